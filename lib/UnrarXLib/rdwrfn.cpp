@@ -179,6 +179,13 @@ int ComprDataIO::UnpRead(byte *Addr,uint Count)
 
 void ComprDataIO::UnpWrite(byte *Addr,uint Count)
 {
+  if (UnpackToMemory && Count > MAXWINMEMSIZE)
+  {
+    // packed entries write up to a full window, hand it over in buffer sized parts
+    for (uint Done=0; Done < Count && !hQuit->WaitMSec(0); Done+=MAXWINMEMSIZE)
+      UnpWrite(Addr+Done,Min(Count-Done,MAXWINMEMSIZE));
+    return;
+  }
 #ifdef RARDLL
   RAROptions *Cmd=((Archive *)SrcFile)->GetRAROptions();
   if (Cmd->DllOpMode!=RAR_SKIP)
@@ -207,9 +214,12 @@ void ComprDataIO::UnpWrite(byte *Addr,uint Count)
     while(UnpackToMemorySize < (int)Count)
     {
       hBufferEmpty->Set();
-      while(! hBufferFilled->WaitMSec(1)) 
-        if (hQuit->WaitMSec(1))
+      // the reader signals hBufferFilled once it emptied the buffer, and on quit
+      while(! hBufferFilled->WaitMSec(100))
+        if (hQuit->WaitMSec(0))
           return;
+      if (hQuit->WaitMSec(0))
+        return;
     }
     
     if (! hSeek->WaitMSec(1)) // we are seeking
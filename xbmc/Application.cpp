@@ -152,6 +152,9 @@
 #include "interfaces/json-rpc/JSONRPC.h"
 #include "network/TCPServer.h"
 #endif
+#ifdef HAS_WEB_SERVER
+#include "network/httprequesthandler/ImageTransformationCache.h"
+#endif
 #ifdef HAS_AIRPLAY
 #include "network/AirPlayServer.h"
 #endif
@@ -635,6 +638,9 @@ bool CApplication::Create()
 
   g_powerManager.Initialize();
 
+  // deliver announcements from their own thread from here on
+  CAnnouncementManager::Get().Start();
+
   // Load the AudioEngine before settings as they need to query the engine
   if (!CAEFactory::LoadEngine())
   {
@@ -1656,14 +1662,14 @@ bool CApplication::LoadSkin(const SkinPtr& skin)
 
   g_colorManager.Load(CSettings::Get().GetString("lookandfeel.skincolors"));
 
-  g_fontManager.LoadFonts(CSettings::Get().GetString("lookandfeel.font"));
-
-  // load in the skin strings
+  // load in the skin strings (before the fonts, so their glyphs can be pre-rendered)
   std::string langPath = URIUtils::AddFileToFolder(skin->Path(), "language");
   URIUtils::AddSlashAtEnd(langPath);
 
   g_localizeStrings.LoadSkinStrings(langPath, CSettings::Get().GetString("locale.language"));
 
+  g_fontManager.LoadFonts(CSettings::Get().GetString("lookandfeel.font"));
+
   g_SkinInfo->LoadIncludes();
 
   int64_t start;
@@ -2687,6 +2693,10 @@ void CApplication::Stop(int exitCode)
     g_RarManager.ClearCache(true);
 #endif
 
+#ifdef HAS_WEB_SERVER
+    CImageTransformationCache::Get().Deinitialize();
+#endif
+
 #ifdef HAS_FILESYSTEM_SFTP
     CSFTPSessionManager::DisconnectAllSessions();
 #endif
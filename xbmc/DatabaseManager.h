@@ -65,6 +65,14 @@ public:
    */ 
   bool CanOpen(const std::string &name);
 
+  /*! \brief Update a database to the latest version
+   Once updated, the database can be opened. Initialize() does this for all databases
+   of the profile, this is for databases set up elsewhere (e.g. by tests).
+   \param db the database to update.
+   \param settings the settings of the database, or NULL for the defaults.
+   */
+  void UpdateDatabase(CDatabase &db, DatabaseSettings *settings = NULL);
+
 private:
   // private construction, and no assignements; use the provided singleton methods
   CDatabaseManager();
@@ -74,7 +82,6 @@ private:
 
   enum DB_STATUS { DB_CLOSED, DB_UPDATING, DB_READY, DB_FAILED };
   void UpdateStatus(const std::string &name, DB_STATUS status);
-  void UpdateDatabase(CDatabase &db, DatabaseSettings *settings = NULL);
 
   CCriticalSection            m_section;     ///< Critical section protecting m_dbStatus.
   std::map<std::string, DB_STATUS> m_dbStatus;    ///< Our database status map.
@@ -24,12 +24,13 @@
 #include "profiles/ProfilesManager.h"
 #include "threads/SingleLock.h"
 #include "utils/Crc32.h"
+#include "utils/CPUInfo.h"
 #include "settings/AdvancedSettings.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
 #include "utils/StringUtils.h"
 #include "URL.h"
-#include "utils/StringUtils.h"
+#include <algorithm>
 
 using namespace XFILE;
 
@@ -39,8 +40,13 @@ CTextureCache &CTextureCache::Get()
   return s_cache;
 }
 
-CTextureCache::CTextureCache() : CJobQueue(false, 1, CJob::PRIORITY_LOW_PAUSABLE)
+/* one caching job per core, each on a worker of its own so that other low
+ * priority jobs don't have to wait for the texture cache */
+#define TEXTURE_CACHE_JOBS std::max(1, g_cpuInfo.getCPUCount())
+
+CTextureCache::CTextureCache() : CJobQueue(false, TEXTURE_CACHE_JOBS, CJob::PRIORITY_LOW_PAUSABLE)
 {
+  CJobManager::GetInstance().SetWorkerAllowance(kJobTypeCacheImage, TEXTURE_CACHE_JOBS);
 }
 
 CTextureCache::~CTextureCache()
@@ -57,6 +63,11 @@ void CTextureCache::Initialize()
 void CTextureCache::Deinitialize()
 {
   CancelJobs();
+  {
+    CSingleLock lock(m_statisticsSection);
+    CLog::Log(LOGDEBUG, "%s - cached %" PRIu64" images, shared %" PRIu64" identical images, read %" PRIu64" bytes", __FUNCTION__,
+              m_statistics.imagesCached, m_statistics.imagesShared, m_statistics.bytesRead);
+  }
   CSingleLock lock(m_databaseSection);
   m_database.Close();
 }
@@ -182,7 +193,11 @@ void CTextureCache::ClearCachedImage(const std::string &url, bool deleteSource /
   std::string path = deleteSource ? url : "";
   std::string cachedFile;
   if (ClearCachedTexture(url, cachedFile))
+  {
+    if (cachedFile.empty())
+      return; // cached file is still used by other images
     path = GetCachedPath(cachedFile);
+  }
   if (CFile::Exists(path))
     CFile::Delete(path);
   path = URIUtils::ReplaceExtension(path, ".dds");
@@ -195,6 +210,8 @@ bool CTextureCache::ClearCachedImage(int id)
   std::string cachedFile;
   if (ClearCachedTexture(id, cachedFile))
   {
+    if (cachedFile.empty())
+      return true; // cached file is still used by other images
     cachedFile = GetCachedPath(cachedFile);
     if (CFile::Exists(cachedFile))
       CFile::Delete(cachedFile);
@@ -214,8 +231,82 @@ bool CTextureCache::GetCachedTexture(const std::string &url, CTextureDetails &de
 
 bool CTextureCache::AddCachedTexture(const std::string &url, const CTextureDetails &details)
 {
-  CSingleLock lock(m_databaseSection);
-  return m_database.AddCachedTexture(url, details);
+  std::string unusedFile;
+  {
+    CSingleLock lock(m_databaseSection);
+    if (!m_database.AddCachedTexture(url, details, &unusedFile))
+      return false;
+  }
+  // remove the previously cached file if nothing else uses it
+  if (!unusedFile.empty())
+  {
+    std::string path = GetCachedPath(unusedFile);
+    if (CFile::Exists(path))
+      CFile::Delete(path);
+    path = URIUtils::ReplaceExtension(path, ".dds");
+    if (CFile::Exists(path))
+      CFile::Delete(path);
+  }
+  return true;
+}
+
+bool CTextureCache::GetCachedContent(const std::string &contentHash, CTextureDetails &details)
+{
+  { // wait for any job currently caching the same content
+    CSingleLock lock(m_processingSection);
+    while (m_processingContent.find(contentHash) != m_processingContent.end())
+      m_contentCondition.wait(lock);
+  }
+
+  CTextureDetails content;
+  bool found;
+  {
+    CSingleLock lock(m_databaseSection);
+    found = m_database.GetCachedContent(contentHash, content);
+  }
+  if (found && CFile::Exists(GetCachedPath(content.file)))
+  {
+    details.file = content.file;
+    details.width = content.width;
+    details.height = content.height;
+    CSingleLock lock(m_statisticsSection);
+    m_statistics.imagesShared++;
+    return true;
+  }
+
+  CSingleLock lock(m_processingSection);
+  if (m_processingContent.find(contentHash) != m_processingContent.end())
+  { // someone beat us to it - wait for them instead
+    lock.Leave();
+    return GetCachedContent(contentHash, details);
+  }
+  m_processingContent.insert(contentHash);
+  return false;
+}
+
+void CTextureCache::ReleaseContent(const std::string &contentHash)
+{
+  CSingleLock lock(m_processingSection);
+  m_processingContent.erase(contentHash);
+  m_contentCondition.notifyAll();
+}
+
+CTextureCache::Statistics CTextureCache::GetStatistics() const
+{
+  CSingleLock lock(m_statisticsSection);
+  return m_statistics;
+}
+
+void CTextureCache::OnImageRead(uint64_t bytes)
+{
+  CSingleLock lock(m_statisticsSection);
+  m_statistics.bytesRead += bytes;
+}
+
+void CTextureCache::OnImageCached()
+{
+  CSingleLock lock(m_statisticsSection);
+  m_statistics.imagesCached++;
 }
 
 void CTextureCache::IncrementUseCount(const CTextureDetails &details)
@@ -258,6 +349,11 @@ std::string CTextureCache::GetCacheFile(const std::string &url)
   return hash;
 }
 
+std::string CTextureCache::GetContentCacheFile(const std::string &contentHash)
+{
+  return StringUtils::Format("%c/%s", contentHash[0], contentHash.c_str());
+}
+
 std::string CTextureCache::GetCachedPath(const std::string &file)
 {
   return URIUtils::AddFileToFolder(CProfilesManager::Get().GetThumbnailsFolder(), file);
@@ -279,6 +375,11 @@ void CTextureCache::OnCachingComplete(bool success, CTextureCacheJob *job)
     if (i != m_processinglist.end())
       m_processinglist.erase(i);
   }
+  if (job->m_cachingContent)
+  {
+    ReleaseContent(job->m_details.contentHash);
+    job->m_cachingContent = false;
+  }
 
   m_completeEvent.Set();
 
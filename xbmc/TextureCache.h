@@ -21,8 +21,10 @@
 #pragma once
 
 #include <set>
+#include <stdint.h>
 #include <string>
 #include <vector>
+#include "threads/Condition.h"
 #include "utils/JobManager.h"
 #include "TextureDatabase.h"
 #include "threads/Event.h"
@@ -129,6 +131,14 @@ public:
    */
   static std::string GetCacheFile(const std::string &url);
 
+  /*! \brief retrieve a cache file (relative to the cache path) for image content with the given hash, excluding extension
+   Content cache files are shared between all images that have identical source data and are cached at the same size.
+   \param contentHash hash of the image content
+   \return a unique filename for the content, excluding extension
+   \sa CTextureCacheJob::GetContentHash
+   */
+  static std::string GetContentCacheFile(const std::string &contentHash);
+
   /*! \brief retrieve the full path of the given cached file
    \param file name of the file
    \return full path of the cached file
@@ -157,6 +167,42 @@ public:
    */
   bool Export(const std::string &image, const std::string &destination, bool overwrite);
   bool Export(const std::string &image, const std::string &destination); // TODO: BACKWARD COMPATIBILITY FOR MUSIC THUMBS
+
+  /*! \brief Find previously cached image content
+   If another job is currently caching the same content, waits for it to complete first.
+   If the content isn't cached, the caller is expected to cache it, and other jobs caching the
+   same content will wait until it's done.
+   \param contentHash hash of the image content
+   \param details [out] details of the cached content (file, width and height)
+   \return true if the content is already cached, false otherwise.
+   \sa CTextureCacheJob::GetContentHash
+   */
+  bool GetCachedContent(const std::string &contentHash, CTextureDetails &details);
+
+  /*! \brief Let jobs waiting in GetCachedContent() continue
+   Called once the content is cached, or when the job responsible for caching it goes away without doing so.
+   \param contentHash hash of the image content
+   */
+  void ReleaseContent(const std::string &contentHash);
+
+  /*! \brief Throughput counters for the texture cache
+   */
+  struct Statistics
+  {
+    Statistics() : imagesCached(0), imagesShared(0), bytesRead(0) {}
+    uint64_t imagesCached; ///< number of images decoded and written to the cache
+    uint64_t imagesShared; ///< number of images that reused an identical, previously cached image
+    uint64_t bytesRead;    ///< number of bytes of source image data read
+  };
+
+  /*! \brief Retrieve the throughput counters of the texture cache since it was initialized
+   */
+  Statistics GetStatistics() const;
+
+  /*! \brief Update the throughput counters, used by CTextureCacheJob
+   */
+  void OnImageRead(uint64_t bytes);
+  void OnImageCached();
 private:
   // private construction, and no assignements; use the provided singleton methods
   CTextureCache();
@@ -224,9 +270,13 @@ private:
   CCriticalSection m_databaseSection;
   CTextureDatabase m_database;
   std::set<std::string> m_processinglist; ///< currently processing list to avoid 2 jobs being processed at once
+  std::set<std::string> m_processingContent; ///< content hashes currently being cached
+  XbmcThreads::ConditionVariable m_contentCondition; ///< signalled when content is no longer being cached
   CCriticalSection     m_processingSection;
   CEvent               m_completeEvent; ///< Set whenever a job has finished
   std::vector<CTextureDetails> m_useCounts; ///< Use count tracking
   CCriticalSection             m_useCountSection;
+  Statistics                   m_statistics;
+  CCriticalSection             m_statisticsSection;
 };
 
@@ -29,10 +29,12 @@
 #include "pictures/Picture.h"
 #include "utils/URIUtils.h"
 #include "utils/StringUtils.h"
+#include "utils/md5.h"
 #include "URL.h"
 #include "FileItem.h"
 #include "music/MusicThumbLoader.h"
 #include "music/tags/MusicInfoTag.h"
+#include <algorithm>
 #if defined(HAS_OMXPLAYER)
 #include "cores/omxplayer/OMXImage.h"
 #endif
@@ -40,12 +42,16 @@
 CTextureCacheJob::CTextureCacheJob(const std::string &url, const std::string &oldHash):
   m_url(url),
   m_oldHash(oldHash),
+  m_cachingContent(false),
   m_cachePath(CTextureCache::GetCacheFile(m_url))
 {
 }
 
 CTextureCacheJob::~CTextureCacheJob()
 {
+  // cancelled jobs never see OnCachingComplete(), don't leave others waiting for our content
+  if (m_cachingContent)
+    CTextureCache::Get().ReleaseContent(m_details.contentHash);
 }
 
 bool CTextureCacheJob::operator==(const CJob* job) const
@@ -102,13 +108,50 @@ bool CTextureCacheJob::CacheTexture(CBaseTexture **out_texture)
     return true;
   }
 #endif
-  CBaseTexture *texture = LoadImage(image, width, height, additional_info, true);
+  // we never cache at more than the image (or fanart) resolution, so there's no
+  // point in having the decoder produce anything larger than that
+  unsigned int maxRes = std::max(g_advancedSettings.m_imageRes, g_advancedSettings.m_fanartRes);
+  if (width == 0)
+    width = maxRes * 16/9;
+  if (height == 0)
+    height = maxRes;
+
+  // read the image data ourselves so we can check whether the same image has already
+  // been cached at this size under another URL (eg the same album cover on every song)
+  XFILE::auto_buffer buffer;
+  std::string mimeType;
+  if (additional_info != "music" && !URIUtils::HasExtension(image, ".dds") && IsImage(image, mimeType))
+  {
+    XFILE::CFile file;
+    if (file.LoadFile(image, buffer) <= 0)
+      return false;
+    CTextureCache::Get().OnImageRead(buffer.size());
+
+    m_details.contentHash = GetContentHash((const unsigned char *)buffer.get(), buffer.size(), width, height, additional_info);
+    if (CTextureCache::Get().GetCachedContent(m_details.contentHash, m_details))
+    {
+      CLog::Log(LOGDEBUG, "%s image '%s' using existing '%s'", m_oldHash.empty() ? "Caching" : "Recaching", image.c_str(), m_details.file.c_str());
+      if (out_texture)
+        *out_texture = LoadImage(CTextureCache::GetCachedPath(m_details.file), m_details.width, m_details.height, "" /* already flipped */);
+      return true;
+    }
+    m_cachingContent = true;
+  }
+
+  CBaseTexture *texture;
+  if (buffer.size())
+    texture = LoadImage((unsigned char *)buffer.get(), buffer.size(), mimeType, width, height, additional_info);
+  else
+    texture = LoadImage(image, width, height, additional_info, true);
+  buffer.clear();
+
   if (texture)
   {
+    std::string cachePath = m_details.contentHash.empty() ? m_cachePath : CTextureCache::GetContentCacheFile(m_details.contentHash);
     if (texture->HasAlpha())
-      m_details.file = m_cachePath + ".png";
+      m_details.file = cachePath + ".png";
     else
-      m_details.file = m_cachePath + ".jpg";
+      m_details.file = cachePath + ".jpg";
 
     CLog::Log(LOGDEBUG, "%s image '%s' to '%s':", m_oldHash.empty() ? "Caching" : "Recaching", image.c_str(), m_details.file.c_str());
 
@@ -116,6 +159,7 @@ bool CTextureCacheJob::CacheTexture(CBaseTexture **out_texture)
     {
       m_details.width = width;
       m_details.height = height;
+      CTextureCache::Get().OnImageCached();
       if (out_texture) // caller wants the texture
         *out_texture = texture;
       else
@@ -195,14 +239,11 @@ CBaseTexture *CTextureCacheJob::LoadImage(const std::string &image, unsigned int
       return CBaseTexture::LoadFromFileInMemory(&art.data[0], art.size, art.mime, width, height);
   }
 
-  // Validate file URL to see if it is an image
-  CFileItem file(image, false);
-  file.FillInMimeType();
-  if (!(file.IsPicture() && !(file.IsZIP() || file.IsRAR() || file.IsCBR() || file.IsCBZ() ))
-      && !StringUtils::StartsWithNoCase(file.GetMimeType(), "image/") && !StringUtils::EqualsNoCase(file.GetMimeType(), "application/octet-stream")) // ignore non-pictures
+  std::string mimeType;
+  if (!IsImage(image, mimeType))
     return NULL;
 
-  CBaseTexture *texture = CBaseTexture::LoadFromFile(image, width, height, CSettings::Get().GetBool("pictures.useexifrotation"), requirePixels, file.GetMimeType());
+  CBaseTexture *texture = CBaseTexture::LoadFromFile(image, width, height, CSettings::Get().GetBool("pictures.useexifrotation"), requirePixels, mimeType);
   if (!texture)
     return NULL;
 
@@ -215,6 +256,29 @@ CBaseTexture *CTextureCacheJob::LoadImage(const std::string &image, unsigned int
   return texture;
 }
 
+CBaseTexture *CTextureCacheJob::LoadImage(unsigned char *buffer, size_t size, const std::string &mimeType, unsigned int width, unsigned int height, const std::string &additional_info)
+{
+  CBaseTexture *texture = CBaseTexture::LoadFromFileInMemory(buffer, size, mimeType, width, height, CSettings::Get().GetBool("pictures.useexifrotation"));
+  if (!texture)
+    return NULL;
+
+  // see above
+  if (additional_info == "flipped")
+    texture->SetOrientation(texture->GetOrientation() ^ 1);
+
+  return texture;
+}
+
+bool CTextureCacheJob::IsImage(const std::string &image, std::string &mimeType)
+{
+  // Validate file URL to see if it is an image
+  CFileItem file(image, false);
+  file.FillInMimeType();
+  mimeType = file.GetMimeType();
+  return (file.IsPicture() && !(file.IsZIP() || file.IsRAR() || file.IsCBR() || file.IsCBZ() ))
+      || StringUtils::StartsWithNoCase(mimeType, "image/") || StringUtils::EqualsNoCase(mimeType, "application/octet-stream"); // ignore non-pictures
+}
+
 bool CTextureCacheJob::UpdateableURL(const std::string &url) const
 {
   // we don't constantly check online images
@@ -243,6 +307,20 @@ std::string CTextureCacheJob::GetImageHash(const std::string &url)
   return "";
 }
 
+std::string CTextureCacheJob::GetContentHash(const unsigned char *buffer, size_t size, unsigned int width, unsigned int height, const std::string &additional_info)
+{
+  XBMC::XBMC_MD5 md5;
+  md5.append(buffer, size);
+  std::string hash = md5.getDigest();
+  StringUtils::ToLower(hash);
+  hash += StringUtils::Format("-%ux%u", width, height);
+  if (additional_info == "flipped")
+    hash += "f";
+  if (CSettings::Get().GetBool("pictures.useexifrotation"))
+    hash += "r";
+  return hash;
+}
+
 CTextureDDSJob::CTextureDDSJob(const std::string &original):
   m_original(original)
 {
@@ -49,6 +49,7 @@ public:
   int          id;
   std::string  file;
   std::string  hash;
+  std::string  contentHash; ///< hash of the source image data and the transform applied to it, empty if unknown
   unsigned int width;
   unsigned int height;
   bool         updateable;
@@ -82,6 +83,7 @@ public:
   std::string m_url;
   std::string m_oldHash;
   CTextureDetails m_details;
+  bool m_cachingContent; ///< whether this job is responsible for caching m_details.contentHash
 private:
   friend class CEdenVideoArtUpdater;
 
@@ -92,6 +94,25 @@ private:
    */
   static std::string GetImageHash(const std::string &url);
 
+  /*! \brief retrieve a hash for the content of the given image
+   Combines an MD5 of the image data with the size and orientation we cache it at, so that
+   identical images referenced by different URLs may share the same cached file.
+   \param buffer the image data
+   \param size the size of the image data
+   \param width the width we're caching at
+   \param height the height we're caching at
+   \param additional_info additional information, such as "flipped" to flip horizontally
+   \return a hash string for this image content
+   */
+  static std::string GetContentHash(const unsigned char *buffer, size_t size, unsigned int width, unsigned int height, const std::string &additional_info);
+
+  /*! \brief Check whether a given image file is a picture we can load
+   \param image the URL of the image file.
+   \param mimeType [out] the mime type of the image file.
+   \return true if the file is a picture, false otherwise.
+   */
+  static bool IsImage(const std::string &image, std::string &mimeType);
+
   /*! \brief Check whether a given URL represents an image that can be updated
    We currently don't check http:// and https:// URLs for updates, under the assumption that
    a image URL is much more likely to be static and the actual image at the URL is unlikely
@@ -123,6 +144,18 @@ private:
    */
   static CBaseTexture *LoadImage(const std::string &image, unsigned int width, unsigned int height, const std::string &additional_info, bool requirePixels = false);
 
+  /*! \brief Load an image held in memory at a given target size and orientation.
+   \param buffer the image file data.
+   \param size the size of the image file data.
+   \param mimeType the mime type of the image file.
+   \param width the desired maximum width.
+   \param height the desired maximum height.
+   \param additional_info extra info for loading, such as whether to flip horizontally.
+   \return a pointer to a CBaseTexture object, NULL if failed.
+   \sa LoadImage
+   */
+  static CBaseTexture *LoadImage(unsigned char *buffer, size_t size, const std::string &mimeType, unsigned int width, unsigned int height, const std::string &additional_info);
+
   std::string    m_cachePath;
 };
 
@@ -174,6 +174,9 @@ void CTextureDatabase::CreateTables()
 
   CLog::Log(LOGINFO, "create path table");
   m_pDS->exec("CREATE TABLE path (id integer primary key, url text, type text, texture text)\n");
+
+  CLog::Log(LOGINFO, "create content table");
+  m_pDS->exec("CREATE TABLE content (id integer primary key, hash text, cachedurl text, width integer, height integer, refcount integer)");
 }
 
 void CTextureDatabase::CreateAnalytics()
@@ -184,6 +187,8 @@ void CTextureDatabase::CreateAnalytics()
   m_pDS->exec("CREATE INDEX idxSize2 ON sizes(idtexture, width, height)");
   // TODO: Should the path index be a covering index? (we need only retrieve texture)
   m_pDS->exec("CREATE INDEX idxPath ON path(url, type)");
+  m_pDS->exec("CREATE INDEX idxContent ON content(hash)");
+  m_pDS->exec("CREATE INDEX idxContent2 ON content(cachedurl)");
 
   CLog::Log(LOGINFO, "%s creating triggers", __FUNCTION__);
   m_pDS->exec("CREATE TRIGGER textureDelete AFTER delete ON texture FOR EACH ROW BEGIN delete from sizes where sizes.idtexture=old.id; END");
@@ -242,6 +247,10 @@ void CTextureDatabase::UpdateTables(int version)
     m_pDS->exec("CREATE TABLE texture (id integer primary key, url text, cachedurl text, imagehash text, lasthashcheck text)");
     m_pDS->exec("CREATE TABLE sizes (idtexture integer, size integer, width integer, height integer, usecount integer, lastusetime text)");
   }
+  if (version < 14)
+  { // reference counted cache files shared between textures with identical content
+    m_pDS->exec("CREATE TABLE content (id integer primary key, hash text, cachedurl text, width integer, height integer, refcount integer)");
+  }
 }
 
 bool CTextureDatabase::IncrementUseCount(const CTextureDetails &details)
@@ -334,16 +343,26 @@ bool CTextureDatabase::SetCachedTextureValid(const std::string &url, bool update
   return ExecuteQuery(sql);
 }
 
-bool CTextureDatabase::AddCachedTexture(const std::string &url, const CTextureDetails &details)
+bool CTextureDatabase::AddCachedTexture(const std::string &url, const CTextureDetails &details, std::string *unusedFile)
 {
   try
   {
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    std::string sql = PrepareSQL("DELETE FROM texture WHERE url='%s'", url.c_str());
+    std::string sql = PrepareSQL("SELECT cachedurl FROM texture WHERE url='%s'", url.c_str());
+    m_pDS->query(sql.c_str());
+    std::string oldFile;
+    if (!m_pDS->eof())
+      oldFile = m_pDS->fv(0).get_asString();
+    m_pDS->close();
+
+    sql = PrepareSQL("DELETE FROM texture WHERE url='%s'", url.c_str());
     m_pDS->exec(sql.c_str());
 
+    if (!oldFile.empty() && oldFile != details.file && ReleaseCachedFile(oldFile) && unusedFile)
+      *unusedFile = oldFile;
+
     std::string date = details.updateable ? CDateTime::GetCurrentDateTime().GetAsDBDateTime() : "";
     sql = PrepareSQL("INSERT INTO texture (id, url, cachedurl, imagehash, lasthashcheck) VALUES(NULL, '%s', '%s', '%s', '%s')", url.c_str(), details.file.c_str(), details.hash.c_str(), date.c_str());
     m_pDS->exec(sql.c_str());
@@ -352,6 +371,25 @@ bool CTextureDatabase::AddCachedTexture(const std::string &url, const CTextureDe
     // set the size information
     sql = PrepareSQL("INSERT INTO sizes (idtexture, size, usecount, lastusetime, width, height) VALUES(%u, 1, 1, CURRENT_TIMESTAMP, %u, %u)", textureID, details.width, details.height);
     m_pDS->exec(sql.c_str());
+
+    // and reference the content, unless we're just replacing ourselves
+    if (!details.contentHash.empty() && oldFile != details.file)
+    {
+      sql = PrepareSQL("SELECT id FROM content WHERE cachedurl='%s'", details.file.c_str());
+      m_pDS->query(sql.c_str());
+      if (!m_pDS->eof())
+      {
+        int contentID = m_pDS->fv(0).get_asInt();
+        m_pDS->close();
+        sql = PrepareSQL("UPDATE content SET refcount=refcount+1 WHERE id=%i", contentID);
+      }
+      else
+      {
+        m_pDS->close();
+        sql = PrepareSQL("INSERT INTO content (id, hash, cachedurl, width, height, refcount) VALUES(NULL, '%s', '%s', %u, %u, 1)", details.contentHash.c_str(), details.file.c_str(), details.width, details.height);
+      }
+      m_pDS->exec(sql.c_str());
+    }
   }
   catch (...)
   {
@@ -360,6 +398,55 @@ bool CTextureDatabase::AddCachedTexture(const std::string &url, const CTextureDe
   return true;
 }
 
+bool CTextureDatabase::GetCachedContent(const std::string &contentHash, CTextureDetails &details)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    std::string sql = PrepareSQL("SELECT cachedurl, width, height FROM content WHERE hash='%s' AND refcount > 0", contentHash.c_str());
+    m_pDS->query(sql.c_str());
+    if (!m_pDS->eof())
+    {
+      details.file = m_pDS->fv(0).get_asString();
+      details.width = m_pDS->fv(1).get_asInt();
+      details.height = m_pDS->fv(2).get_asInt();
+      details.contentHash = contentHash;
+      m_pDS->close();
+      return true;
+    }
+    m_pDS->close();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s, failed on content '%s'", __FUNCTION__, contentHash.c_str());
+  }
+  return false;
+}
+
+bool CTextureDatabase::ReleaseCachedFile(const std::string &cacheFile)
+{
+  std::string sql = PrepareSQL("SELECT id, refcount FROM content WHERE cachedurl='%s'", cacheFile.c_str());
+  m_pDS->query(sql.c_str());
+  if (m_pDS->eof())
+  { // not content addressed, so it was ours alone
+    m_pDS->close();
+    return true;
+  }
+  int contentID = m_pDS->fv(0).get_asInt();
+  int refCount = m_pDS->fv(1).get_asInt();
+  m_pDS->close();
+
+  if (refCount > 1)
+  {
+    m_pDS->exec(PrepareSQL("UPDATE content SET refcount=refcount-1 WHERE id=%i", contentID));
+    return false;
+  }
+  m_pDS->exec(PrepareSQL("DELETE FROM content WHERE id=%i", contentID));
+  return true;
+}
+
 bool CTextureDatabase::ClearCachedTexture(const std::string &url, std::string &cacheFile)
 {
   std::string id = GetSingleValue(PrepareSQL("select id from texture where url='%s'", url.c_str()));
@@ -383,6 +470,8 @@ bool CTextureDatabase::ClearCachedTexture(int id, std::string &cacheFile)
       // remove it
       sql = PrepareSQL("delete from texture where id=%u", id);
       m_pDS->exec(sql.c_str());
+      if (!ReleaseCachedFile(cacheFile))
+        cacheFile.clear();
       return true;
     }
     m_pDS->close();
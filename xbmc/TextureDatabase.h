@@ -73,12 +73,36 @@ public:
   virtual bool Open();
 
   bool GetCachedTexture(const std::string &originalURL, CTextureDetails &details);
-  bool AddCachedTexture(const std::string &originalURL, const CTextureDetails &details);
+
+  /*! \brief Add a cached texture to the database
+   Replaces any previous cached texture for the URL. If details.contentHash is set, the cached
+   file is reference counted so that it may be shared with other URLs having the same content.
+   \param originalURL url of the original image
+   \param details details of the cached texture
+   \param unusedFile [out] optional, the previously cached file of this URL if nothing uses it anymore
+   \return true on success, false otherwise
+   \sa GetCachedContent
+   */
+  bool AddCachedTexture(const std::string &originalURL, const CTextureDetails &details, std::string *unusedFile = NULL);
   bool SetCachedTextureValid(const std::string &originalURL, bool updateable);
+
+  /*! \brief Clear a cached texture from the database
+   \param originalURL url of the original image
+   \param cacheFile [out] the cached file, empty if it's still in use by other textures
+   \return true if the texture was cached, false otherwise
+   */
   bool ClearCachedTexture(const std::string &originalURL, std::string &cacheFile);
   bool ClearCachedTexture(int textureID, std::string &cacheFile);
   bool IncrementUseCount(const CTextureDetails &details);
 
+  /*! \brief Get previously cached image content
+   \param contentHash hash of the image content
+   \param details [out] the cached file, width and height of the content
+   \return true if the content is cached, false otherwise
+   \sa CTextureCacheJob::GetContentHash
+   */
+  bool GetCachedContent(const std::string &contentHash, CTextureDetails &details);
+
   /*! \brief Invalidate a previously cached texture
    Invalidates the texture hash, and sets the texture update time to the current time so that
    next texture load it will be re-cached.
@@ -127,9 +151,15 @@ protected:
    */
   unsigned int GetURLHash(const std::string &url) const;
 
+  /*! \brief Drop a reference to a cached file
+   \param cacheFile the cached file
+   \return true if the cached file is no longer used, false otherwise
+   */
+  bool ReleaseCachedFile(const std::string &cacheFile);
+
   virtual void CreateTables();
   virtual void CreateAnalytics();
   virtual void UpdateTables(int version);
-  virtual int GetSchemaVersion() const { return 13; };
+  virtual int GetSchemaVersion() const { return 14; };
   const char *GetBaseDBName() const { return "Textures"; };
 };
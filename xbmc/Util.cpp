@@ -1984,9 +1984,11 @@ void CUtil::ScanForExternalSubtitles(const std::string& strMovie, std::vector<st
   {
     if (strLookInPaths[step].length() != 0)
     {
-      CFileItemList items;
-      
-      CDirectory::GetDirectory(strLookInPaths[step], items, g_advancedSettings.m_subtitlesExtensions, DIR_FLAG_NO_FILE_DIRS);
+      // the listing is only read, so the cached one can be used as is
+      CDirectory::CDirectoryPtr dir;
+      if (!CDirectory::GetDirectory(strLookInPaths[step], dir, g_advancedSettings.m_subtitlesExtensions, DIR_FLAG_NO_FILE_DIRS))
+        continue;
+      const CFileItemList &items = *dir;
       
       for (int j = 0; j < items.Size(); j++)
       {
@@ -24,6 +24,7 @@ using namespace ActiveAE;
 #include "ActiveAESound.h"
 #include "ActiveAEStream.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
+#include "cores/AudioEngine/Utils/AEKernels.h"
 #include "cores/AudioEngine/AEResampleFactory.h"
 #include "cores/AudioEngine/Encoders/AEEncoderFFmpeg.h"
 
@@ -36,7 +37,18 @@ using namespace ActiveAE;
 #define MAX_CACHE_LEVEL 0.5   // total cache time of stream in seconds
 #define MAX_WATER_LEVEL 0.25  // buffered time after stream stages in seconds
 #define MAX_BUFFER_TIME 0.1   // max time of a buffer in seconds
+#define LOW_LATENCY_PERIOD 0.01 // sink period requested by low latency streams in seconds
 
+CEngineStats::CEngineStats()
+{
+  m_sinkCacheTotal = 0;
+  m_sinkLatency = 0;
+  m_cacheLevel = MAX_CACHE_LEVEL;
+  m_waterLevel = MAX_WATER_LEVEL;
+  Reset(44100);
+}
+
+// the buffer levels are kept, they only change when the engine is configured
 void CEngineStats::Reset(unsigned int sampleRate)
 {
   CSingleLock lock(m_lock);
@@ -110,7 +122,8 @@ float CEngineStats::GetCacheTime(CActiveAEStream *stream)
 
 float CEngineStats::GetCacheTotal(CActiveAEStream *stream)
 {
-  return MAX_CACHE_LEVEL + m_sinkCacheTotal;
+  CSingleLock lock(m_lock);
+  return m_cacheLevel + m_sinkCacheTotal;
 }
 
 int64_t CEngineStats::GetPlayingPTS()
@@ -144,6 +157,48 @@ float CEngineStats::GetWaterLevel()
   return (float)m_bufferedSamples / m_sinkSampleRate;
 }
 
+void CEngineStats::SetSinkCacheTotal(float time)
+{
+  CSingleLock lock(m_lock);
+  m_sinkCacheTotal = time;
+}
+
+void CEngineStats::SetSinkLatency(float time)
+{
+  CSingleLock lock(m_lock);
+  m_sinkLatency = time;
+}
+
+void CEngineStats::SetLowLatency(bool lowLatency, float sinkPeriod)
+{
+  CSingleLock lock(m_lock);
+  m_cacheLevel = MAX_CACHE_LEVEL;
+  m_waterLevel = MAX_WATER_LEVEL;
+  if (lowLatency)
+  {
+    m_cacheLevel = std::min(m_cacheLevel, 2 * sinkPeriod);
+    m_waterLevel = std::min(m_waterLevel, 2 * sinkPeriod);
+  }
+}
+
+float CEngineStats::GetMaxCacheLevel()
+{
+  CSingleLock lock(m_lock);
+  return m_cacheLevel;
+}
+
+float CEngineStats::GetMaxWaterLevel()
+{
+  CSingleLock lock(m_lock);
+  return m_waterLevel;
+}
+
+float CEngineStats::GetMaxLatency()
+{
+  CSingleLock lock(m_lock);
+  return m_cacheLevel + m_waterLevel + m_sinkCacheTotal + m_sinkLatency;
+}
+
 void CEngineStats::SetSuspended(bool state)
 {
   CSingleLock lock(m_lock);
@@ -177,6 +232,9 @@ CActiveAE::CActiveAE() :
   m_audioCallback = NULL;
   m_vizInitialized = false;
   m_sinkHasVolume = false;
+  m_lowLatency = false;
+  m_cacheLevel = MAX_CACHE_LEVEL;
+  m_waterLevel = MAX_WATER_LEVEL;
   m_stats.Reset(44100);
 }
 
@@ -964,12 +1022,23 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
   ApplySettingsToFormat(m_sinkRequestFormat, m_settings, (int*)&m_mode);
   m_extKeepConfig = 0;
 
+  // low latency if all streams ask for it, the sink is told by a requested period
+  bool lowLatency = !m_streams.empty() && m_mode != MODE_RAW;
+  std::list<CActiveAEStream*>::iterator itStream;
+  for (itStream = m_streams.begin(); itStream != m_streams.end(); ++itStream)
+  {
+    if (!(*itStream)->m_lowLatency)
+      lowLatency = false;
+  }
+  m_sinkRequestFormat.m_frames = lowLatency ? LOW_LATENCY_PERIOD * m_sinkRequestFormat.m_sampleRate : 0;
+
   std::string device = AE_IS_RAW(m_sinkRequestFormat.m_dataFormat) ? m_settings.passthoughdevice : m_settings.device;
   std::string driver;
   CAESinkFactory::ParseDevice(device, driver);
   if ((!CompareFormat(m_sinkRequestFormat, m_sinkFormat) && !CompareFormat(m_sinkRequestFormat, oldSinkRequestFormat)) ||
       m_currDevice.compare(device) != 0 ||
-      m_settings.driver.compare(driver) != 0)
+      m_settings.driver.compare(driver) != 0 ||
+      m_lowLatency != lowLatency)
   {
     if (!InitSink())
       return;
@@ -988,6 +1057,16 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
     }
   }
 
+  // engine buffers are kept to two sink periods in low latency mode
+  m_lowLatency = lowLatency;
+  float period = (float)m_sinkFormat.m_frames / m_sinkFormat.m_sampleRate;
+  m_stats.SetLowLatency(m_lowLatency, period);
+  m_cacheLevel = m_stats.GetMaxCacheLevel();
+  m_waterLevel = m_stats.GetMaxWaterLevel();
+  if (m_lowLatency)
+    CLog::Log(LOGNOTICE, "ActiveAE::%s - low latency mode, sink period %d ms, worst case latency %d ms", __FUNCTION__,
+              (int)(period * 1000), (int)(m_stats.GetMaxLatency() * 1000));
+
   if (m_silenceBuffers)
   {
     m_discardBufferPools.push_back(m_silenceBuffers);
@@ -1251,7 +1330,10 @@ CActiveAEStream* CActiveAE::CreateStream(MsgStreamNew *streamMsg)
     stream->m_streamIsBuffering = true;
   }
 
-  if (streamMsg->options & AESTREAM_FORCE_RESAMPLE)
+  // low latency streams are only resampled if the rate does not match
+  if (streamMsg->options & AESTREAM_LOW_LATENCY)
+    stream->m_lowLatency = true;
+  else if (streamMsg->options & AESTREAM_FORCE_RESAMPLE)
     stream->m_forceResampler = true;
 
   m_streams.push_back(stream);
@@ -1676,7 +1758,7 @@ bool CActiveAE::RunStages()
     {
       float buftime = (float)(*it)->m_inputBuffers->m_format.m_frames / (*it)->m_inputBuffers->m_format.m_sampleRate;
       time += buftime * (*it)->m_processingSamples.size();
-      while ((time < MAX_CACHE_LEVEL || (*it)->m_streamIsBuffering) && !(*it)->m_inputBuffers->m_freeSamples.empty())
+      while ((time < m_cacheLevel || (*it)->m_streamIsBuffering) && !(*it)->m_inputBuffers->m_freeSamples.empty())
       {
         buffer = (*it)->m_inputBuffers->GetFreeBuffer();
         (*it)->m_processingSamples.push_back(buffer);
@@ -1717,7 +1799,7 @@ bool CActiveAE::RunStages()
     }
   }
 
-  if (m_stats.GetWaterLevel() < MAX_WATER_LEVEL &&
+  if (m_stats.GetWaterLevel() < m_waterLevel &&
      (m_mode != MODE_TRANSCODE || (m_encoderBuffers && !m_encoderBuffers->m_freeSamples.empty())))
   {
     // mix streams and sounds sounds
@@ -1825,15 +1907,7 @@ bool CActiveAE::RunStages()
 
               for(int j=0; j<out->pkt->planes; j++)
               {
-#ifdef __SSE__
-                CAEUtil::SSEMulArray((float*)out->pkt->data[j]+i*nb_floats, volume, nb_floats);
-#else
-                float* fbuffer = (float*) out->pkt->data[j]+i*nb_floats;
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  fbuffer[k] *= volume;
-                }
-#endif
+                CAEKernels::MulArray((float*)out->pkt->data[j]+i*nb_floats, volume, nb_floats);
               }
             }
           }
@@ -1894,24 +1968,9 @@ bool CActiveAE::RunStages()
               {
                 float *dst = (float*)out->pkt->data[j]+i*nb_floats;
                 float *src = (float*)mix->pkt->data[j]+i*nb_floats;
-#ifdef __SSE__
-                CAEUtil::SSEMulAddArray(dst, src, volume, nb_floats);
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  if (fabs(dst[k]) > 1.0f)
-                  {
-                    needClamp = true;
-                    break;
-                  }
-                }
-#else
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  dst[k] += src[k] * volume;
-                  if (fabs(dst[k]) > 1.0f)
-                    needClamp = true;
-                }
-#endif
+                CAEKernels::MulAddArray(dst, src, volume, nb_floats);
+                if (!needClamp && CAEKernels::PeakArray(dst, nb_floats) > 1.0f)
+                  needClamp = true;
               }
             }
             mix->Return();
@@ -1926,7 +1985,7 @@ bool CActiveAE::RunStages()
         int nb_floats = out->pkt->nb_samples * out->pkt->config.channels / out->pkt->planes;
         for(int i=0; i<out->pkt->planes; i++)
         {
-          CAEUtil::ClampArray((float*)out->pkt->data[i], nb_floats);
+          CAEKernels::ClampArray((float*)out->pkt->data[i], nb_floats);
         }
       }
 
@@ -2098,12 +2157,7 @@ void CActiveAE::MixSounds(CSoundPacket &dstSample)
       out = (float*)dstSample.data[j];
       sample_buffer = (float*)(it->sound->GetSound(false)->data[j]+start);
       int nb_floats = mix_samples * dstSample.config.channels / dstSample.planes;
-#ifdef __SSE__
-      CAEUtil::SSEMulAddArray(out, sample_buffer, volume, nb_floats);
-#else
-      for (int k = 0; k < nb_floats; ++k)
-        *out++ += *sample_buffer++ * volume;
-#endif
+      CAEKernels::MulAddArray(out, sample_buffer, volume, nb_floats);
     }
 
     it->samples_played += mix_samples;
@@ -2129,13 +2183,7 @@ void CActiveAE::Deamplify(CSoundPacket &dstSample)
     for(int j=0; j<dstSample.planes; j++)
     {
       buffer = (float*)dstSample.data[j];
-#ifdef __SSE__
-      CAEUtil::SSEMulArray(buffer, volume, nb_floats);
-#else
-      float *fbuffer = buffer;
-      for (int i = 0; i < nb_floats; i++)
-        *fbuffer++ *= volume;
-#endif
+      CAEKernels::MulArray(buffer, volume, nb_floats);
     }
   }
 }
@@ -161,6 +161,7 @@ struct MsgStreamFade
 class CEngineStats
 {
 public:
+  CEngineStats();
   void Reset(unsigned int sampleRate);
   void UpdateSinkDelay(const AEDelayStatus& status, int samples, int64_t pts, int clockId = 0);
   void AddSamples(int samples, std::list<CActiveAEStream*> &streams);
@@ -172,8 +173,18 @@ public:
   int64_t GetPlayingPTS();
   int Discontinuity(bool reset = false);
   void SetSuspended(bool state);
-  void SetSinkCacheTotal(float time) { m_sinkCacheTotal = time; }
-  void SetSinkLatency(float time) { m_sinkLatency = time; }
+  void SetSinkCacheTotal(float time);
+  void SetSinkLatency(float time);
+  /*!
+   \brief Sets how much the engine buffers, low latency keeps it to two sink periods
+   */
+  void SetLowLatency(bool lowLatency, float sinkPeriod);
+  float GetMaxCacheLevel();
+  float GetMaxWaterLevel();
+  /*!
+   \brief Worst case time from adding data to a stream until it is played
+   */
+  float GetMaxLatency();
   bool IsSuspended();
   CCriticalSection *GetLock() { return &m_lock; }
 protected:
@@ -181,6 +192,8 @@ protected:
   int m_clockId;
   float m_sinkCacheTotal;
   float m_sinkLatency;
+  float m_cacheLevel;
+  float m_waterLevel;
   int m_bufferedSamples;
   unsigned int m_sinkSampleRate;
   AEDelayStatus m_sinkDelay;
@@ -352,6 +365,9 @@ protected:
   float m_volumeScaled; // multiplier to scale samples in order to achieve the volume specified in m_volume
   bool m_muted;
   bool m_sinkHasVolume;
+  bool m_lowLatency;
+  float m_cacheLevel;  // max time buffered per stream before the mixer in seconds
+  float m_waterLevel;  // max time buffered after the mixer in seconds
 
   // viz
   IAudioCallback *m_audioCallback;
@@ -19,6 +19,7 @@
  */
 
 #include "cores/AudioEngine/Utils/AEUtil.h"
+#include "cores/AudioEngine/Utils/AEKernels.h"
 #include "ActiveAEResampleFFMPEG.h"
 #include "utils/log.h"
 
@@ -34,6 +35,7 @@ CActiveAEResampleFFMPEG::CActiveAEResampleFFMPEG()
 {
   m_pContext = NULL;
   m_loaded = true;
+  m_directConvert = false;
 }
 
 CActiveAEResampleFFMPEG::~CActiveAEResampleFFMPEG()
@@ -59,6 +61,7 @@ bool CActiveAEResampleFFMPEG::Init(uint64_t dst_chan_layout, int dst_channels, i
   m_src_fmt = src_fmt;
   m_src_bits = src_bits;
   m_src_dither_bits = src_dither;
+  m_directConvert = false;
 
   if (m_dst_chan_layout == 0)
     m_dst_chan_layout = av_get_default_channel_layout(m_dst_channels);
@@ -176,13 +179,78 @@ bool CActiveAEResampleFFMPEG::Init(uint64_t dst_chan_layout, int dst_channels, i
     CLog::Log(LOGERROR, "CActiveAEResampleFFMPEG::Init - init resampler failed");
     return false;
   }
+
+  m_directConvert = CanConvertDirectly(remapLayout);
   return true;
 }
 
+bool CActiveAEResampleFFMPEG::CanConvertDirectly(CAEChannelInfo *remapLayout)
+{
+  if (m_src_rate != m_dst_rate || m_src_channels != m_dst_channels)
+    return false;
+
+  if (av_sample_fmt_is_planar(m_src_fmt) != av_sample_fmt_is_planar(m_dst_fmt))
+    return false;
+
+  AVSampleFormat src = av_get_packed_sample_fmt(m_src_fmt);
+  AVSampleFormat dst = av_get_packed_sample_fmt(m_dst_fmt);
+  if (src == AV_SAMPLE_FMT_FLT)
+  {
+    if (dst != AV_SAMPLE_FMT_S16 && dst != AV_SAMPLE_FMT_S32)
+      return false;
+  }
+  else if (src == AV_SAMPLE_FMT_S16 || src == AV_SAMPLE_FMT_S32)
+  {
+    if (dst != AV_SAMPLE_FMT_FLT)
+      return false;
+  }
+  else
+    return false;
+
+  // the channel matrix has to be the identity
+  if (remapLayout)
+  {
+    if ((int)remapLayout->Count() != m_dst_channels)
+      return false;
+    for (unsigned int out=0; out<remapLayout->Count(); out++)
+    {
+      if (CAEUtil::GetAVChannelIndex((*remapLayout)[out], m_src_chan_layout) != (int)out)
+        return false;
+    }
+    return true;
+  }
+
+  return m_src_chan_layout == m_dst_chan_layout;
+}
+
+int CActiveAEResampleFFMPEG::Convert(uint8_t **dst_buffer, uint8_t **src_buffer, int samples)
+{
+  int planes = av_sample_fmt_is_planar(m_dst_fmt) ? m_dst_channels : 1;
+  int count = samples * m_dst_channels / planes;
+  AVSampleFormat src = av_get_packed_sample_fmt(m_src_fmt);
+  AVSampleFormat dst = av_get_packed_sample_fmt(m_dst_fmt);
+
+  for (int i=0; i<planes; i++)
+  {
+    if (src == AV_SAMPLE_FMT_FLT && dst == AV_SAMPLE_FMT_S16)
+      CAEKernels::FloatToS16((float*)src_buffer[i], (int16_t*)dst_buffer[i], count);
+    else if (src == AV_SAMPLE_FMT_FLT && dst == AV_SAMPLE_FMT_S32)
+      CAEKernels::FloatToS32((float*)src_buffer[i], (int32_t*)dst_buffer[i], count);
+    else if (src == AV_SAMPLE_FMT_S16)
+      CAEKernels::S16ToFloat((int16_t*)src_buffer[i], (float*)dst_buffer[i], count);
+    else
+      CAEKernels::S32ToFloat((int32_t*)src_buffer[i], (float*)dst_buffer[i], count);
+  }
+  return samples;
+}
+
 int CActiveAEResampleFFMPEG::Resample(uint8_t **dst_buffer, int dst_samples, uint8_t **src_buffer, int src_samples, double ratio)
 {
   if (ratio != 1.0)
   {
+    // from now on swr holds compensation state, stay with it
+    m_directConvert = false;
+
     if (swr_set_compensation(m_pContext,
                              (dst_samples*ratio-dst_samples)*m_dst_rate/m_src_rate,
                              dst_samples*m_dst_rate/m_src_rate) < 0)
@@ -192,11 +260,19 @@ int CActiveAEResampleFFMPEG::Resample(uint8_t **dst_buffer, int dst_samples, uin
     }
   }
 
-  int ret = swr_convert(m_pContext, dst_buffer, dst_samples, (const uint8_t**)src_buffer, src_samples);
-  if (ret < 0)
+  int ret;
+  // plain sample format conversions bypass swr as long as it has nothing buffered
+  if (m_directConvert && src_samples > 0 && src_samples <= dst_samples &&
+      swr_get_delay(m_pContext, m_src_rate) == 0)
+    ret = Convert(dst_buffer, src_buffer, src_samples);
+  else
   {
-    CLog::Log(LOGERROR, "CActiveAEResampleFFMPEG::Resample - resample failed");
-    return -1;
+    ret = swr_convert(m_pContext, dst_buffer, dst_samples, (const uint8_t**)src_buffer, src_samples);
+    if (ret < 0)
+    {
+      CLog::Log(LOGERROR, "CActiveAEResampleFFMPEG::Resample - resample failed");
+      return -1;
+    }
   }
 
   // special handling for S24 formats which are carried in S32
@@ -47,6 +47,9 @@ public:
   int GetDstBufferSize(int samples);
 
 protected:
+  bool CanConvertDirectly(CAEChannelInfo *remapLayout);
+  int Convert(uint8_t **dst_buffer, uint8_t **src_buffer, int samples);
+
   bool m_loaded;
   uint64_t m_src_chan_layout, m_dst_chan_layout;
   int m_src_rate, m_dst_rate;
@@ -56,6 +59,7 @@ protected:
   int m_src_dither_bits, m_dst_dither_bits;
   SwrContext *m_pContext;
   double m_rematrix[AE_CH_MAX][AE_CH_MAX];
+  bool m_directConvert;
 };
 
 }
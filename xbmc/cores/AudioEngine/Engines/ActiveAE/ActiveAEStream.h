@@ -122,6 +122,7 @@ protected:
   float m_fadingTarget;
   int m_fadingTime;
   bool m_forceResampler;
+  bool m_lowLatency;
 };
 }
 
@@ -0,0 +1,80 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAE.h"
+
+#include "gtest/gtest.h"
+
+#include <list>
+
+using namespace ActiveAE;
+
+TEST(TestActiveAE, DefaultBuffers)
+{
+  CEngineStats stats;
+  stats.SetLowLatency(false, 0.01f);
+  stats.SetSinkCacheTotal(0.5f);
+
+  EXPECT_FLOAT_EQ(0.5f, stats.GetMaxCacheLevel());
+  EXPECT_FLOAT_EQ(0.25f, stats.GetMaxWaterLevel());
+  EXPECT_FLOAT_EQ(1.0f, stats.GetCacheTotal(NULL));
+  EXPECT_FLOAT_EQ(1.25f, stats.GetMaxLatency());
+}
+
+TEST(TestActiveAE, LowLatencyBuffers)
+{
+  CEngineStats stats;
+  // 10 ms period with four periods buffered as set up by the NULL sink
+  stats.SetLowLatency(true, 0.01f);
+  stats.SetSinkCacheTotal(0.04f);
+  stats.SetSinkLatency(0.005f);
+
+  EXPECT_FLOAT_EQ(0.02f, stats.GetMaxCacheLevel());
+  EXPECT_FLOAT_EQ(0.02f, stats.GetMaxWaterLevel());
+  EXPECT_FLOAT_EQ(0.06f, stats.GetCacheTotal(NULL));
+  EXPECT_FLOAT_EQ(0.085f, stats.GetMaxLatency());
+
+  // a flush of the engine keeps the configured buffers
+  stats.Reset(48000);
+  EXPECT_FLOAT_EQ(0.085f, stats.GetMaxLatency());
+
+  // sinks which can't go that low don't get more buffering than usual
+  stats.SetLowLatency(true, 0.3f);
+  EXPECT_FLOAT_EQ(0.5f, stats.GetMaxCacheLevel());
+  EXPECT_FLOAT_EQ(0.25f, stats.GetMaxWaterLevel());
+}
+
+TEST(TestActiveAE, Delay)
+{
+  CEngineStats stats;
+  stats.Reset(48000);
+
+  std::list<CActiveAEStream*> streams;
+  stats.AddSamples(960, streams);
+  EXPECT_FLOAT_EQ(0.02f, stats.GetWaterLevel());
+
+  AEDelayStatus status;
+  status.delay = 0.04;
+  stats.UpdateSinkDelay(status, 480, 0);
+  EXPECT_FLOAT_EQ(0.01f, stats.GetWaterLevel());
+
+  stats.GetDelay(status);
+  EXPECT_NEAR(0.05, status.delay, 1e-6);
+}
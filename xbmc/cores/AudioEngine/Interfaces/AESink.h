@@ -38,6 +38,9 @@ public:
     The sink does NOT have to honour anything in the format struct or the device
     if however it does not honour what is requested, it MUST update device/format
     with what it does support.
+    A non zero format.m_frames is the period size requested by a low latency
+    stream, sinks should go as low as the hardware allows. On return m_frames
+    is the period size that is used.
   */
   virtual bool Initialize  (AEAudioFormat &format, std::string &device) = 0;
 
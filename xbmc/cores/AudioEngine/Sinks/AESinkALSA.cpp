@@ -504,6 +504,8 @@ bool CAESinkALSA::Initialize(AEAudioFormat &format, std::string &device)
   ALSAConfig inconfig, outconfig;
   inconfig.format = format.m_dataFormat;
   inconfig.sampleRate = format.m_sampleRate;
+  // a non zero period is requested by low latency streams
+  inconfig.periodSize = format.m_frames;
 
   /*
    * We can't use the better GetChannelLayout() at this point as the device
@@ -742,6 +744,17 @@ bool CAESinkALSA::InitializeHW(const ALSAConfig &inconfig, ALSAConfig &outconfig
   */
   periodSize  = std::min(periodSize, (snd_pcm_uframes_t) sampleRate / 20);
   bufferSize  = std::min(bufferSize, (snd_pcm_uframes_t) sampleRate / 5);
+
+  /*
+   Low latency: use the requested period and keep 4 periods in the
+   buffer, the lower bound is still given by the hardware.
+  */
+  if (inconfig.periodSize > 0)
+  {
+    snd_pcm_uframes_t requested = (snd_pcm_uframes_t)inconfig.periodSize * sampleRate / inconfig.sampleRate;
+    periodSize = std::min(periodSize, requested);
+    bufferSize = std::min(bufferSize, requested * 4);
+  }
   
   /* 
    According to upstream we should set buffer size first - so make sure it is always at least
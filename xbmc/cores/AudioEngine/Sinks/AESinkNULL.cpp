@@ -22,14 +22,16 @@
 
 #include <stdint.h>
 #include <limits.h>
+#include <algorithm>
 
 #include "AESinkNULL.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
 #include "utils/log.h"
 
-CAESinkNULL::CAESinkNULL()
+CAESinkNULL::CAESinkNULL(bool simulatedClock /* = false */)
   : CThread("AESinkNull"),
     m_draining(false),
+    m_simulatedClock(simulatedClock),
     m_sink_frameSize(0),
     m_sinkbuffer_size(0),
     m_sinkbuffer_level(0),
@@ -43,19 +45,25 @@ CAESinkNULL::~CAESinkNULL()
 
 bool CAESinkNULL::Initialize(AEAudioFormat &format, std::string &device)
 {
-  // setup for a 250ms sink feed from SoftAE 
+  // low latency streams request a period, otherwise
+  // setup for a 250ms sink feed from SoftAE
+  unsigned int period    = format.m_frames;
   format.m_dataFormat    = AE_IS_RAW(format.m_dataFormat) ? AE_FMT_S16NE : AE_FMT_FLOAT;
-  format.m_frames        = format.m_sampleRate / 1000 * 250;
+  format.m_frames        = period ? period : format.m_sampleRate / 1000 * 250;
   format.m_frameSamples  = format.m_channelLayout.Count();
   format.m_frameSize     = format.m_frameSamples * (CAEUtil::DataFormatToBits(format.m_dataFormat) >> 3);
   m_format = format;
 
-  // setup a pretend 500ms internal buffer
+  // setup a pretend 500ms internal buffer, 4 periods for low latency
   m_sink_frameSize = format.m_channelLayout.Count() * CAEUtil::DataFormatToBits(format.m_dataFormat) >> 3;
-  m_sinkbuffer_size = m_sink_frameSize * format.m_sampleRate / 2;
+  m_sinkbuffer_size = m_sink_frameSize * (period ? period * 4 : format.m_sampleRate / 2);
+  m_sinkbuffer_level = 0;
   m_sinkbuffer_sec_per_byte = 1.0 / (double)(m_sink_frameSize * format.m_sampleRate);
 
   m_draining = false;
+  if (m_simulatedClock)
+    return true;
+
   m_wake.Reset();
   m_inited.Reset();
   Create();
@@ -70,6 +78,9 @@ bool CAESinkNULL::Initialize(AEAudioFormat &format, std::string &device)
 
 void CAESinkNULL::Deinitialize()
 {
+  if (m_simulatedClock)
+    return;
+
   // force m_bStop and set m_wake, if might be sleeping.
   m_bStop = true;
   StopThread();
@@ -103,10 +114,21 @@ unsigned int CAESinkNULL::AddPackets(uint8_t **data, unsigned int frames, unsign
 
 void CAESinkNULL::Drain()
 {
+  if (m_simulatedClock)
+  {
+    m_sinkbuffer_level = 0;
+    return;
+  }
   m_draining = true;
   m_wake.Set();
 }
 
+void CAESinkNULL::AdvanceClock(double seconds)
+{
+  unsigned int bytes = (unsigned int)(seconds * m_format.m_sampleRate) * m_sink_frameSize;
+  m_sinkbuffer_level -= std::min(bytes, m_sinkbuffer_level);
+}
+
 void CAESinkNULL::EnumerateDevices (AEDeviceList &devices, bool passthrough)
 {
   // we never return any devices
@@ -131,8 +153,8 @@ void CAESinkNULL::Process()
       m_draining = false;
     }
 
-    // pretend we have a 64k audio buffer
-    unsigned int min_buffer_size = 64 * 1024;
+    // pretend we have a 64k audio buffer, or a single period for low latency
+    unsigned int min_buffer_size = std::min(64U * 1024, m_format.m_frames * m_sink_frameSize);
     unsigned int read_bytes = m_sinkbuffer_level;
     if (read_bytes > min_buffer_size)
       read_bytes = min_buffer_size;
@@ -28,7 +28,12 @@ class CAESinkNULL : public CThread, public IAESink
 public:
   virtual const char *GetName() { return "NULL"; }
 
-  CAESinkNULL();
+  /*!
+   \brief Create a sink that throws away all audio
+   \param simulatedClock if true no playback thread is started, audio is only
+          consumed when AdvanceClock() is called. Used to test the engine timing.
+   */
+  CAESinkNULL(bool simulatedClock = false);
   virtual ~CAESinkNULL();
 
   virtual bool Initialize(AEAudioFormat &format, std::string &device);
@@ -40,12 +45,19 @@ public:
   virtual void         Drain           ();
 
   static void          EnumerateDevices(AEDeviceList &devices, bool passthrough);
+
+  /*!
+   \brief Consume audio as if the given time has passed on the device
+   \param seconds time that has passed since the last call
+   */
+  void                 AdvanceClock(double seconds);
 private:
   virtual void         Process();
 
   CEvent               m_wake;
   CEvent               m_inited;
   volatile bool        m_draining;
+  bool                 m_simulatedClock;
   AEAudioFormat        m_format;
   unsigned int         m_sink_frameSize;
   unsigned int         m_sinkbuffer_size;  ///< total size of the buffer
@@ -589,13 +589,21 @@ bool CAESinkPULSE::Initialize(AEAudioFormat &format, std::string &device)
   pa_stream_set_latency_update_callback(m_Stream, StreamLatencyUpdateCallback, m_MainLoop);
 
   pa_buffer_attr buffer_attr;
+  // a non zero period is requested by low latency streams
+  bool lowLatency = format.m_frames > 0;
 
   // 200ms max latency
   // 50ms min packet size
-  if(sinkStruct.isHWDevice || isDefaultDevice)
+  if(sinkStruct.isHWDevice || isDefaultDevice || lowLatency)
   {
     unsigned int latency = m_BytesPerSecond / 5;
     unsigned int process_time = latency / 4;
+    if (lowLatency)
+    {
+      // 4 periods of the requested size
+      process_time = std::min(process_time, format.m_frames * frameSize);
+      latency = process_time * 4;
+    }
     memset(&buffer_attr, 0, sizeof(buffer_attr));
     buffer_attr.tlength = (uint32_t) latency;
     buffer_attr.minreq = (uint32_t) process_time;
@@ -604,7 +612,7 @@ bool CAESinkPULSE::Initialize(AEAudioFormat &format, std::string &device)
     buffer_attr.fragsize = (uint32_t) latency;
   }
 
-  if (pa_stream_connect_playback(m_Stream, isDefaultDevice ? NULL : device.c_str(), sinkStruct.isHWDevice ? &buffer_attr : NULL, ((pa_stream_flags)(PA_STREAM_INTERPOLATE_TIMING | PA_STREAM_AUTO_TIMING_UPDATE | PA_STREAM_ADJUST_LATENCY)), NULL, NULL) < 0)
+  if (pa_stream_connect_playback(m_Stream, isDefaultDevice ? NULL : device.c_str(), (sinkStruct.isHWDevice || lowLatency) ? &buffer_attr : NULL, ((pa_stream_flags)(PA_STREAM_INTERPOLATE_TIMING | PA_STREAM_AUTO_TIMING_UPDATE | PA_STREAM_ADJUST_LATENCY)), NULL, NULL) < 0)
   {
     CLog::Log(LOGERROR, "PulseAudio: Failed to connect stream to output");
     pa_threaded_mainloop_unlock(m_MainLoop);
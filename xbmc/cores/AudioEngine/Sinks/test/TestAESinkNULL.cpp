@@ -0,0 +1,84 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Sinks/AESinkNULL.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+static AEAudioFormat GetStereoFormat(unsigned int frames)
+{
+  AEAudioFormat format;
+  format.m_dataFormat = AE_FMT_FLOAT;
+  format.m_sampleRate = 48000;
+  format.m_channelLayout = AE_CH_LAYOUT_2_0;
+  format.m_frames = frames;
+  return format;
+}
+
+TEST(TestAESinkNULL, DefaultPeriod)
+{
+  CAESinkNULL sink(true);
+  AEAudioFormat format = GetStereoFormat(0);
+  std::string device;
+
+  ASSERT_TRUE(sink.Initialize(format, device));
+  EXPECT_EQ(12000U, format.m_frames);
+  EXPECT_EQ(8U, format.m_frameSize);
+  EXPECT_DOUBLE_EQ(0.5, sink.GetCacheTotal());
+  sink.Deinitialize();
+}
+
+TEST(TestAESinkNULL, LowLatency)
+{
+  CAESinkNULL sink(true);
+  // 10 ms period as requested by ActiveAE for low latency streams
+  AEAudioFormat format = GetStereoFormat(480);
+  std::string device;
+
+  ASSERT_TRUE(sink.Initialize(format, device));
+  EXPECT_EQ(480U, format.m_frames);
+  EXPECT_NEAR(0.04, sink.GetCacheTotal(), 1e-9);
+
+  std::vector<uint8_t> buffer(format.m_frames * format.m_frameSize);
+  uint8_t *data = &buffer[0];
+  unsigned int frames, added = 0;
+  while ((frames = sink.AddPackets(&data, format.m_frames, 0)) > 0)
+    added += frames;
+  EXPECT_EQ(4 * format.m_frames, added);
+
+  AEDelayStatus status;
+  sink.GetDelay(status);
+  EXPECT_NEAR(0.04, status.delay, 1e-6);
+
+  // the simulated clock consumes exactly what has been played
+  sink.AdvanceClock(0.01);
+  sink.GetDelay(status);
+  EXPECT_NEAR(0.03, status.delay, 1e-6);
+  EXPECT_EQ(format.m_frames, sink.AddPackets(&data, format.m_frames, 0));
+
+  sink.AdvanceClock(1.0);
+  sink.GetDelay(status);
+  EXPECT_DOUBLE_EQ(0.0, status.delay);
+
+  sink.Deinitialize();
+}
@@ -0,0 +1,676 @@
+/*
+ *      Copyright (C) 2010-2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEKernels.h"
+#include "threads/Atomics.h"
+#include "utils/CPUInfo.h"
+#include <math.h>
+
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP > 1) || defined(_M_X64)
+  #define AE_KERNELS_HAVE_SSE2
+  #include <emmintrin.h>
+#endif
+
+// AVX2 kernels are compiled with a function level target so that the rest of
+// the binary does not require an AVX2 capable CPU
+#if defined(AE_KERNELS_HAVE_SSE2)
+  #if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+    #define AE_KERNELS_HAVE_AVX2
+    #define AE_TARGET_AVX2 __attribute__((target("avx2")))
+  #elif defined(_MSC_VER) && _MSC_VER >= 1700
+    #define AE_KERNELS_HAVE_AVX2
+    #define AE_TARGET_AVX2
+  #endif
+  #if defined(AE_KERNELS_HAVE_AVX2)
+    #include <immintrin.h>
+  #endif
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+  #define AE_KERNELS_HAVE_NEON
+  #include <arm_neon.h>
+#endif
+
+#define AE_S16_SCALE 32768.0f
+#define AE_S32_SCALE 2147483648.0f
+
+volatile long CAEKernels::m_set = AE_KERNELS_MAX;
+
+/* generic kernels */
+
+static void GenericMulArray(float *data, const float mul, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    data[i] *= mul;
+}
+
+static void GenericMulAddArray(float *data, const float *add, const float mul, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    data[i] += add[i] * mul;
+}
+
+static inline float GenericSoftClamp(float x)
+{
+  if (x < -3.0f)
+    return -1.0f;
+  else if (x > 3.0f)
+    return 1.0f;
+  float y = x * x;
+  return x * (27.0f + y) / (27.0f + 9.0f * y);
+}
+
+static void GenericClampArray(float *data, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    data[i] = GenericSoftClamp(data[i]);
+}
+
+static float GenericPeakArray(const float *data, uint32_t count)
+{
+  float peak = 0.0f;
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    float value = fabsf(data[i]);
+    if (value > peak)
+      peak = value;
+  }
+  return peak;
+}
+
+static inline int16_t GenericFloatToS16(float x)
+{
+  float value = x * AE_S16_SCALE;
+  if (value >= 32767.0f)
+    return INT16_MAX;
+  else if (value <= -32768.0f)
+    return INT16_MIN;
+  return (int16_t)lrintf(value);
+}
+
+static inline int32_t GenericFloatToS32(float x)
+{
+  // the product is exact, the largest float below 2^31 is 2147483520
+  float value = x * AE_S32_SCALE;
+  if (value >= AE_S32_SCALE)
+    return INT32_MAX;
+  else if (value <= -AE_S32_SCALE)
+    return INT32_MIN;
+  return (int32_t)lrintf(value);
+}
+
+static void GenericFloatToS16Array(const float *src, int16_t *dst, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    dst[i] = GenericFloatToS16(src[i]);
+}
+
+static void GenericFloatToS32Array(const float *src, int32_t *dst, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    dst[i] = GenericFloatToS32(src[i]);
+}
+
+static void GenericS16ToFloatArray(const int16_t *src, float *dst, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    dst[i] = src[i] * (1.0f / AE_S16_SCALE);
+}
+
+static void GenericS32ToFloatArray(const int32_t *src, float *dst, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    dst[i] = (float)src[i] * (1.0f / AE_S32_SCALE);
+}
+
+static const CAEKernels::Kernels GenericKernels =
+{
+  GenericMulArray,
+  GenericMulAddArray,
+  GenericClampArray,
+  GenericPeakArray,
+  GenericFloatToS16Array,
+  GenericFloatToS32Array,
+  GenericS16ToFloatArray,
+  GenericS32ToFloatArray
+};
+
+/* SSE2 kernels */
+
+#if defined(AE_KERNELS_HAVE_SSE2)
+static void SSE2MulArray(float *data, const float mul, uint32_t count)
+{
+  const __m128 m = _mm_set1_ps(mul);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), m));
+  GenericMulArray(data + i, mul, count - i);
+}
+
+static void SSE2MulAddArray(float *data, const float *add, const float mul, uint32_t count)
+{
+  const __m128 m = _mm_set1_ps(mul);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 ad = _mm_mul_ps(_mm_loadu_ps(add + i), m);
+    _mm_storeu_ps(data + i, _mm_add_ps(_mm_loadu_ps(data + i), ad));
+  }
+  GenericMulAddArray(data + i, add + i, mul, count - i);
+}
+
+static void SSE2ClampArray(float *data, uint32_t count)
+{
+  const __m128 c1 = _mm_set1_ps(27.0f);
+  const __m128 c2 = _mm_set1_ps(9.0f);
+  const __m128 hi = _mm_set1_ps(3.0f);
+  const __m128 lo = _mm_set1_ps(-3.0f);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    // beyond +-3 the approximation is exactly +-1
+    __m128 x = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(data + i), hi), lo);
+    __m128 y = _mm_mul_ps(x, x);
+    __m128 n = _mm_mul_ps(x, _mm_add_ps(c1, y));
+    _mm_storeu_ps(data + i, _mm_div_ps(n, _mm_add_ps(c1, _mm_mul_ps(c2, y))));
+  }
+  GenericClampArray(data + i, count - i);
+}
+
+static float SSE2PeakArray(const float *data, uint32_t count)
+{
+  const __m128 abs = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+  __m128 peak = _mm_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    peak = _mm_max_ps(peak, _mm_and_ps(_mm_loadu_ps(data + i), abs));
+
+  peak = _mm_max_ps(peak, _mm_movehl_ps(peak, peak));
+  peak = _mm_max_ss(peak, _mm_shuffle_ps(peak, peak, 1));
+  float result = _mm_cvtss_f32(peak);
+  float tail = GenericPeakArray(data + i, count - i);
+  return tail > result ? tail : result;
+}
+
+static void SSE2FloatToS16Array(const float *src, int16_t *dst, uint32_t count)
+{
+  const __m128 scale = _mm_set1_ps(AE_S16_SCALE);
+  const __m128 hi = _mm_set1_ps(32767.0f);
+  const __m128 lo = _mm_set1_ps(-32768.0f);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128 a = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+    __m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+    a = _mm_max_ps(_mm_min_ps(a, hi), lo);
+    b = _mm_max_ps(_mm_min_ps(b, hi), lo);
+    __m128i out = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+    _mm_storeu_si128((__m128i*)(dst + i), out);
+  }
+  GenericFloatToS16Array(src + i, dst + i, count - i);
+}
+
+static void SSE2FloatToS32Array(const float *src, int32_t *dst, uint32_t count)
+{
+  const __m128 scale = _mm_set1_ps(AE_S32_SCALE);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 value = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+    // positive overflow converts to 0x80000000, flip it to 0x7FFFFFFF
+    __m128i overflow = _mm_castps_si128(_mm_cmpge_ps(value, scale));
+    __m128i out = _mm_xor_si128(_mm_cvtps_epi32(value), overflow);
+    _mm_storeu_si128((__m128i*)(dst + i), out);
+  }
+  GenericFloatToS32Array(src + i, dst + i, count - i);
+}
+
+static void SSE2S16ToFloatArray(const int16_t *src, float *dst, uint32_t count)
+{
+  const __m128 scale = _mm_set1_ps(1.0f / AE_S16_SCALE);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+    // sign extend to 32 bit
+    __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16);
+    __m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16);
+    _mm_storeu_ps(dst + i,     _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+    _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+  }
+  GenericS16ToFloatArray(src + i, dst + i, count - i);
+}
+
+static void SSE2S32ToFloatArray(const int32_t *src, float *dst, uint32_t count)
+{
+  const __m128 scale = _mm_set1_ps(1.0f / AE_S32_SCALE);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(in), scale));
+  }
+  GenericS32ToFloatArray(src + i, dst + i, count - i);
+}
+
+static const CAEKernels::Kernels SSE2Kernels =
+{
+  SSE2MulArray,
+  SSE2MulAddArray,
+  SSE2ClampArray,
+  SSE2PeakArray,
+  SSE2FloatToS16Array,
+  SSE2FloatToS32Array,
+  SSE2S16ToFloatArray,
+  SSE2S32ToFloatArray
+};
+#endif
+
+/* AVX2 kernels */
+
+#if defined(AE_KERNELS_HAVE_AVX2)
+AE_TARGET_AVX2 static void AVX2MulArray(float *data, const float mul, uint32_t count)
+{
+  const __m256 m = _mm256_set1_ps(mul);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), m));
+  GenericMulArray(data + i, mul, count - i);
+}
+
+AE_TARGET_AVX2 static void AVX2MulAddArray(float *data, const float *add, const float mul, uint32_t count)
+{
+  const __m256 m = _mm256_set1_ps(mul);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    // no fma here, results have to match the other kernel sets
+    __m256 ad = _mm256_mul_ps(_mm256_loadu_ps(add + i), m);
+    _mm256_storeu_ps(data + i, _mm256_add_ps(_mm256_loadu_ps(data + i), ad));
+  }
+  GenericMulAddArray(data + i, add + i, mul, count - i);
+}
+
+AE_TARGET_AVX2 static void AVX2ClampArray(float *data, uint32_t count)
+{
+  const __m256 c1 = _mm256_set1_ps(27.0f);
+  const __m256 c2 = _mm256_set1_ps(9.0f);
+  const __m256 hi = _mm256_set1_ps(3.0f);
+  const __m256 lo = _mm256_set1_ps(-3.0f);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 x = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(data + i), hi), lo);
+    __m256 y = _mm256_mul_ps(x, x);
+    __m256 n = _mm256_mul_ps(x, _mm256_add_ps(c1, y));
+    _mm256_storeu_ps(data + i, _mm256_div_ps(n, _mm256_add_ps(c1, _mm256_mul_ps(c2, y))));
+  }
+  GenericClampArray(data + i, count - i);
+}
+
+AE_TARGET_AVX2 static float AVX2PeakArray(const float *data, uint32_t count)
+{
+  const __m256 abs = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+  __m256 peak = _mm256_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+    peak = _mm256_max_ps(peak, _mm256_and_ps(_mm256_loadu_ps(data + i), abs));
+
+  __m128 half = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+  half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+  half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+  float result = _mm_cvtss_f32(half);
+  float tail = GenericPeakArray(data + i, count - i);
+  return tail > result ? tail : result;
+}
+
+AE_TARGET_AVX2 static void AVX2FloatToS16Array(const float *src, int16_t *dst, uint32_t count)
+{
+  const __m256 scale = _mm256_set1_ps(AE_S16_SCALE);
+  const __m256 hi = _mm256_set1_ps(32767.0f);
+  const __m256 lo = _mm256_set1_ps(-32768.0f);
+  uint32_t i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    __m256 a = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+    __m256 b = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale);
+    a = _mm256_max_ps(_mm256_min_ps(a, hi), lo);
+    b = _mm256_max_ps(_mm256_min_ps(b, hi), lo);
+    // packs works per 128 bit lane, restore the sample order afterwards
+    __m256i out = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+    out = _mm256_permute4x64_epi64(out, 0xD8);
+    _mm256_storeu_si256((__m256i*)(dst + i), out);
+  }
+  GenericFloatToS16Array(src + i, dst + i, count - i);
+}
+
+AE_TARGET_AVX2 static void AVX2FloatToS32Array(const float *src, int32_t *dst, uint32_t count)
+{
+  const __m256 scale = _mm256_set1_ps(AE_S32_SCALE);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 value = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+    __m256i overflow = _mm256_castps_si256(_mm256_cmp_ps(value, scale, _CMP_GE_OQ));
+    __m256i out = _mm256_xor_si256(_mm256_cvtps_epi32(value), overflow);
+    _mm256_storeu_si256((__m256i*)(dst + i), out);
+  }
+  GenericFloatToS32Array(src + i, dst + i, count - i);
+}
+
+AE_TARGET_AVX2 static void AVX2S16ToFloatArray(const int16_t *src, float *dst, uint32_t count)
+{
+  const __m256 scale = _mm256_set1_ps(1.0f / AE_S16_SCALE);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i in = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+    _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(in), scale));
+  }
+  GenericS16ToFloatArray(src + i, dst + i, count - i);
+}
+
+AE_TARGET_AVX2 static void AVX2S32ToFloatArray(const int32_t *src, float *dst, uint32_t count)
+{
+  const __m256 scale = _mm256_set1_ps(1.0f / AE_S32_SCALE);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i in = _mm256_loadu_si256((const __m256i*)(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(in), scale));
+  }
+  GenericS32ToFloatArray(src + i, dst + i, count - i);
+}
+
+static const CAEKernels::Kernels AVX2Kernels =
+{
+  AVX2MulArray,
+  AVX2MulAddArray,
+  AVX2ClampArray,
+  AVX2PeakArray,
+  AVX2FloatToS16Array,
+  AVX2FloatToS32Array,
+  AVX2S16ToFloatArray,
+  AVX2S32ToFloatArray
+};
+#endif
+
+/* NEON kernels */
+
+#if defined(AE_KERNELS_HAVE_NEON)
+static void NEONMulArray(float *data, const float mul, uint32_t count)
+{
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    vst1q_f32(data + i, vmulq_n_f32(vld1q_f32(data + i), mul));
+  GenericMulArray(data + i, mul, count - i);
+}
+
+static void NEONMulAddArray(float *data, const float *add, const float mul, uint32_t count)
+{
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    float32x4_t ad = vmulq_n_f32(vld1q_f32(add + i), mul);
+    vst1q_f32(data + i, vaddq_f32(vld1q_f32(data + i), ad));
+  }
+  GenericMulAddArray(data + i, add + i, mul, count - i);
+}
+
+static void NEONClampArray(float *data, uint32_t count)
+{
+  const float32x4_t c1 = vdupq_n_f32(27.0f);
+  const float32x4_t hi = vdupq_n_f32(3.0f);
+  const float32x4_t lo = vdupq_n_f32(-3.0f);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    float32x4_t x = vmaxq_f32(vminq_f32(vld1q_f32(data + i), hi), lo);
+    float32x4_t y = vmulq_f32(x, x);
+    float32x4_t n = vmulq_f32(x, vaddq_f32(c1, y));
+    float32x4_t d = vmlaq_n_f32(c1, y, 9.0f);
+    // no vector divide on armv7, refine the reciprocal estimate twice
+    float32x4_t r = vrecpeq_f32(d);
+    r = vmulq_f32(vrecpsq_f32(d, r), r);
+    r = vmulq_f32(vrecpsq_f32(d, r), r);
+    vst1q_f32(data + i, vmulq_f32(n, r));
+  }
+  GenericClampArray(data + i, count - i);
+}
+
+static float NEONPeakArray(const float *data, uint32_t count)
+{
+  float32x4_t peak = vdupq_n_f32(0.0f);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    peak = vmaxq_f32(peak, vabsq_f32(vld1q_f32(data + i)));
+
+  float32x2_t half = vpmax_f32(vget_low_f32(peak), vget_high_f32(peak));
+  half = vpmax_f32(half, half);
+  float result = vget_lane_f32(half, 0);
+  float tail = GenericPeakArray(data + i, count - i);
+  return tail > result ? tail : result;
+}
+
+static inline int32x4_t NEONRound(float32x4_t value)
+{
+  // round to nearest even like lrintf does in the generic kernels
+#if defined(__aarch64__)
+  return vcvtnq_s32_f32(value);
+#else
+  // vcvt truncates. Adding and subtracting 2^23 (with the sign of the value)
+  // leaves no fraction bits, so the FPU rounds to nearest even. Values of
+  // 2^23 and above have no fraction and are passed on to vcvt which saturates.
+  const float32x4_t magic = vdupq_n_f32(8388608.0f);
+  const uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(value), vdupq_n_u32(0x80000000));
+  float32x4_t m = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(magic), sign));
+  float32x4_t rounded = vsubq_f32(vaddq_f32(value, m), m);
+  uint32x4_t small = vcltq_f32(vabsq_f32(value), magic);
+  return vcvtq_s32_f32(vbslq_f32(small, rounded, value));
+#endif
+}
+
+static void NEONFloatToS16Array(const float *src, int16_t *dst, uint32_t count)
+{
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    int32x4_t a = NEONRound(vmulq_n_f32(vld1q_f32(src + i), AE_S16_SCALE));
+    int32x4_t b = NEONRound(vmulq_n_f32(vld1q_f32(src + i + 4), AE_S16_SCALE));
+    vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+  }
+  GenericFloatToS16Array(src + i, dst + i, count - i);
+}
+
+static void NEONFloatToS32Array(const float *src, int32_t *dst, uint32_t count)
+{
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    vst1q_s32(dst + i, NEONRound(vmulq_n_f32(vld1q_f32(src + i), AE_S32_SCALE)));
+  GenericFloatToS32Array(src + i, dst + i, count - i);
+}
+
+static void NEONS16ToFloatArray(const int16_t *src, float *dst, uint32_t count)
+{
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    int16x8_t in = vld1q_s16(src + i);
+    int32x4_t a = vmovl_s16(vget_low_s16(in));
+    int32x4_t b = vmovl_s16(vget_high_s16(in));
+    vst1q_f32(dst + i,     vmulq_n_f32(vcvtq_f32_s32(a), 1.0f / AE_S16_SCALE));
+    vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_s32(b), 1.0f / AE_S16_SCALE));
+  }
+  GenericS16ToFloatArray(src + i, dst + i, count - i);
+}
+
+static void NEONS32ToFloatArray(const int32_t *src, float *dst, uint32_t count)
+{
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(src + i)), 1.0f / AE_S32_SCALE));
+  GenericS32ToFloatArray(src + i, dst + i, count - i);
+}
+
+static const CAEKernels::Kernels NEONKernels =
+{
+  NEONMulArray,
+  NEONMulAddArray,
+  NEONClampArray,
+  NEONPeakArray,
+  NEONFloatToS16Array,
+  NEONFloatToS32Array,
+  NEONS16ToFloatArray,
+  NEONS32ToFloatArray
+};
+#endif
+
+/* dispatch */
+
+const CAEKernels::Kernels* CAEKernels::GetKernels(AEKernelSet set)
+{
+  switch (set)
+  {
+#if defined(AE_KERNELS_HAVE_SSE2)
+    case AE_KERNELS_SSE2:
+      return &SSE2Kernels;
+#endif
+#if defined(AE_KERNELS_HAVE_AVX2)
+    case AE_KERNELS_AVX2:
+      return &AVX2Kernels;
+#endif
+#if defined(AE_KERNELS_HAVE_NEON)
+    case AE_KERNELS_NEON:
+      return &NEONKernels;
+#endif
+    case AE_KERNELS_GENERIC:
+      return &GenericKernels;
+    default:
+      return NULL;
+  }
+}
+
+bool CAEKernels::IsSupported(AEKernelSet set)
+{
+  if (GetKernels(set) == NULL)
+    return false;
+
+  unsigned int features = g_cpuInfo.GetCPUFeatures();
+  switch (set)
+  {
+    case AE_KERNELS_SSE2:
+      return (features & CPU_FEATURE_SSE2) != 0;
+    case AE_KERNELS_AVX2:
+      return (features & CPU_FEATURE_AVX2) != 0;
+    case AE_KERNELS_NEON:
+      return (features & CPU_FEATURE_NEON) != 0;
+    default:
+      return true;
+  }
+}
+
+AEKernelSet CAEKernels::DetectKernelSet()
+{
+  if (IsSupported(AE_KERNELS_AVX2))
+    return AE_KERNELS_AVX2;
+  if (IsSupported(AE_KERNELS_SSE2))
+    return AE_KERNELS_SSE2;
+  if (IsSupported(AE_KERNELS_NEON))
+    return AE_KERNELS_NEON;
+  return AE_KERNELS_GENERIC;
+}
+
+const CAEKernels::Kernels* CAEKernels::GetKernels()
+{
+  return GetKernels(GetKernelSet());
+}
+
+AEKernelSet CAEKernels::GetKernelSet()
+{
+  long set = m_set;
+  if (set == AE_KERNELS_MAX)
+  {
+    // concurrent first calls detect the same set, only the first one is stored
+    cas(&m_set, AE_KERNELS_MAX, DetectKernelSet());
+    set = m_set;
+  }
+  return (AEKernelSet)set;
+}
+
+bool CAEKernels::SetKernelSet(AEKernelSet set)
+{
+  if (!IsSupported(set))
+    return false;
+
+  m_set = set;
+  return true;
+}
+
+const char* CAEKernels::GetKernelSetName(AEKernelSet set)
+{
+  switch (set)
+  {
+    case AE_KERNELS_GENERIC: return "generic";
+    case AE_KERNELS_SSE2:    return "sse2";
+    case AE_KERNELS_AVX2:    return "avx2";
+    case AE_KERNELS_NEON:    return "neon";
+    default:                 return "unknown";
+  }
+}
+
+void CAEKernels::MulArray(float *data, const float mul, uint32_t count)
+{
+  GetKernels()->MulArray(data, mul, count);
+}
+
+void CAEKernels::MulAddArray(float *data, const float *add, const float mul, uint32_t count)
+{
+  GetKernels()->MulAddArray(data, add, mul, count);
+}
+
+void CAEKernels::ClampArray(float *data, uint32_t count)
+{
+  GetKernels()->ClampArray(data, count);
+}
+
+float CAEKernels::PeakArray(const float *data, uint32_t count)
+{
+  return GetKernels()->PeakArray(data, count);
+}
+
+void CAEKernels::FloatToS16(const float *src, int16_t *dst, uint32_t count)
+{
+  GetKernels()->FloatToS16(src, dst, count);
+}
+
+void CAEKernels::FloatToS32(const float *src, int32_t *dst, uint32_t count)
+{
+  GetKernels()->FloatToS32(src, dst, count);
+}
+
+void CAEKernels::S16ToFloat(const int16_t *src, float *dst, uint32_t count)
+{
+  GetKernels()->S16ToFloat(src, dst, count);
+}
+
+void CAEKernels::S32ToFloat(const int32_t *src, float *dst, uint32_t count)
+{
+  GetKernels()->S32ToFloat(src, dst, count);
+}
@@ -0,0 +1,98 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+
+enum AEKernelSet
+{
+  AE_KERNELS_GENERIC = 0,
+  AE_KERNELS_SSE2,
+  AE_KERNELS_AVX2,
+  AE_KERNELS_NEON,
+  AE_KERNELS_MAX
+};
+
+/*!
+ \brief Sample processing kernels used by the audio engine's mixing stage.
+
+ Every kernel has a plain C implementation plus SIMD variants for the
+ instruction sets that were available at compile time. The best variant is
+ picked once at runtime from the features reported by CCPUInfo, so a single
+ binary runs everywhere and still uses AVX2 or NEON when the CPU has them.
+
+ Conversions follow the scaling used by libswresample: floats are scaled by
+ 2^15 resp. 2^31, rounded to nearest and saturated.
+ */
+class CAEKernels
+{
+public:
+  /*! \brief data[i] *= mul */
+  static void MulArray(float *data, const float mul, uint32_t count);
+
+  /*! \brief data[i] += add[i] * mul */
+  static void MulAddArray(float *data, const float *add, const float mul, uint32_t count);
+
+  /*! \brief Soft clamp all samples to [-1.0, 1.0], see CAEUtil::SoftClamp */
+  static void ClampArray(float *data, uint32_t count);
+
+  /*! \brief Return the largest absolute sample value of the array */
+  static float PeakArray(const float *data, uint32_t count);
+
+  static void FloatToS16(const float *src, int16_t *dst, uint32_t count);
+  static void FloatToS32(const float *src, int32_t *dst, uint32_t count);
+  static void S16ToFloat(const int16_t *src, float *dst, uint32_t count);
+  static void S32ToFloat(const int32_t *src, float *dst, uint32_t count);
+
+  /*! \brief Return the kernel set used by the functions above */
+  static AEKernelSet GetKernelSet();
+
+  /*! \brief Return true if the given kernel set was compiled in and is supported by the CPU */
+  static bool IsSupported(AEKernelSet set);
+
+  /*!
+   \brief Force a kernel set, used by the unit tests and benchmarks
+   \param set the kernel set to use, must be supported
+   \return true if the kernel set was selected, false otherwise
+   */
+  static bool SetKernelSet(AEKernelSet set);
+
+  static const char* GetKernelSetName(AEKernelSet set);
+
+  struct Kernels
+  {
+    void  (*MulArray)   (float *data, const float mul, uint32_t count);
+    void  (*MulAddArray)(float *data, const float *add, const float mul, uint32_t count);
+    void  (*ClampArray) (float *data, uint32_t count);
+    float (*PeakArray)  (const float *data, uint32_t count);
+    void  (*FloatToS16) (const float *src, int16_t *dst, uint32_t count);
+    void  (*FloatToS32) (const float *src, int32_t *dst, uint32_t count);
+    void  (*S16ToFloat) (const int16_t *src, float *dst, uint32_t count);
+    void  (*S32ToFloat) (const int32_t *src, float *dst, uint32_t count);
+  };
+
+private:
+  static const Kernels* GetKernels();
+  static const Kernels* GetKernels(AEKernelSet set);
+  static AEKernelSet DetectKernelSet();
+
+  // the selected AEKernelSet, AE_KERNELS_MAX until it has been detected
+  static volatile long m_set;
+};
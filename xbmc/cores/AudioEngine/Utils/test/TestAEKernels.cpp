@@ -0,0 +1,244 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEKernels.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// 7.1 at 48kHz, one period of the sink
+#define FRAMES   1024
+#define CHANNELS 8
+#define SAMPLES  (FRAMES * CHANNELS + 3) // odd count to exercise the tails
+
+class TestAEKernels : public testing::Test
+{
+protected:
+  TestAEKernels()
+  {
+    m_set = CAEKernels::GetKernelSet();
+    m_input.resize(SAMPLES);
+    m_add.resize(SAMPLES);
+    srand(42);
+    for (unsigned int i = 0; i < SAMPLES; i++)
+    {
+      m_input[i] = (rand() % 40001 - 20000) / 10000.0f; // [-2.0, 2.0]
+      m_add[i]   = (rand() % 20001 - 10000) / 10000.0f; // [-1.0, 1.0]
+    }
+    m_input[0] = 1.0f;
+    m_input[1] = -1.0f;
+    m_input[2] = 4.0f;
+    m_input[3] = -4.0f;
+  }
+
+  ~TestAEKernels()
+  {
+    CAEKernels::SetKernelSet(m_set);
+  }
+
+  std::vector<AEKernelSet> GetSets()
+  {
+    std::vector<AEKernelSet> sets;
+    for (int set = AE_KERNELS_GENERIC + 1; set < AE_KERNELS_MAX; set++)
+    {
+      if (CAEKernels::IsSupported((AEKernelSet)set))
+        sets.push_back((AEKernelSet)set);
+    }
+    return sets;
+  }
+
+  AEKernelSet m_set;
+  std::vector<float> m_input;
+  std::vector<float> m_add;
+};
+
+TEST_F(TestAEKernels, Generic)
+{
+  float data[4] = { 0.5f, -0.5f, 3.5f, -3.5f };
+  EXPECT_TRUE(CAEKernels::SetKernelSet(AE_KERNELS_GENERIC));
+
+  EXPECT_FLOAT_EQ(3.5f, CAEKernels::PeakArray(data, 4));
+
+  CAEKernels::MulArray(data, 2.0f, 4);
+  EXPECT_FLOAT_EQ(1.0f, data[0]);
+  EXPECT_FLOAT_EQ(-7.0f, data[3]);
+
+  // soft clipping starts well below full scale
+  CAEKernels::ClampArray(data, 4);
+  EXPECT_FLOAT_EQ(28.0f / 36.0f, data[0]);
+  EXPECT_FLOAT_EQ(-28.0f / 36.0f, data[1]);
+  EXPECT_FLOAT_EQ(1.0f, data[2]);
+  EXPECT_FLOAT_EQ(-1.0f, data[3]);
+
+  float in[4] = { 1.0f, -1.0f, 0.5f, 2.0f };
+  int16_t s16[4];
+  int32_t s32[4];
+  CAEKernels::FloatToS16(in, s16, 4);
+  EXPECT_EQ(32767, s16[0]);
+  EXPECT_EQ(-32768, s16[1]);
+  EXPECT_EQ(16384, s16[2]);
+  EXPECT_EQ(32767, s16[3]);
+  CAEKernels::FloatToS32(in, s32, 4);
+  EXPECT_EQ(INT32_MAX, s32[0]);
+  EXPECT_EQ(INT32_MIN, s32[1]);
+  EXPECT_EQ(1073741824, s32[2]);
+  EXPECT_EQ(INT32_MAX, s32[3]);
+
+  CAEKernels::S16ToFloat(s16, data, 4);
+  EXPECT_FLOAT_EQ(-1.0f, data[1]);
+  EXPECT_FLOAT_EQ(0.5f, data[2]);
+  CAEKernels::S32ToFloat(s32, data, 4);
+  EXPECT_FLOAT_EQ(-1.0f, data[1]);
+  EXPECT_FLOAT_EQ(0.5f, data[2]);
+}
+
+TEST_F(TestAEKernels, MatchesGeneric)
+{
+  std::vector<AEKernelSet> sets = GetSets();
+  for (std::vector<AEKernelSet>::iterator it = sets.begin(); it != sets.end(); ++it)
+  {
+    SCOPED_TRACE(CAEKernels::GetKernelSetName(*it));
+
+    std::vector<float> ref(m_input), out(m_input);
+    std::vector<int16_t> ref16(SAMPLES), out16(SAMPLES);
+    std::vector<int32_t> ref32(SAMPLES), out32(SAMPLES);
+
+    CAEKernels::SetKernelSet(AE_KERNELS_GENERIC);
+    CAEKernels::MulAddArray(&ref[1], &m_add[0], 0.75f, SAMPLES - 1);
+    CAEKernels::MulArray(&ref[0], 0.5f, SAMPLES);
+    float refPeak = CAEKernels::PeakArray(&ref[1], SAMPLES - 1);
+    CAEKernels::FloatToS16(&ref[0], &ref16[0], SAMPLES);
+    CAEKernels::FloatToS32(&ref[0], &ref32[0], SAMPLES);
+    CAEKernels::ClampArray(&ref[0], SAMPLES);
+
+    ASSERT_TRUE(CAEKernels::SetKernelSet(*it));
+    CAEKernels::MulAddArray(&out[1], &m_add[0], 0.75f, SAMPLES - 1);
+    CAEKernels::MulArray(&out[0], 0.5f, SAMPLES);
+    EXPECT_EQ(refPeak, CAEKernels::PeakArray(&out[1], SAMPLES - 1));
+    CAEKernels::FloatToS16(&out[0], &out16[0], SAMPLES);
+    CAEKernels::FloatToS32(&out[0], &out32[0], SAMPLES);
+    CAEKernels::ClampArray(&out[0], SAMPLES);
+
+    // neon approximates the division of the soft clamp
+    for (unsigned int i = 0; i < SAMPLES; i++)
+      EXPECT_NEAR(ref[i], out[i], 1e-6f) << "sample " << i;
+    EXPECT_TRUE(ref16 == out16);
+    EXPECT_TRUE(ref32 == out32);
+
+    std::vector<float> ref2(SAMPLES);
+    CAEKernels::SetKernelSet(AE_KERNELS_GENERIC);
+    CAEKernels::S16ToFloat(&ref16[0], &ref[0], SAMPLES);
+    CAEKernels::S32ToFloat(&ref32[0], &ref2[0], SAMPLES);
+    CAEKernels::SetKernelSet(*it);
+    CAEKernels::S16ToFloat(&ref16[0], &out[0], SAMPLES);
+    EXPECT_TRUE(!memcmp(&ref[0], &out[0], SAMPLES * sizeof(float)));
+    CAEKernels::S32ToFloat(&ref32[0], &out[0], SAMPLES);
+    EXPECT_TRUE(!memcmp(&ref2[0], &out[0], SAMPLES * sizeof(float)));
+  }
+}
+
+TEST_F(TestAEKernels, RoundHalfToEven)
+{
+  // halfway cases after scaling, plus values without a fraction
+  const float in[8] = { 0.5f / 32768, 1.5f / 32768, 2.5f / 32768, -0.5f / 32768,
+                        -2.5f / 32768, 32766.5f / 32768, -32767.5f / 32768, 8.0f / 32768 };
+  const int16_t expected16[8] = { 0, 2, 2, 0, -2, 32766, -32768, 8 };
+  const int32_t expected32[8] = { 32768, 98304, 163840, -32768, -163840, 2147385344, -2147450880, 524288 };
+
+  std::vector<AEKernelSet> sets = GetSets();
+  sets.insert(sets.begin(), AE_KERNELS_GENERIC);
+  for (std::vector<AEKernelSet>::iterator it = sets.begin(); it != sets.end(); ++it)
+  {
+    SCOPED_TRACE(CAEKernels::GetKernelSetName(*it));
+    ASSERT_TRUE(CAEKernels::SetKernelSet(*it));
+
+    // 16 values to run the vector loops as well as the tails
+    float src[16];
+    int16_t s16[16];
+    int32_t s32[16];
+    for (unsigned int i = 0; i < 16; i++)
+      src[i] = in[i % 8];
+    CAEKernels::FloatToS16(src, s16, 16);
+    CAEKernels::FloatToS32(src, s32, 16);
+    for (unsigned int i = 0; i < 16; i++)
+    {
+      EXPECT_EQ(expected16[i % 8], s16[i]) << "sample " << i;
+      EXPECT_EQ(expected32[i % 8], s32[i]) << "sample " << i;
+    }
+  }
+}
+
+/* Not a correctness test, prints the throughput of every kernel set that is
+ * supported by this machine. Runs on the cpu only, no audio device needed.
+ */
+TEST_F(TestAEKernels, Benchmark)
+{
+  const int iterations = 2000;
+  std::vector<AEKernelSet> sets = GetSets();
+  sets.insert(sets.begin(), AE_KERNELS_GENERIC);
+
+  std::vector<float> data(SAMPLES);
+  std::vector<int16_t> s16(SAMPLES);
+  std::vector<int32_t> s32(SAMPLES);
+  double freq = (double)CurrentHostFrequency();
+
+  std::cout << "Selected kernel set: " << CAEKernels::GetKernelSetName(m_set) << std::endl;
+  for (std::vector<AEKernelSet>::iterator it = sets.begin(); it != sets.end(); ++it)
+  {
+    ASSERT_TRUE(CAEKernels::SetKernelSet(*it));
+    int64_t times[6] = { 0 };
+    float peak = 0.0f;
+
+    for (int i = 0; i < iterations; i++)
+    {
+      memcpy(&data[0], &m_input[0], SAMPLES * sizeof(float));
+      int64_t start = CurrentHostCounter();
+      CAEKernels::MulArray(&data[0], 0.5f, SAMPLES);
+      int64_t t1 = CurrentHostCounter();
+      CAEKernels::MulAddArray(&data[0], &m_add[0], 0.5f, SAMPLES);
+      int64_t t2 = CurrentHostCounter();
+      peak += CAEKernels::PeakArray(&data[0], SAMPLES);
+      int64_t t3 = CurrentHostCounter();
+      CAEKernels::ClampArray(&data[0], SAMPLES);
+      int64_t t4 = CurrentHostCounter();
+      CAEKernels::FloatToS16(&data[0], &s16[0], SAMPLES);
+      int64_t t5 = CurrentHostCounter();
+      CAEKernels::FloatToS32(&data[0], &s32[0], SAMPLES);
+      int64_t t6 = CurrentHostCounter();
+      times[0] += t1 - start;
+      times[1] += t2 - t1;
+      times[2] += t3 - t2;
+      times[3] += t4 - t3;
+      times[4] += t5 - t4;
+      times[5] += t6 - t5;
+    }
+    EXPECT_GT(peak, 0.0f);
+
+    static const char *names[6] = { "mul", "muladd", "peak", "clamp", "float->s16", "float->s32" };
+    std::cout << CAEKernels::GetKernelSetName(*it) << ":";
+    for (int i = 0; i < 6; i++)
+      std::cout << " " << names[i] << " " << (double)times[i] * 1e9 / freq / iterations / SAMPLES << "ns";
+    std::cout << " (per sample)" << std::endl;
+  }
+}
@@ -49,7 +49,7 @@ bool CRetroPlayerAudio::Start(AEDataFormat format, double samplerate)
 
     CLog::Log(LOGINFO, "RetroPlayerAudio: Creating audio stream, sample rate hint = %u", newsamplerate);
     static enum AEChannel map[3] = { AE_CH_FL, AE_CH_FR, AE_CH_NULL };
-    m_pAudioStream = CAEFactory::MakeStream(format, newsamplerate, newsamplerate, CAEChannelInfo(map), AESTREAM_AUTOSTART);
+    m_pAudioStream = CAEFactory::MakeStream(format, newsamplerate, newsamplerate, CAEChannelInfo(map), AESTREAM_AUTOSTART | AESTREAM_LOW_LATENCY);
 
     if (!m_pAudioStream)
     {
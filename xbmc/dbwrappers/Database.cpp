@@ -106,6 +106,10 @@ CDatabase::CDatabase(void)
   m_sqlite = true;
   m_bMultiWrite = false;
   m_multipleExecute = false;
+  m_batchSize = 0;
+  m_batchCount = 0;
+  m_batchTransaction = false;
+  m_batchSavepoint = false;
 }
 
 CDatabase::~CDatabase(void)
@@ -234,6 +238,22 @@ bool CDatabase::ExecuteQuery(const std::string &strQuery)
   return bReturn;
 }
 
+std::shared_ptr<Statement> CDatabase::PrepareStatement(const std::string &strQuery, bool cache /* = true */)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return std::shared_ptr<Statement>();
+
+    return m_pDB->prepareStatement(strQuery, cache);
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - failed to prepare query '%s'",
+        __FUNCTION__, strQuery.c_str());
+  }
+  return std::shared_ptr<Statement>();
+}
+
 bool CDatabase::ResultQuery(const std::string &strQuery)
 {
   bool bReturn = false;
@@ -574,6 +594,7 @@ void CDatabase::Close()
     return;
   }
 
+  EndBatch();
   m_openCount = 0;
   m_multipleExecute = false;
 
@@ -631,7 +652,21 @@ void CDatabase::BeginTransaction()
   try
   {
     if (NULL != m_pDB.get())
-      m_pDB->start_transaction();
+    {
+      if (!InBatch() || !m_batchTransaction)
+      {
+        m_pDB->start_transaction();
+        m_batchTransaction = InBatch();
+      }
+
+      // every transaction of a batch gets its own savepoint so that rolling
+      // it back doesn't discard the transactions batched before it
+      if (m_batchTransaction)
+      {
+        m_pDS->exec("SAVEPOINT batchitem");
+        m_batchSavepoint = true;
+      }
+    }
   }
   catch (...)
   {
@@ -641,6 +676,26 @@ void CDatabase::BeginTransaction()
 
 bool CDatabase::CommitTransaction()
 {
+  if (InBatch() && m_batchTransaction)
+  {
+    try
+    {
+      if (m_batchSavepoint && NULL != m_pDB.get())
+        m_pDS->exec("RELEASE SAVEPOINT batchitem");
+    }
+    catch (...)
+    {
+      CLog::Log(LOGERROR, "database:committransaction failed to release savepoint");
+    }
+    m_batchSavepoint = false;
+
+    if (++m_batchCount < m_batchSize)
+      return true;
+  }
+
+  m_batchCount = 0;
+  m_batchTransaction = false;
+  m_batchSavepoint = false;
   try
   {
     if (NULL != m_pDB.get())
@@ -656,6 +711,29 @@ bool CDatabase::CommitTransaction()
 
 void CDatabase::RollbackTransaction()
 {
+  // only discard the changes since the savepoint of the failed transaction,
+  // the transactions batched before stay in the open database transaction
+  if (InBatch() && m_batchTransaction && m_batchSavepoint)
+  {
+    m_batchSavepoint = false;
+    try
+    {
+      if (NULL != m_pDB.get())
+      {
+        m_pDS->exec("ROLLBACK TO SAVEPOINT batchitem");
+        m_pDS->exec("RELEASE SAVEPOINT batchitem");
+        return;
+      }
+    }
+    catch (...)
+    {
+      CLog::Log(LOGERROR, "database:rollbacktransaction failed to roll back to savepoint, discarding %u batched transactions", m_batchCount);
+    }
+  }
+
+  m_batchCount = 0;
+  m_batchTransaction = false;
+  m_batchSavepoint = false;
   try
   {
     if (NULL != m_pDB.get())
@@ -667,6 +745,41 @@ void CDatabase::RollbackTransaction()
   }
 }
 
+void CDatabase::BeginBatch(unsigned int batchSize)
+{
+  FlushBatch();
+  m_batchSize = batchSize;
+  m_batchCount = 0;
+}
+
+bool CDatabase::FlushBatch()
+{
+  if (!m_batchTransaction)
+    return true;
+
+  m_batchCount = 0;
+  m_batchTransaction = false;
+  m_batchSavepoint = false;
+  try
+  {
+    if (NULL != m_pDB.get())
+      m_pDB->commit_transaction();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "database:flushbatch failed");
+    return false;
+  }
+  return true;
+}
+
+bool CDatabase::EndBatch()
+{
+  bool ret = FlushBatch();
+  m_batchSize = 0;
+  return ret;
+}
+
 bool CDatabase::InTransaction()
 {
   if (NULL != m_pDB.get()) return false;
@@ -23,6 +23,7 @@
 namespace dbiplus {
   class Database;
   class Dataset;
+  class Statement;
 }
 
 #include <memory>
@@ -71,6 +72,36 @@ public:
   void RollbackTransaction();
   bool InTransaction();
 
+  /*!
+   * @brief Group subsequent transactions into larger ones.
+   * While batching, BeginTransaction() only opens a transaction if none is open
+   * and CommitTransaction() only commits every batchSize calls. This lets bulk
+   * writers such as the library scanners keep using the per item transactions
+   * of the Add* methods without paying for a commit per item. Every grouped
+   * transaction runs in its own savepoint, so RollbackTransaction() only
+   * discards the changes of the failed transaction and keeps the ones before.
+   * @param batchSize Number of transactions to group, 0 or 1 disables batching.
+   * @sa FlushBatch, EndBatch
+   */
+  void BeginBatch(unsigned int batchSize);
+
+  /*!
+   * @brief Commit the transactions grouped so far, the batch stays active.
+   * @return True if there was nothing to commit or the commit succeeded, false otherwise.
+   */
+  bool FlushBatch();
+
+  /*!
+   * @brief Commit the pending transactions and stop batching.
+   * @return True if there was nothing to commit or the commit succeeded, false otherwise.
+   */
+  bool EndBatch();
+
+  /*!
+   * @brief Whether transactions are currently grouped.
+   */
+  bool InBatch() const { return m_batchSize > 1; }
+
   std::string PrepareSQL(std::string strStmt, ...) const;
 
   /*!
@@ -118,6 +149,18 @@ public:
    */
   bool ResultQuery(const std::string &strQuery);
 
+  /*!
+   * @brief Get a prepared statement for a query with '?' placeholders.
+   *        Values are bound to the statement instead of being formatted into
+   *        the query, and rows are read one at a time with step().
+   * @remarks Statements are cached per query, so pass cache = false for
+   *          queries that are built on the fly.
+   * @param strQuery The query to prepare.
+   * @param cache Whether the statement should be kept for the next call with the same query.
+   * @return The statement, empty if it couldn't be prepared.
+   */
+  std::shared_ptr<dbiplus::Statement> PrepareStatement(const std::string &strQuery, bool cache = true);
+
   /*!
    * @brief Start a multiple execution queue. Any ExecuteQuery() function
    *        following this call will be queued rather than executed until
@@ -220,4 +263,9 @@ private:
 
   bool m_multipleExecute;
   std::vector<std::string> m_multipleQueries;
+
+  unsigned int m_batchSize;   /*!< Number of transactions to group, see BeginBatch */
+  unsigned int m_batchCount;  /*!< Number of transactions committed into the open batch */
+  bool m_batchTransaction;    /*!< True if the batch has an open database transaction */
+  bool m_batchSavepoint;      /*!< True if the current transaction of the batch has a savepoint */
 };
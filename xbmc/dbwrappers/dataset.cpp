@@ -29,6 +29,8 @@
 #include "dataset.h"
 #include "utils/log.h"
 #include <cstring>
+#include <cstdio>
+#include <vector>
 
 #ifndef __GNUC__
 #pragma warning (disable:4800)
@@ -80,6 +82,173 @@ string Database::prepare(const char *format, ...)
   return result;
 }
 
+#define MAX_CACHED_STATEMENTS 100
+
+/* resets a cached statement once the caller is done with it, so that it doesn't
+   keep a pending cursor (and the locks that come with it) until its next use */
+struct StatementReleaser {
+  StatementPtr statement;
+  StatementReleaser(const StatementPtr &s) : statement(s) {}
+  void operator()(Statement *) { statement->reset(); statement.reset(); }
+};
+
+StatementPtr Database::prepareStatement(const std::string &sql, bool cache)
+{
+  if (cache)
+  {
+    StatementCache::iterator it = statements.find(sql);
+    if (it != statements.end())
+    {
+      // only the cache holds it, so it's not in use
+      if (it->second.use_count() == 1)
+        return StatementPtr(it->second.get(), StatementReleaser(it->second));
+      cache = false;
+    }
+    else if (statements.size() >= MAX_CACHED_STATEMENTS)
+    {
+      // drop the statements that aren't in use
+      for (it = statements.begin(); it != statements.end(); )
+      {
+        if (it->second.use_count() == 1)
+          statements.erase(it++);
+        else
+          ++it;
+      }
+    }
+  }
+
+  StatementPtr statement(createStatement(sql));
+  if (!cache)
+    return statement;
+
+  statements.insert(make_pair(sql, statement));
+  return StatementPtr(statement.get(), StatementReleaser(statement));
+}
+
+void Database::clearStatements()
+{
+  for (StatementCache::iterator it = statements.begin(); it != statements.end(); ++it)
+    it->second->finalize();
+  statements.clear();
+}
+
+//************* DatasetStatement implementation ***************
+
+/* Statement for connections without native prepared statements. The values
+   are escaped and put into the query, which is run through a dataset when the
+   statement is executed. */
+class DatasetStatement : public Statement {
+public:
+  DatasetStatement(Database *newDb, const std::string &newSql) :
+    db(newDb), sql(newSql), ds(newDb->CreateDataset()), executed(false)
+  {
+    size_t pos = sql.find_first_not_of(" \t\r\n(");
+    select = pos != string::npos && (sql.compare(pos, 6, "select") == 0 || sql.compare(pos, 6, "SELECT") == 0);
+  }
+  virtual ~DatasetStatement() { finalize(); }
+
+  virtual void bind(int index, int64_t value)
+  {
+    char buffer[32];
+    sprintf(buffer, "%lld", (long long)value);
+    set_value(index, buffer);
+  }
+  virtual void bind(int index, double value)
+  {
+    char buffer[32];
+    sprintf(buffer, "%.17g", value);
+    set_value(index, buffer);
+  }
+  virtual void bind(int index, const std::string &value) { set_value(index, db->prepare("'%s'", value.c_str())); }
+  virtual void bind_null(int index) { set_value(index, "NULL"); }
+
+  virtual bool step()
+  {
+    if (ds == NULL) throw DbErrors("Statement is finalized");
+    if (!executed)
+    {
+      executed = true;
+      std::string query = make_query();
+      if (!select)
+      {
+        ds->exec(query);
+        return false;
+      }
+      ds->query(query);
+    }
+    else if (!ds->eof())
+      ds->next();
+    return !ds->eof();
+  }
+  virtual void reset()
+  {
+    if (ds) ds->close();
+    values.clear();
+    executed = false;
+  }
+  virtual void finalize()
+  {
+    delete ds;
+    ds = NULL;
+  }
+
+  virtual int column_count() { return ds->fieldCount(); }
+  virtual const char *column_name(int col) { return ds->fieldName(col); }
+  virtual bool is_null(int col) { return ds->get_sql_record()->at(col).get_isNull(); }
+  virtual int64_t get_int64(int col) { return ds->get_sql_record()->at(col).get_asInt64(); }
+  virtual double get_double(int col) { return ds->get_sql_record()->at(col).get_asDouble(); }
+  virtual const char *get_text(int col)
+  {
+    if ((int)texts.size() <= col)
+      texts.resize(col + 1);
+    texts[col] = ds->get_sql_record()->at(col).get_asString();
+    return texts[col].c_str();
+  }
+  virtual const sql_record* const get_sql_record() { return ds->get_sql_record(); }
+  virtual int64_t lastinsertid() { return ds->lastinsertid(); }
+
+private:
+  void set_value(int index, const std::string &value)
+  {
+    if (index < 1) throw DbErrors("Invalid parameter index %d", index);
+    if ((int)values.size() < index)
+      values.resize(index, "NULL");
+    values[index - 1] = value;
+  }
+
+  /* replaces the placeholders outside of string literals by the bound values */
+  std::string make_query() const
+  {
+    std::string query;
+    query.reserve(sql.size() + values.size() * 16);
+    bool quoted = false;
+    size_t param = 0;
+    for (size_t i = 0; i < sql.size(); i++)
+    {
+      if (sql[i] == '\'')
+        quoted = !quoted;
+      if (sql[i] == '?' && !quoted)
+        query += param < values.size() ? values[param++] : "NULL";
+      else
+        query += sql[i];
+    }
+    return query;
+  }
+
+  Database *db;
+  std::string sql;
+  Dataset *ds;
+  bool select;
+  bool executed;
+  std::vector<std::string> values;
+  std::vector<std::string> texts;
+};
+
+Statement *Database::createStatement(const std::string &sql)
+{
+  return new DatasetStatement(this, sql);
+}
+
 //************* Dataset implementation ***************
 
 Dataset::Dataset():
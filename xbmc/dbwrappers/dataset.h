@@ -34,6 +34,7 @@
 #include <string>
 #include <map>
 #include <list>
+#include <memory>
 #include "qry_dat.h"
 #include <stdarg.h>
 
@@ -42,6 +43,9 @@
 
 namespace dbiplus {
 class Dataset;		// forward declaration of class Dataset
+class Statement;	// forward declaration of class Statement
+
+typedef std::shared_ptr<Statement> StatementPtr;
 
 
 #define S_NO_CONNECTION "No active connection";
@@ -167,6 +171,72 @@ public:
 
   virtual bool in_transaction() {return false;};
 
+/* methods for prepared statements */
+
+  /*! \brief Get a prepared statement for a query with '?' placeholders.
+   Statements are cached by their query, so repeating the same query only binds
+   new values instead of parsing it again. A cached statement that is still in
+   use is never handed out twice, a new one is prepared instead.
+   \param sql - the query, values are bound with Statement::bind().
+   \param cache - false for queries that are built on the fly and won't be repeated.
+   \return the statement, ready to be executed.
+   */
+  virtual StatementPtr prepareStatement(const std::string &sql, bool cache = true);
+
+protected:
+/* creates a new statement, the default runs the query through a dataset */
+  virtual Statement *createStatement(const std::string &sql);
+/* finalizes all cached statements, must be called before the connection is closed */
+  void clearStatements();
+
+private:
+  typedef std::map<std::string, StatementPtr> StatementCache;
+  StatementCache statements;
+};
+
+
+
+
+/******************* Class Statement definition *******************
+
+  prepared statement with bound parameters and a forward only cursor
+  on its result, which reads the current row only
+
+******************************************************************/
+class Statement {
+public:
+  virtual ~Statement() {};
+
+/* bind a value to the parameter 'index', the index-th '?' of the query (starting with 1) */
+  void bind(int index, int value) { bind(index, (int64_t)value); }
+  virtual void bind(int index, int64_t value) = 0;
+  virtual void bind(int index, double value) = 0;
+  virtual void bind(int index, const std::string &value) = 0;
+  virtual void bind_null(int index) = 0;
+
+/* execute the statement resp. go to the next row, returns false if there is no (more) row */
+  virtual bool step() = 0;
+/* make the statement ready to be executed again, bound values are cleared */
+  virtual void reset() = 0;
+/* release the underlying statement, the object can't be used afterwards */
+  virtual void finalize() = 0;
+
+/* values of the current row, columns start with 0 */
+  virtual int column_count() = 0;
+  virtual const char *column_name(int col) = 0;
+  virtual bool is_null(int col) = 0;
+  int get_int(int col) { return (int)get_int64(col); }
+  virtual int64_t get_int64(int col) = 0;
+  virtual double get_double(int col) = 0;
+/* the text is owned by the statement and valid until the next step() */
+  virtual const char *get_text(int col) = 0;
+  std::string get_string(int col) { const char *text = get_text(col); return text ? text : ""; }
+
+/* the current row as a record for code that reads datasets, the record is reused for each row */
+  virtual const sql_record* const get_sql_record() = 0;
+
+/* last inserted id */
+  virtual int64_t lastinsertid() = 0;
 };
 
 
@@ -199,6 +199,7 @@ int MysqlDatabase::connect(bool create_new) {
 void MysqlDatabase::disconnect(void) {
   if (conn != NULL)
   {
+    clearStatements();
     mysql_close(conn);
     conn = NULL;
   }
@@ -175,7 +175,7 @@ public:
   }
   }
 
-  void set_isNull(){is_null=true;}
+  void set_isNull(bool isNull = true){is_null=isNull;}
   void set_asString(const char *s);
   void set_asString(const std::string & s);
   void set_asBool(const bool b);
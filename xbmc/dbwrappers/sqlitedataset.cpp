@@ -258,7 +258,23 @@ bool SqliteDatabase::exists(void)
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
-  sqlite3_close(conn);
+  clearStatements();
+
+  // statements still held by callers can't be used without the connection
+  while (!liveStatements.empty())
+    (*liveStatements.begin())->finalize();
+
+  // sqlite3_close() fails and leaves the connection open as long as any
+  // statement is left, so finalize those we don't know about as well
+  sqlite3_stmt *stmt;
+  while ((stmt = sqlite3_next_stmt(conn, NULL)) != NULL)
+  {
+    CLog::Log(LOGWARNING, "%s - finalizing unfinished statement '%s'", __FUNCTION__, sqlite3_sql(stmt));
+    sqlite3_finalize(stmt);
+  }
+
+  if (sqlite3_close(conn) != SQLITE_OK)
+    CLog::Log(LOGERROR, "%s - failed to close %s: %s", __FUNCTION__, db.c_str(), sqlite3_errmsg(conn));
   active = false;
 }
 
@@ -445,6 +461,131 @@ string SqliteDatabase::vprepare(const char *format, va_list args)
 }
 
 
+Statement *SqliteDatabase::createStatement(const std::string &sql) {
+  return new SqliteStatement(this, sql);
+}
+
+
+//************* SqliteStatement implementation ***************
+
+SqliteStatement::SqliteStatement(SqliteDatabase *newDb, const std::string &newSql) :
+  db(newDb), stmt(NULL), sql(newSql)
+{
+  if (!db->getHandle()) throw DbErrors("No Database Connection");
+  check(sqlite3_prepare_v2(db->getHandle(), sql.c_str(), -1, &stmt, NULL));
+  db->liveStatements.insert(this);
+}
+
+SqliteStatement::~SqliteStatement() {
+  finalize();
+}
+
+void SqliteStatement::check(int rc) {
+  if (db->setErr(rc, sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+}
+
+void SqliteStatement::bind(int index, int64_t value) {
+  check(sqlite3_bind_int64(stmt, index, value));
+}
+
+void SqliteStatement::bind(int index, double value) {
+  check(sqlite3_bind_double(stmt, index, value));
+}
+
+void SqliteStatement::bind(int index, const std::string &value) {
+  check(sqlite3_bind_text(stmt, index, value.c_str(), value.size(), SQLITE_TRANSIENT));
+}
+
+void SqliteStatement::bind_null(int index) {
+  check(sqlite3_bind_null(stmt, index));
+}
+
+bool SqliteStatement::step() {
+  if (!stmt) throw DbErrors("Statement is finalized");
+  int rc = sqlite3_step(stmt);
+  if (rc == SQLITE_ROW)
+    return true;
+  if (rc == SQLITE_DONE)
+    return false;
+  // sqlite3_reset() returns the actual error of the failed step
+  check(sqlite3_reset(stmt));
+  check(rc);
+  return false;
+}
+
+void SqliteStatement::reset() {
+  if (!stmt) return;
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+}
+
+void SqliteStatement::finalize() {
+  if (!stmt) return;
+  sqlite3_finalize(stmt);
+  stmt = NULL;
+  db->liveStatements.erase(this);
+}
+
+int SqliteStatement::column_count() {
+  return sqlite3_column_count(stmt);
+}
+
+const char *SqliteStatement::column_name(int col) {
+  return sqlite3_column_name(stmt, col);
+}
+
+bool SqliteStatement::is_null(int col) {
+  return sqlite3_column_type(stmt, col) == SQLITE_NULL;
+}
+
+int64_t SqliteStatement::get_int64(int col) {
+  return sqlite3_column_int64(stmt, col);
+}
+
+double SqliteStatement::get_double(int col) {
+  return sqlite3_column_double(stmt, col);
+}
+
+const char *SqliteStatement::get_text(int col) {
+  return (const char *)sqlite3_column_text(stmt, col);
+}
+
+const sql_record* const SqliteStatement::get_sql_record() {
+  // same conversion as SqliteDataset::query(), but into a single reused record
+  const int numColumns = sqlite3_column_count(stmt);
+  record.resize(numColumns);
+  for (int i = 0; i < numColumns; i++)
+  {
+    field_value &v = record[i];
+    v.set_isNull(false);
+    switch (sqlite3_column_type(stmt, i))
+    {
+    case SQLITE_INTEGER:
+      v.set_asInt64(sqlite3_column_int64(stmt, i));
+      break;
+    case SQLITE_FLOAT:
+      v.set_asDouble(sqlite3_column_double(stmt, i));
+      break;
+    case SQLITE_TEXT:
+    case SQLITE_BLOB:
+      v.set_asString((const char *)sqlite3_column_text(stmt, i));
+      break;
+    case SQLITE_NULL:
+    default:
+      v.set_asString("");
+      v.set_isNull();
+      break;
+    }
+  }
+  return &record;
+}
+
+int64_t SqliteStatement::lastinsertid() {
+  return sqlite3_last_insert_rowid(db->getHandle());
+}
+
+
 //************* SqliteDataset implementation ***************
 
 SqliteDataset::SqliteDataset():Dataset() {
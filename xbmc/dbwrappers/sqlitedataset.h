@@ -30,10 +30,13 @@
 #define _SQLITEDATASET_H
 
 #include <stdio.h>
+#include <set>
 #include "dataset.h"
 #include <sqlite3.h>
 
 namespace dbiplus {
+class SqliteStatement;
+
 /***************** Class SqliteDatabase definition ******************
 
        class 'SqliteDatabase' connects with Sqlite-server
@@ -45,6 +48,8 @@ protected:
   sqlite3 *conn;
   bool _in_transaction;
   int last_err;
+/* statements prepared on this connection that haven't been finalized yet */
+  std::set<SqliteStatement*> liveStatements;
 
 public:
 /* default constructor */
@@ -97,6 +102,52 @@ public:
 
   bool in_transaction() {return _in_transaction;}; 	
 
+protected:
+/* creates a native sqlite3 prepared statement */
+  virtual Statement *createStatement(const std::string &sql);
+
+  friend class SqliteStatement;
+};
+
+
+
+/***************** Class SqliteStatement definition *****************
+
+       class 'SqliteStatement' wraps a sqlite3 prepared statement,
+       rows are read one by one instead of being copied into a dataset
+
+******************************************************************/
+class SqliteStatement : public Statement {
+protected:
+  SqliteDatabase *db;
+  sqlite3_stmt *stmt;
+  std::string sql;
+  sql_record record;
+
+  void check(int rc);
+
+public:
+  SqliteStatement(SqliteDatabase *newDb, const std::string &newSql);
+  virtual ~SqliteStatement();
+
+  virtual void bind(int index, int64_t value);
+  virtual void bind(int index, double value);
+  virtual void bind(int index, const std::string &value);
+  virtual void bind_null(int index);
+
+  virtual bool step();
+  virtual void reset();
+  virtual void finalize();
+
+  virtual int column_count();
+  virtual const char *column_name(int col);
+  virtual bool is_null(int col);
+  virtual int64_t get_int64(int col);
+  virtual double get_double(int col);
+  virtual const char *get_text(int col);
+  virtual const sql_record* const get_sql_record();
+
+  virtual int64_t lastinsertid();
 };
 
 
@@ -0,0 +1,171 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/Database.h"
+#include "dbwrappers/dataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+class CTestDatabase : public CDatabase
+{
+public:
+  /* creates a new database in the temp folder, without the database manager */
+  bool Create()
+  {
+    DatabaseSettings settings;
+    settings.type = "sqlite3";
+    settings.host = CSpecialProtocol::TranslatePath("special://temp/");
+    settings.name = "TestDatabase";
+    return Update(settings);
+  }
+
+  void Delete()
+  {
+    std::string file;
+    if (m_pDB.get())
+      file = URIUtils::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase());
+    Close();
+    if (!file.empty())
+      XFILE::CFile::Delete(file);
+  }
+
+  bool AddItem(int id)
+  {
+    BeginTransaction();
+    if (!ExecuteQuery(PrepareSQL("INSERT INTO item (idItem) VALUES (%i)", id)))
+    {
+      RollbackTransaction();
+      return false;
+    }
+    return CommitTransaction();
+  }
+
+  int GetItemCount()
+  {
+    return atoi(GetSingleValue("SELECT COUNT(*) FROM item").c_str());
+  }
+
+  bool HasItem(int id)
+  {
+    return !GetSingleValue(PrepareSQL("SELECT idItem FROM item WHERE idItem = %i", id)).empty();
+  }
+
+protected:
+  virtual void CreateTables()
+  {
+    m_pDS->exec("CREATE TABLE item (idItem INTEGER PRIMARY KEY)");
+  }
+
+  virtual void CreateAnalytics() { }
+  virtual int GetSchemaVersion() const { return 1; }
+  virtual const char *GetBaseDBName() const { return "TestDatabase"; }
+};
+
+class TestDatabase : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    ASSERT_TRUE(m_db.Create());
+  }
+
+  virtual void TearDown()
+  {
+    m_db.Delete();
+  }
+
+  CTestDatabase m_db;
+};
+
+TEST_F(TestDatabase, Rollback)
+{
+  m_db.BeginTransaction();
+  EXPECT_TRUE(m_db.ExecuteQuery("INSERT INTO item (idItem) VALUES (1)"));
+  m_db.RollbackTransaction();
+  EXPECT_EQ(0, m_db.GetItemCount());
+}
+
+TEST_F(TestDatabase, BatchCommit)
+{
+  m_db.BeginBatch(3);
+  for (int i = 1; i <= 5; i++)
+    EXPECT_TRUE(m_db.AddItem(i));
+  EXPECT_TRUE(m_db.EndBatch());
+  EXPECT_EQ(5, m_db.GetItemCount());
+}
+
+TEST_F(TestDatabase, BatchRollbackKeepsEarlierItems)
+{
+  m_db.BeginBatch(10);
+  EXPECT_TRUE(m_db.AddItem(1));
+  EXPECT_TRUE(m_db.AddItem(2));
+  EXPECT_TRUE(m_db.AddItem(3));
+
+  // a failing item only discards its own changes
+  m_db.BeginTransaction();
+  EXPECT_TRUE(m_db.ExecuteQuery("INSERT INTO item (idItem) VALUES (4)"));
+  m_db.RollbackTransaction();
+
+  // the duplicate key makes the item fail
+  EXPECT_FALSE(m_db.AddItem(2));
+  EXPECT_TRUE(m_db.AddItem(5));
+  EXPECT_TRUE(m_db.EndBatch());
+
+  EXPECT_EQ(4, m_db.GetItemCount());
+  EXPECT_TRUE(m_db.HasItem(1));
+  EXPECT_TRUE(m_db.HasItem(3));
+  EXPECT_FALSE(m_db.HasItem(4));
+  EXPECT_TRUE(m_db.HasItem(5));
+}
+
+TEST_F(TestDatabase, BatchRollbackFirstItem)
+{
+  m_db.BeginBatch(10);
+  m_db.BeginTransaction();
+  EXPECT_TRUE(m_db.ExecuteQuery("INSERT INTO item (idItem) VALUES (1)"));
+  m_db.RollbackTransaction();
+  EXPECT_TRUE(m_db.AddItem(2));
+  EXPECT_TRUE(m_db.EndBatch());
+
+  EXPECT_EQ(1, m_db.GetItemCount());
+  EXPECT_TRUE(m_db.HasItem(2));
+}
+
+TEST_F(TestDatabase, CloseFinalizesStatements)
+{
+  EXPECT_TRUE(m_db.AddItem(1));
+  EXPECT_TRUE(m_db.AddItem(2));
+
+  // a statement in the middle of its rows keeps the connection open
+  dbiplus::StatementPtr stmt = m_db.PrepareStatement("SELECT idItem FROM item", false);
+  ASSERT_TRUE(stmt.get() != NULL);
+  EXPECT_TRUE(stmt->step());
+  m_db.Close();
+  EXPECT_THROW(stmt->step(), dbiplus::DbErrors);
+
+  // the old connection doesn't hold a lock on the file anymore
+  ASSERT_TRUE(m_db.Create());
+  EXPECT_TRUE(m_db.AddItem(3));
+  EXPECT_EQ(3, m_db.GetItemCount());
+}
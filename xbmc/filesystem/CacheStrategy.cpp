@@ -294,6 +294,11 @@ CDoubleCache::~CDoubleCache()
   delete m_pCacheOld;
 }
 
+void CDoubleCache::SetSource(const std::string &path, int64_t length, const std::string &validator)
+{
+  m_pCache->SetSource(path, length, validator);
+}
+
 int CDoubleCache::Open()
 {
   return m_pCache->Open();
@@ -41,6 +41,15 @@ public:
   CCacheStrategy();
   virtual ~CCacheStrategy();
 
+  /*!
+   \brief Tell the strategy which source it caches, called before Open()
+   \param path the path of the source
+   \param length the length of the source, 0 when unknown or not seekable
+   \param validator identifies the version of the source (ETag, modification time),
+                    empty when the source can't tell
+   */
+  virtual void SetSource(const std::string &path, int64_t length, const std::string &validator) {}
+
   virtual int Open() = 0;
   virtual void Close() = 0;
 
@@ -117,6 +126,7 @@ public:
   CDoubleCache(CCacheStrategy *impl);
   virtual ~CDoubleCache();
 
+  virtual void SetSource(const std::string &path, int64_t length, const std::string &validator);
   virtual int Open() ;
   virtual void Close() ;
 
@@ -52,6 +52,9 @@ using namespace XCURL;
 #define XMIN(a,b) ((a)<(b)?(a):(b))
 #define FITS_INT(a) (((a) <= INT_MAX) && ((a) >= INT_MIN))
 
+/* smallest file CCurlFile::Download splits into parallel ranged requests */
+#define DOWNLOAD_RANGE_MIN_SIZE (4 * 1024 * 1024)
+
 curl_proxytype proxyType2CUrlProxyType[] = {
   CURLPROXY_HTTP,
   CURLPROXY_SOCKS4,
@@ -124,6 +127,46 @@ extern "C" size_t header_callback(void *ptr, size_t size, size_t nmemb, void *st
   return state->HeaderCallback(ptr, size, nmemb);
 }
 
+/* a single ranged request of a parallel download */
+struct SCurlRange
+{
+  CCurlFile::CReadState state;
+  CFile*  file;
+  int64_t pos;
+  int64_t end;
+  bool    partial;
+};
+
+extern "C" size_t range_write_callback(char *buffer,
+               size_t size,
+               size_t nitems,
+               void *userp)
+{
+  if(userp == NULL) return 0;
+
+  SCurlRange *range = (SCurlRange *)userp;
+  ssize_t amount = size * nitems;
+
+  /* fail the range if the server ignored it and sends the whole file instead */
+  if (!range->partial)
+  {
+    long code = 0;
+    if (g_curlInterface.easy_getinfo(range->state.m_easyHandle, CURLINFO_RESPONSE_CODE, &code) != CURLE_OK || code != 206)
+      return 0;
+    range->partial = true;
+  }
+
+  if (range->pos + amount > range->end + 1)
+    return 0;
+
+  if (range->file->Seek(range->pos, SEEK_SET) != range->pos
+  ||  range->file->Write(buffer, amount) != amount)
+    return 0;
+
+  range->pos += amount;
+  return amount;
+}
+
 /* fix for silly behavior of realloc */
 static inline void* realloc_simple(void *ptr, size_t size)
 {
@@ -503,8 +546,12 @@ void CCurlFile::SetCommonOptions(CReadState* state)
   g_curlInterface.easy_setopt(h, CURLOPT_SSL_VERIFYPEER, 0);
   g_curlInterface.easy_setopt(h, CURLOPT_SSL_VERIFYHOST, 0);
 
-  g_curlInterface.easy_setopt(m_state->m_easyHandle, CURLOPT_URL, m_url.c_str());
-  g_curlInterface.easy_setopt(m_state->m_easyHandle, CURLOPT_TRANSFERTEXT, FALSE);
+  g_curlInterface.easy_setopt(h, CURLOPT_URL, m_url.c_str());
+  g_curlInterface.easy_setopt(h, CURLOPT_TRANSFERTEXT, FALSE);
+
+  // reuse connections, dns lookups and tls sessions of other handles
+  if (g_curlInterface.GetShare())
+    g_curlInterface.easy_setopt(h, CURLOPT_SHARE, g_curlInterface.GetShare());
 
   // setup POST data if it is set (and it may be empty)
   if (m_postdataset)
@@ -574,6 +621,11 @@ void CCurlFile::SetCommonOptions(CReadState* state)
 
   if (m_useOldHttpVersion)
     g_curlInterface.easy_setopt(h, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_0);
+#if LIBCURL_VERSION_NUM >= 0x072f00
+  // negotiate http/2 over tls, silently stays on http/1.1 if libcurl lacks nghttp2
+  else if (!g_advancedSettings.m_curlDisableHTTP2)
+    g_curlInterface.easy_setopt(h, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+#endif
 
   if (g_advancedSettings.m_curlDisableIPV6)
     g_curlInterface.easy_setopt(h, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
@@ -857,25 +909,191 @@ bool CCurlFile::Download(const std::string& strURL, const std::string& strFileNa
 {
   CLog::Log(LOGINFO, "CCurlFile::Download - %s->%s", strURL.c_str(), strFileName.c_str());
 
-  std::string strData;
-  if (!Get(strURL, strData))
+  m_postdata = "";
+  m_postdataset = false;
+  if (!Open(CURL(strURL)))
+  {
+    Close();
     return false;
+  }
 
   XFILE::CFile file;
   if (!file.OpenForWrite(strFileName, true))
   {
     CLog::Log(LOGERROR, "CCurlFile::Download - Unable to open file %s: %u",
     strFileName.c_str(), GetLastError());
+    Close();
     return false;
   }
-  ssize_t written = 0;
-  if (strData.size() > 0)
-    written = file.Write(strData.c_str(), strData.size());
+
+  int64_t size = m_state->m_fileSize;
+  bool ranged = false;
+  bool success = true;
+  if (m_seekable && size >= DOWNLOAD_RANGE_MIN_SIZE && g_advancedSettings.m_curlParallelRanges > 1)
+  {
+    // the connection of the first request is picked up again by one of the ranges
+    m_state->Disconnect();
+    ranged = DownloadRanges(file, size);
+    if (!ranged && !m_state->m_cancelled)
+    {
+      CLog::Log(LOGNOTICE, "CCurlFile::Download - Ranged download failed, retrying with a single request");
+      SetCommonOptions(m_state);
+      SetRequestHeaders(m_state);
+      m_state->m_sendRange = true;
+      long response = m_state->Connect(m_bufferSize);
+      success = response >= 0 && response < 400 && file.Seek(0, SEEK_SET) == 0;
+    }
+  }
+
+  int64_t written = 0;
+  if (ranged)
+    written = size;
+  else if (success)
+  {
+    char buffer[16384];
+    int size_read;
+    while ((size_read = Read(buffer, sizeof(buffer))) > 0)
+    {
+      if (file.Write(buffer, size_read) != size_read)
+      {
+        success = false;
+        break;
+      }
+      written += size_read;
+    }
+    if (size_read < 0 || (size > 0 && written != size))
+      success = false;
+  }
+
+  if (m_state->m_cancelled)
+    success = false;
+
+  Close();
+  file.Close();
+
+  if (!success)
+  {
+    CFile::Delete(strFileName);
+    written = 0;
+  }
 
   if (pdwSize != NULL)
-    *pdwSize = written > 0 ? written : 0;
+    *pdwSize = (DWORD)written;
+
+  return success;
+}
+
+bool CCurlFile::DownloadRanges(CFile &file, int64_t size)
+{
+  CURL url(m_url);
+  int count = g_advancedSettings.m_curlParallelRanges;
+  int64_t chunk = size / count;
+
+  CURLM* multi = g_curlInterface.multi_init();
+  if (!multi)
+    return false;
+
+#ifdef CURLPIPE_MULTIPLEX
+  // let the ranges share a single connection where the server speaks http/2
+  g_curlInterface.multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+
+  CLog::Log(LOGDEBUG, "CCurlFile::DownloadRanges - Fetching %s in %i ranges", CURL::GetRedacted(m_url).c_str(), count);
+
+  std::vector<SCurlRange*> ranges;
+  for (int i = 0; i < count; i++)
+  {
+    SCurlRange* range = new SCurlRange;
+    range->file = &file;
+    range->pos = chunk * i;
+    range->end = (i == count - 1 ? size : chunk * (i + 1)) - 1;
+    range->partial = false;
+    ranges.push_back(range);
+
+    g_curlInterface.easy_aquire(url.GetProtocol().c_str(),
+                                url.GetHostName().c_str(),
+                                &range->state.m_easyHandle,
+                                NULL);
+
+    SetCommonOptions(&range->state);
+    SetRequestHeaders(&range->state);
+
+    CURL_HANDLE* h = range->state.m_easyHandle;
+    std::string bytes = StringUtils::Format("%" PRId64"-%" PRId64, range->pos, range->end);
+    g_curlInterface.easy_setopt(h, CURLOPT_RANGE, bytes.c_str());
+    g_curlInterface.easy_setopt(h, CURLOPT_WRITEDATA, range);
+    g_curlInterface.easy_setopt(h, CURLOPT_WRITEFUNCTION, range_write_callback);
+#ifdef CURLPIPE_MULTIPLEX
+    g_curlInterface.easy_setopt(h, CURLOPT_PIPEWAIT, 1L);
+#endif
+    g_curlInterface.multi_add_handle(multi, h);
+  }
+
+  bool success = true;
+  int running = count;
+  while (running > 0)
+  {
+    if (m_state->m_cancelled)
+    {
+      success = false;
+      break;
+    }
+
+    CURLMcode result = g_curlInterface.multi_perform(multi, &running);
+    if (result == CURLM_CALL_MULTI_PERFORM)
+      continue;
+    if (result != CURLM_OK)
+    {
+      CLog::Log(LOGERROR, "CCurlFile::DownloadRanges - Multi perform failed with code %d, aborting", result);
+      success = false;
+      break;
+    }
+    if (running == 0)
+      break;
+
+    fd_set fdread;
+    fd_set fdwrite;
+    fd_set fdexcep;
+    int maxfd = -1;
+    FD_ZERO(&fdread);
+    FD_ZERO(&fdwrite);
+    FD_ZERO(&fdexcep);
+    g_curlInterface.multi_fdset(multi, &fdread, &fdwrite, &fdexcep, &maxfd);
+
+    long timeout = 0;
+    if (CURLM_OK != g_curlInterface.multi_timeout(multi, &timeout) || timeout < 0 || timeout > 200)
+      timeout = 200;
+
+    if (maxfd < 0)
+      Sleep(timeout > 10 ? 10 : timeout);
+    else
+    {
+      struct timeval t = { (int)timeout / 1000, ((int)timeout % 1000) * 1000 };
+      select(maxfd + 1, &fdread, &fdwrite, &fdexcep, &t);
+    }
+  }
+
+  int msgs;
+  CURLMsg* msg;
+  while ((msg = g_curlInterface.multi_info_read(multi, &msgs)))
+  {
+    if (msg->msg == CURLMSG_DONE && msg->data.result != CURLE_OK)
+    {
+      CLog::Log(LOGDEBUG, "CCurlFile::DownloadRanges - Range failed: %s(%d)", g_curlInterface.easy_strerror(msg->data.result), msg->data.result);
+      success = false;
+    }
+  }
+
+  for (std::vector<SCurlRange*>::iterator it = ranges.begin(); it != ranges.end(); ++it)
+  {
+    if ((*it)->pos != (*it)->end + 1)
+      success = false;
+    g_curlInterface.multi_remove_handle(multi, (*it)->state.m_easyHandle);
+    delete *it;
+  }
+  g_curlInterface.multi_cleanup(multi);
 
-  return written == strData.size();
+  return success;
 }
 
 // Detect whether we are "online" or not! Very simple and dirty!
@@ -34,6 +34,8 @@ namespace XCURL
 
 namespace XFILE
 {
+  class CFile;
+
   class CCurlFile : public IFile
   {
     public:
@@ -155,6 +157,7 @@ namespace XFILE
       void SetRequestHeaders(CReadState* state);
       void SetCorrectHeaders(CReadState* state);
       bool Service(const std::string& strURL, std::string& strHTML);
+      bool DownloadRanges(CFile &file, int64_t size);
 
     protected:
       CReadState*     m_state;
@@ -24,6 +24,7 @@
 #include "commons/Exception.h"
 #include "FileItem.h"
 #include "DirectoryCache.h"
+#include "PersistentDirectoryCache.h"
 #include "settings/Settings.h"
 #include "utils/log.h"
 #include "utils/Job.h"
@@ -46,12 +47,14 @@ private:
 
   struct CResult
   {
-    CResult(const CURL& dir, const CURL& listDir) : m_event(true), m_dir(dir), m_listDir(listDir), m_result(false) {}
+    CResult(const CURL& dir, const CURL& listDir, bool validate) : m_event(true), m_dir(dir), m_listDir(listDir), m_result(false), m_validate(validate) {}
     CEvent        m_event;
     CFileItemList m_list;
     CURL          m_dir;
     CURL          m_listDir;
     bool          m_result;
+    bool          m_validate;
+    std::string   m_validator;
   };
 
   struct CGetJob
@@ -65,6 +68,8 @@ private:
   public:
     virtual bool DoWork()
     {
+      if (m_result->m_validate)
+        m_result->m_validator    = m_imp->GetCacheValidator(m_result->m_dir);
       m_result->m_list.SetURL(m_result->m_listDir);
       m_result->m_result         = m_imp->GetDirectory(m_result->m_dir, m_result->m_list);
       m_result->m_event.Set();
@@ -77,8 +82,8 @@ private:
 
 public:
 
-  CGetDirectory(std::shared_ptr<IDirectory>& imp, const CURL& dir, const CURL& listDir)
-    : m_result(new CResult(dir, listDir))
+  CGetDirectory(std::shared_ptr<IDirectory>& imp, const CURL& dir, const CURL& listDir, bool validate)
+    : m_result(new CResult(dir, listDir, validate))
   {
     m_id = CJobManager::GetInstance().AddJob(new CGetJob(imp, m_result)
                                            , NULL
@@ -106,6 +111,11 @@ public:
     list.Copy(m_result->m_list);
     return true;
   }
+
+  const std::string& GetCacheValidator() const
+  {
+    return m_result->m_validator;
+  }
   std::shared_ptr<CResult> m_result;
   unsigned int               m_id;
 };
@@ -151,6 +161,13 @@ bool CDirectory::GetDirectory(const CURL& url, CFileItemList &items, const CHint
     // check our cache for this path
     if (g_directoryCache.GetDirectory(realURL.Get(), items, (hints.flags & DIR_FLAG_READ_CACHE) == DIR_FLAG_READ_CACHE))
       items.SetURL(url);
+    // when browsing, show the listing stored on disk at once and validate it in the background
+    else if (g_application.IsCurrentThread() && allowThreads && !(hints.flags & DIR_FLAG_BYPASS_CACHE) &&
+             CPersistentDirectoryCache::Get().Load(realURL, url, hints.flags, pDirectory->GetCacheType(url), items))
+    {
+      g_directoryCache.SetDirectory(realURL.Get(), items, pDirectory->GetCacheType(url));
+      items.SetURL(url);
+    }
     else
     {
       // need to clear the cache (in case the directory fetch fails)
@@ -160,6 +177,11 @@ bool CDirectory::GetDirectory(const CURL& url, CFileItemList &items, const CHint
 
       pDirectory->SetFlags(hints.flags);
 
+      // take the validator before listing, so a change made while listing is caught by the next validation
+      const DIR_CACHE_TYPE cacheType = pDirectory->GetCacheType(url);
+      const bool persist = !(hints.flags & DIR_FLAG_BYPASS_CACHE) && CPersistentDirectoryCache::Get().IsCacheable(realURL, cacheType);
+      std::string validator;
+
       bool result = false, cancel = false;
       while (!result && !cancel)
       {
@@ -168,7 +190,7 @@ bool CDirectory::GetDirectory(const CURL& url, CFileItemList &items, const CHint
         {
           CSingleExit ex(g_graphicsContext);
 
-          CGetDirectory get(pDirectory, realURL, url);
+          CGetDirectory get(pDirectory, realURL, url, persist);
           if(!get.Wait(TIME_TO_BUSY_DIALOG))
           {
             CGUIDialogBusy* dialog = (CGUIDialogBusy*)g_windowManager.GetWindow(WINDOW_DIALOG_BUSY);
@@ -197,9 +219,12 @@ bool CDirectory::GetDirectory(const CURL& url, CFileItemList &items, const CHint
               dialog->Close();
           }
           result = get.GetDirectory(items);
+          validator = get.GetCacheValidator();
         }
         else
         {
+          if (persist)
+            validator = pDirectory->GetCacheValidator(realURL);
           items.SetURL(url);
           result = pDirectory->GetDirectory(realURL, items);
         }
@@ -215,7 +240,11 @@ bool CDirectory::GetDirectory(const CURL& url, CFileItemList &items, const CHint
 
       // cache the directory, if necessary
       if (!(hints.flags & DIR_FLAG_BYPASS_CACHE))
-        g_directoryCache.SetDirectory(realURL.Get(), items, pDirectory->GetCacheType(url));
+      {
+        g_directoryCache.SetDirectory(realURL.Get(), items, cacheType);
+        if (persist)
+          CPersistentDirectoryCache::Get().Store(realURL, hints.flags, cacheType, validator);
+      }
     }
 
     // now filter for allowed files
@@ -274,6 +303,68 @@ bool CDirectory::GetDirectory(const CURL& url, CFileItemList &items, const CHint
   return false;
 }
 
+bool CDirectory::GetDirectory(const std::string& strPath, CDirectoryPtr &items, const std::string &strMask /* = "" */, int flags /* = DIR_FLAG_DEFAULTS */)
+{
+  CHints hints;
+  hints.flags = flags;
+  hints.mask = strMask;
+  const CURL pathToUrl(strPath);
+  return GetDirectory(pathToUrl, items, hints);
+}
+
+bool CDirectory::GetDirectory(const CURL& url, CDirectoryPtr &items, const CHints &hints)
+{
+  // the cached snapshot can only be handed out if none of the steps of the
+  // copying overload would change its items
+  CURL realURL = URIUtils::SubstitutePath(url);
+  if ((hints.flags & DIR_FLAG_NO_FILE_DIRS) && !(hints.flags & DIR_FLAG_BYPASS_CACHE) && url.Get() == realURL.Get())
+  {
+    CDirectoryPtr snapshot;
+    std::unique_ptr<IDirectory> pDirectory(CDirectoryFactory::Create(realURL));
+    if (pDirectory.get() &&
+        g_directoryCache.GetDirectory(realURL.Get(), snapshot, (hints.flags & DIR_FLAG_READ_CACHE) == DIR_FLAG_READ_CACHE))
+    {
+      bool filterMask = !pDirectory->AllowAll();
+      if (filterMask)
+        pDirectory->SetMask(hints.mask);
+      bool filterHidden = !CSettings::Get().GetBool("filelists.showhidden") && !(hints.flags & DIR_FLAG_GET_HIDDEN);
+
+      CFileItemList *filtered = NULL;
+      for (int i = 0; i < snapshot->Size(); ++i)
+      {
+        const CFileItemPtr item = snapshot->Get(i);
+        bool allowed = !(filterMask && !item->m_bIsFolder && !pDirectory->IsAllowed(item->GetURL())) &&
+                       !(filterHidden && item->GetProperty("file:hidden").asBoolean());
+        if (!allowed && !filtered)
+        {
+          // the list shares the items of the snapshot
+          filtered = new CFileItemList;
+          filtered->Copy(*snapshot, false);
+          for (int j = 0; j < i; ++j)
+            filtered->Add(snapshot->Get(j));
+        }
+        else if (allowed && filtered)
+          filtered->Add(item);
+      }
+
+      if (filtered)
+        items.reset(filtered);
+      else
+        items = snapshot;
+      return true;
+    }
+  }
+
+  CFileItemList *list = new CFileItemList;
+  items.reset(list);
+  if (!GetDirectory(url, *list, hints))
+  {
+    items.reset();
+    return false;
+  }
+  return true;
+}
+
 bool CDirectory::Create(const std::string& strPath)
 {
   const CURL pathToUrl(strPath);
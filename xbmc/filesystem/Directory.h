@@ -20,6 +20,7 @@
  */
 
 #include "IDirectory.h"
+#include <memory>
 #include <string>
 
 namespace XFILE
@@ -44,6 +45,9 @@ public:
     int flags;
   };
 
+  /*! \brief A shared listing which must not be modified, see CDirectoryCache */
+  typedef std::shared_ptr<const CFileItemList> CDirectoryPtr;
+
   static bool GetDirectory(const CURL& url
                            , CFileItemList &items
                            , const std::string &strMask=""
@@ -70,6 +74,27 @@ public:
                            , const CHints &hints
                            , bool allowThreads=false);
 
+  /*! \brief Get a read only listing of a directory
+   If the listing is cached, the cached snapshot is handed out without copying
+   its items (only a list of the items that pass the mask and the hidden
+   filter is built if needed). Items of the listing must not be modified, use
+   the CFileItemList overloads which return a copy to do so. Files that act
+   like directories are only replaced if DIR_FLAG_NO_FILE_DIRS isn't set, in
+   which case the listing is always a copy.
+   \param strPath The path of the directory
+   \param items The shared listing
+   \param strMask The mask the files have to match
+   \param flags DIR_FLAG_* flags
+   \return true if the directory was listed, false otherwise */
+  static bool GetDirectory(const std::string& strPath
+                           , CDirectoryPtr &items
+                           , const std::string &strMask=""
+                           , int flags=DIR_FLAG_DEFAULTS);
+
+  static bool GetDirectory(const CURL& url
+                           , CDirectoryPtr &items
+                           , const CHints &hints);
+
   static bool Create(const std::string& strPath);
   static bool Exists(const std::string& strPath, bool bUseCache = true);
   static bool Remove(const std::string& strPath);
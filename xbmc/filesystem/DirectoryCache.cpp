@@ -20,10 +20,14 @@
 
 #include "DirectoryCache.h"
 #include "FileItem.h"
+#include "music/tags/MusicInfoTag.h"
+#include "pictures/PictureInfoTag.h"
+#include "settings/AdvancedSettings.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
 #include "utils/StringUtils.h"
+#include "video/VideoInfoTag.h"
 #include "climits"
 
 #include <algorithm>
@@ -34,56 +38,127 @@ using namespace XFILE;
 CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType)
 {
   m_cacheType = cacheType;
-  m_lastAccess = 0;
-  m_Items = new CFileItemList;
-  m_Items->SetFastLookup(true);
+  m_size = 0;
 }
 
-CDirectoryCache::CDir::~CDir()
+CDirectoryCache::CShard::CShard()
 {
-  delete m_Items;
+  m_bytes = 0;
+  m_hits = 0;
+  m_misses = 0;
+  m_evictions = 0;
 }
 
-void CDirectoryCache::CDir::SetLastAccess(unsigned int &accessCounter)
+CDirectoryCache::CDirectoryCache(void)
 {
-  m_lastAccess = accessCounter++;
+  m_budget = 0;
+  m_bytes = 0;
 }
 
-CDirectoryCache::CDirectoryCache(void)
+CDirectoryCache::~CDirectoryCache(void)
 {
-  m_accessCounter = 0;
-#ifdef _DEBUG
-  m_cacheHits = 0;
-  m_cacheMisses = 0;
-#endif
 }
 
-CDirectoryCache::~CDirectoryCache(void)
+CDirectoryCache::CShard& CDirectoryCache::GetShard(const std::string& storedPath)
+{
+  // FNV-1a, the shard only has to be stable for a given path
+  uint32_t hash = 2166136261U;
+  for (std::string::const_iterator it = storedPath.begin(); it != storedPath.end(); ++it)
+  {
+    hash ^= (unsigned char)*it;
+    hash *= 16777619U;
+  }
+  return m_shards[hash % NUM_SHARDS];
+}
+
+uint64_t CDirectoryCache::GetBudget() const
+{
+  if (m_budget > 0)
+    return m_budget;
+  return (uint64_t)g_advancedSettings.m_directoryCacheSize * 1024;
+}
+
+bool CDirectoryCache::IsFull() const
+{
+  CSingleLock lock(m_bytesSection);
+  return m_bytes > GetBudget();
+}
+
+void CDirectoryCache::ChangeSize(CShard& shard, uint64_t removed, uint64_t added)
+{
+  shard.m_bytes = shard.m_bytes - removed + added;
+
+  CSingleLock lock(m_bytesSection);
+  m_bytes = m_bytes - removed + added;
+}
+
+void CDirectoryCache::SetMemoryBudget(uint64_t bytes)
+{
+  m_budget = bytes;
+  CheckIfFull("");
+}
+
+size_t CDirectoryCache::EstimateSize(const CFileItemList &items)
+{
+  size_t size = sizeof(CFileItemList) + items.GetPath().size();
+  for (int i = 0; i < items.Size(); i++)
+  {
+    const CFileItemPtr item = items[i];
+    size += sizeof(CFileItem) + item->GetPath().size() + item->GetLabel().size() + item->GetLabel2().size() +
+            item->GetArtCount() * 128;
+    if (item->HasProperties())
+      size += 512;
+    if (item->HasVideoInfoTag())
+      size += sizeof(CVideoInfoTag);
+    if (item->HasMusicInfoTag())
+      size += sizeof(MUSIC_INFO::CMusicInfoTag);
+    if (item->HasPictureInfoTag())
+      size += sizeof(CPictureInfoTag);
+  }
+  // fast lookup map node and key per item
+  size += items.Size() * 64;
+  return size;
+}
+
+void CDirectoryCache::Touch(CShard& shard, CDir& dir)
 {
+  if (dir.m_cacheType != DIR_CACHE_ALWAYS)
+    shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, dir.m_lruPosition);
 }
 
 bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll)
 {
-  CSingleLock lock (m_cs);
+  CDirectoryPtr dir;
+  if (!GetDirectory(strPath, dir, retrieveAll))
+    return false;
 
+  // the copy is made outside of the lock, the snapshot is never modified
+  items.Copy(*dir);
+  return true;
+}
+
+bool CDirectoryCache::GetDirectory(const std::string& strPath, CDirectoryPtr &items, bool retrieveAll)
+{
   std::string storedPath = strPath;
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  CShard &shard = GetShard(storedPath);
+  CSingleLock lock (shard.m_cs);
+
+  iCache i = shard.m_cache.find(storedPath);
+  if (i != shard.m_cache.end())
   {
-    CDir* dir = i->second;
-    if (dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
-       (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
+    CDir& dir = i->second;
+    if (dir.m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
+       (dir.m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
     {
-      items.Copy(*dir->m_Items);
-      dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-      m_cacheHits+=items.Size();
-#endif
+      items = dir.m_Items;
+      Touch(shard, dir);
+      shard.m_hits++;
       return true;
     }
   }
+  shard.m_misses++;
   return false;
 }
 
@@ -103,19 +178,37 @@ void CDirectoryCache::SetDirectory(const std::string& strPath, const CFileItemLi
   // IDEALLY, any further processing on the item would actually create a new item
   // instead of altering it, but we can't really enforce that in an easy way, so
   // this is the best solution for now.
-  CSingleLock lock (m_cs);
-
   std::string storedPath = strPath;
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ClearDirectory(storedPath);
+  // build the snapshot before taking the lock
+  CFileItemList *copy = new CFileItemList;
+  copy->Copy(items);
+  copy->SetFastLookup(true);
+
+  CDir dir(cacheType);
+  dir.m_Items.reset(copy);
+  dir.m_size = EstimateSize(*copy);
+
+  {
+    CShard &shard = GetShard(storedPath);
+    CSingleLock lock (shard.m_cs);
+
+    iCache i = shard.m_cache.find(storedPath);
+    if (i != shard.m_cache.end())
+      Delete(shard, i);
 
-  CheckIfFull();
+    i = shard.m_cache.insert(make_pair(storedPath, dir)).first;
+    if (cacheType == DIR_CACHE_ALWAYS)
+      return;
 
-  CDir* dir = new CDir(cacheType);
-  dir->m_Items->Copy(items);
-  dir->SetLastAccess(m_accessCounter);
-  m_cache.insert(pair<std::string, CDir*>(storedPath, dir));
+    shard.m_lru.push_front(storedPath);
+    i->second.m_lruPosition = shard.m_lru.begin();
+    ChangeSize(shard, 0, dir.m_size);
+  }
+
+  // the shard lock is released, as other shards may have to make room
+  CheckIfFull(storedPath);
 }
 
 void CDirectoryCache::ClearFile(const std::string& strFile)
@@ -125,53 +218,67 @@ void CDirectoryCache::ClearFile(const std::string& strFile)
 
 void CDirectoryCache::ClearDirectory(const std::string& strPath)
 {
-  CSingleLock lock (m_cs);
-
   std::string storedPath = strPath;
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  iCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
-    Delete(i);
+  CShard &shard = GetShard(storedPath);
+  CSingleLock lock (shard.m_cs);
+
+  iCache i = shard.m_cache.find(storedPath);
+  if (i != shard.m_cache.end())
+    Delete(shard, i);
 }
 
 void CDirectoryCache::ClearSubPaths(const std::string& strPath)
 {
-  CSingleLock lock (m_cs);
-
   std::string storedPath = strPath;
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
   {
-    if (StringUtils::StartsWith(i->first, storedPath))
-      Delete(i++);
-    else
-      i++;
+    CShard &shard = m_shards[s];
+    CSingleLock lock (shard.m_cs);
+
+    // paths sharing the prefix are adjacent in the map
+    iCache i = shard.m_cache.lower_bound(storedPath);
+    while (i != shard.m_cache.end() && StringUtils::StartsWith(i->first, storedPath))
+      Delete(shard, i++);
   }
 }
 
 void CDirectoryCache::AddFile(const std::string& strFile)
 {
-  CSingleLock lock (m_cs);
-
   std::string strPath = URIUtils::GetDirectory(strFile);
   URIUtils::RemoveSlashAtEnd(strPath);
 
-  ciCache i = m_cache.find(strPath);
-  if (i != m_cache.end())
+  CShard &shard = GetShard(strPath);
+  CSingleLock lock (shard.m_cs);
+
+  iCache i = shard.m_cache.find(strPath);
+  if (i != shard.m_cache.end())
   {
-    CDir *dir = i->second;
+    CDir &dir = i->second;
+
+    // readers may hold the current snapshot, so replace it by a new one
+    // sharing the unmodified items
+    CFileItemList *items = new CFileItemList;
+    items->Copy(*dir.m_Items, false);
+    items->Append(*dir.m_Items);
     CFileItemPtr item(new CFileItem(strFile, false));
-    dir->m_Items->Add(item);
-    dir->SetLastAccess(m_accessCounter);
+    items->Add(item);
+    items->SetFastLookup(true);
+    dir.m_Items.reset(items);
+
+    size_t size = EstimateSize(*items);
+    if (dir.m_cacheType != DIR_CACHE_ALWAYS)
+      ChangeSize(shard, dir.m_size, size);
+    dir.m_size = size;
+    Touch(shard, dir);
   }
 }
 
 bool CDirectoryCache::FileExists(const std::string& strFile, bool& bInCache)
 {
-  CSingleLock lock (m_cs);
   bInCache = false;
 
   std::string strPath(strFile);
@@ -179,31 +286,34 @@ bool CDirectoryCache::FileExists(const std::string& strFile, bool& bInCache)
   std::string storedPath = URIUtils::GetDirectory(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  CShard &shard = GetShard(storedPath);
+  CSingleLock lock (shard.m_cs);
+
+  iCache i = shard.m_cache.find(storedPath);
+  if (i != shard.m_cache.end())
   {
     bInCache = true;
-    CDir *dir = i->second;
-    dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-    m_cacheHits++;
-#endif
-    return (URIUtils::PathEquals(strPath, storedPath) || dir->m_Items->Contains(strFile));
+    CDir &dir = i->second;
+    Touch(shard, dir);
+    shard.m_hits++;
+    return (URIUtils::PathEquals(strPath, storedPath) || dir.m_Items->Contains(strFile));
   }
-#ifdef _DEBUG
-  m_cacheMisses++;
-#endif
+  shard.m_misses++;
   return false;
 }
 
 void CDirectoryCache::Clear()
 {
   // this routine clears everything
-  CSingleLock lock (m_cs);
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
+  {
+    CShard &shard = m_shards[s];
+    CSingleLock lock (shard.m_cs);
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end() )
-    Delete(i++);
+    shard.m_cache.clear();
+    shard.m_lru.clear();
+    ChangeSize(shard, shard.m_bytes, 0);
+  }
 }
 
 void CDirectoryCache::InitCache(set<std::string>& dirs)
@@ -220,61 +330,95 @@ void CDirectoryCache::InitCache(set<std::string>& dirs)
 
 void CDirectoryCache::ClearCache(set<std::string>& dirs)
 {
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
+  // only the listings stored under exactly the given paths are cleared
+  set<std::string>::iterator it;
+  for (it = dirs.begin(); it != dirs.end(); ++it)
   {
-    if (dirs.find(i->first) != dirs.end())
-      Delete(i++);
-    else
-      i++;
+    CShard &shard = GetShard(*it);
+    CSingleLock lock (shard.m_cs);
+
+    iCache i = shard.m_cache.find(*it);
+    if (i != shard.m_cache.end())
+      Delete(shard, i);
   }
 }
 
-void CDirectoryCache::CheckIfFull()
+void CDirectoryCache::CheckIfFull(const std::string& keepPath)
 {
-  CSingleLock lock (m_cs);
-  static const unsigned int max_cached_dirs = 10;
+  // must be called without holding a shard lock, shards are locked one at a time
+  for (unsigned int s = 0; s < NUM_SHARDS && IsFull(); s++)
+  {
+    CShard &shard = m_shards[s];
+    CSingleLock lock (shard.m_cs);
+    CheckIfFull(shard, keepPath);
+  }
+}
 
-  // find the last accessed folder, and remove if the number of cached folders is too many
-  iCache lastAccessed = m_cache.end();
-  unsigned int numCached = 0;
-  for (iCache i = m_cache.begin(); i != m_cache.end(); i++)
+void CDirectoryCache::CheckIfFull(CShard& shard, const std::string& keepPath)
+{
+  // while the cache is full, a shard that uses budget left unused by others gives it
+  // back by evicting its least recently used folders, so a large listing doesn't
+  // evict the listings of its own shard as long as other shards have room.
+  // dirs that are always cached aren't in the LRU list and are never cleared,
+  // and the folder that was just added stays even if it exceeds the budget alone
+  uint64_t share = GetBudget() / NUM_SHARDS;
+  while (shard.m_bytes > share && IsFull() && !shard.m_lru.empty() && shard.m_lru.back() != keepPath)
   {
-    // ensure dirs that are always cached aren't cleared
-    if (i->second->m_cacheType != DIR_CACHE_ALWAYS)
-    {
-      if (lastAccessed == m_cache.end() || i->second->GetLastAccess() < lastAccessed->second->GetLastAccess())
-        lastAccessed = i;
-      numCached++;
+    iCache i = shard.m_cache.find(shard.m_lru.back());
+    if (i == shard.m_cache.end())
+    { // can't happen, but don't loop forever
+      shard.m_lru.pop_back();
+      continue;
     }
+    Delete(shard, i);
+    shard.m_evictions++;
   }
-  if (lastAccessed != m_cache.end() && numCached >= max_cached_dirs)
-    Delete(lastAccessed);
 }
 
-void CDirectoryCache::Delete(iCache it)
+void CDirectoryCache::Delete(CShard& shard, iCache it)
 {
-  CDir* dir = it->second;
-  delete dir;
-  m_cache.erase(it);
+  CDir &dir = it->second;
+  if (dir.m_cacheType != DIR_CACHE_ALWAYS)
+  {
+    shard.m_lru.erase(dir.m_lruPosition);
+    ChangeSize(shard, dir.m_size, 0);
+  }
+  shard.m_cache.erase(it);
 }
 
-#ifdef _DEBUG
-void CDirectoryCache::PrintStats() const
+void CDirectoryCache::GetStats(CacheStats &stats) const
 {
-  CSingleLock lock (m_cs);
-  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, and %u cache misses", __FUNCTION__, m_cacheHits, m_cacheMisses);
-  // run through and find the oldest and the number of items cached
-  unsigned int oldest = UINT_MAX;
-  unsigned int numItems = 0;
-  unsigned int numDirs = 0;
-  for (ciCache i = m_cache.begin(); i != m_cache.end(); i++)
+  stats.hits = 0;
+  stats.misses = 0;
+  stats.evictions = 0;
+  stats.bytes = 0;
+  stats.budget = GetBudget();
+  stats.directories = 0;
+  stats.items = 0;
+
+  for (unsigned int s = 0; s < NUM_SHARDS; s++)
   {
-    CDir *dir = i->second;
-    oldest = min(oldest, dir->GetLastAccess());
-    numItems += dir->m_Items->Size();
-    numDirs++;
+    const CShard &shard = m_shards[s];
+    CSingleLock lock (shard.m_cs);
+
+    stats.hits += shard.m_hits;
+    stats.misses += shard.m_misses;
+    stats.evictions += shard.m_evictions;
+    for (ciCache i = shard.m_cache.begin(); i != shard.m_cache.end(); ++i)
+    {
+      stats.bytes += i->second.m_size;
+      stats.items += i->second.m_Items->Size();
+      stats.directories++;
+    }
   }
-  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total.  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, oldest, m_accessCounter);
+}
+
+#ifdef _DEBUG
+void CDirectoryCache::PrintStats() const
+{
+  CacheStats stats;
+  GetStats(stats);
+  CLog::Log(LOGDEBUG, "%s - total of %" PRIu64" cache hits, %" PRIu64" cache misses and %" PRIu64" evictions", __FUNCTION__, stats.hits, stats.misses, stats.evictions);
+  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total using %" PRIu64" of %" PRIu64" bytes", __FUNCTION__, stats.directories, stats.items, stats.bytes, stats.budget);
 }
 #endif
@@ -23,33 +23,60 @@
 #include "Directory.h"
 #include "threads/CriticalSection.h"
 
+#include <list>
 #include <map>
+#include <memory>
 #include <set>
+#include <stdint.h>
 
 class CFileItem;
 
 namespace XFILE
 {
+  /*!
+   \brief Cache of directory listings.
+
+   Listings are kept as immutable snapshots which are shared between the cache
+   and its readers, so looking up a listing never blocks other lookups for the
+   time it takes to copy it. Changes (e.g. AddFile) replace the snapshot
+   instead of modifying it.
+
+   The cache is split into shards by path, each with its own lock and LRU
+   list. The budget set by the <directorycachesize> advanced setting applies to
+   the whole cache, a shard may use the part other shards leave unused. Once
+   the estimated memory use of all listings exceeds it, listings that are not
+   DIR_CACHE_ALWAYS are evicted from the shards using more than their share.
+   */
   class CDirectoryCache
   {
-    class CDir
-    {
-    public:
-      CDir(DIR_CACHE_TYPE cacheType);
-      virtual ~CDir();
-
-      void SetLastAccess(unsigned int &accessCounter);
-      unsigned int GetLastAccess() const { return m_lastAccess; };
+  public:
+    typedef CDirectory::CDirectoryPtr CDirectoryPtr;
 
-      CFileItemList* m_Items;
-      DIR_CACHE_TYPE m_cacheType;
-    private:
-      unsigned int m_lastAccess;
+    struct CacheStats
+    {
+      uint64_t hits;
+      uint64_t misses;
+      uint64_t evictions;
+      uint64_t bytes;
+      uint64_t budget;
+      unsigned int directories;
+      unsigned int items;
     };
-  public:
+
     CDirectoryCache(void);
     virtual ~CDirectoryCache(void);
+
+    /*!
+     \brief Get a modifiable copy of a cached directory listing
+     */
     bool GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll = false);
+
+    /*!
+     \brief Get the cached snapshot of a directory listing without copying it
+     \param items the shared snapshot, which must not be modified
+     */
+    bool GetDirectory(const std::string& strPath, CDirectoryPtr &items, bool retrieveAll = false);
+
     void SetDirectory(const std::string& strPath, const CFileItemList &items, DIR_CACHE_TYPE cacheType);
     void ClearDirectory(const std::string& strPath);
     void ClearFile(const std::string& strFile);
@@ -57,27 +84,70 @@ namespace XFILE
     void Clear();
     void AddFile(const std::string& strFile);
     bool FileExists(const std::string& strPath, bool& bInCache);
+
+    /*!
+     \brief Override the memory budget of the cache
+     \param bytes the budget in bytes, 0 to use the <directorycachesize> advanced setting
+     */
+    void SetMemoryBudget(uint64_t bytes);
+    void GetStats(CacheStats &stats) const;
 #ifdef _DEBUG
     void PrintStats() const;
 #endif
+
+    /*!
+     \brief Estimate the memory used by a directory listing
+     */
+    static size_t EstimateSize(const CFileItemList &items);
+
   protected:
-    void InitCache(std::set<std::string>& dirs);
-    void ClearCache(std::set<std::string>& dirs);
-    void CheckIfFull();
+    class CDir
+    {
+    public:
+      CDir(DIR_CACHE_TYPE cacheType);
+
+      CDirectoryPtr m_Items;
+      DIR_CACHE_TYPE m_cacheType;
+      size_t m_size;
+      std::list<std::string>::iterator m_lruPosition;
+    };
+
+    typedef std::map<std::string, CDir> CacheMap;
+    typedef CacheMap::iterator iCache;
+    typedef CacheMap::const_iterator ciCache;
 
-    std::map<std::string, CDir*> m_cache;
-    typedef std::map<std::string, CDir*>::iterator iCache;
-    typedef std::map<std::string, CDir*>::const_iterator ciCache;
-    void Delete(iCache i);
+    class CShard
+    {
+    public:
+      CShard();
 
-    CCriticalSection m_cs;
+      CCriticalSection m_cs;
+      CacheMap m_cache;
+      std::list<std::string> m_lru; ///< evictable paths, most recently used first
+      uint64_t m_bytes;
+      uint64_t m_hits;
+      uint64_t m_misses;
+      uint64_t m_evictions;
+    };
 
-    unsigned int m_accessCounter;
+    static const unsigned int NUM_SHARDS = 8;
 
-#ifdef _DEBUG
-    unsigned int m_cacheHits;
-    unsigned int m_cacheMisses;
-#endif
+    CShard& GetShard(const std::string& storedPath);
+    uint64_t GetBudget() const;
+    bool IsFull() const;
+    void ChangeSize(CShard& shard, uint64_t removed, uint64_t added);
+    void Touch(CShard& shard, CDir& dir);
+    void CheckIfFull(const std::string& keepPath);
+    void CheckIfFull(CShard& shard, const std::string& keepPath);
+    void Delete(CShard& shard, iCache i);
+
+    void InitCache(std::set<std::string>& dirs);
+    void ClearCache(std::set<std::string>& dirs);
+
+    CShard m_shards[NUM_SHARDS];
+    uint64_t m_budget;
+    uint64_t m_bytes; ///< estimated size of the evictable listings of all shards
+    CCriticalSection m_bytesSection; ///< guards m_bytes, taken after a shard lock
   };
 }
 extern XFILE::CDirectoryCache g_directoryCache;
@@ -92,6 +92,20 @@ bool DllLibCurlGlobal::Load()
   /* check idle will clean up the last one */
   g_curlReferences = 2;
 
+  /* share connections, dns lookups and tls sessions between all handles */
+  m_share = share_init();
+  if (m_share)
+  {
+    share_setopt(m_share, CURLSHOPT_LOCKFUNC, share_lock);
+    share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+    share_setopt(m_share, CURLSHOPT_USERDATA, this);
+    share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+    share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+  }
+
 #if defined(HAS_CURL_STATIC)
   // Initialize ssl locking array
   m_sslLockArray = new CCriticalSection*[CRYPTO_num_locks()];
@@ -113,6 +127,10 @@ void DllLibCurlGlobal::Unload()
     if (!IsLoaded())
       return;
 
+    if (m_share && share_cleanup(m_share) != CURLSHE_OK)
+      CLog::Log(LOGWARNING, "%s - Share handle still in use on cleanup", __FUNCTION__);
+    m_share = NULL;
+
     // close libcurl
     global_cleanup();
 
@@ -136,6 +154,20 @@ void DllLibCurlGlobal::Unload()
 #endif
 }
 
+void DllLibCurlGlobal::share_lock(CURL_HANDLE *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+  DllLibCurlGlobal *curl = (DllLibCurlGlobal *)userptr;
+  if (data >= 0 && data < CURL_LOCK_DATA_LAST)
+    curl->m_shareLocks[data].lock();
+}
+
+void DllLibCurlGlobal::share_unlock(CURL_HANDLE *handle, curl_lock_data data, void *userptr)
+{
+  DllLibCurlGlobal *curl = (DllLibCurlGlobal *)userptr;
+  if (data >= 0 && data < CURL_LOCK_DATA_LAST)
+    curl->m_shareLocks[data].unlock();
+}
+
 void DllLibCurlGlobal::CheckIdle()
 {
   /* avoid locking section here, to avoid stalling gfx thread on loads*/
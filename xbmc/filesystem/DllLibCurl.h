@@ -53,6 +53,8 @@ namespace XCURL
     virtual CURLMcode multi_timeout(CURLM *multi_handle, long *timeout)=0;
     virtual CURLMsg*  multi_info_read(CURLM *multi_handle, int *msgs_in_queue)=0;
     virtual void multi_cleanup(CURL_HANDLE * handle )=0;
+    virtual CURLSH * share_init(void)=0;
+    virtual CURLSHcode share_cleanup(CURLSH *share_handle)=0;
     virtual struct curl_slist* slist_append(struct curl_slist *, const char *)=0;
     virtual void  slist_free_all(struct curl_slist *)=0;
   };
@@ -78,6 +80,10 @@ namespace XCURL
     DEFINE_METHOD2(CURLMcode, multi_timeout, (CURLM *p1, long *p2))
     DEFINE_METHOD2(CURLMsg*,  multi_info_read, (CURLM *p1, int *p2))
     DEFINE_METHOD1(void, multi_cleanup, (CURLM *p1))
+    DEFINE_METHOD_FP(CURLMcode, multi_setopt, (CURLM *p1, CURLMoption p2, ...))
+    DEFINE_METHOD0(CURLSH *, share_init)
+    DEFINE_METHOD_FP(CURLSHcode, share_setopt, (CURLSH *p1, CURLSHoption p2, ...))
+    DEFINE_METHOD1(CURLSHcode, share_cleanup, (CURLSH *p1))
     DEFINE_METHOD2(struct curl_slist*, slist_append, (struct curl_slist * p1, const char * p2))
     DEFINE_METHOD1(void, slist_free_all, (struct curl_slist * p1))
     DEFINE_METHOD1(const char *, easy_strerror, (CURLcode p1))
@@ -105,6 +111,10 @@ namespace XCURL
       RESOLVE_METHOD_RENAME(curl_multi_timeout, multi_timeout)
       RESOLVE_METHOD_RENAME(curl_multi_info_read, multi_info_read)
       RESOLVE_METHOD_RENAME(curl_multi_cleanup, multi_cleanup)
+      RESOLVE_METHOD_RENAME_FP(curl_multi_setopt, multi_setopt)
+      RESOLVE_METHOD_RENAME(curl_share_init, share_init)
+      RESOLVE_METHOD_RENAME_FP(curl_share_setopt, share_setopt)
+      RESOLVE_METHOD_RENAME(curl_share_cleanup, share_cleanup)
       RESOLVE_METHOD_RENAME(curl_slist_append, slist_append)
       RESOLVE_METHOD_RENAME(curl_slist_free_all, slist_free_all)
 #if defined(HAS_CURL_STATIC)
@@ -118,6 +128,8 @@ namespace XCURL
   class DllLibCurlGlobal : public DllLibCurl
   {
   public:
+    DllLibCurlGlobal() : m_share(NULL) {}
+
     /* extend interface with buffered functions */
     void easy_aquire(const char *protocol, const char *hostname, CURL_HANDLE** easy_handle, CURLM** multi_handle);
     void easy_release(CURL_HANDLE** easy_handle, CURLM** multi_handle);
@@ -125,6 +137,14 @@ namespace XCURL
     CURL_HANDLE* easy_duphandle(CURL_HANDLE* easy_handle);
     void CheckIdle();
 
+    /*!
+     \brief Share handle holding the connection cache, DNS cache and TLS
+     sessions of all easy handles, so connections outlive the session that
+     opened them and can be reused by any CCurlFile talking to the same host.
+     \return the share handle, NULL if sharing is not available
+     */
+    CURLSH* GetShare() const { return m_share; }
+
     /* overloaded load and unload with reference counter */
     virtual bool Load();
     virtual void Unload();
@@ -144,6 +164,13 @@ namespace XCURL
 
     VEC_CURLSESSIONS m_sessions;
     CCriticalSection m_critSection;
+
+  private:
+    static void share_lock(CURL_HANDLE *handle, curl_lock_data data, curl_lock_access access, void *userptr);
+    static void share_unlock(CURL_HANDLE *handle, curl_lock_data data, void *userptr);
+
+    CURLSH*          m_share;
+    CCriticalSection m_shareLocks[CURL_LOCK_DATA_LAST];
   };
 }
 
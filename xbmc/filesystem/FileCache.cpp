@@ -23,11 +23,14 @@
 #include "FileCache.h"
 #include "threads/Thread.h"
 #include "File.h"
+#include "CurlFile.h"
 #include "URL.h"
 
 #include "CircularCache.h"
+#include "MappedFileCache.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
+#include "utils/StringUtils.h"
 #include "utils/TimeUtils.h"
 #include "settings/AdvancedSettings.h"
 
@@ -39,6 +42,27 @@ using namespace XFILE;
 
 #define READ_CACHE_CHUNK_SIZE (64*1024)
 
+/* tells which version of the source is cached, so data kept from an earlier
+ * session isn't mixed with a changed source of the same length.
+ */
+static std::string GetSourceValidator(CFile &source)
+{
+  CCurlFile *curl = dynamic_cast<CCurlFile*>(source.GetImplemenation());
+  if (curl)
+  {
+    std::string validator = curl->GetHttpHeader().GetValue("etag");
+    if (validator.empty())
+      validator = curl->GetHttpHeader().GetValue("last-modified");
+    return validator;
+  }
+
+  struct __stat64 buffer;
+  if (source.Stat(&buffer) == 0 && buffer.st_mtime > 0)
+    return StringUtils::Format("%" PRId64, (int64_t)buffer.st_mtime);
+
+  return "";
+}
+
 class CWriteRate
 {
 public:
@@ -111,7 +135,9 @@ CFileCache::CFileCache(bool useDoubleCache)
    m_seekPos = 0;
    m_readPos = 0;
    m_writePos = 0;
-   if (g_advancedSettings.m_cacheMemBufferSize == 0)
+   if (g_advancedSettings.m_cacheMapped)
+     m_pCache = new CMappedFileCache(g_advancedSettings.m_cacheMappedPersist);
+   else if (g_advancedSettings.m_cacheMemBufferSize == 0)
      m_pCache = new CSimpleFileCache();
    else
    {
@@ -124,7 +150,8 @@ CFileCache::CFileCache(bool useDoubleCache)
      }
      m_pCache = new CCircularCache(front, back);
    }
-   if (useDoubleCache)
+   // the mapped cache keeps every range it fetched, a second one adds nothing
+   if (useDoubleCache && !g_advancedSettings.m_cacheMapped)
    {
      m_pCache = new CDoubleCache(m_pCache);
    }
@@ -186,14 +213,6 @@ bool CFileCache::Open(const CURL& url)
 
   m_sourcePath = url.Get();
 
-  // open cache strategy
-  if (m_pCache->Open() != CACHE_RC_OK)
-  {
-    CLog::Log(LOGERROR,"CFileCache::Open - failed to open cache");
-    Close();
-    return false;
-  }
-
   // opening the source file.
   if (!m_source.Open(m_sourcePath, READ_NO_CACHE | READ_TRUNCATED | READ_CHUNKED))
   {
@@ -208,6 +227,15 @@ bool CFileCache::Open(const CURL& url)
   m_seekPossible = m_source.IoControl(IOCTRL_SEEK_POSSIBLE, NULL);
   m_chunkSize = CFile::GetChunkSize(m_source.GetChunkSize(), READ_CACHE_CHUNK_SIZE);
 
+  // open cache strategy
+  m_pCache->SetSource(m_sourcePath, m_seekPossible > 0 ? m_source.GetLength() : 0, GetSourceValidator(m_source));
+  if (m_pCache->Open() != CACHE_RC_OK)
+  {
+    CLog::Log(LOGERROR,"CFileCache::Open - failed to open cache");
+    Close();
+    return false;
+  }
+
   m_readPos = 0;
   m_writePos = 0;
   m_writeRate = 1024 * 1024;
@@ -360,6 +388,21 @@ void CFileCache::Process()
 
     m_writePos += iTotalWrite;
 
+    // the cache may already hold the data that follows, continue the source after it
+    const int64_t cacheEnd = m_pCache->CachedDataEndPos();
+    if (cacheEnd > m_writePos && !m_bStop)
+    {
+      cacheReachEOF = (cacheEnd == m_source.GetLength());
+      if (!cacheReachEOF && m_source.Seek(cacheEnd, SEEK_SET) != cacheEnd)
+      {
+        CLog::Log(LOGERROR,"CFileCache::Process - Error seeking past cached data to %" PRId64, cacheEnd);
+        m_bStop = true;
+      }
+      m_writePos = cacheEnd;
+      limiter.Reset(m_writePos);
+      average.Reset(m_writePos, false);
+    }
+
     // under estimate write rate by a second, to
     // avoid uncertainty at start of caching
     m_writeRateActual = average.Rate(m_writePos, 1000);
@@ -120,6 +120,15 @@ public:
   */
   virtual DIR_CACHE_TYPE GetCacheType(const CURL& url) const { return DIR_CACHE_ONCE; };
 
+  /*!
+  \brief Get a token that changes whenever the content of the directory changes
+  Used to validate listings restored from the persistent directory cache.
+  \param url Directory at hand.
+  \return the token (e.g. the modification time), or an empty string if the directory can't be validated without listing it.
+  \sa CPersistentDirectoryCache
+  */
+  virtual std::string GetCacheValidator(const CURL& url) { return ""; }
+
   void SetMask(const std::string& strMask);
   void SetFlags(int flags);
 
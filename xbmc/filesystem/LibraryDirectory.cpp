@@ -60,18 +60,7 @@ bool CLibraryDirectory::GetDirectory(const CURL& url, CFileItemList &items)
       if (type == "filter")
       {
         CSmartPlaylist playlist;
-        std::string type, label;
-        XMLUtils::GetString(node, "content", type);
-        if (type.empty())
-        {
-          CLog::Log(LOGERROR, "<content> tag must not be empty for type=\"filter\" node '%s'", libNode.c_str());
-          return false;
-        }
-        if (XMLUtils::GetString(node, "label", label))
-          label = CGUIControlFactory::FilterLabel(label);
-        playlist.SetType(type);
-        playlist.SetName(label);
-        if (playlist.LoadFromXML(node) &&
+        if (GetFilterPlaylist(node, libNode, playlist) &&
             CSmartPlaylistDirectory::GetDirectory(playlist, items))
         {
           items.SetProperty("library.filter", "true");
@@ -82,12 +71,8 @@ bool CLibraryDirectory::GetDirectory(const CURL& url, CFileItemList &items)
       else if (type == "folder")
       {
         std::string path;
-        XMLUtils::GetPath(node, "path", path);
-        if (!path.empty())
-        {
-          URIUtils::AddSlashAtEnd(path);
+        if (GetFolderPath(node, path))
           return CDirectory::GetDirectory(path, items, m_strFileMask, m_flags);
-        }
       }
     }
     return false;
@@ -163,6 +148,58 @@ TiXmlElement *CLibraryDirectory::LoadXML(const std::string &xmlFile)
   return NULL;
 }
 
+bool CLibraryDirectory::GetFolderPath(const CURL& url, std::string& path)
+{
+  std::string libNode = GetNode(url);
+  if (!URIUtils::HasExtension(libNode, ".xml"))
+    return false;
+
+  TiXmlElement *node = LoadXML(libNode);
+  if (!node || XMLUtils::GetAttribute(node, "type") != "folder")
+    return false;
+
+  return GetFolderPath(node, path);
+}
+
+bool CLibraryDirectory::GetFilterPlaylist(const CURL& url, CSmartPlaylist& playlist)
+{
+  std::string libNode = GetNode(url);
+  if (!URIUtils::HasExtension(libNode, ".xml"))
+    return false;
+
+  TiXmlElement *node = LoadXML(libNode);
+  if (!node || XMLUtils::GetAttribute(node, "type") != "filter")
+    return false;
+
+  return GetFilterPlaylist(node, libNode, playlist);
+}
+
+bool CLibraryDirectory::GetFilterPlaylist(const TiXmlElement *node, const std::string &libNode, CSmartPlaylist &playlist)
+{
+  std::string type, label;
+  XMLUtils::GetString(node, "content", type);
+  if (type.empty())
+  {
+    CLog::Log(LOGERROR, "<content> tag must not be empty for type=\"filter\" node '%s'", libNode.c_str());
+    return false;
+  }
+  if (XMLUtils::GetString(node, "label", label))
+    label = CGUIControlFactory::FilterLabel(label);
+  playlist.SetType(type);
+  playlist.SetName(label);
+  return playlist.LoadFromXML(node);
+}
+
+bool CLibraryDirectory::GetFolderPath(const TiXmlElement *node, std::string &path)
+{
+  XMLUtils::GetPath(node, "path", path);
+  if (path.empty())
+    return false;
+
+  URIUtils::AddSlashAtEnd(path);
+  return true;
+}
+
 bool CLibraryDirectory::Exists(const CURL& url)
 {
   return !GetNode(url).empty();
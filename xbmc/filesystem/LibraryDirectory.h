@@ -22,6 +22,8 @@
 #include "IDirectory.h"
 #include "utils/XBMCTinyXML.h"
 
+class CSmartPlaylist;
+
 namespace XFILE
 {
   class CLibraryDirectory : public IDirectory
@@ -32,6 +34,20 @@ namespace XFILE
     virtual bool GetDirectory(const CURL& url, CFileItemList &items);
     virtual bool Exists(const CURL& url);
     virtual bool AllowAll() const { return true; }
+
+    /*! \brief resolve a library:// folder node to the path it points to
+     \param url the library:// path of the folder node
+     \param path [out] the path the folder node points to
+     \return true if the url is a visible folder node, false otherwise
+     */
+    bool GetFolderPath(const CURL& url, std::string& path);
+
+    /*! \brief get the smart playlist holding the rules of a library:// filter node
+     \param url the library:// path of the filter node
+     \param playlist [out] the smart playlist of the filter node
+     \return true if the url is a visible filter node, false otherwise
+     */
+    bool GetFilterPlaylist(const CURL& url, CSmartPlaylist& playlist);
   private:
     /*! \brief parse the given path and return the node corresponding to this path
      \param path the library:// path to parse
@@ -46,6 +62,21 @@ namespace XFILE
      */
     TiXmlElement *LoadXML(const std::string &xmlFile);
 
+    /*! \brief get the path of the given folder node
+     \param node the <node> root element of a folder node
+     \param path [out] the path the folder node points to
+     \return true if the folder node has a path, false otherwise
+     */
+    static bool GetFolderPath(const TiXmlElement *node, std::string &path);
+
+    /*! \brief get the smart playlist of the given filter node
+     \param node the <node> root element of a filter node
+     \param libNode the path of the node, for logging
+     \param playlist [out] the smart playlist of the filter node
+     \return true if the filter node could be loaded, false otherwise
+     */
+    static bool GetFilterPlaylist(const TiXmlElement *node, const std::string &libNode, CSmartPlaylist &playlist);
+
     CXBMCTinyXML m_doc;
   };
 }
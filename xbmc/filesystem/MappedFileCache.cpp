@@ -0,0 +1,646 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "MappedFileCache.h"
+#include "Directory.h"
+#include "File.h"
+#include "FileItem.h"
+#include "SpecialProtocol.h"
+#include "URL.h"
+#include "Util.h"
+#include "PlatformDefs.h" //for PRId64
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/Crc32.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#ifdef TARGET_WINDOWS
+#include "win32/WIN32Util.h"
+#include <winioctl.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace XFILE;
+
+#define MAPPED_WINDOW_SIZE  (16 * 1024 * 1024)
+#define MAPPED_WINDOW_COUNT 8
+#define MAPPED_PERSIST_MAX  10
+#define MAPPED_CACHE_FOLDER "special://temp/filecache/"
+
+CMappedFileCache::CMappedFileCache(bool persist)
+ : CCacheStrategy()
+ , m_sourceLength(0)
+ , m_persist(persist)
+ , m_readPos(0)
+ , m_writePos(0)
+ , m_fileSize(0)
+ , m_windowClock(0)
+#ifdef TARGET_WINDOWS
+ , m_handle(INVALID_HANDLE_VALUE)
+ , m_mapping(NULL)
+ , m_mappingSize(0)
+#else
+ , m_fd(-1)
+#endif
+{
+}
+
+CMappedFileCache::~CMappedFileCache()
+{
+  Close();
+}
+
+void CMappedFileCache::SetSource(const std::string &path, int64_t length, const std::string &validator)
+{
+  CSingleLock lock(m_sync);
+  m_source = path;
+  m_sourceLength = length;
+  m_sourceValidator = validator;
+}
+
+int CMappedFileCache::Open()
+{
+  Close();
+
+  CSingleLock lock(m_sync);
+
+  m_readPos = 0;
+  m_writePos = 0;
+  m_ranges.clear();
+
+  bool resume = false;
+  if (m_persist && !m_source.empty() && m_sourceLength > 0 && !m_sourceValidator.empty())
+  {
+    Crc32 crc;
+    crc.Compute(m_source);
+    std::string base = StringUtils::Format(MAPPED_CACHE_FOLDER "%08x", (uint32_t)crc);
+    CDirectory::Create(MAPPED_CACHE_FOLDER);
+    m_filename = CSpecialProtocol::TranslatePath(base + ".cache");
+
+    // the ranges only belong to whoever holds the file
+    if (OpenFile(true))
+    {
+      m_rangesFile = base + ".ranges";
+      resume = LoadRanges();
+    }
+    else
+    {
+      CLog::Log(LOGDEBUG, "CMappedFileCache::Open - %s is in use, caching in a temporary file", m_filename.c_str());
+      m_filename.clear();
+    }
+  }
+
+  if (m_filename.empty())
+  {
+    m_filename = CSpecialProtocol::TranslatePath(CUtil::GetNextFilename("special://temp/filecache%03d.cache", 999));
+    if (m_filename.empty())
+    {
+      CLog::Log(LOGERROR, "%s - Unable to generate a new filename", __FUNCTION__);
+      Close();
+      return CACHE_RC_ERROR;
+    }
+
+    if (!OpenFile(false))
+    {
+      CLog::LogF(LOGERROR, "failed to create file \"%s\"", m_filename.c_str());
+      Close();
+      return CACHE_RC_ERROR;
+    }
+  }
+
+  if (!resume && !TruncateFile())
+  {
+    CLog::LogF(LOGERROR, "failed to truncate file \"%s\"", m_filename.c_str());
+    Close();
+    return CACHE_RC_ERROR;
+  }
+
+  // only trust ranges the cache file actually holds
+  RangeMap::iterator it = m_ranges.begin();
+  while (it != m_ranges.end())
+  {
+    if (it->second > m_fileSize)
+      m_ranges.erase(it++);
+    else
+      ++it;
+  }
+
+  if (resume)
+    CLog::Log(LOGDEBUG, "CMappedFileCache::Open - resuming %s with %u cached ranges", m_filename.c_str(), (unsigned int)m_ranges.size());
+
+  return CACHE_RC_OK;
+}
+
+void CMappedFileCache::Close()
+{
+  CSingleLock lock(m_sync);
+
+  // saved while the file is still locked, so the next owner finds them
+  bool persisted = !m_filename.empty() && !m_rangesFile.empty() && !m_ranges.empty() && SaveRanges();
+
+  for (std::vector<Window>::iterator it = m_windows.begin(); it != m_windows.end(); ++it)
+    UnmapWindow(*it);
+  m_windows.clear();
+
+#ifdef TARGET_WINDOWS
+  if (m_mapping)
+    CloseHandle(m_mapping);
+  m_mapping = NULL;
+  m_mappingSize = 0;
+  if (m_handle != INVALID_HANDLE_VALUE)
+    CloseHandle(m_handle);
+  m_handle = INVALID_HANDLE_VALUE;
+#else
+  if (m_fd >= 0)
+    close(m_fd);
+  m_fd = -1;
+#endif
+
+  if (!m_filename.empty())
+  {
+    if (persisted)
+      CleanupPersisted();
+    else if (!CFile::Delete(m_filename))
+      CLog::LogF(LOGWARNING, "failed to delete temporary file \"%s\"", m_filename.c_str());
+  }
+
+  m_filename.clear();
+  m_rangesFile.clear();
+  m_ranges.clear();
+  m_fileSize = 0;
+}
+
+size_t CMappedFileCache::GetMaxWriteSize(const size_t& iRequestSize)
+{
+  return iRequestSize; // Can always write since it's on disk
+}
+
+int CMappedFileCache::WriteToCache(const char *pBuffer, size_t iSize)
+{
+  CSingleLock lock(m_sync);
+
+  size_t written = 0;
+  while (written < iSize)
+  {
+    size_t avail;
+    uint8_t *dst = MapWindow(m_writePos + written, avail);
+    if (!dst)
+      break;
+
+    size_t len = std::min(avail, iSize - written);
+    memcpy(dst, pBuffer + written, len);
+    written += len;
+  }
+
+  if (written == 0 && iSize > 0)
+  {
+    CLog::LogF(LOGERROR, "failed to map cache file at %" PRId64, m_writePos);
+    return CACHE_RC_ERROR;
+  }
+
+  AddRange(m_writePos, m_writePos + written);
+  m_writePos += written;
+
+  // continue after data an earlier download already left in the cache
+  RangeMap::const_iterator it = FindRange(m_writePos);
+  if (written == iSize && it != m_ranges.end())
+    m_writePos = it->second;
+
+  m_written.Set();
+
+  return written;
+}
+
+int CMappedFileCache::ReadFromCache(char *pBuffer, size_t iMaxSize)
+{
+  CSingleLock lock(m_sync);
+
+  int64_t avail = m_writePos - m_readPos;
+  if (avail <= 0)
+    return IsEndOfInput() ? 0 : CACHE_RC_WOULD_BLOCK;
+
+  size_t toRead = ((int64_t)iMaxSize > avail) ? (size_t)avail : iMaxSize;
+  size_t readBytes = 0;
+  while (readBytes < toRead)
+  {
+    size_t size;
+    uint8_t *src = MapWindow(m_readPos, size);
+    if (!src)
+      break;
+
+    size_t len = std::min(size, toRead - readBytes);
+    memcpy(pBuffer + readBytes, src, len);
+    readBytes += len;
+    m_readPos += len;
+  }
+
+  if (readBytes == 0)
+  {
+    CLog::LogF(LOGERROR, "failed to map cache file at %" PRId64, m_readPos);
+    return CACHE_RC_ERROR;
+  }
+
+  m_space.Set();
+
+  return readBytes;
+}
+
+int64_t CMappedFileCache::WaitForData(unsigned int iMinAvail, unsigned int iMillis)
+{
+  CSingleLock lock(m_sync);
+  int64_t avail = m_writePos - m_readPos;
+
+  if (iMillis == 0 || IsEndOfInput())
+    return avail;
+
+  XbmcThreads::EndTime endtime(iMillis);
+  while (!IsEndOfInput() && avail < iMinAvail && !endtime.IsTimePast())
+  {
+    lock.Leave();
+    m_written.WaitMSec(50); // may miss the deadline. shouldn't be a problem.
+    lock.Enter();
+    avail = m_writePos - m_readPos;
+  }
+
+  return avail;
+}
+
+int64_t CMappedFileCache::Seek(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+
+  // if seek is a bit over what we have, try to wait a few seconds for the data to be available.
+  // we try to avoid a (heavy) seek on the source
+  if (iFilePosition > m_writePos && iFilePosition < m_writePos + 100000 && m_readPos <= m_writePos)
+  {
+    int64_t wanted = iFilePosition - m_readPos;
+    lock.Leave();
+    WaitForData((unsigned int)wanted, 5000);
+    lock.Enter();
+  }
+
+  /* only the range being written to can be read without the help of the
+   * writer, a seek into any other range makes CFileCache move the source to
+   * the end of that range (see Reset()), the data before it is reused.
+   */
+  RangeMap::const_iterator it = m_writePos > 0 ? FindRange(m_writePos - 1) : m_ranges.end();
+  int64_t start = it != m_ranges.end() ? it->first : m_writePos;
+  if (iFilePosition >= start && iFilePosition <= m_writePos)
+  {
+    m_readPos = iFilePosition;
+    m_space.Set();
+    return iFilePosition;
+  }
+
+  return CACHE_RC_ERROR;
+}
+
+bool CMappedFileCache::Reset(int64_t iSourcePosition, bool clearAnyway)
+{
+  CSingleLock lock(m_sync);
+
+  if (clearAnyway)
+    m_ranges.clear();
+  else
+  {
+    RangeMap::const_iterator it = FindRange(iSourcePosition);
+    if (it != m_ranges.end())
+    {
+      m_readPos = iSourcePosition;
+      m_writePos = it->second;
+      return false;
+    }
+  }
+
+  m_readPos = iSourcePosition;
+  m_writePos = iSourcePosition;
+  return true;
+}
+
+int64_t CMappedFileCache::CachedDataEndPosIfSeekTo(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+  RangeMap::const_iterator it = FindRange(iFilePosition);
+  if (it != m_ranges.end())
+    return it->second;
+  return iFilePosition;
+}
+
+int64_t CMappedFileCache::CachedDataEndPos()
+{
+  CSingleLock lock(m_sync);
+  return m_writePos;
+}
+
+bool CMappedFileCache::IsCachedPosition(int64_t iFilePosition)
+{
+  CSingleLock lock(m_sync);
+  return FindRange(iFilePosition) != m_ranges.end();
+}
+
+CCacheStrategy *CMappedFileCache::CreateNew()
+{
+  return new CMappedFileCache(m_persist);
+}
+
+size_t CMappedFileCache::GetRangeCount()
+{
+  CSingleLock lock(m_sync);
+  return m_ranges.size();
+}
+
+CMappedFileCache::RangeMap::const_iterator CMappedFileCache::FindRange(int64_t pos) const
+{
+  RangeMap::const_iterator it = m_ranges.upper_bound(pos);
+  if (it == m_ranges.begin())
+    return m_ranges.end();
+  --it;
+  if (pos < it->second)
+    return it;
+  return m_ranges.end();
+}
+
+void CMappedFileCache::AddRange(int64_t start, int64_t end)
+{
+  if (end <= start)
+    return;
+
+  RangeMap::iterator it = m_ranges.upper_bound(start);
+  if (it != m_ranges.begin())
+  {
+    RangeMap::iterator prev = it;
+    --prev;
+    if (prev->second >= start)
+    {
+      start = prev->first;
+      end = std::max(end, prev->second);
+      m_ranges.erase(prev);
+    }
+  }
+
+  while (it != m_ranges.end() && it->first <= end)
+  {
+    end = std::max(end, it->second);
+    m_ranges.erase(it++);
+  }
+
+  m_ranges[start] = end;
+}
+
+uint8_t *CMappedFileCache::MapWindow(int64_t pos, size_t &size)
+{
+  int64_t offset = pos - pos % MAPPED_WINDOW_SIZE;
+  size = (size_t)(offset + MAPPED_WINDOW_SIZE - pos);
+
+  Window *window = NULL;
+  for (std::vector<Window>::iterator it = m_windows.begin(); it != m_windows.end(); ++it)
+  {
+    if (it->offset == offset)
+    {
+      it->used = ++m_windowClock;
+      return it->data + (pos - offset);
+    }
+    if (!window || it->used < window->used)
+      window = &(*it);
+  }
+
+  if (!ReserveWindow(offset))
+    return NULL;
+
+  // reuse the least recently used window once all are taken
+  if (m_windows.size() < MAPPED_WINDOW_COUNT)
+  {
+    Window empty = { 0, NULL, 0 };
+    m_windows.push_back(empty);
+    window = &m_windows.back();
+  }
+  else
+    UnmapWindow(*window);
+
+#ifdef TARGET_WINDOWS
+  window->data = (uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, (DWORD)(offset >> 32), (DWORD)(offset & 0xFFFFFFFF), MAPPED_WINDOW_SIZE);
+#else
+  void *data = mmap(NULL, MAPPED_WINDOW_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, offset);
+  window->data = data == MAP_FAILED ? NULL : (uint8_t*)data;
+#endif
+  if (!window->data)
+    return NULL;
+
+  window->offset = offset;
+  window->used = ++m_windowClock;
+  return window->data + (pos - offset);
+}
+
+void CMappedFileCache::UnmapWindow(Window &window)
+{
+  if (!window.data)
+    return;
+
+#ifdef TARGET_WINDOWS
+  UnmapViewOfFile(window.data);
+#else
+  munmap(window.data, MAPPED_WINDOW_SIZE);
+#endif
+  window.data = NULL;
+}
+
+bool CMappedFileCache::OpenFile(bool exclusive)
+{
+#ifdef TARGET_WINDOWS
+  // not shared, a second cache for the same source fails to open it
+  m_handle = CreateFileW(CWIN32Util::ConvertPathToWin32Form(m_filename).c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                         OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (m_handle == INVALID_HANDLE_VALUE)
+    return false;
+
+  // don't let the file system allocate the parts we skip over
+  DWORD bytes;
+  DeviceIoControl(m_handle, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &bytes, NULL);
+
+  LARGE_INTEGER size;
+  m_fileSize = GetFileSizeEx(m_handle, &size) ? size.QuadPart : 0;
+#else
+  m_fd = open(m_filename.c_str(), O_RDWR | O_CREAT, 0600);
+  if (m_fd < 0)
+    return false;
+
+  // truncating a file another cache has mapped would crash it
+  if (exclusive && flock(m_fd, LOCK_EX | LOCK_NB) != 0)
+  {
+    close(m_fd);
+    m_fd = -1;
+    return false;
+  }
+
+  struct stat st;
+  m_fileSize = fstat(m_fd, &st) == 0 ? st.st_size : 0;
+#endif
+  return true;
+}
+
+bool CMappedFileCache::TruncateFile()
+{
+#ifdef TARGET_WINDOWS
+  LARGE_INTEGER start;
+  start.QuadPart = 0;
+  if (!SetFilePointerEx(m_handle, start, NULL, FILE_BEGIN) || !SetEndOfFile(m_handle))
+    return false;
+#else
+  if (ftruncate(m_fd, 0) != 0)
+    return false;
+#endif
+  m_fileSize = 0;
+  return true;
+}
+
+bool CMappedFileCache::ReserveWindow(int64_t offset)
+{
+  int64_t size = offset + MAPPED_WINDOW_SIZE;
+#ifdef TARGET_WINDOWS
+  if (m_handle == INVALID_HANDLE_VALUE)
+    return false;
+
+  // writing into a sparse view fails with an exception once the disk is full
+  ULARGE_INTEGER available;
+  if (GetDiskFreeSpaceExW(CWIN32Util::ConvertPathToWin32Form(URIUtils::GetDirectory(m_filename)).c_str(), &available, NULL, NULL) &&
+      available.QuadPart < MAPPED_WINDOW_SIZE)
+  {
+    CLog::LogF(LOGERROR, "not enough space to cache at %" PRId64, offset);
+    return false;
+  }
+
+  if (size > m_fileSize)
+  {
+    LARGE_INTEGER end;
+    end.QuadPart = size;
+    if (!SetFilePointerEx(m_handle, end, NULL, FILE_BEGIN) || !SetEndOfFile(m_handle))
+      return false;
+    m_fileSize = size;
+  }
+
+  // mapped views keep the old mapping alive, only new views use the larger one
+  if (!m_mapping || m_mappingSize < m_fileSize)
+  {
+    if (m_mapping)
+      CloseHandle(m_mapping);
+    m_mapping = CreateFileMapping(m_handle, NULL, PAGE_READWRITE, (DWORD)(m_fileSize >> 32), (DWORD)(m_fileSize & 0xFFFFFFFF), NULL);
+    m_mappingSize = m_mapping ? m_fileSize : 0;
+  }
+  return m_mapping != NULL;
+#else
+  if (m_fd < 0)
+    return false;
+
+#if defined(TARGET_DARWIN) || defined(TARGET_ANDROID)
+  // no posix_fallocate, a full disk shows up when writing into the mapping
+  if (size > m_fileSize && ftruncate(m_fd, size) != 0)
+    return false;
+#else
+  // allocate the window up front, writing into a hole of the mapping raises
+  // SIGBUS instead of an error once the disk is full
+  int err = posix_fallocate(m_fd, offset, MAPPED_WINDOW_SIZE);
+  if (err != 0)
+  {
+    CLog::LogF(LOGERROR, "failed to allocate cache file at %" PRId64 ": %s", offset, strerror(err));
+    return false;
+  }
+#endif
+  m_fileSize = std::max(m_fileSize, size);
+  return true;
+#endif
+}
+
+bool CMappedFileCache::LoadRanges()
+{
+  auto_buffer buffer;
+  CFile file;
+  if (file.LoadFile(m_rangesFile, buffer) <= 0)
+    return false;
+  file.Close();
+
+  // the ranges are saved again on close, a crash in between leaves no stale ones behind
+  CFile::Delete(m_rangesFile);
+
+  std::vector<std::string> lines = StringUtils::Split(std::string(buffer.get(), buffer.size()), "\n");
+  if (lines.size() < 3 ||
+      lines[0] != CURL(m_source).GetRedacted() ||
+      strtoll(lines[1].c_str(), NULL, 10) != m_sourceLength ||
+      lines[2] != m_sourceValidator)
+  {
+    CLog::Log(LOGDEBUG, "CMappedFileCache::LoadRanges - source changed, dropping cached data of %s", m_filename.c_str());
+    return false;
+  }
+
+  for (size_t i = 3; i < lines.size(); i++)
+  {
+    int64_t start, end;
+    if (sscanf(lines[i].c_str(), "%" PRId64 " %" PRId64, &start, &end) == 2 &&
+        start >= 0 && start < end && end <= m_sourceLength)
+      AddRange(start, end);
+  }
+  return true;
+}
+
+bool CMappedFileCache::SaveRanges()
+{
+  // credentials in the source don't belong on disk
+  std::string data = CURL(m_source).GetRedacted() + "\n" +
+                     StringUtils::Format("%" PRId64 "\n", m_sourceLength) +
+                     m_sourceValidator + "\n";
+  for (RangeMap::const_iterator it = m_ranges.begin(); it != m_ranges.end(); ++it)
+    data += StringUtils::Format("%" PRId64 " %" PRId64 "\n", it->first, it->second);
+
+  CFile file;
+  if (!file.OpenForWrite(m_rangesFile, true))
+    return false;
+
+  return file.Write(data.c_str(), data.size()) == (ssize_t)data.size();
+}
+
+void CMappedFileCache::CleanupPersisted()
+{
+  CFileItemList items;
+  if (!CDirectory::GetDirectory(MAPPED_CACHE_FOLDER, items, ".ranges", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE))
+    return;
+
+  if (items.Size() <= MAPPED_PERSIST_MAX)
+    return;
+
+  // keep the most recently closed ones
+  items.Sort(SortByDate, SortOrderDescending);
+  for (int i = MAPPED_PERSIST_MAX; i < items.Size(); i++)
+  {
+    const std::string &path = items[i]->GetPath();
+    CFile::Delete(path);
+    CFile::Delete(URIUtils::ReplaceExtension(path, ".cache"));
+  }
+}
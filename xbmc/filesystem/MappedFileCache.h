@@ -0,0 +1,134 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CacheStrategy.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace XFILE {
+
+/*!
+ \brief Cache strategy keeping everything that was downloaded in a sparse file.
+
+ Data is written at its position in the source, so the cache file mirrors the
+ source with holes for the parts that were never fetched. The fetched byte
+ ranges are tracked in an interval map, a seek into any of them continues
+ reading from the cache and only moves the source to the end of that range.
+ Writing into the start of an already fetched range merges both, the writer
+ then continues after the merged range (see CachedDataEndPos()).
+
+ The file is accessed through a few memory mapped windows, so the address
+ space used stays bounded independent of the size of the source.
+
+ When persisting, the cache file and its ranges are kept in
+ special://temp/filecache/ on close and picked up again when the same source
+ with the same length and validator is opened. Sources without a validator
+ aren't persisted. While a persisted file is in use, another cache for the same
+ source uses a temporary file instead.
+ */
+class CMappedFileCache : public CCacheStrategy
+{
+public:
+  CMappedFileCache(bool persist = false);
+  virtual ~CMappedFileCache();
+
+  virtual void SetSource(const std::string &path, int64_t length, const std::string &validator);
+
+  virtual int Open();
+  virtual void Close();
+
+  virtual size_t GetMaxWriteSize(const size_t& iRequestSize);
+  virtual int WriteToCache(const char *pBuffer, size_t iSize);
+  virtual int ReadFromCache(char *pBuffer, size_t iMaxSize);
+  virtual int64_t WaitForData(unsigned int iMinAvail, unsigned int iMillis);
+
+  virtual int64_t Seek(int64_t iFilePosition);
+  virtual bool Reset(int64_t iSourcePosition, bool clearAnyway=true);
+
+  virtual int64_t CachedDataEndPosIfSeekTo(int64_t iFilePosition);
+  virtual int64_t CachedDataEndPos();
+  virtual bool IsCachedPosition(int64_t iFilePosition);
+
+  virtual CCacheStrategy *CreateNew();
+
+  /*! \brief Number of disjoint byte ranges held by the cache */
+  size_t GetRangeCount();
+
+protected:
+  typedef std::map<int64_t, int64_t> RangeMap; ///< start -> end (exclusive) of fetched data
+
+  struct Window
+  {
+    int64_t      offset;
+    uint8_t     *data;
+    unsigned int used;
+  };
+
+  RangeMap::const_iterator FindRange(int64_t pos) const;
+  void AddRange(int64_t start, int64_t end);
+
+  /*!
+   \brief Open (or create) m_filename without truncating it
+   \param exclusive fail if another cache has the file open
+   */
+  bool OpenFile(bool exclusive);
+  bool TruncateFile();
+
+  uint8_t *MapWindow(int64_t pos, size_t &size);
+  void UnmapWindow(Window &window);
+  /*! \brief Make sure the disk space of the window at offset is allocated */
+  bool ReserveWindow(int64_t offset);
+
+  bool LoadRanges();
+  bool SaveRanges();
+  void CleanupPersisted();
+
+  std::string      m_source;
+  int64_t          m_sourceLength;
+  std::string      m_sourceValidator;
+  bool             m_persist;
+  std::string      m_filename;
+  std::string      m_rangesFile;
+
+  RangeMap         m_ranges;
+  int64_t          m_readPos;
+  int64_t          m_writePos;
+  int64_t          m_fileSize;
+
+  std::vector<Window> m_windows;
+  unsigned int     m_windowClock;
+
+  CCriticalSection m_sync;
+  CEvent           m_written;
+#ifdef TARGET_WINDOWS
+  HANDLE           m_handle;
+  HANDLE           m_mapping;
+  int64_t          m_mappingSize;
+#else
+  int              m_fd;
+#endif
+};
+
+} // namespace XFILE
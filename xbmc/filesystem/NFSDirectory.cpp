@@ -359,4 +359,24 @@ bool CNFSDirectory::Exists(const CURL& url2)
   return S_ISDIR(info.st_mode) ? true : false;
 }
 
+std::string CNFSDirectory::GetCacheValidator(const CURL& url2)
+{
+  CSingleLock lock(gNfsConnection);
+  std::string folderName(url2.Get());
+  URIUtils::RemoveSlashAtEnd(folderName);
+  CURL url(folderName);
+  folderName = "";
+
+  if(!gNfsConnection.Connect(url,folderName))
+    return "";
+
+  // the modification time of a directory changes when entries are added, removed or renamed
+  NFSSTAT info;
+  if (gNfsConnection.GetImpl()->nfs_stat(gNfsConnection.GetNfsContext(), folderName.c_str(), &info) != 0 ||
+      !S_ISDIR(info.st_mode))
+    return "";
+
+  return StringUtils::Format("%" PRId64, (int64_t)info.st_mtime);
+}
+
 #endif
@@ -31,6 +31,7 @@ namespace XFILE
       virtual ~CNFSDirectory(void);
       virtual bool GetDirectory(const CURL& url, CFileItemList &items);
       virtual DIR_CACHE_TYPE GetCacheType(const CURL& url) const { return DIR_CACHE_ONCE; };
+      virtual std::string GetCacheValidator(const CURL& url);
       virtual bool Create(const CURL& url);
       virtual bool Exists(const CURL& url);
       virtual bool Remove(const CURL& url);
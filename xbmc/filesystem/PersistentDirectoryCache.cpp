@@ -0,0 +1,329 @@
+/*
+ *      Copyright (C) 2005-2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PersistentDirectoryCache.h"
+#include "Directory.h"
+#include "DirectoryCache.h"
+#include "DirectoryFactory.h"
+#include "File.h"
+#include "FileItem.h"
+#include "URL.h"
+#include "guilib/GUIWindowManager.h"
+#include "GUIUserMessages.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "utils/Archive.h"
+#include "utils/Crc32.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+using namespace XFILE;
+
+#define CACHE_FOLDER  "special://temp/dircache/"
+#define CACHE_VERSION 1
+// listings kept on disk before the least recently used ones are deleted
+#define CACHE_MAX_LISTINGS 500
+
+// flags that don't change what IDirectory returns
+#define CACHE_IGNORED_FLAGS (DIR_FLAG_ALLOW_PROMPT | DIR_FLAG_READ_CACHE | DIR_FLAG_BYPASS_CACHE)
+
+class CPersistentDirectoryJob : public CJob
+{
+public:
+  /*!
+   \brief Store a listing
+   */
+  CPersistentDirectoryJob(const CURL &realURL, int flags, const CDirectoryCache::CDirectoryPtr &items, const std::string &validator)
+    : m_realURL(realURL), m_url(realURL), m_flags(flags), m_cacheType(DIR_CACHE_ONCE), m_validator(validator), m_items(items)
+  {
+  }
+
+  /*!
+   \brief Validate a restored listing, and refresh it if it changed
+   */
+  CPersistentDirectoryJob(const CURL &realURL, const CURL &url, int flags, DIR_CACHE_TYPE cacheType, const std::string &validator)
+    : m_realURL(realURL), m_url(url), m_flags(flags), m_cacheType(cacheType), m_validator(validator)
+  {
+  }
+
+  virtual const char *GetType() const { return m_items ? "persistentdirectorystore" : "persistentdirectoryvalidate"; }
+
+  virtual bool operator==(const CJob* job) const
+  {
+    if (strcmp(job->GetType(), GetType()) == 0)
+    {
+      const CPersistentDirectoryJob* dirJob = dynamic_cast<const CPersistentDirectoryJob*>(job);
+      if (dirJob && dirJob->m_realURL.Get() == m_realURL.Get() && dirJob->m_flags == m_flags)
+        return true;
+    }
+    return false;
+  }
+
+  virtual bool DoWork()
+  {
+    // the validator was taken when the listing was fetched
+    if (m_items)
+      return CPersistentDirectoryCache::Get().Write(m_realURL.Get(), m_flags, *m_items, m_validator);
+
+    return CPersistentDirectoryCache::Get().Validate(m_realURL, m_url, m_flags, m_cacheType, m_validator);
+  }
+
+private:
+  CURL m_realURL;
+  CURL m_url;
+  int m_flags;
+  DIR_CACHE_TYPE m_cacheType;
+  std::string m_validator;
+  CDirectoryCache::CDirectoryPtr m_items;
+};
+
+CPersistentDirectoryCache::CPersistentDirectoryCache()
+  : CJobQueue(false, 2, CJob::PRIORITY_LOW),
+    m_lruLoaded(false),
+    m_maxListings(CACHE_MAX_LISTINGS)
+{
+}
+
+CPersistentDirectoryCache &CPersistentDirectoryCache::Get()
+{
+  static CPersistentDirectoryCache s_cache;
+  return s_cache;
+}
+
+bool CPersistentDirectoryCache::IsCacheable(const CURL &url, DIR_CACHE_TYPE cacheType) const
+{
+  if (!g_advancedSettings.m_persistentDirectoryCache || cacheType == DIR_CACHE_NEVER)
+    return false;
+
+  const std::string path = url.Get();
+  return URIUtils::IsSmb(path) || URIUtils::IsNfs(path) || URIUtils::IsAfp(path) || URIUtils::IsUPnP(path);
+}
+
+bool CPersistentDirectoryCache::Load(const CURL &realURL, const CURL &url, int flags, DIR_CACHE_TYPE cacheType, CFileItemList &items)
+{
+  if (!IsCacheable(realURL, cacheType))
+    return false;
+
+  std::string validator;
+  if (!Read(realURL.Get(), flags, items, validator))
+    return false;
+
+  CLog::Log(LOGDEBUG, "%s - restored %i items of %s", __FUNCTION__, items.Size(), url.GetRedacted().c_str());
+  AddJob(new CPersistentDirectoryJob(realURL, url, flags & ~CACHE_IGNORED_FLAGS, cacheType, validator));
+  return true;
+}
+
+void CPersistentDirectoryCache::Store(const CURL &realURL, int flags, DIR_CACHE_TYPE cacheType, const std::string &validator)
+{
+  if (!IsCacheable(realURL, cacheType))
+    return;
+
+  // the snapshot of the directory cache is immutable, so the job can write it without a copy
+  CDirectoryCache::CDirectoryPtr items;
+  if (g_directoryCache.GetDirectory(realURL.Get(), items, true) && items->Size() > 0)
+    AddJob(new CPersistentDirectoryJob(realURL, flags & ~CACHE_IGNORED_FLAGS, items, validator));
+}
+
+bool CPersistentDirectoryCache::Validate(const CURL &realURL, const CURL &url, int flags, DIR_CACHE_TYPE cacheType, const std::string &validator)
+{
+  std::shared_ptr<IDirectory> directory(CDirectoryFactory::Create(realURL));
+  if (!directory.get())
+    return false;
+
+  // take it before listing again, so a change made while listing is caught by the next validation
+  std::string currentValidator = directory->GetCacheValidator(realURL);
+  if (!currentValidator.empty() && currentValidator == validator)
+    return true;
+
+  // changed or can't tell, list it again. there's no one to ask for credentials
+  CFileItemList items;
+  directory->SetFlags(flags & ~DIR_FLAG_ALLOW_PROMPT);
+  if (!directory->GetDirectory(realURL, items))
+    return false;
+
+  CFileItemList stored;
+  std::string storedValidator;
+  bool changed = !Read(realURL.Get(), flags, stored, storedValidator) || !IsSameListing(stored, items);
+
+  Write(realURL.Get(), flags, items, currentValidator);
+
+  if (changed)
+  {
+    CLog::Log(LOGDEBUG, "%s - listing of %s changed, refreshing", __FUNCTION__, url.GetRedacted().c_str());
+    g_directoryCache.SetDirectory(realURL.Get(), items, cacheType);
+
+    CGUIMessage message(GUI_MSG_NOTIFY_ALL, 0, 0, GUI_MSG_UPDATE_PATH);
+    message.SetStringParam(url.Get());
+    g_windowManager.SendThreadMessage(message);
+  }
+  return true;
+}
+
+std::string CPersistentDirectoryCache::GetCacheFile(const std::string &path, int flags) const
+{
+  std::string storedPath(path);
+  URIUtils::RemoveSlashAtEnd(storedPath);
+
+  Crc32 crc;
+  crc.ComputeFromLowerCase(storedPath);
+  return StringUtils::Format(CACHE_FOLDER "%08x-%x.fi", (unsigned __int32)crc, flags & ~CACHE_IGNORED_FLAGS);
+}
+
+bool CPersistentDirectoryCache::Read(const std::string &path, int flags, CFileItemList &items, std::string &validator)
+{
+  std::string cacheFile = GetCacheFile(path, flags);
+
+  CSingleLock lock(m_cs);
+  CFile file;
+  if (!file.Open(cacheFile))
+    return false;
+
+  CArchive ar(&file, CArchive::load);
+  bool loaded = false;
+  int version;
+  ar >> version;
+  if (version == CACHE_VERSION)
+  {
+    std::string storedPath;
+    ar >> storedPath;
+    // the name is a hash, make sure it's really the listing we're after
+    if (URIUtils::PathEquals(storedPath, path, true))
+    {
+      ar >> validator;
+      ar >> items;
+      loaded = true;
+    }
+  }
+  ar.Close();
+  file.Close();
+
+  if (loaded)
+    Touch(cacheFile);
+  return loaded;
+}
+
+bool CPersistentDirectoryCache::Write(const std::string &path, int flags, const CFileItemList &items, const std::string &validator)
+{
+  std::string cacheFile = GetCacheFile(path, flags);
+  std::string tempFile = cacheFile + ".tmp";
+
+  CSingleLock lock(m_cs);
+  if (!CDirectory::Exists(CACHE_FOLDER))
+    CDirectory::Create(CACHE_FOLDER);
+
+  CFile file;
+  if (!file.OpenForWrite(tempFile, true))
+  {
+    CLog::Log(LOGERROR, "%s - unable to write %s", __FUNCTION__, tempFile.c_str());
+    return false;
+  }
+
+  CArchive ar(&file, CArchive::store);
+  ar << (int)CACHE_VERSION;
+  ar << path;
+  ar << validator;
+  // IArchivable::Archive() serves loading and storing, so it can't be const. When storing,
+  // CFileItemList::Archive() only reads the list and its items under the list's own lock,
+  // so casting away const is safe here, also for the shared snapshot of the directory cache.
+  ar << const_cast<CFileItemList&>(items);
+  ar.Close();
+  file.Close();
+
+  // replace the old listing in one go so a crash never leaves a partial one behind
+  if (CFile::Exists(cacheFile))
+    CFile::Delete(cacheFile);
+  if (!CFile::Rename(tempFile, cacheFile))
+    return false;
+
+  Touch(cacheFile);
+  Prune();
+  return true;
+}
+
+bool CPersistentDirectoryCache::IsSameListing(const CFileItemList &items1, const CFileItemList &items2)
+{
+  if (items1.Size() != items2.Size())
+    return false;
+
+  for (int i = 0; i < items1.Size(); i++)
+  {
+    const CFileItemPtr item1 = items1[i];
+    const CFileItemPtr item2 = items2[i];
+    if (item1->GetPath() != item2->GetPath() ||
+        item1->m_bIsFolder != item2->m_bIsFolder ||
+        item1->m_dwSize != item2->m_dwSize ||
+        item1->m_dateTime != item2->m_dateTime)
+      return false;
+  }
+  return true;
+}
+
+void CPersistentDirectoryCache::SetMaxListings(unsigned int listings)
+{
+  CSingleLock lock(m_cs);
+  m_maxListings = listings > 0 ? listings : CACHE_MAX_LISTINGS;
+  Prune();
+}
+
+void CPersistentDirectoryCache::LoadCacheFiles()
+{
+  if (m_lruLoaded)
+    return;
+  m_lruLoaded = true;
+
+  // listings of earlier sessions rank by the time they were written, newest first
+  CFileItemList files;
+  if (!CDirectory::GetDirectory(CACHE_FOLDER, files, ".fi", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE))
+    return;
+  files.Sort(SortByDate, SortOrderDescending);
+
+  for (int i = 0; i < files.Size(); i++)
+  {
+    const std::string cacheFile = CACHE_FOLDER + URIUtils::GetFileName(files[i]->GetPath());
+    if (m_lruPositions.find(cacheFile) == m_lruPositions.end())
+      m_lruPositions[cacheFile] = m_lru.insert(m_lru.end(), cacheFile);
+  }
+}
+
+void CPersistentDirectoryCache::Touch(const std::string &cacheFile)
+{
+  LoadCacheFiles();
+
+  std::map<std::string, std::list<std::string>::iterator>::iterator it = m_lruPositions.find(cacheFile);
+  if (it != m_lruPositions.end())
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+  else
+    m_lruPositions[cacheFile] = m_lru.insert(m_lru.begin(), cacheFile);
+}
+
+void CPersistentDirectoryCache::Prune()
+{
+  LoadCacheFiles();
+
+  while (m_lru.size() > m_maxListings)
+  {
+    const std::string cacheFile = m_lru.back();
+    if (CFile::Exists(cacheFile) && !CFile::Delete(cacheFile))
+      CLog::Log(LOGWARNING, "%s - unable to delete %s", __FUNCTION__, cacheFile.c_str());
+    m_lruPositions.erase(cacheFile);
+    m_lru.pop_back();
+  }
+}
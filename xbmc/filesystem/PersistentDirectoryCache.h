@@ -0,0 +1,109 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "IDirectory.h"
+#include "threads/CriticalSection.h"
+#include "utils/JobManager.h"
+
+#include <list>
+#include <map>
+#include <string>
+
+class CFileItemList;
+class CURL;
+
+namespace XFILE
+{
+  /*!
+   \brief Listings of network directories kept on disk between sessions.
+
+   A restored listing is shown right away and validated in the background
+   against the token returned by IDirectory::GetCacheValidator(). If the
+   directory can't be validated that way it's listed again. When the listing
+   changed, the stored copy and the directory cache are updated and windows
+   showing the path are asked to refresh.
+
+   Only directories on SMB, NFS, AFP and UPnP shares that IDirectory allows
+   to be cached (DIR_CACHE_ONCE or DIR_CACHE_ALWAYS) are stored. The cache is
+   enabled by the <persistentdirectorycache> advanced setting. Once it holds
+   more listings than its limit, the least recently used ones are deleted.
+   */
+  class CPersistentDirectoryCache : public CJobQueue
+  {
+  public:
+    static CPersistentDirectoryCache &Get();
+
+    /*!
+     \brief Whether listings of the given directory are stored
+     */
+    bool IsCacheable(const CURL &url, DIR_CACHE_TYPE cacheType) const;
+
+    /*!
+     \brief Restore a stored listing and validate it in the background
+     \param realURL the directory after path substitution, the key of the listing
+     \param url the directory as requested, refreshed in the GUI if the listing changed
+     \param flags the DIR_FLAGs the directory is listed with
+     \param items the restored listing
+     \return true if a stored listing was found
+     */
+    bool Load(const CURL &realURL, const CURL &url, int flags, DIR_CACHE_TYPE cacheType, CFileItemList &items);
+
+    /*!
+     \brief Store the listing held by the directory cache in the background
+     \param validator the token of IDirectory::GetCacheValidator(), taken before the directory was listed
+     */
+    void Store(const CURL &realURL, int flags, DIR_CACHE_TYPE cacheType, const std::string &validator);
+
+    /*!
+     \brief Check a restored listing against the directory, done by the job queued in Load()
+     Lists the directory again unless its validator is unchanged. If the listing differs
+     from the stored one, it's stored and windows showing the directory are refreshed.
+     \param validator the token stored with the restored listing
+     \return false if the directory couldn't be listed
+     */
+    bool Validate(const CURL &realURL, const CURL &url, int flags, DIR_CACHE_TYPE cacheType, const std::string &validator);
+
+    bool Read(const std::string &path, int flags, CFileItemList &items, std::string &validator);
+    bool Write(const std::string &path, int flags, const CFileItemList &items, const std::string &validator);
+
+    static bool IsSameListing(const CFileItemList &items1, const CFileItemList &items2);
+
+    /*!
+     \brief Override the maximum number of stored listings
+     \param listings the maximum, 0 for the default
+     */
+    void SetMaxListings(unsigned int listings);
+
+  private:
+    CPersistentDirectoryCache();
+    std::string GetCacheFile(const std::string &path, int flags) const;
+
+    void LoadCacheFiles();
+    void Touch(const std::string &cacheFile);
+    void Prune();
+
+    CCriticalSection m_cs;
+    std::list<std::string> m_lru; ///< stored listings, most recently used first
+    std::map<std::string, std::list<std::string>::iterator> m_lruPositions;
+    bool m_lruLoaded;
+    unsigned int m_maxListings;
+  };
+}
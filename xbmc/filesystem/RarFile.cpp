@@ -32,6 +32,9 @@
 #include "utils/log.h"
 #include "UnrarXLib/rar.hpp"
 #include "utils/StringUtils.h"
+#include "utils/auto_buffer.h"
+
+#include <algorithm>
 
 #ifndef TARGET_POSIX
 #include <process.h>
@@ -134,6 +137,7 @@ CRarFile::CRarFile()
   m_bUseFile = false;
   m_bOpen = false;
   m_bSeekable = true;
+  m_bPacked = false;
   m_iFilePosition = 0;
   m_iFileSize = 0;
   m_iBufferStart = 0;
@@ -204,8 +208,22 @@ bool CRarFile::Open(const CURL& url)
     else
     {
       CFileInfo* info = g_RarManager.GetFileInRar(m_strRarPath,m_strPathInRar);
-      if ((!info || !CFile::Exists(info->m_strCachedPath)) && m_bFileOptions & EXFILE_NOCACHE)
+      bool cached = info && CFile::Exists(info->m_strCachedPath);
+
+      // unpack while reading instead of extracting the whole entry first,
+      // unless an extracted copy is around already
+      if (!cached && OpenInArchive())
+      {
+        m_iFileSize = items[i]->m_dwSize;
+        m_bPacked = true;
+        m_bOpen = true;
+        return true;
+      }
+
+      // solid archives and links can only be extracted
+      if (!cached && m_bFileOptions & EXFILE_NOCACHE)
         return false;
+
       m_bUseFile = true;
       std::string strPathInCache;
 
@@ -321,7 +339,12 @@ ssize_t CRarFile::Read(void *lpBuf, size_t uiBufSize)
     }
 
     m_pExtract->GetDataIO().hBufferFilled->Set();
-    m_pExtract->GetDataIO().hBufferEmpty->Wait();
+    // the extract thread ends after the last buffer of a packed entry
+    while (!m_pExtract->GetDataIO().hBufferEmpty->WaitMSec(100))
+    {
+      if (!m_pExtractThread->hRunning.WaitMSec(1))
+        break;
+    }
 
     if (m_pExtract->GetDataIO().NextVolumeMissing)
       break;
@@ -437,6 +460,9 @@ int64_t CRarFile::Seek(int64_t iFilePosition, int iWhence)
       return -1;
   }
 
+  if (m_bPacked)
+    return SeekInPacked(iFilePosition);
+
   if (iFilePosition > this->GetLength())
     return -1;
 
@@ -510,6 +536,65 @@ int64_t CRarFile::Seek(int64_t iFilePosition, int iWhence)
 #endif
 }
 
+/*!
+ \brief Seek in a compressed entry.
+ RAR data can only be unpacked from the start of an entry, seeking forward
+ unpacks and drops the data in between, seeking back before the current
+ buffer starts over.
+ */
+int64_t CRarFile::SeekInPacked(int64_t iFilePosition)
+{
+#ifdef HAS_FILESYSTEM_RAR
+  if (iFilePosition < 0)
+    return -1;
+
+  // beyond the end reads nothing, like a regular file
+  if (iFilePosition >= GetLength())
+  {
+    m_iFilePosition = iFilePosition;
+    return m_iFilePosition;
+  }
+
+  int64_t iBufferFill = m_iDataInBuffer >= 0 ? (m_szStartOfBuffer - m_szBuffer) + m_iDataInBuffer : 0;
+  if (iFilePosition < m_iBufferStart)
+  {
+    CleanUp();
+    if (!OpenInArchive())
+    {
+      delete m_pExtractThread;
+      m_pExtractThread = NULL;
+      m_bOpen = false;
+      return -1;
+    }
+    iBufferFill = 0;
+  }
+  else if (iFilePosition < m_iBufferStart + iBufferFill) // still in memory
+  {
+    m_szStartOfBuffer = m_szBuffer + (iFilePosition - m_iBufferStart);
+    m_iDataInBuffer = iBufferFill - (iFilePosition - m_iBufferStart);
+    m_iFilePosition = iFilePosition;
+    return m_iFilePosition;
+  }
+
+  // continue after what was unpacked so far
+  m_szStartOfBuffer = m_szBuffer + iBufferFill;
+  m_iDataInBuffer = 0;
+  m_iFilePosition = m_iBufferStart + iBufferFill;
+
+  XUTILS::auto_buffer skip(MAXWINMEMSIZE);
+  while (m_iFilePosition < iFilePosition)
+  {
+    size_t iToRead = (size_t)std::min<int64_t>(skip.size(), iFilePosition - m_iFilePosition);
+    if (Read(skip.get(), iToRead) <= 0)
+      return -1;
+  }
+
+  return m_iFilePosition;
+#else
+  return -1;
+#endif
+}
+
 int64_t CRarFile::GetLength()
 {
   if (!m_bOpen)
@@ -584,6 +669,8 @@ void CRarFile::CleanUp()
       if (m_pExtractThread->hRunning.WaitMSec(1))
       {
         m_pExtract->GetDataIO().hQuit->Set();
+        // wake the unpacker if it waits for the buffer to be read
+        m_pExtract->GetDataIO().hBufferFilled->Set();
         while (m_pExtractThread->hRunning.WaitMSec(1))
           Sleep(1);
       }
@@ -724,6 +811,13 @@ bool CRarFile::OpenInArchive()
       m_pArc->SeekToNext();
     }
 
+    // packed entries of solid archives depend on all entries before them
+    if (m_pArc->NewLhd.Method != 0x30 && (m_pArc->Solid || IsLink(m_pArc->NewLhd.FileAttr)))
+    {
+      CleanUp();
+      return false;
+    }
+
     m_szBuffer = new uint8_t[MAXWINMEMSIZE];
     m_szStartOfBuffer = m_szBuffer;
     m_pExtract->GetDataIO().SetUnpackToMemory(m_szBuffer,0);
@@ -90,6 +90,7 @@ namespace XFILE
     void InitFromUrl(const CURL& url);
     bool OpenInArchive();
     void CleanUp();
+    int64_t SeekInPacked(int64_t iFilePosition);
 
     int64_t m_iFilePosition;
     int64_t m_iFileSize;
@@ -97,6 +98,7 @@ namespace XFILE
     bool m_bUseFile;
     bool m_bOpen;
     bool m_bSeekable;
+    bool m_bPacked; // compressed entry unpacked while reading
     CFile m_File; // for packed source
 #ifdef HAS_FILESYSTEM_RAR
     Archive* m_pArc;
@@ -301,12 +301,19 @@ bool CRarManager::GetFilesInRar(CFileItemList& vecpItems, const std::string& str
 #ifdef HAS_FILESYSTEM_RAR
   CSingleLock lock(m_CritSection);
 
+  ValidateListing(strRarPath);
+
   ArchiveList_struct* pFileList = NULL;
   map<std::string,pair<ArchiveList_struct*,vector<CFileInfo> > >::iterator it = m_ExFiles.find(strRarPath);
   if (it == m_ExFiles.end())
   {
     if( urarlib_list((char*) strRarPath.c_str(), &pFileList, NULL) )
+    {
       m_ExFiles.insert(make_pair(strRarPath,make_pair(pFileList,vector<CFileInfo>())));
+      struct __stat64 st;
+      if (CFile::Stat(strRarPath, &st) == 0)
+        m_ExStamps[strRarPath] = make_pair((int64_t)st.st_size, (int64_t)st.st_mtime);
+    }
     else
     {
       if( pFileList ) urarlib_freelist(pFileList);
@@ -456,6 +463,41 @@ bool CRarManager::IsFileInRar(bool& bResult, const std::string& strRarPath, cons
 #endif
 }
 
+/*! \brief Drop the listing of an archive that changed on disk since it was listed.
+ The listing is kept while any of its entries is in use.
+ */
+void CRarManager::ValidateListing(const std::string& strRarPath)
+{
+#ifdef HAS_FILESYSTEM_RAR
+  map<std::string,pair<ArchiveList_struct*,vector<CFileInfo> > >::iterator j = m_ExFiles.find(strRarPath);
+  if (j == m_ExFiles.end())
+    return;
+
+  map<std::string, pair<int64_t, int64_t> >::iterator stamp = m_ExStamps.find(strRarPath);
+  struct __stat64 st;
+  if (stamp == m_ExStamps.end() || CFile::Stat(strRarPath, &st) != 0)
+    return;
+  if (stamp->second.first == (int64_t)st.st_size && stamp->second.second == (int64_t)st.st_mtime)
+    return;
+
+  for (vector<CFileInfo>::iterator it = j->second.second.begin(); it != j->second.second.end(); ++it)
+  {
+    if (it->m_iUsed > 0)
+      return;
+  }
+
+  CLog::Log(LOGDEBUG, "%s: %s changed, listing it again", __FUNCTION__, strRarPath.c_str());
+  for (vector<CFileInfo>::iterator it = j->second.second.begin(); it != j->second.second.end(); ++it)
+  {
+    if (it->m_bAutoDel)
+      CFile::Delete(it->m_strCachedPath);
+  }
+  urarlib_freelist(j->second.first);
+  m_ExFiles.erase(j);
+  m_ExStamps.erase(stamp);
+#endif
+}
+
 void CRarManager::ClearCache(bool force)
 {
 #ifdef HAS_FILESYSTEM_RAR
@@ -474,6 +516,7 @@ void CRarManager::ClearCache(bool force)
   }
 
   m_ExFiles.clear();
+  m_ExStamps.clear();
 #endif
 }
 
@@ -82,7 +82,9 @@ public:
 protected:
 
   bool ListArchive(const std::string& strRarPath, ArchiveList_struct* &pArchiveList);
+  void ValidateListing(const std::string& strRarPath);
   std::map<std::string, std::pair<ArchiveList_struct*,std::vector<CFileInfo> > > m_ExFiles;
+  std::map<std::string, std::pair<int64_t, int64_t> > m_ExStamps; ///< size and mtime of listed archives
   CCriticalSection m_CritSection;
 
   int64_t CheckFreeSpace(const std::string& strDrive);
@@ -333,3 +333,20 @@ bool CSMBDirectory::Exists(const CURL& url2)
   return S_ISDIR(info.st_mode);
 }
 
+std::string CSMBDirectory::GetCacheValidator(const CURL& url2)
+{
+  CSingleLock lock(smb);
+  smb.Init();
+
+  CURL url(url2);
+  CPasswordManager::GetInstance().AuthenticateURL(url);
+  std::string strFileName = smb.URLEncode(url);
+
+  // the modification time of a directory changes when entries are added, removed or renamed
+  struct stat info;
+  if (smbc_stat(strFileName.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+    return "";
+
+  return StringUtils::Format("%" PRId64, (int64_t)info.st_mtime);
+}
+
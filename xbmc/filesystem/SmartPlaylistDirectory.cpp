@@ -63,12 +63,47 @@ namespace XFILE
   }
   
   bool CSmartPlaylistDirectory::GetDirectory(const CSmartPlaylist &playlist, CFileItemList& items, const std::string &strBaseDir /* = "" */, bool filter /* = false */)
+  {
+    return GetDirectory(playlist, items, strBaseDir, filter, 0, 0);
+  }
+
+  bool CSmartPlaylistDirectory::GetDirectoryRange(const CSmartPlaylist &playlist, unsigned int start, unsigned int end, CFileItemList& items)
+  {
+    // mixed and grouped playlists and virtual folders combine several lists
+    std::vector<std::string> virtualFolders;
+    playlist.GetVirtualFolders(virtualFolders);
+    const std::string& group = playlist.GetGroup();
+    if (playlist.GetType() == "mixed" || !virtualFolders.empty() ||
+       (!group.empty() && !StringUtils::EqualsNoCase(group, "none")))
+      return false;
+
+    unsigned int limit = playlist.GetLimit();
+    if (limit > 0 && start >= limit)
+    {
+      items.Clear();
+      items.SetProperty("total", limit);
+      return true;
+    }
+
+    if (!GetDirectory(playlist, items, "", false, start, end))
+      return false;
+
+    // the database counts all matching items, regardless of the limit
+    if (limit > 0 && items.GetProperty("total").asInteger() > limit)
+      items.SetProperty("total", limit);
+    return true;
+  }
+
+  bool CSmartPlaylistDirectory::GetDirectory(const CSmartPlaylist &playlist, CFileItemList& items, const std::string &strBaseDir, bool filter, unsigned int start, unsigned int end)
   {
     bool success = false, success2 = false;
     std::vector<std::string> virtualFolders;
 
     SortDescription sorting;
     sorting.limitEnd = playlist.GetLimit();
+    if (end > 0 && (sorting.limitEnd <= 0 || end < (unsigned int)sorting.limitEnd))
+      sorting.limitEnd = end;
+    sorting.limitStart = start;
     sorting.sortBy = playlist.GetOrder();
     sorting.sortOrder = playlist.GetOrderAscending() ? SortOrderAscending : SortOrderDescending;
     sorting.sortAttributes = playlist.GetOrderAttributes();
@@ -289,7 +324,7 @@ namespace XFILE
     for (int i = 0; i < items.Size(); i++)
     {
       CFileItemPtr item = items[i];
-      item->m_iprogramCount = i;  // hack for playlist order
+      item->m_iprogramCount = start + i;  // hack for playlist order
     }
 
     if (playlist.GetType() == "mixed")
@@ -39,6 +39,21 @@ namespace XFILE
 
     static bool GetDirectory(const CSmartPlaylist &playlist, CFileItemList& items, const std::string &strBaseDir = "", bool filter = false);
 
+    /*!
+     \brief Get a range of the items of a smart playlist, in the order of the playlist
+     Mixed and grouped playlists and playlists with virtual folders combine several
+     lists and can't be retrieved in ranges.
+     \param playlist the smart playlist
+     \param start index of the first item to retrieve
+     \param end index after the last item to retrieve, within the limit of the playlist
+     \param items [out] the items, with the number of items of the whole playlist in the "total" property
+     \return true if the range was retrieved, false if the playlist can't be retrieved in ranges or on error
+     */
+    static bool GetDirectoryRange(const CSmartPlaylist &playlist, unsigned int start, unsigned int end, CFileItemList& items);
+
     static std::string GetPlaylistByName(const std::string& name, const std::string& playlistType);
+
+  private:
+    static bool GetDirectory(const CSmartPlaylist &playlist, CFileItemList& items, const std::string &strBaseDir, bool filter, unsigned int start, unsigned int end);
   };
 }
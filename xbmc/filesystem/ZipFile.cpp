@@ -23,9 +23,13 @@
 #include "utils/URIUtils.h"
 #include "utils/auto_buffer.h"
 
+#include <algorithm>
 #include <sys/stat.h>
 
-#define ZIP_CACHE_LIMIT 4*1024*1024
+// decompressed data between two inflate checkpoints, the interval grows for
+// large entries so at most ZIP_MAX_CHECKPOINTS windows are kept
+#define ZIP_CHECKPOINT_INTERVAL 1024*1024
+#define ZIP_MAX_CHECKPOINTS 64
 
 using namespace XFILE;
 using namespace std;
@@ -35,8 +39,8 @@ CZipFile::CZipFile()
   m_szStringBuffer = NULL;
   m_szStartOfStringBuffer = NULL;
   m_iDataInStringBuffer = 0;
-  m_bCached = false;
   m_iRead = -1;
+  m_iCheckpointInterval = 0;
 }
 
 CZipFile::~CZipFile()
@@ -47,7 +51,6 @@ CZipFile::~CZipFile()
 
 bool CZipFile::Open(const CURL&url)
 {
-  std::string strOpts = url.GetOptions();
   CURL url2(url);
   url2.SetOptions("");
   if (!g_ZipManager.GetZipEntry(url2,mZipItem))
@@ -65,26 +68,18 @@ bool CZipFile::Open(const CURL&url)
     return false;
   }
 
-  if (mZipItem.method != 0 && mZipItem.usize > ZIP_CACHE_LIMIT && strOpts != "?cache=no")
-  {
-    if (!CFile::Exists("special://temp/" + URIUtils::GetFileName(url2)))
-    {
-      url2.SetOptions("?cache=no");
-      const CURL pathToUrl("special://temp/" + URIUtils::GetFileName(url2));
-      if (!CFile::Copy(url2, pathToUrl))
-        return false;
-    }
-    m_bCached = true;
-    return mFile.Open("special://temp/" + URIUtils::GetFileName(url2));
-  }
-
   if (!mFile.Open(url.GetHostName())) // this is the zip-file, always open binary
   {
     CLog::Log(LOGERROR,"FileZip: unable to open zip file %s!",url.GetHostName().c_str());
     return false;
   }
   mFile.Seek(mZipItem.offset,SEEK_SET);
-  return InitDecompress();
+  if (!InitDecompress())
+    return false;
+
+  if (mZipItem.method == 8)
+    m_iCheckpointInterval = std::max<int64_t>(ZIP_CHECKPOINT_INTERVAL, mZipItem.usize / ZIP_MAX_CHECKPOINTS);
+  return true;
 }
 
 bool CZipFile::InitDecompress()
@@ -94,6 +89,8 @@ bool CZipFile::InitDecompress()
   m_iZipFilePos = 0;
   m_iAvailBuffer = 0;
   m_bFlush = false;
+  m_iCheckpointInterval = 0;
+  ClearCheckpoints();
   m_ZStream.zalloc = Z_NULL;
   m_ZStream.zfree = Z_NULL;
   m_ZStream.opaque = Z_NULL;
@@ -119,16 +116,11 @@ int64_t CZipFile::GetLength()
 
 int64_t CZipFile::GetPosition()
 {
-  if (m_bCached)
-    return mFile.GetPosition();
-
   return m_iFilePos;
 }
 
 int64_t CZipFile::Seek(int64_t iFilePosition, int iWhence)
 {
-  if (m_bCached)
-    return mFile.Seek(iFilePosition,iWhence);
   if (mZipItem.method == 0) // this is easy
   {
     int64_t iResult;
@@ -179,8 +171,9 @@ int64_t CZipFile::Seek(int64_t iFilePosition, int iWhence)
         return -1;
       // read until position in 128k blocks.. only way to do it due to format.
       // can't start in the middle of data since then we'd have no clue where
-      // we are in uncompressed data..
-      if (iFilePosition < m_iFilePos)
+      // we are in uncompressed data, unless we passed there before and kept
+      // the inflate state.
+      if (!RestoreCheckpoint(iFilePosition) && iFilePosition < m_iFilePos)
       {
         m_iFilePos = 0;
         m_iZipFilePos = 0;
@@ -190,16 +183,15 @@ int64_t CZipFile::Seek(int64_t iFilePosition, int iWhence)
         m_ZStream.next_in = (Bytef*)m_szBuffer;
         m_ZStream.avail_in = 0;
         m_ZStream.total_out = 0;
-        while (m_iFilePos < iFilePosition)
-        {
-          unsigned int iToRead = (iFilePosition - m_iFilePos)>blockSize ? blockSize : (int)(iFilePosition - m_iFilePos);
-          if (Read(buf.get(),iToRead) != iToRead)
-            return -1;
-        }
-        return m_iFilePos;
+        m_bFlush = false;
       }
-      else // seek forward
-        return Seek(iFilePosition-m_iFilePos,SEEK_CUR);
+      while (m_iFilePos < iFilePosition)
+      {
+        unsigned int iToRead = (iFilePosition - m_iFilePos)>blockSize ? blockSize : (int)(iFilePosition - m_iFilePos);
+        if (Read(buf.get(),iToRead) != iToRead)
+          return -1;
+      }
+      return m_iFilePos;
       break;
 
     case SEEK_CUR:
@@ -209,6 +201,7 @@ int64_t CZipFile::Seek(int64_t iFilePosition, int iWhence)
       if (m_iFilePos+iFilePosition > mZipItem.usize)
         return -1;
       iFilePosition += m_iFilePos;
+      RestoreCheckpoint(iFilePosition);
       while (m_iFilePos < iFilePosition)
       {
         unsigned int iToRead = (iFilePosition - m_iFilePos)>blockSize ? blockSize : (int)(iFilePosition - m_iFilePos);
@@ -290,9 +283,6 @@ ssize_t CZipFile::Read(void* lpBuf, size_t uiBufSize)
   if (uiBufSize > SSIZE_MAX)
     uiBufSize = SSIZE_MAX;
 
-  if (m_bCached)
-    return mFile.Read(lpBuf,uiBufSize);
-
   // flush what might be left in the string buffer
   if (m_iDataInStringBuffer > 0)
   {
@@ -341,6 +331,11 @@ ssize_t CZipFile::Read(void* lpBuf, size_t uiBufSize)
       iDecompressed = m_ZStream.total_out-prevOut;
     }
     m_iFilePos += iDecompressed;
+
+    if (m_iCheckpointInterval > 0 &&
+        m_iFilePos >= (m_checkpoints.empty() ? 0 : m_checkpoints.back().filePos) + m_iCheckpointInterval)
+      AddCheckpoint();
+
     return static_cast<unsigned int>(iDecompressed);
   }
   else if (mZipItem.method == 0) // uncompressed. just read from file, but mind our boundaries.
@@ -364,8 +359,9 @@ ssize_t CZipFile::Read(void* lpBuf, size_t uiBufSize)
 
 void CZipFile::Close()
 {
-  if (mZipItem.method == 8 && !m_bCached && m_iRead != -1)
+  if (mZipItem.method == 8 && m_iRead != -1)
     inflateEnd(&m_ZStream);
+  ClearCheckpoints();
 
   mFile.Close();
 }
@@ -457,6 +453,65 @@ bool CZipFile::FillBuffer()
   return true;
 }
 
+void CZipFile::AddCheckpoint()
+{
+  m_checkpoints.push_back(SInflateCheckpoint());
+  SInflateCheckpoint& checkpoint = m_checkpoints.back();
+  checkpoint.filePos = m_iFilePos;
+  checkpoint.zipFilePos = m_iZipFilePos - m_ZStream.avail_in; // unused input is read again
+  checkpoint.flush = m_bFlush;
+  if (inflateCopy(&checkpoint.stream, &m_ZStream) != Z_OK)
+  {
+    CLog::Log(LOGWARNING, "FileZip: unable to copy inflate state, seeking will be slow");
+    m_checkpoints.pop_back();
+    m_iCheckpointInterval = 0;
+  }
+}
+
+bool CZipFile::RestoreCheckpoint(int64_t iFilePosition)
+{
+  SInflateCheckpoint* checkpoint = NULL;
+  for (std::list<SInflateCheckpoint>::iterator it = m_checkpoints.begin(); it != m_checkpoints.end(); ++it)
+  {
+    if (it->filePos > iFilePosition)
+      break;
+    checkpoint = &(*it);
+  }
+
+  // no need to go back if we are between the checkpoint and the position
+  if (!checkpoint || (checkpoint->filePos <= m_iFilePos && m_iFilePos <= iFilePosition))
+    return false;
+
+  inflateEnd(&m_ZStream);
+  if (inflateCopy(&m_ZStream, &checkpoint->stream) != Z_OK)
+  {
+    // start over from the beginning of the entry
+    inflateInit2(&m_ZStream,-MAX_WBITS);
+    m_iFilePos = m_iZipFilePos = 0;
+    mFile.Seek(mZipItem.offset,SEEK_SET);
+    m_ZStream.next_in = (Bytef*)m_szBuffer;
+    m_ZStream.avail_in = 0;
+    m_ZStream.total_out = 0;
+    m_bFlush = false;
+    return true;
+  }
+
+  m_iFilePos = checkpoint->filePos;
+  m_iZipFilePos = checkpoint->zipFilePos;
+  m_bFlush = checkpoint->flush;
+  mFile.Seek(mZipItem.offset+m_iZipFilePos,SEEK_SET);
+  m_ZStream.next_in = (Bytef*)m_szBuffer;
+  m_ZStream.avail_in = 0;
+  return true;
+}
+
+void CZipFile::ClearCheckpoints()
+{
+  for (std::list<SInflateCheckpoint>::iterator it = m_checkpoints.begin(); it != m_checkpoints.end(); ++it)
+    inflateEnd(&it->stream);
+  m_checkpoints.clear();
+}
+
 void CZipFile::DestroyBuffer(void* lpBuffer, int iBufSize)
 {
   if (!m_bFlush)
@@ -26,6 +26,8 @@
 #include "File.h"
 #include "ZipManager.h"
 
+#include <list>
+
 namespace XFILE
 {
   class CZipFile : public IFile
@@ -47,9 +49,24 @@ namespace XFILE
 
     int UnpackFromMemory(std::string& strDest, const std::string& strInput, bool isGZ=false);
   private:
+    /*! \brief Copy of the inflate state at some position of the uncompressed
+     data, lets seeks restart decompressing close to their target.
+     zlib keeps a pointer to the owning z_stream, so these must not move.
+     */
+    struct SInflateCheckpoint
+    {
+      int64_t filePos;    ///< position in uncompressed data
+      int64_t zipFilePos; ///< position in compressed data of the next input byte
+      bool flush;
+      z_stream stream;
+    };
+
     bool InitDecompress();
     bool FillBuffer();
     void DestroyBuffer(void* lpBuffer, int iBufSize);
+    void AddCheckpoint();
+    bool RestoreCheckpoint(int64_t iFilePosition);
+    void ClearCheckpoints();
     CFile mFile;
     SZipEntry mZipItem;
     int64_t m_iFilePos; // position in _uncompressed_ data read
@@ -62,7 +79,8 @@ namespace XFILE
     size_t m_iDataInStringBuffer;
     int m_iRead;
     bool m_bFlush;
-    bool m_bCached;
+    std::list<SInflateCheckpoint> m_checkpoints;
+    int64_t m_iCheckpointInterval;
   };
 }
 
@@ -27,6 +27,7 @@
 #include "utils/EndianSwap.h"
 #include "utils/URIUtils.h"
 #include "SpecialProtocol.h"
+#include "threads/SingleLock.h"
 
 
 #ifndef min
@@ -49,31 +50,61 @@ bool CZipManager::GetZipList(const CURL& url, vector<SZipEntry>& items)
 {
   CLog::Log(LOGDEBUG, "%s - Processing %s", __FUNCTION__, url.GetRedacted().c_str());
 
-  struct __stat64 m_StatData = {};
+  ManifestPtr manifest = GetManifest(url, true);
+  if (!manifest)
+    return false;
+
+  items = manifest->items;
+  return true;
+}
 
+CZipManager::ManifestPtr CZipManager::GetManifest(const CURL& url, bool validate)
+{
   std::string strFile = url.GetHostName();
 
+  if (!validate)
+  {
+    CSingleLock lock(m_critSection);
+    map<std::string, ManifestPtr>::const_iterator it = m_manifests.find(strFile);
+    if (it != m_manifests.end())
+      return it->second;
+  }
+
+  struct __stat64 m_StatData = {};
   if (CFile::Stat(strFile,&m_StatData))
   {
     CLog::Log(LOGDEBUG,"CZipManager::GetZipList: failed to stat file %s", url.GetRedacted().c_str());
-    return false;
+    return ManifestPtr();
   }
 
-  map<std::string,vector<SZipEntry> >::iterator it = mZipMap.find(strFile);
-  if (it != mZipMap.end()) // already listed, just return it if not changed, else release and reread
   {
-    map<std::string,int64_t>::iterator it2=mZipDate.find(strFile);
-    CLog::Log(LOGDEBUG,"statdata: %" PRId64" new: %" PRIu64, it2->second, (uint64_t)m_StatData.st_mtime);
-
-      if (m_StatData.st_mtime == it2->second)
-      {
-        items = it->second;
-        return true;
-      }
-      mZipMap.erase(it);
-      mZipDate.erase(it2);
+    CSingleLock lock(m_critSection);
+    map<std::string, ManifestPtr>::iterator it = m_manifests.find(strFile);
+    if (it != m_manifests.end()) // already listed, just return it if not changed, else release and reread
+    {
+      if (it->second->mtime == (int64_t)m_StatData.st_mtime && it->second->size == (int64_t)m_StatData.st_size)
+        return it->second;
+      m_manifests.erase(it);
+    }
   }
 
+  // parse without holding the lock, other archives stay accessible meanwhile
+  std::shared_ptr<CZipManifest> manifest(new CZipManifest);
+  manifest->size = m_StatData.st_size;
+  manifest->mtime = m_StatData.st_mtime;
+  if (!ReadCentralDirectory(strFile, manifest->items))
+    return ManifestPtr();
+
+  for (size_t i = 0; i < manifest->items.size(); i++)
+    manifest->names.insert(make_pair(std::string(manifest->items[i].name), i));
+
+  CSingleLock lock(m_critSection);
+  m_manifests[strFile] = manifest;
+  return manifest;
+}
+
+bool CZipManager::ReadCentralDirectory(const std::string& strFile, vector<SZipEntry>& items)
+{
   CFile mFile;
   if (!mFile.Open(strFile))
   {
@@ -88,9 +119,6 @@ bool CZipManager::GetZipList(const CURL& url, vector<SZipEntry>& items)
     mFile.Close();
     return false;
   }
-  // push date for update detection
-  mZipDate.insert(make_pair(strFile,m_StatData.st_mtime));
-
 
   // Look for end of central directory record
   // Zipfile comment may be up to 65535 bytes
@@ -212,36 +240,22 @@ bool CZipManager::GetZipList(const CURL& url, vector<SZipEntry>& items)
 
   }
 
-  mZipMap.insert(make_pair(strFile,items));
   mFile.Close();
   return true;
 }
 
 bool CZipManager::GetZipEntry(const CURL& url, SZipEntry& item)
 {
-  std::string strFile = url.GetHostName();
+  ManifestPtr manifest = GetManifest(url, false);
+  if (!manifest)
+    return false;
 
-  map<std::string,vector<SZipEntry> >::iterator it = mZipMap.find(strFile);
-  vector<SZipEntry> items;
-  if (it == mZipMap.end()) // we need to list the zip
-  {
-    GetZipList(url,items);
-  }
-  else
-  {
-    items = it->second;
-  }
+  map<std::string, size_t>::const_iterator it = manifest->names.find(url.GetFileName());
+  if (it == manifest->names.end())
+    return false;
 
-  std::string strFileName = url.GetFileName();
-  for (vector<SZipEntry>::iterator it2=items.begin();it2 != items.end();++it2)
-  {
-    if (std::string(it2->name) == strFileName)
-    {
-      memcpy(&item,&(*it2),sizeof(SZipEntry));
-      return true;
-    }
-  }
-  return false;
+  item = manifest->items[it->second];
+  return true;
 }
 
 bool CZipManager::ExtractArchive(const std::string& strArchive, const std::string& strPath)
@@ -309,13 +323,6 @@ void CZipManager::readCHeader(const char* buffer, SZipEntry& info)
 void CZipManager::release(const std::string& strPath)
 {
   CURL url(strPath);
-  map<std::string,vector<SZipEntry> >::iterator it= mZipMap.find(url.GetHostName());
-  if (it != mZipMap.end())
-  {
-    map<std::string,int64_t>::iterator it2=mZipDate.find(url.GetHostName());
-    mZipMap.erase(it);
-    mZipDate.erase(it2);
-  }
+  CSingleLock lock(m_critSection);
+  m_manifests.erase(url.GetHostName());
 }
-
-
@@ -30,10 +30,13 @@
 #define ECDREC_SIZE 22
 
 #include <memory.h>
+#include <memory>
 #include <string>
 #include <vector>
 #include <map>
 
+#include "threads/CriticalSection.h"
+
 class CURL;
 
 struct SZipEntry {
@@ -109,8 +112,23 @@ public:
   static void readHeader(const char* buffer, SZipEntry& info);
   static void readCHeader(const char* buffer, SZipEntry& info);
 private:
-  std::map<std::string,std::vector<SZipEntry> > mZipMap;
-  std::map<std::string,int64_t> mZipDate;
+  /*! \brief Parsed central directory of an archive, shared by all readers.
+   Valid as long as the size and modification time of the archive match.
+   */
+  struct CZipManifest
+  {
+    int64_t size;
+    int64_t mtime;
+    std::vector<SZipEntry> items;
+    std::map<std::string, size_t> names; ///< entry name -> index in items
+  };
+  typedef std::shared_ptr<const CZipManifest> ManifestPtr;
+
+  ManifestPtr GetManifest(const CURL& url, bool validate);
+  bool ReadCentralDirectory(const std::string& strFile, std::vector<SZipEntry>& items);
+
+  std::map<std::string, ManifestPtr> m_manifests;
+  CCriticalSection m_critSection;
 };
 
 extern CZipManager g_ZipManager;
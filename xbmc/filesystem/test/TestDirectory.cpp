@@ -19,6 +19,8 @@
  */
 
 #include "filesystem/Directory.h"
+#include "filesystem/DirectoryCache.h"
+#include "filesystem/File.h"
 #include "filesystem/SpecialProtocol.h"
 #include "FileItem.h"
 #include "utils/URIUtils.h"
@@ -52,3 +54,42 @@ TEST(TestDirectory, General)
   EXPECT_TRUE(XFILE::CDirectory::Remove(tmppath1));
   EXPECT_FALSE(XFILE::CDirectory::Exists(tmppath1));
 }
+
+TEST(TestDirectory, GetSharedListing)
+{
+  std::string path = URIUtils::AddFileToFolder(CSpecialProtocol::TranslatePath("special://temp/"), "TestDirectoryShared/");
+  std::string srtFile = URIUtils::AddFileToFolder(path, "movie.srt");
+  std::string mkvFile = URIUtils::AddFileToFolder(path, "movie.mkv");
+  ASSERT_TRUE(XFILE::CDirectory::Create(path));
+  XFILE::CFile file;
+  ASSERT_TRUE(file.OpenForWrite(srtFile, true));
+  file.Close();
+  ASSERT_TRUE(file.OpenForWrite(mkvFile, true));
+  file.Close();
+
+  // fills the directory cache
+  CFileItemList items;
+  EXPECT_TRUE(XFILE::CDirectory::GetDirectory(path, items, "", XFILE::DIR_FLAG_NO_FILE_DIRS));
+  EXPECT_EQ(2, items.Size());
+
+  // the cached snapshot is handed out without copying it
+  const int flags = XFILE::DIR_FLAG_NO_FILE_DIRS | XFILE::DIR_FLAG_READ_CACHE;
+  XFILE::CDirectory::CDirectoryPtr all, again, srt;
+  EXPECT_TRUE(XFILE::CDirectory::GetDirectory(path, all, "", flags));
+  ASSERT_TRUE(all != NULL);
+  EXPECT_EQ(2, all->Size());
+  EXPECT_TRUE(XFILE::CDirectory::GetDirectory(path, again, "", flags));
+  EXPECT_EQ(all.get(), again.get());
+
+  // a mask builds a new list sharing the items of the snapshot
+  EXPECT_TRUE(XFILE::CDirectory::GetDirectory(path, srt, ".srt", flags));
+  ASSERT_TRUE(srt != NULL);
+  ASSERT_EQ(1, srt->Size());
+  EXPECT_STREQ(srtFile.c_str(), srt->Get(0)->GetPath().c_str());
+  EXPECT_TRUE(all->Get(0) == srt->Get(0) || all->Get(1) == srt->Get(0));
+
+  g_directoryCache.ClearDirectory(path);
+  EXPECT_TRUE(XFILE::CFile::Delete(srtFile));
+  EXPECT_TRUE(XFILE::CFile::Delete(mkvFile));
+  EXPECT_TRUE(XFILE::CDirectory::Remove(path));
+}
@@ -0,0 +1,277 @@
+/*
+ *      Copyright (C) 2005-2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/DirectoryCache.h"
+#include "FileItem.h"
+#include "utils/StringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+
+#include <vector>
+
+using namespace XFILE;
+
+class CTestDirectoryCache : public CDirectoryCache
+{
+public:
+  // returns a path ending in a number that is stored in the same shard as path
+  std::string GetPathInSameShard(const std::string &path, int start)
+  {
+    for (int i = start; ; i++)
+    {
+      std::string other = StringUtils::Format("/media/%04i", i);
+      if (&GetShard(other) == &GetShard(path))
+        return other;
+    }
+  }
+
+  // returns a path ending in a number that is stored in none of the shards of paths
+  std::string GetPathInOtherShard(const std::vector<std::string> &paths)
+  {
+    for (int i = 0; ; i++)
+    {
+      std::string other = StringUtils::Format("/media/%04i", i);
+      bool used = false;
+      for (std::vector<std::string>::const_iterator it = paths.begin(); it != paths.end(); ++it)
+        used |= &GetShard(other) == &GetShard(*it);
+      if (!used)
+        return other;
+    }
+  }
+
+  static unsigned int GetNumShards() { return NUM_SHARDS; }
+};
+
+static void FillList(CFileItemList &items, const std::string &path, int count)
+{
+  items.SetPath(path);
+  for (int i = 0; i < count; i++)
+  {
+    CFileItemPtr item(new CFileItem(StringUtils::Format("%s/file%04i.mkv", path.c_str(), i), false));
+    item->SetLabel(StringUtils::Format("file%04i", i));
+    items.Add(item);
+  }
+}
+
+TEST(TestDirectoryCache, GetDirectory)
+{
+  CDirectoryCache cache;
+  cache.SetMemoryBudget(1024 * 1024);
+
+  CFileItemList items;
+  FillList(items, "/media/0000", 10);
+  cache.SetDirectory("/media/0000/", items, DIR_CACHE_ONCE);
+
+  CFileItemList copy;
+  EXPECT_FALSE(cache.GetDirectory("/media/0000", copy));
+  EXPECT_TRUE(cache.GetDirectory("/media/0000", copy, true));
+  EXPECT_EQ(10, copy.Size());
+  EXPECT_STREQ("/media/0000/file0000.mkv", copy[0]->GetPath().c_str());
+
+  // the copy doesn't share items with the cache
+  copy[0]->SetPath("/changed");
+  CDirectoryCache::CDirectoryPtr snapshot;
+  EXPECT_TRUE(cache.GetDirectory("/media/0000/", snapshot, true));
+  EXPECT_STREQ("/media/0000/file0000.mkv", (*snapshot)[0]->GetPath().c_str());
+
+  CDirectoryCache::CacheStats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(2U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(1U, stats.directories);
+  EXPECT_EQ(10U, stats.items);
+  EXPECT_EQ(CDirectoryCache::EstimateSize(items), stats.bytes);
+}
+
+TEST(TestDirectoryCache, AddFileKeepsSnapshots)
+{
+  CDirectoryCache cache;
+  cache.SetMemoryBudget(1024 * 1024);
+
+  CFileItemList items;
+  FillList(items, "/media/0000", 2);
+  cache.SetDirectory("/media/0000", items, DIR_CACHE_ALWAYS);
+
+  CDirectoryCache::CDirectoryPtr before;
+  EXPECT_TRUE(cache.GetDirectory("/media/0000", before));
+
+  cache.AddFile("/media/0000/new.mkv");
+
+  bool inCache;
+  EXPECT_TRUE(cache.FileExists("/media/0000/new.mkv", inCache));
+  EXPECT_TRUE(inCache);
+  EXPECT_EQ(2, before->Size());
+  EXPECT_FALSE(before->Contains("/media/0000/new.mkv"));
+
+  CDirectoryCache::CDirectoryPtr after;
+  EXPECT_TRUE(cache.GetDirectory("/media/0000", after));
+  EXPECT_EQ(3, after->Size());
+  // unmodified items are shared between the snapshots
+  EXPECT_EQ((*before)[0].get(), (*after)[0].get());
+}
+
+TEST(TestDirectoryCache, EvictLeastRecentlyUsed)
+{
+  CTestDirectoryCache cache;
+
+  std::string path1 = "/media/0000";
+  std::string path2 = cache.GetPathInSameShard(path1, 1);
+  std::string path3 = cache.GetPathInSameShard(path1, atoi(path2.substr(7).c_str()) + 1);
+
+  CFileItemList items1, items2, items3;
+  FillList(items1, path1, 100);
+  FillList(items2, path2, 100);
+  FillList(items3, path3, 100);
+
+  // room for two listings in the whole cache
+  size_t size = CDirectoryCache::EstimateSize(items1);
+  cache.SetMemoryBudget((uint64_t)(size * 2.5));
+
+  cache.SetDirectory(path1, items1, DIR_CACHE_ONCE);
+  cache.SetDirectory(path2, items2, DIR_CACHE_ONCE);
+
+  bool inCache;
+  cache.FileExists(path1 + "/file0000.mkv", inCache);
+  EXPECT_TRUE(inCache);
+
+  // path2 is the least recently used now
+  cache.SetDirectory(path3, items3, DIR_CACHE_ONCE);
+  cache.FileExists(path2 + "/file0000.mkv", inCache);
+  EXPECT_FALSE(inCache);
+  EXPECT_TRUE(cache.FileExists(path1 + "/file0000.mkv", inCache));
+  EXPECT_TRUE(cache.FileExists(path3 + "/file0000.mkv", inCache));
+
+  CDirectoryCache::CacheStats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(1U, stats.evictions);
+  EXPECT_EQ(2U, stats.directories);
+  EXPECT_LE(stats.bytes, stats.budget);
+}
+
+TEST(TestDirectoryCache, AlwaysCachedAreNotEvicted)
+{
+  CTestDirectoryCache cache;
+  cache.SetMemoryBudget(1);
+
+  for (int i = 0; i < 50; i++)
+  {
+    CFileItemList items;
+    std::string path = StringUtils::Format("/media/%04i", i);
+    FillList(items, path, 5);
+    cache.SetDirectory(path, items, i < 10 ? DIR_CACHE_ALWAYS : DIR_CACHE_ONCE);
+  }
+
+  bool inCache;
+  for (int i = 0; i < 10; i++)
+  {
+    cache.FileExists(StringUtils::Format("/media/%04i/file0000.mkv", i), inCache);
+    EXPECT_TRUE(inCache);
+  }
+  // the most recent listing is kept even if it exceeds the budget alone
+  cache.FileExists("/media/0049/file0000.mkv", inCache);
+  EXPECT_TRUE(inCache);
+
+  CDirectoryCache::CacheStats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(11U, stats.directories);
+  EXPECT_EQ(50U, stats.directories + stats.evictions);
+}
+
+TEST(TestDirectoryCache, BorrowUnusedBudget)
+{
+  CTestDirectoryCache cache;
+
+  std::vector<std::string> paths;
+  paths.push_back("/media/0000");
+  paths.push_back(cache.GetPathInSameShard(paths[0], 1));
+  paths.push_back(cache.GetPathInOtherShard(paths));
+  paths.push_back(cache.GetPathInOtherShard(paths));
+
+  CFileItemList small[3], large;
+  FillList(small[0], paths[0], 10);
+  FillList(large, paths[1], 200);
+  FillList(small[1], paths[2], 10);
+  FillList(small[2], paths[3], 10);
+
+  // room for the large listing and two small ones, far more than a shard's share
+  size_t smallSize = CDirectoryCache::EstimateSize(small[0]);
+  cache.SetMemoryBudget(CDirectoryCache::EstimateSize(large) + 2 * smallSize + smallSize / 2);
+
+  // the large listing doesn't evict the other listing of its shard while the cache has room
+  cache.SetDirectory(paths[0], small[0], DIR_CACHE_ONCE);
+  cache.SetDirectory(paths[1], large, DIR_CACHE_ONCE);
+  cache.SetDirectory(paths[2], small[1], DIR_CACHE_ONCE);
+
+  bool inCache;
+  for (int i = 0; i < 3; i++)
+  {
+    cache.FileExists(paths[i] + "/file0000.mkv", inCache);
+    EXPECT_TRUE(inCache) << paths[i];
+  }
+
+  CDirectoryCache::CacheStats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(0U, stats.evictions);
+
+  // once the cache is full, the shard using more than its share makes room
+  cache.SetDirectory(paths[3], small[2], DIR_CACHE_ONCE);
+  cache.FileExists(paths[0] + "/file0000.mkv", inCache);
+  EXPECT_FALSE(inCache);
+  for (int i = 1; i < 4; i++)
+  {
+    cache.FileExists(paths[i] + "/file0000.mkv", inCache);
+    EXPECT_TRUE(inCache) << paths[i];
+  }
+
+  cache.GetStats(stats);
+  EXPECT_EQ(1U, stats.evictions);
+  EXPECT_EQ(3U, stats.directories);
+  EXPECT_LE(stats.bytes, stats.budget);
+}
+
+TEST(TestDirectoryCache, ClearSubPaths)
+{
+  CDirectoryCache cache;
+  cache.SetMemoryBudget(1024 * 1024);
+
+  const char *paths[] = { "/media", "/media/a", "/media/a/b", "/other" };
+  for (unsigned int i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+  {
+    CFileItemList items;
+    FillList(items, paths[i], 1);
+    cache.SetDirectory(paths[i], items, DIR_CACHE_ALWAYS);
+  }
+
+  cache.ClearSubPaths("/media/a");
+
+  CDirectoryCache::CDirectoryPtr dir;
+  EXPECT_TRUE(cache.GetDirectory("/media", dir));
+  EXPECT_FALSE(cache.GetDirectory("/media/a", dir));
+  EXPECT_FALSE(cache.GetDirectory("/media/a/b", dir));
+  EXPECT_TRUE(cache.GetDirectory("/other", dir));
+
+  cache.Clear();
+  CDirectoryCache::CacheStats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(0U, stats.directories);
+  EXPECT_EQ(0U, stats.bytes);
+}
@@ -0,0 +1,231 @@
+/*
+ *      Copyright (C) 2005-2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/Directory.h"
+#include "filesystem/DirectoryCache.h"
+#include "filesystem/File.h"
+#include "filesystem/PersistentDirectoryCache.h"
+#include "filesystem/SpecialProtocol.h"
+#include "guilib/GUIWindowManager.h"
+#include "guilib/IMsgTargetCallback.h"
+#include "FileItem.h"
+#include "GUIUserMessages.h"
+#include "URL.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/StringUtils.h"
+
+#include "gtest/gtest.h"
+
+#define CACHE_FOLDER   "special://temp/dircache/"
+#define TEST_DIRECTORY "special://temp/dircachetest/"
+
+using namespace XFILE;
+
+// records the paths windows are asked to refresh
+class CUpdatePathRecorder : public IMsgTargetCallback
+{
+public:
+  virtual bool OnMessage(CGUIMessage& message)
+  {
+    if (message.GetMessage() == GUI_MSG_NOTIFY_ALL && message.GetParam1() == GUI_MSG_UPDATE_PATH)
+      m_paths.push_back(message.GetStringParam());
+    return false;
+  }
+
+  std::vector<std::string> m_paths;
+};
+
+static CUpdatePathRecorder s_recorder;
+
+class TestPersistentDirectoryCache : public testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    // the window manager can't unregister targets, so it's only added once
+    static bool registered = false;
+    if (!registered)
+      g_windowManager.AddMsgTarget(&s_recorder);
+    registered = true;
+  }
+
+  virtual void TearDown()
+  {
+    CPersistentDirectoryCache::Get().SetMaxListings(0);
+    DeleteFolder(CACHE_FOLDER);
+    DeleteFolder(TEST_DIRECTORY);
+  }
+
+  static void DeleteFolder(const std::string &path)
+  {
+    CFileItemList items;
+    CDirectory::GetDirectory(path, items, "", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE);
+    for (int i = 0; i < items.Size(); i++)
+      CFile::Delete(items[i]->GetPath());
+    CDirectory::Remove(path);
+  }
+
+  static bool WriteTestFile(const std::string &path)
+  {
+    CFile file;
+    return file.OpenForWrite(path, true) && file.Write(path.c_str(), path.size()) == (ssize_t)path.size();
+  }
+
+  // sends the queued thread messages and returns the paths that were refreshed
+  static std::vector<std::string> GetUpdatedPaths()
+  {
+    s_recorder.m_paths.clear();
+    g_windowManager.DispatchThreadMessages();
+    return s_recorder.m_paths;
+  }
+};
+
+static void FillList(CFileItemList &items, const std::string &path, int count)
+{
+  items.SetPath(path);
+  for (int i = 0; i < count; i++)
+  {
+    CFileItemPtr item(new CFileItem(StringUtils::Format("%sfile%04i.mkv", path.c_str(), i), false));
+    item->SetLabel(StringUtils::Format("file%04i", i));
+    item->m_dwSize = i * 1024;
+    items.Add(item);
+  }
+}
+
+TEST_F(TestPersistentDirectoryCache, ReadWrite)
+{
+  CPersistentDirectoryCache &cache = CPersistentDirectoryCache::Get();
+
+  CFileItemList items;
+  FillList(items, "smb://server/share/movies/", 100);
+  EXPECT_TRUE(cache.Write("smb://server/share/movies/", DIR_FLAG_DEFAULTS, items, "1400000000"));
+
+  CFileItemList restored;
+  std::string validator;
+  EXPECT_TRUE(cache.Read("smb://server/share/movies", DIR_FLAG_DEFAULTS, restored, validator));
+  EXPECT_STREQ("1400000000", validator.c_str());
+  EXPECT_EQ(100, restored.Size());
+  EXPECT_STREQ("file0042", restored[42]->GetLabel().c_str());
+  EXPECT_TRUE(CPersistentDirectoryCache::IsSameListing(items, restored));
+
+  // listings are stored per set of flags
+  restored.Clear();
+  EXPECT_FALSE(cache.Read("smb://server/share/movies/", DIR_FLAG_NO_FILE_INFO, restored, validator));
+  EXPECT_FALSE(cache.Read("smb://server/share/music/", DIR_FLAG_DEFAULTS, restored, validator));
+}
+
+TEST_F(TestPersistentDirectoryCache, IsSameListing)
+{
+  CFileItemList items1, items2;
+  FillList(items1, "nfs://server/export/", 10);
+  FillList(items2, "nfs://server/export/", 10);
+  EXPECT_TRUE(CPersistentDirectoryCache::IsSameListing(items1, items2));
+
+  items2[5]->m_dwSize++;
+  EXPECT_FALSE(CPersistentDirectoryCache::IsSameListing(items1, items2));
+
+  items2.Remove(5);
+  EXPECT_FALSE(CPersistentDirectoryCache::IsSameListing(items1, items2));
+}
+
+TEST_F(TestPersistentDirectoryCache, IsCacheable)
+{
+  CPersistentDirectoryCache &cache = CPersistentDirectoryCache::Get();
+  bool enabled = g_advancedSettings.m_persistentDirectoryCache;
+
+  g_advancedSettings.m_persistentDirectoryCache = true;
+  EXPECT_TRUE(cache.IsCacheable(CURL("smb://server/share/"), DIR_CACHE_ONCE));
+  EXPECT_TRUE(cache.IsCacheable(CURL("upnp://device/1/"), DIR_CACHE_ONCE));
+  EXPECT_FALSE(cache.IsCacheable(CURL("smb://server/share/"), DIR_CACHE_NEVER));
+  EXPECT_FALSE(cache.IsCacheable(CURL("/home/user/movies/"), DIR_CACHE_ONCE));
+
+  g_advancedSettings.m_persistentDirectoryCache = false;
+  EXPECT_FALSE(cache.IsCacheable(CURL("smb://server/share/"), DIR_CACHE_ONCE));
+
+  g_advancedSettings.m_persistentDirectoryCache = enabled;
+}
+
+TEST_F(TestPersistentDirectoryCache, PrunesLeastRecentlyUsed)
+{
+  CPersistentDirectoryCache &cache = CPersistentDirectoryCache::Get();
+  cache.SetMaxListings(3);
+
+  CFileItemList items;
+  FillList(items, "smb://server/share/", 10);
+  EXPECT_TRUE(cache.Write("smb://server/share/1/", DIR_FLAG_DEFAULTS, items, ""));
+  EXPECT_TRUE(cache.Write("smb://server/share/2/", DIR_FLAG_DEFAULTS, items, ""));
+  EXPECT_TRUE(cache.Write("smb://server/share/3/", DIR_FLAG_DEFAULTS, items, ""));
+
+  // reading the first listing makes the second one the least recently used
+  CFileItemList restored;
+  std::string validator;
+  EXPECT_TRUE(cache.Read("smb://server/share/1/", DIR_FLAG_DEFAULTS, restored, validator));
+  EXPECT_TRUE(cache.Write("smb://server/share/4/", DIR_FLAG_DEFAULTS, items, ""));
+
+  EXPECT_TRUE(cache.Read("smb://server/share/1/", DIR_FLAG_DEFAULTS, restored, validator));
+  EXPECT_FALSE(cache.Read("smb://server/share/2/", DIR_FLAG_DEFAULTS, restored, validator));
+  EXPECT_TRUE(cache.Read("smb://server/share/3/", DIR_FLAG_DEFAULTS, restored, validator));
+  EXPECT_TRUE(cache.Read("smb://server/share/4/", DIR_FLAG_DEFAULTS, restored, validator));
+
+  // a lower limit prunes right away
+  cache.SetMaxListings(1);
+  EXPECT_FALSE(cache.Read("smb://server/share/1/", DIR_FLAG_DEFAULTS, restored, validator));
+  EXPECT_FALSE(cache.Read("smb://server/share/3/", DIR_FLAG_DEFAULTS, restored, validator));
+  EXPECT_TRUE(cache.Read("smb://server/share/4/", DIR_FLAG_DEFAULTS, restored, validator));
+}
+
+TEST_F(TestPersistentDirectoryCache, Validate)
+{
+  CPersistentDirectoryCache &cache = CPersistentDirectoryCache::Get();
+  const std::string path = CSpecialProtocol::TranslatePath(TEST_DIRECTORY);
+  const CURL url(path);
+  ASSERT_TRUE(WriteTestFile(path + "file1.mkv"));
+  ASSERT_TRUE(WriteTestFile(path + "file2.mkv"));
+  GetUpdatedPaths();
+
+  // local directories have no validator, so they are listed again. without a stored listing it changed
+  EXPECT_TRUE(cache.Validate(url, url, DIR_FLAG_DEFAULTS, DIR_CACHE_ONCE, ""));
+  std::vector<std::string> updated = GetUpdatedPaths();
+  ASSERT_EQ(1, updated.size());
+  EXPECT_STREQ(path.c_str(), updated[0].c_str());
+
+  CFileItemList restored;
+  std::string validator;
+  EXPECT_TRUE(cache.Read(path, DIR_FLAG_DEFAULTS, restored, validator));
+  EXPECT_EQ(2, restored.Size());
+
+  // the same listing doesn't refresh anything
+  EXPECT_TRUE(cache.Validate(url, url, DIR_FLAG_DEFAULTS, DIR_CACHE_ONCE, validator));
+  EXPECT_TRUE(GetUpdatedPaths().empty());
+
+  // a new file is stored and refreshed, also in the directory cache
+  ASSERT_TRUE(WriteTestFile(path + "file3.mkv"));
+  EXPECT_TRUE(cache.Validate(url, url, DIR_FLAG_DEFAULTS, DIR_CACHE_ONCE, validator));
+  EXPECT_EQ(1, GetUpdatedPaths().size());
+
+  restored.Clear();
+  EXPECT_TRUE(cache.Read(path, DIR_FLAG_DEFAULTS, restored, validator));
+  EXPECT_EQ(3, restored.Size());
+
+  CFileItemList cached;
+  EXPECT_TRUE(g_directoryCache.GetDirectory(path, cached));
+  EXPECT_EQ(3, cached.Size());
+  g_directoryCache.ClearDirectory(path);
+}
@@ -89,6 +89,70 @@ TEST(TestRarFile, Read)
   file.Close();
 }
 
+TEST(TestRarFile, StreamedRead)
+{
+  XFILE::CFile file, reference;
+  char buf[20], refbuf[1616];
+  std::string reffile, strpathinrar;
+  CFileItemList itemlist;
+
+  ASSERT_TRUE(reference.Open(XBMC_REF_FILE_PATH("xbmc/filesystem/test/reffile.txt")));
+  ASSERT_EQ(sizeof(refbuf), reference.Read(refbuf, sizeof(refbuf)));
+  reference.Close();
+
+  /* the entry is packed, flags=8 (EXFILE_NOCACHE) rules out extracting it first */
+  reffile = XBMC_REF_FILE_PATH("xbmc/filesystem/test/reffile.txt.rar");
+  CURL rarUrl = URIUtils::CreateArchivePath("rar", CURL(reffile), "");
+  ASSERT_TRUE(XFILE::CDirectory::GetDirectory(rarUrl, itemlist, "",
+    XFILE::DIR_FLAG_NO_FILE_DIRS));
+  strpathinrar = itemlist[0]->GetPath() + "?flags=8";
+  ASSERT_TRUE(file.Open(strpathinrar));
+  EXPECT_EQ(1616, file.GetLength());
+
+  std::string content;
+  ssize_t read;
+  while ((read = file.Read(buf, sizeof(buf))) > 0)
+    content.append(buf, read);
+  EXPECT_EQ(0, read);
+  ASSERT_EQ(sizeof(refbuf), content.size());
+  EXPECT_TRUE(!memcmp(refbuf, content.c_str(), sizeof(refbuf)));
+  file.Close();
+}
+
+TEST(TestRarFile, StreamedSeek)
+{
+  XFILE::CFile file;
+  char buf[20];
+  std::string reffile, strpathinrar;
+  CFileItemList itemlist;
+
+  reffile = XBMC_REF_FILE_PATH("xbmc/filesystem/test/reffile.txt.rar");
+  CURL rarUrl = URIUtils::CreateArchivePath("rar", CURL(reffile), "");
+  ASSERT_TRUE(XFILE::CDirectory::GetDirectory(rarUrl, itemlist, "",
+    XFILE::DIR_FLAG_NO_FILE_DIRS));
+  strpathinrar = itemlist[0]->GetPath() + "?flags=8";
+  ASSERT_TRUE(file.Open(strpathinrar));
+
+  /* forward seeks skip unpacked data */
+  EXPECT_EQ(220, file.Seek(220));
+  EXPECT_EQ(sizeof(buf), file.Read(buf, sizeof(buf)));
+  EXPECT_EQ(240, file.GetPosition());
+  EXPECT_TRUE(!memcmp("rs, XBMC is a non-pr", buf, sizeof(buf) - 1));
+  EXPECT_EQ(1596, file.Seek(-(int64_t)sizeof(buf), SEEK_END));
+  EXPECT_EQ(sizeof(buf), file.Read(buf, sizeof(buf)));
+  EXPECT_TRUE(!memcmp("multimedia jukebox.\n", buf, sizeof(buf) - 1));
+
+  /* backward seeks restart unpacking */
+  EXPECT_EQ(100, file.Seek(100));
+  EXPECT_EQ(sizeof(buf), file.Read(buf, sizeof(buf)));
+  EXPECT_EQ(120, file.GetPosition());
+  EXPECT_TRUE(!memcmp("ent hub for digital ", buf, sizeof(buf) - 1));
+  EXPECT_EQ(0, file.Seek(0, SEEK_SET));
+  EXPECT_EQ(sizeof(buf), file.Read(buf, sizeof(buf)));
+  EXPECT_TRUE(!memcmp("About\n-----\nXBMC is ", buf, sizeof(buf) - 1));
+  file.Close();
+}
+
 TEST(TestRarFile, Exists)
 {
   std::string reffile, strpathinrar;
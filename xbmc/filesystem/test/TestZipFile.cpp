@@ -20,6 +20,7 @@
 
 #include "filesystem/Directory.h"
 #include "filesystem/File.h"
+#include "filesystem/ZipManager.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 #include "FileItem.h"
@@ -28,6 +29,16 @@
 #include "URL.h"
 
 #include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#ifdef TARGET_WINDOWS
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#include <algorithm>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -57,6 +68,53 @@ protected:
   }
 };
 
+// uncompressed size of reflarge.txt, spans several inflate checkpoint intervals
+#define LARGE_FILE_SIZE (5 * 1024 * 1024)
+#define LARGE_FILE_MB   (1024 * 1024)
+
+static std::string GetLargeFilePath()
+{
+  std::string reffile = XBMC_REF_FILE_PATH("xbmc/filesystem/test/reflarge.txt.zip");
+  return URIUtils::CreateArchivePath("zip", CURL(reffile), "reflarge.txt").Get();
+}
+
+// reads the whole entry from the start without seeking
+static bool ReadSequentially(const std::string &path, std::vector<char> &data)
+{
+  XFILE::CFile file;
+  if (!file.Open(path))
+    return false;
+
+  data.resize((size_t)file.GetLength());
+  size_t position = 0;
+  while (position < data.size())
+  {
+    ssize_t read = file.Read(&data[position], std::min<size_t>(64 * 1024, data.size() - position));
+    if (read <= 0)
+      return false;
+    position += read;
+  }
+  return true;
+}
+
+// reads a block at the current position and compares it with the sequential read
+static void ExpectBlock(XFILE::CFile &file, const std::vector<char> &data, int64_t position)
+{
+  char buf[4096];
+  size_t size = std::min<size_t>(sizeof(buf), data.size() - (size_t)position);
+  ASSERT_EQ(position, file.GetPosition());
+  ASSERT_EQ((ssize_t)size, file.Read(buf, size));
+  EXPECT_EQ(0, memcmp(buf, &data[(size_t)position], size)) << "at position " << position;
+}
+
+static bool SetModificationTime(const std::string &path, time_t mtime)
+{
+  struct utimbuf times;
+  times.actime = mtime;
+  times.modtime = mtime;
+  return utime(path.c_str(), &times) == 0;
+}
+
 TEST_F(TestZipFile, Read)
 {
   XFILE::CFile file;
@@ -216,3 +274,138 @@ TEST_F(TestZipFile, CorruptedFile)
   file->Close();
   XBMC_DELETETEMPFILE(file);
 }
+
+TEST_F(TestZipFile, SeekBackwardToCheckpoint)
+{
+  std::vector<char> data;
+  ASSERT_TRUE(ReadSequentially(GetLargeFilePath(), data));
+  ASSERT_EQ(LARGE_FILE_SIZE, data.size());
+  EXPECT_TRUE(!memcmp("00000000: ", &data[0], 10));
+
+  // reading up to the end leaves a checkpoint every megabyte behind
+  XFILE::CFile file;
+  ASSERT_TRUE(file.Open(GetLargeFilePath()));
+  EXPECT_EQ(LARGE_FILE_SIZE - 4096, file.Seek(-4096, SEEK_END));
+  ExpectBlock(file, data, LARGE_FILE_SIZE - 4096);
+
+  const int64_t positions[] = {
+    4 * LARGE_FILE_MB + LARGE_FILE_MB / 2, // between two checkpoints
+    3 * LARGE_FILE_MB,                     // on a checkpoint
+    2 * LARGE_FILE_MB - 100,               // block spans a checkpoint
+    LARGE_FILE_MB / 2,                     // before the first checkpoint
+    0
+  };
+  for (size_t i = 0; i < sizeof(positions) / sizeof(positions[0]); i++)
+  {
+    EXPECT_EQ(positions[i], file.Seek(positions[i], SEEK_SET));
+    ExpectBlock(file, data, positions[i]);
+  }
+
+  // relative seeks backwards as well
+  EXPECT_EQ(LARGE_FILE_SIZE - LARGE_FILE_MB, file.Seek(LARGE_FILE_SIZE - LARGE_FILE_MB, SEEK_SET));
+  EXPECT_EQ(LARGE_FILE_SIZE - 3 * LARGE_FILE_MB, file.Seek(-2 * LARGE_FILE_MB, SEEK_CUR));
+  ExpectBlock(file, data, LARGE_FILE_SIZE - 3 * LARGE_FILE_MB);
+  file.Close();
+}
+
+TEST_F(TestZipFile, SeekForwardToCheckpoint)
+{
+  std::vector<char> data;
+  ASSERT_TRUE(ReadSequentially(GetLargeFilePath(), data));
+  ASSERT_EQ(LARGE_FILE_SIZE, data.size());
+
+  XFILE::CFile file;
+  ASSERT_TRUE(file.Open(GetLargeFilePath()));
+
+  // seeking forward inflates up to the position, leaving checkpoints at 1 and 2 MB
+  int64_t position = 2 * LARGE_FILE_MB + LARGE_FILE_MB / 2;
+  EXPECT_EQ(position, file.Seek(position, SEEK_SET));
+  ExpectBlock(file, data, position);
+
+  // go back before the first checkpoint, then past both of them again
+  position = LARGE_FILE_MB / 2;
+  EXPECT_EQ(position, file.Seek(position, SEEK_SET));
+  ExpectBlock(file, data, position);
+  position = 2 * LARGE_FILE_MB + 300;
+  EXPECT_EQ(position, file.Seek(position, SEEK_SET));
+  ExpectBlock(file, data, position);
+
+  // from the first checkpoint forward to one that has not been reached yet
+  position = LARGE_FILE_MB + 1;
+  EXPECT_EQ(position, file.Seek(position, SEEK_SET));
+  ExpectBlock(file, data, position);
+  position += 4096 + 2 * LARGE_FILE_MB;
+  EXPECT_EQ(position, file.Seek(2 * LARGE_FILE_MB, SEEK_CUR));
+  ExpectBlock(file, data, position);
+
+  // and again, now that a checkpoint exists at 3 MB
+  position = LARGE_FILE_MB + 1;
+  EXPECT_EQ(position, file.Seek(position, SEEK_SET));
+  ExpectBlock(file, data, position);
+  position += 4096 + 2 * LARGE_FILE_MB;
+  EXPECT_EQ(position, file.Seek(2 * LARGE_FILE_MB, SEEK_CUR));
+  ExpectBlock(file, data, position);
+
+  // read on across the last checkpoints up to the end
+  position = LARGE_FILE_SIZE - 100;
+  EXPECT_EQ(position, file.Seek(position, SEEK_SET));
+  ExpectBlock(file, data, position);
+  EXPECT_EQ(LARGE_FILE_SIZE, file.GetPosition());
+  file.Close();
+}
+
+TEST_F(TestZipFile, ChangedArchiveIsListedAgain)
+{
+  XFILE::CFile *tempfile;
+  ASSERT_TRUE((tempfile = XBMC_CREATETEMPFILE(".zip")) != NULL);
+  tempfile->Close();
+  std::string archive = XBMC_TEMPFILEPATH(tempfile);
+  CURL archiveUrl = URIUtils::CreateArchivePath("zip", CURL(archive), "");
+  std::vector<SZipEntry> items;
+
+  XFILE::CFile file;
+  XUTILS::auto_buffer buffer;
+  ASSERT_LT(0, file.LoadFile(XBMC_REF_FILE_PATH("xbmc/filesystem/test/reffile.txt.zip"), buffer));
+  ASSERT_TRUE(file.OpenForWrite(archive, true));
+  ASSERT_EQ((ssize_t)buffer.size(), file.Write(buffer.get(), buffer.size()));
+  file.Close();
+  time_t mtime = time(NULL) - 3600;
+  ASSERT_TRUE(SetModificationTime(archive, mtime));
+
+  ASSERT_TRUE(g_ZipManager.GetZipList(archiveUrl, items));
+  ASSERT_EQ(1, items.size());
+  EXPECT_STREQ("reffile.txt", items[0].name);
+
+  // same size, different name in the local and central headers
+  std::string contents(buffer.get(), buffer.size());
+  EXPECT_EQ(2, StringUtils::Replace(contents, "reffile.txt", "reffile.new"));
+  ASSERT_TRUE(file.OpenForWrite(archive, true));
+  ASSERT_EQ((ssize_t)contents.size(), file.Write(contents.c_str(), contents.size()));
+  file.Close();
+
+  // the cached central directory is kept while size and mtime are unchanged
+  ASSERT_TRUE(SetModificationTime(archive, mtime));
+  ASSERT_TRUE(g_ZipManager.GetZipList(archiveUrl, items));
+  ASSERT_EQ(1, items.size());
+  EXPECT_STREQ("reffile.txt", items[0].name);
+
+  // a changed mtime invalidates it
+  ASSERT_TRUE(SetModificationTime(archive, mtime + 60));
+  ASSERT_TRUE(g_ZipManager.GetZipList(archiveUrl, items));
+  ASSERT_EQ(1, items.size());
+  EXPECT_STREQ("reffile.new", items[0].name);
+
+  // so does a changed size
+  ASSERT_LT(0, file.LoadFile(XBMC_REF_FILE_PATH("xbmc/filesystem/test/reflarge.txt.zip"), buffer));
+  ASSERT_TRUE(file.OpenForWrite(archive, true));
+  ASSERT_EQ((ssize_t)buffer.size(), file.Write(buffer.get(), buffer.size()));
+  file.Close();
+  ASSERT_TRUE(SetModificationTime(archive, mtime + 60));
+  ASSERT_TRUE(g_ZipManager.GetZipList(archiveUrl, items));
+  ASSERT_EQ(1, items.size());
+  EXPECT_STREQ("reflarge.txt", items[0].name);
+  EXPECT_EQ((unsigned int)LARGE_FILE_SIZE, items[0].usize);
+
+  g_ZipManager.release(archiveUrl.Get());
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(tempfile));
+}
@@ -24,6 +24,7 @@
 #include "addons/Skin.h"
 #include "GUIFontTTF.h"
 #include "GUIFont.h"
+#include "LocalizeStrings.h"
 #include "utils/XMLUtils.h"
 #include "GUIControlFactory.h"
 #include "filesystem/Directory.h"
@@ -38,6 +39,8 @@
 #include "URL.h"
 #include "Util.h"
 
+#include <set>
+
 using namespace std;
 
 GUIFontManager::GUIFontManager(void)
@@ -335,6 +338,20 @@ void GUIFontManager::Clear()
   m_vecFonts.clear();
   m_vecFontFiles.clear();
   m_vecFontInfo.clear();
+  m_prerenderCharacters.clear();
+}
+
+const std::vector<wchar_t>& GUIFontManager::GetPrerenderCharacters()
+{
+  if (m_prerenderCharacters.empty())
+  {
+    std::set<wchar_t> characters;
+    for (wchar_t c = 0x20; c < 0x7f; c++)
+      characters.insert(c);
+    g_localizeStrings.GetCharacters(characters);
+    m_prerenderCharacters.assign(characters.begin(), characters.end());
+  }
+  return m_prerenderCharacters;
 }
 
 void GUIFontManager::LoadFonts(const std::string& fontSet)
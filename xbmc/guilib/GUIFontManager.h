@@ -76,6 +76,12 @@ public:
   void Clear();
   void FreeFontFile(CGUIFontTTFBase *pFont);
 
+  /*! \brief Get the characters that fonts should pre-render when loaded
+   These are the characters used by the strings of the current language and skin.
+   \return the characters to pre-render, sorted.
+   */
+  const std::vector<wchar_t>& GetPrerenderCharacters();
+
   static void SettingOptionsFontsFiller(const CSetting *setting, std::vector< std::pair<std::string, std::string> > &list, std::string &current, void *data);
 
 protected:
@@ -90,6 +96,7 @@ protected:
   std::vector<OrigFontInfo> m_vecFontInfo;
   RESOLUTION_INFO m_skinResolution;
   bool m_canReload;
+  std::vector<wchar_t> m_prerenderCharacters;
 };
 
 /*!
@@ -28,8 +28,11 @@
 #include "utils/log.h"
 #include "windowing/WindowingFactory.h"
 #include "URL.h"
+#include "filesystem/Directory.h"
 #include "filesystem/File.h"
 #include "threads/SystemClock.h"
+#include "utils/Crc32.h"
+#include "utils/StringUtils.h"
 
 #include <math.h>
 #include <memory>
@@ -53,6 +56,24 @@ using namespace std;
 #define CHARS_PER_TEXTURE_LINE 20 // number of characters to cache per texture line
 #define CHAR_CHUNK    64      // 64 chars allocated at a time (1024 bytes)
 
+#define GLYPH_ATLAS_PATH    "special://temp/fonts/"
+#define GLYPH_ATLAS_VERSION 1
+
+// header of our persisted glyph atlas, followed by the character table and the 8bit alpha texture rows
+struct GlyphAtlasHeader
+{
+  char     magic[4];
+  uint32_t version;
+  uint32_t characterSize;
+  uint32_t textureWidth;
+  uint32_t cellHeight;
+  uint32_t cellBaseLine;
+  int32_t  posX;
+  int32_t  posY;
+  uint32_t numChars;
+  uint32_t rows;
+};
+
 
 class CFreeTypeLibrary
 {
@@ -155,6 +176,8 @@ XBMC_GLOBAL_REF(CFreeTypeLibrary, g_freeTypeLibrary); // our freetype library
 CGUIFontTTFBase::CGUIFontTTFBase(const std::string& strFileName) : m_staticCache(*this), m_dynamicCache(*this)
 {
   m_texture = NULL;
+  m_persistGlyphs = false;
+  m_savedChars = 0;
   m_char = NULL;
   m_maxChars = 0;
   m_nestedBeginCount = 0;
@@ -216,6 +239,10 @@ void CGUIFontTTFBase::ClearCharacterCache()
 
 void CGUIFontTTFBase::Clear()
 {
+  SaveGlyphAtlas();
+  m_glyphAtlasFile.clear();
+  m_savedChars = 0;
+
   delete(m_texture);
   m_texture = NULL;
   delete[] m_char;
@@ -322,6 +349,20 @@ bool CGUIFontTTFBase::Load(const std::string& strFilename, float height, float a
   m_posX = m_textureWidth;
   m_posY = -(int)GetTextureLineHeight();
 
+  // restore the characters we had last time, or render those we're likely to need now,
+  // rather than rendering them on first use during layout. Without a persisted atlas
+  // they would be rendered again on every start, so leave them to first use then.
+  if (m_persistGlyphs)
+  {
+    const std::vector<wchar_t> &characters = g_fontManager.GetPrerenderCharacters();
+    m_glyphAtlasFile = GetGlyphAtlasFile(strFilename, height, aspect, border, characters);
+    if (!LoadGlyphAtlas())
+    {
+      PrerenderCharacters(characters);
+      SaveGlyphAtlas();
+    }
+  }
+
   // cache the ellipses width
   Character *ellipse = GetCharacter(L'.');
   if (ellipse) m_ellipsesWidth = ellipse->advance;
@@ -643,7 +684,13 @@ CGUIFontTTFBase::Character* CGUIFontTTFBase::GetCharacter(character_t chr)
   if (nestedBeginCount) Begin();
   m_nestedBeginCount = nestedBeginCount;
 
-  // fixup quick access
+  UpdateQuickAccess();
+
+  return m_char + low;
+}
+
+void CGUIFontTTFBase::UpdateQuickAccess()
+{
   memset(m_charquick, 0, sizeof(m_charquick));
   for(int i=0;i<m_numChars;i++)
   {
@@ -653,8 +700,125 @@ CGUIFontTTFBase::Character* CGUIFontTTFBase::GetCharacter(character_t chr)
       m_charquick[ch] = m_char+i;
     }
   }
+}
 
-  return m_char + low;
+void CGUIFontTTFBase::PrerenderCharacters(const std::vector<wchar_t> &characters)
+{
+  unsigned int maxHeight = g_Windowing.GetMaxTextureSize() / 2;
+  for (std::vector<wchar_t>::const_iterator i = characters.begin(); i != characters.end(); ++i)
+  {
+    if (m_posY + 2 * GetTextureLineHeight() > maxHeight)
+    {
+      CLog::Log(LOGDEBUG, "%s: stopped after %i characters of %s", __FUNCTION__, m_numChars, m_strFilename.c_str());
+      break;
+    }
+    if (*i > 0xffff || *i == L'\r')
+      continue;
+    GetCharacter((character_t)*i);
+  }
+}
+
+std::string CGUIFontTTFBase::GetGlyphAtlasFile(const std::string& strFilename, float height, float aspect, bool border, const std::vector<wchar_t> &characters) const
+{
+  struct __stat64 st;
+  if (XFILE::CFile::Stat(strFilename, &st) != 0)
+    return "";
+
+  Crc32 charCrc;
+  if (!characters.empty())
+    charCrc.Compute((const char *)&characters[0], characters.size() * sizeof(wchar_t));
+
+  std::string key = StringUtils::Format("%s|%" PRId64"|%" PRId64"|%f|%f|%i|%u|%u|%08x", strFilename.c_str(),
+                                        (int64_t)st.st_size, (int64_t)st.st_mtime, height, aspect, border ? 1 : 0,
+                                        m_textureWidth, m_cellHeight, (unsigned int)charCrc);
+  Crc32 crc;
+  crc.Compute(key);
+  return StringUtils::Format(GLYPH_ATLAS_PATH "%08x.glyphs", (unsigned int)crc);
+}
+
+bool CGUIFontTTFBase::LoadGlyphAtlas()
+{
+  if (!m_persistGlyphs || m_glyphAtlasFile.empty() || !XFILE::CFile::Exists(m_glyphAtlasFile))
+    return false;
+
+  XFILE::CFile file;
+  XUTILS::auto_buffer buffer;
+  if (file.LoadFile(m_glyphAtlasFile, buffer) < (ssize_t)sizeof(GlyphAtlasHeader))
+    return false;
+
+  GlyphAtlasHeader header;
+  memcpy(&header, buffer.get(), sizeof(header));
+  if (memcmp(header.magic, "XBGA", 4) != 0 || header.version != GLYPH_ATLAS_VERSION ||
+      header.characterSize != sizeof(Character) || header.textureWidth != m_textureWidth ||
+      header.cellHeight != m_cellHeight || header.cellBaseLine != m_cellBaseLine ||
+      header.numChars == 0 || header.rows == 0 ||
+      buffer.size() != sizeof(header) + header.numChars * sizeof(Character) + header.rows * header.textureWidth)
+  {
+    CLog::Log(LOGDEBUG, "%s: ignoring invalid glyph atlas %s", __FUNCTION__, m_glyphAtlasFile.c_str());
+    return false;
+  }
+
+  unsigned int newHeight = header.rows;
+  CBaseTexture* newTexture = ReallocTexture(newHeight);
+  if (!newTexture)
+    return false;
+  m_texture = newTexture;
+
+  // copy the texture across as though it were one big glyph
+  FT_BitmapGlyphRec glyph;
+  memset(&glyph, 0, sizeof(glyph));
+  glyph.bitmap.width = header.textureWidth;
+  glyph.bitmap.pitch = header.textureWidth;
+  glyph.bitmap.rows = header.rows;
+  glyph.bitmap.buffer = (unsigned char *)buffer.get() + sizeof(header) + header.numChars * sizeof(Character);
+  CopyCharToTexture(&glyph, 0, 0, m_textureWidth, std::min(header.rows, m_textureHeight));
+
+  delete[] m_char;
+  m_maxChars = (header.numChars / CHAR_CHUNK + 1) * CHAR_CHUNK;
+  m_char = new Character[m_maxChars];
+  memcpy(m_char, buffer.get() + sizeof(header), header.numChars * sizeof(Character));
+  m_numChars = m_savedChars = header.numChars;
+  m_posX = header.posX;
+  m_posY = header.posY;
+  UpdateQuickAccess();
+
+  CLog::Log(LOGDEBUG, "%s: loaded %i characters of %s from %s", __FUNCTION__, m_numChars, m_strFilename.c_str(), m_glyphAtlasFile.c_str());
+  return true;
+}
+
+void CGUIFontTTFBase::SaveGlyphAtlas()
+{
+  if (!m_persistGlyphs || m_glyphAtlasFile.empty() || !m_texture || !m_texture->GetPixels() ||
+      m_numChars == 0 || m_numChars == m_savedChars || m_posY < 0)
+    return;
+
+  GlyphAtlasHeader header;
+  memcpy(header.magic, "XBGA", 4);
+  header.version = GLYPH_ATLAS_VERSION;
+  header.characterSize = sizeof(Character);
+  header.textureWidth = m_textureWidth;
+  header.cellHeight = m_cellHeight;
+  header.cellBaseLine = m_cellBaseLine;
+  header.posX = m_posX;
+  header.posY = m_posY;
+  header.numChars = m_numChars;
+  header.rows = std::min(m_posY + GetTextureLineHeight(), m_textureHeight);
+
+  XFILE::CDirectory::Create(GLYPH_ATLAS_PATH);
+  XFILE::CFile file;
+  if (!file.OpenForWrite(m_glyphAtlasFile, true))
+  {
+    CLog::Log(LOGWARNING, "%s: unable to write glyph atlas %s", __FUNCTION__, m_glyphAtlasFile.c_str());
+    return;
+  }
+  file.Write(&header, sizeof(header));
+  file.Write(m_char, m_numChars * sizeof(Character));
+  const unsigned char *row = m_texture->GetPixels();
+  for (unsigned int y = 0; y < header.rows; y++, row += m_texture->GetPitch())
+    file.Write(row, m_textureWidth);
+  file.Close();
+
+  m_savedChars = m_numChars;
 }
 
 bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *ch)
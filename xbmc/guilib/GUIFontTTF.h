@@ -124,6 +124,30 @@ protected:
   bool CacheCharacter(wchar_t letter, uint32_t style, Character *ch);
   void RenderCharacter(float posX, float posY, const Character *ch, color_t color, bool roundX, std::vector<SVertex> &vertices);
   void ClearCharacterCache();
+  void UpdateQuickAccess();
+
+  /*! \brief Render the given characters to our texture ahead of their use
+   Stops once the texture reaches half the maximal texture size, leaving room for glyphs we didn't expect.
+   \param characters the characters to render (in the normal style)
+   */
+  void PrerenderCharacters(const std::vector<wchar_t> &characters);
+
+  /*! \brief Get the file our glyph atlas (the character table and texture) is persisted in
+   The file is keyed by the font file, its size and modification time, the font size, aspect and border,
+   and the characters we pre-render.
+   */
+  std::string GetGlyphAtlasFile(const std::string& strFilename, float height, float aspect, bool border, const std::vector<wchar_t> &characters) const;
+
+  /*! \brief Load the glyph atlas persisted by a previous run
+   \return true if the atlas was loaded, false if it doesn't exist, is out of date or we can't persist glyphs.
+   \sa SaveGlyphAtlas
+   */
+  bool LoadGlyphAtlas();
+
+  /*! \brief Persist our glyph atlas if any glyphs have been added since it was loaded
+   \sa LoadGlyphAtlas
+   */
+  void SaveGlyphAtlas();
 
   virtual CBaseTexture* ReallocTexture(unsigned int& newHeight) = 0;
   virtual bool CopyCharToTexture(FT_BitmapGlyph bitGlyph, unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2) = 0;
@@ -134,6 +158,9 @@ protected:
   static void ObliqueGlyph(FT_GlyphSlot slot);
 
   CBaseTexture* m_texture;        // texture that holds our rendered characters (8bit alpha only)
+  bool m_persistGlyphs;           // whether m_texture holds the pixels of our characters, so they can be persisted
+  std::string m_glyphAtlasFile;   // file our characters are persisted in
+  int m_savedChars;               // number of characters persisted in m_glyphAtlasFile
 
   unsigned int m_textureWidth;       // width of our texture
   unsigned int m_textureHeight;      // heigth of our texture
@@ -48,6 +48,7 @@ CGUIFontTTFGL::CGUIFontTTFGL(const std::string& strFileName)
   m_updateY1 = 0;
   m_updateY2 = 0;
   m_textureStatus = TEXTURE_VOID;
+  m_persistGlyphs = true; // m_texture keeps the pixels in system memory
 }
 
 CGUIFontTTFGL::~CGUIFontTTFGL(void)
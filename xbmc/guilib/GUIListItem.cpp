@@ -25,11 +25,25 @@
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
+#include <algorithm>
+
 using namespace std;
 
-bool CGUIListItem::icompare::operator()(const std::string &s1, const std::string &s2) const
+template<class T>
+static bool AtomLess(const pair<CStringAtom, T> &item, const CStringAtom &atom)
+{
+  return item.first < atom;
+}
+
+template<class T>
+static bool AtomPairLess(const pair<CStringAtom, T> &left, const pair<CStringAtom, T> &right)
 {
-  return StringUtils::CompareNoCase(s1, s2) < 0;
+  return left.first < right.first;
+}
+
+static bool FoldedAtomLess(const pair<CStringAtom, CVariant> &item, const CStringAtom &key)
+{
+  return item.first.LessNoCase(key);
 }
 
 CGUIListItem::CGUIListItem(const CGUIListItem& item)
@@ -112,23 +126,38 @@ const std::wstring& CGUIListItem::GetSortLabel() const
 
 void CGUIListItem::SetArt(const std::string &type, const std::string &url)
 {
-  ArtMap::iterator i = m_art.find(type);
-  if (i == m_art.end() || i->second != url)
+  CStringAtom atom(type);
+  ArtVector::iterator i = lower_bound(m_art.begin(), m_art.end(), atom, AtomLess<std::string>);
+  if (i == m_art.end() || i->first != atom)
   {
-    m_art[type] = url;
+    m_art.insert(i, make_pair(atom, url));
+    SetInvalid();
+  }
+  else if (i->second != url)
+  {
+    i->second = url;
     SetInvalid();
   }
 }
 
 void CGUIListItem::SetArt(const ArtMap &art)
 {
-  m_art = art;
+  m_art.clear();
+  m_art.reserve(art.size());
+  for (ArtMap::const_iterator i = art.begin(); i != art.end(); ++i)
+    m_art.push_back(make_pair(CStringAtom(i->first), i->second));
+  sort(m_art.begin(), m_art.end(), AtomPairLess<std::string>);
   SetInvalid();
 }
 
 void CGUIListItem::SetArtFallback(const std::string &from, const std::string &to)
 {
-  m_artFallbacks[from] = to;
+  CStringAtom atom(from);
+  ArtFallbackVector::iterator i = lower_bound(m_artFallbacks.begin(), m_artFallbacks.end(), atom, AtomLess<CStringAtom>);
+  if (i == m_artFallbacks.end() || i->first != atom)
+    m_artFallbacks.insert(i, make_pair(atom, CStringAtom(to)));
+  else
+    i->second = CStringAtom(to);
 }
 
 void CGUIListItem::ClearArt()
@@ -143,24 +172,40 @@ void CGUIListItem::AppendArt(const ArtMap &art, const std::string &prefix)
     SetArt(prefix.empty() ? i->first : prefix + '.' + i->first, i->second);
 }
 
+const std::string *CGUIListItem::FindArt(const CStringAtom &type) const
+{
+  ArtVector::const_iterator i = lower_bound(m_art.begin(), m_art.end(), type, AtomLess<std::string>);
+  if (i != m_art.end() && i->first == type)
+    return &i->second;
+  return NULL;
+}
+
 std::string CGUIListItem::GetArt(const std::string &type) const
 {
-  ArtMap::const_iterator i = m_art.find(type);
-  if (i != m_art.end())
-    return i->second;
-  i = m_artFallbacks.find(type);
-  if (i != m_artFallbacks.end())
+  // no item can have art of a type that no item holds
+  CStringAtom atom;
+  if (!CStringAtom::Find(type, atom))
+    return "";
+
+  const std::string *art = FindArt(atom);
+  if (art)
+    return *art;
+  ArtFallbackVector::const_iterator i = lower_bound(m_artFallbacks.begin(), m_artFallbacks.end(), atom, AtomLess<CStringAtom>);
+  if (i != m_artFallbacks.end() && i->first == atom)
   {
-    ArtMap::const_iterator j = m_art.find(i->second);
-    if (j != m_art.end())
-      return j->second;
+    art = FindArt(i->second);
+    if (art)
+      return *art;
   }
   return "";
 }
 
-const CGUIListItem::ArtMap &CGUIListItem::GetArt() const
+CGUIListItem::ArtMap CGUIListItem::GetArt() const
 {
-  return m_art;
+  ArtMap art;
+  for (ArtVector::const_iterator i = m_art.begin(); i != m_art.end(); ++i)
+    art.insert(make_pair(i->first.str(), i->second));
+  return art;
 }
 
 bool CGUIListItem::HasArt(const std::string &type) const
@@ -263,20 +308,20 @@ void CGUIListItem::Archive(CArchive &ar)
     ar << (int)m_mapProperties.size();
     for (PropertyMap::const_iterator it = m_mapProperties.begin(); it != m_mapProperties.end(); ++it)
     {
-      ar << it->first;
+      ar << it->first.str();
       ar << it->second;
     }
     ar << (int)m_art.size();
-    for (ArtMap::const_iterator i = m_art.begin(); i != m_art.end(); ++i)
+    for (ArtVector::const_iterator i = m_art.begin(); i != m_art.end(); ++i)
     {
-      ar << i->first;
+      ar << i->first.str();
       ar << i->second;
     }
     ar << (int)m_artFallbacks.size();
-    for (ArtMap::const_iterator i = m_artFallbacks.begin(); i != m_artFallbacks.end(); ++i)
+    for (ArtFallbackVector::const_iterator i = m_artFallbacks.begin(); i != m_artFallbacks.end(); ++i)
     {
-      ar << i->first;
-      ar << i->second;
+      ar << i->first.str();
+      ar << i->second.str();
     }
   }
   else
@@ -308,7 +353,7 @@ void CGUIListItem::Archive(CArchive &ar)
       std::string key, value;
       ar >> key;
       ar >> value;
-      m_art.insert(make_pair(key, value));
+      SetArt(key, value);
     }
     ar >> mapSize;
     for (int i = 0; i < mapSize; i++)
@@ -316,7 +361,7 @@ void CGUIListItem::Archive(CArchive &ar)
       std::string key, value;
       ar >> key;
       ar >> value;
-      m_artFallbacks.insert(make_pair(key, value));
+      SetArtFallback(key, value);
     }
     SetInvalid();
   }
@@ -332,10 +377,10 @@ void CGUIListItem::Serialize(CVariant &value)
 
   for (PropertyMap::const_iterator it = m_mapProperties.begin(); it != m_mapProperties.end(); ++it)
   {
-    value["properties"][it->first] = it->second;
+    value["properties"][it->first.str()] = it->second;
   }
-  for (ArtMap::const_iterator it = m_art.begin(); it != m_art.end(); ++it)
-    value["art"][it->first] = it->second;
+  for (ArtVector::const_iterator it = m_art.begin(); it != m_art.end(); ++it)
+    value["art"][it->first.str()] = it->second;
 }
 
 void CGUIListItem::FreeIcons()
@@ -390,12 +435,30 @@ void CGUIListItem::SetInvalid()
   if (m_focusedLayout) m_focusedLayout->SetInvalid();
 }
 
+CGUIListItem::PropertyMap::iterator CGUIListItem::FindProperty(const std::string &strKey)
+{
+  CStringAtom folded;
+  if (!CStringAtom::FindNoCase(strKey, folded))
+    return m_mapProperties.end();
+
+  PropertyMap::iterator iter = lower_bound(m_mapProperties.begin(), m_mapProperties.end(), folded, FoldedAtomLess);
+  if (iter != m_mapProperties.end() && iter->first.EqualsNoCase(folded))
+    return iter;
+  return m_mapProperties.end();
+}
+
+CGUIListItem::PropertyMap::const_iterator CGUIListItem::FindProperty(const std::string &strKey) const
+{
+  return const_cast<CGUIListItem*>(this)->FindProperty(strKey);
+}
+
 void CGUIListItem::SetProperty(const std::string &strKey, const CVariant &value)
 {
-  PropertyMap::iterator iter = m_mapProperties.find(strKey);
-  if (iter == m_mapProperties.end())
+  CStringAtom key(strKey);
+  PropertyMap::iterator iter = lower_bound(m_mapProperties.begin(), m_mapProperties.end(), key, FoldedAtomLess);
+  if (iter == m_mapProperties.end() || !iter->first.EqualsNoCase(key))
   {
-    m_mapProperties.insert(make_pair(strKey, value));
+    m_mapProperties.insert(iter, make_pair(key, value));
     SetInvalid();
   }
   else if (iter->second != value)
@@ -407,16 +470,21 @@ void CGUIListItem::SetProperty(const std::string &strKey, const CVariant &value)
 
 CVariant CGUIListItem::GetProperty(const std::string &strKey) const
 {
-  PropertyMap::const_iterator iter = m_mapProperties.find(strKey);
+  PropertyMap::const_iterator iter = FindProperty(strKey);
   if (iter == m_mapProperties.end())
     return CVariant(CVariant::VariantTypeNull);
 
   return iter->second;
 }
 
+bool CGUIListItem::HasProperties() const
+{
+  return !m_mapProperties.empty();
+}
+
 bool CGUIListItem::HasProperty(const std::string &strKey) const
 {
-  PropertyMap::const_iterator iter = m_mapProperties.find(strKey);
+  PropertyMap::const_iterator iter = FindProperty(strKey);
   if (iter == m_mapProperties.end())
     return false;
 
@@ -425,7 +493,7 @@ bool CGUIListItem::HasProperty(const std::string &strKey) const
 
 void CGUIListItem::ClearProperty(const std::string &strKey)
 {
-  PropertyMap::iterator iter = m_mapProperties.find(strKey);
+  PropertyMap::iterator iter = FindProperty(strKey);
   if (iter != m_mapProperties.end())
   {
     m_mapProperties.erase(iter);
@@ -459,5 +527,5 @@ void CGUIListItem::IncrementProperty(const std::string &strKey, double dVal)
 void CGUIListItem::AppendProperties(const CGUIListItem &item)
 {
   for (PropertyMap::const_iterator i = item.m_mapProperties.begin(); i != item.m_mapProperties.end(); ++i)
-    SetProperty(i->first, i->second);
+    SetProperty(i->first.str(), i->second);
 }
@@ -30,6 +30,9 @@
 
 #include <map>
 #include <string>
+#include <vector>
+
+#include "utils/StringAtom.h"
 
 //  Forward
 class CGUIListItemLayout;
@@ -115,7 +118,11 @@ public:
    \return a type:url map for artwork
    \sa SetArt
    */
-  const ArtMap &GetArt() const;
+  ArtMap GetArt() const;
+
+  /*! \brief Number of art types set on the item, cheaper than GetArt().size()
+   */
+  size_t GetArtCount() const { return m_art.size(); };
 
   /*! \brief Check whether an item has a particular piece of art
    Equivalent to !GetArt(type).empty()
@@ -165,7 +172,7 @@ public:
   void Serialize(CVariant& value);
 
   bool       HasProperty(const std::string &strKey) const;
-  bool       HasProperties() const { return !m_mapProperties.empty(); };
+  bool       HasProperties() const;
   void       ClearProperty(const std::string &strKey);
 
   CVariant   GetProperty(const std::string &strKey) const;
@@ -179,19 +186,25 @@ protected:
   CGUIListItemLayout *m_focusedLayout;
   bool m_bSelected;     // item is selected or not
 
-  struct icompare
-  {
-    bool operator()(const std::string &s1, const std::string &s2) const;
-  };
-
-  typedef std::map<std::string, CVariant, icompare> PropertyMap;
+  /* Properties and art are kept in small vectors sorted by their interned key
+     rather than in maps, as large lists have tens of thousands of items that
+     usually have a handful of them. Property keys are case insensitive, so
+     properties are sorted by the folded key. */
+  typedef std::vector<std::pair<CStringAtom, CVariant> > PropertyMap;
   PropertyMap m_mapProperties;
 private:
+  typedef std::vector<std::pair<CStringAtom, std::string> > ArtVector;
+  typedef std::vector<std::pair<CStringAtom, CStringAtom> > ArtFallbackVector;
+
+  PropertyMap::iterator FindProperty(const std::string &strKey);
+  PropertyMap::const_iterator FindProperty(const std::string &strKey) const;
+  const std::string *FindArt(const CStringAtom &type) const;
+
   std::wstring m_sortLabel;    // text for sorting. Need to be UTF16 for proper sorting
   std::string m_strLabel;      // text of column1
 
-  ArtMap m_art;
-  ArtMap m_artFallbacks;
+  ArtVector m_art;
+  ArtFallbackVector m_artFallbacks;
 };
 #endif
 
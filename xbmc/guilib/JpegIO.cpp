@@ -29,8 +29,12 @@
 #include "JpegIO.h"
 #include "utils/StringUtils.h"
 #include <setjmp.h>
+#include <math.h>
+#include <algorithm>
 
 #define EXIF_TAG_ORIENTATION    0x0112
+#define EXIF_TAG_THUMBNAIL      0x0201
+#define EXIF_TAG_THUMBNAIL_SIZE 0x0202
 
 struct my_error_mgr
 {
@@ -249,6 +253,7 @@ void CJpegIO::Close()
   free(m_inputBuff);
   m_inputBuff = NULL;
   m_inputBuffSize = 0;
+  m_exifThumbnail.clear();
   ReleaseThumbnailBuffer();
 }
 
@@ -316,6 +321,34 @@ bool CJpegIO::Read(unsigned char* buffer, unsigned int bufSize, unsigned int min
       minx = miny * 16/9;
     }
 
+    m_originalWidth  = m_cinfo.image_width;
+    m_originalHeight = m_cinfo.image_height;
+    if (m_cinfo.marker_list)
+      m_orientation = GetExifOrientation(m_cinfo.marker_list->data, m_cinfo.marker_list->data_length);
+
+    /* For thumbnail sized requests many cameras embed a small JPEG in the EXIF
+    data that is good enough on it's own. If it has the same aspect ratio as the
+    main image and is at least as big as the size we need (less the
+    exifthumbtolerance advanced setting), decode that instead. The thumb has
+    been decoded completely at this point, so switching to it can't fail. */
+    if (m_cinfo.marker_list && ReadExifThumbnail(m_cinfo.marker_list->data, m_cinfo.marker_list->data_length, minx, miny))
+    {
+      jpeg_destroy_decompress(&m_cinfo);
+      jpeg_create_decompress(&m_cinfo);
+#if JPEG_LIB_VERSION < 80
+      x_mem_src(&m_cinfo, &m_exifThumbnail[0], m_exifThumbnail.size());
+#else
+      jpeg_mem_src(&m_cinfo, &m_exifThumbnail[0], m_exifThumbnail.size());
+#endif
+      jpeg_read_header(&m_cinfo, true);
+    }
+
+    /* Work out the size the image will end up at once it's been scaled to fit
+    inside minx x miny (keeping aspect) as that is all we need to decode. */
+    unsigned int idealx = m_cinfo.image_width;
+    unsigned int idealy = m_cinfo.image_height;
+    GetIdealSize(m_originalWidth, m_originalHeight, minx, miny, idealx, idealy);
+
     m_cinfo.scale_denom = 8;
     m_cinfo.out_color_space = JCS_RGB;
     unsigned int maxtexsize = g_Windowing.GetMaxTextureSize();
@@ -325,22 +358,101 @@ bool CJpegIO::Read(unsigned char* buffer, unsigned int bufSize, unsigned int min
       jpeg_calc_output_dimensions(&m_cinfo);
       if ((m_cinfo.output_width > maxtexsize) || (m_cinfo.output_height > maxtexsize))
       {
-        m_cinfo.scale_num--;
+        if (scale > 1)
+          m_cinfo.scale_num--;
         break;
       }
-      if (m_cinfo.output_width >= minx && m_cinfo.output_height >= miny)
+      if (m_cinfo.output_width >= idealx && m_cinfo.output_height >= idealy)
         break;
     }
     jpeg_calc_output_dimensions(&m_cinfo);
     m_width  = m_cinfo.output_width;
     m_height = m_cinfo.output_height;
 
-    if (m_cinfo.marker_list)
-      m_orientation = GetExifOrientation(m_cinfo.marker_list->data, m_cinfo.marker_list->data_length);
     return true;
   }
 }
 
+void CJpegIO::GetIdealSize(unsigned int width, unsigned int height, unsigned int maxx, unsigned int maxy, unsigned int &idealx, unsigned int &idealy)
+{
+  // idealx/idealy are the dimensions of the image we are going to decode, which
+  // may be a (same aspect) EXIF thumbnail of the width x height original
+  if (!width || !height)
+    return;
+
+  float scale = std::min((float)maxx / width, (float)maxy / height);
+  if (scale < 1.0f)
+  {
+    idealx = std::min(idealx, (unsigned int)(width * scale + 0.5f));
+    idealy = std::min(idealy, (unsigned int)(height * scale + 0.5f));
+  }
+}
+
+bool CJpegIO::ReadExifThumbnail(unsigned char* exif_data, unsigned int exif_data_size, unsigned int minx, unsigned int miny)
+{
+  unsigned int offset = 0;
+  unsigned int length = 0;
+  if (!GetExifThumbnail(exif_data, exif_data_size, offset, length))
+    return false;
+
+  unsigned int idealx = m_originalWidth;
+  unsigned int idealy = m_originalHeight;
+  GetIdealSize(m_originalWidth, m_originalHeight, minx, miny, idealx, idealy);
+  if (idealx >= m_originalWidth || idealy >= m_originalHeight)
+    return false; // full size requested - no point looking at the thumb
+
+  // decode the embedded thumb with it's own error handler so that a broken
+  // thumb doesn't take the main image with it
+  struct jpeg_decompress_struct cinfo;
+  struct my_error_mgr jerr;
+  cinfo.err = jpeg_std_error(&jerr.pub);
+  jerr.pub.error_exit = jpeg_error_exit;
+  jpeg_create_decompress(&cinfo);
+#if JPEG_LIB_VERSION < 80
+  x_mem_src(&cinfo, exif_data + offset, length);
+#else
+  jpeg_mem_src(&cinfo, exif_data + offset, length);
+#endif
+  if (setjmp(jerr.setjmp_buffer))
+  {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  jpeg_read_header(&cinfo, true);
+  unsigned int width = cinfo.image_width;
+  unsigned int height = cinfo.image_height;
+
+  // the thumb may be a bit smaller than needed if the user is fine with that
+  unsigned int tolerance = std::min(g_advancedSettings.m_exifThumbTolerance, 50U);
+  unsigned int minWidth = idealx * (100 - tolerance) / 100;
+  unsigned int minHeight = idealy * (100 - tolerance) / 100;
+
+  // some cameras letterbox the thumbnail, so insist on the same aspect ratio
+  if (!width || !height || width < minWidth || height < minHeight ||
+      fabsf((float)width * m_originalHeight / ((float)height * m_originalWidth) - 1.0f) > 0.01f)
+  {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+
+  // thumbs are often truncated, only use one that decodes completely
+  cinfo.out_color_space = JCS_RGB;
+  jpeg_start_decompress(&cinfo);
+  JSAMPARRAY row = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, cinfo.output_width * cinfo.output_components, 1);
+  while (cinfo.output_scanline < cinfo.output_height)
+    jpeg_read_scanlines(&cinfo, row, 1);
+  bool complete = cinfo.err->num_warnings == 0;
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  if (!complete)
+    return false;
+
+  // marker data belongs to the main decompressor, so keep our own copy
+  m_exifThumbnail.assign(exif_data + offset, exif_data + offset + length);
+  CLog::Log(LOGDEBUG, "JpegIO: using %ux%u EXIF thumbnail of %s", width, height, m_texturePath.c_str());
+  return true;
+}
+
 bool CJpegIO::Decode(const unsigned char *pixels, unsigned int pitch, unsigned int format)
 {
   unsigned char *dst = (unsigned char*)pixels;
@@ -669,6 +781,75 @@ unsigned int CJpegIO::GetExifOrientation(unsigned char* exif_data, unsigned int
   return orientation;//done
 }
 
+static unsigned int ExifGet16(const unsigned char* data, bool isMotorola)
+{
+  if (isMotorola)
+    return (data[0] << 8) | data[1];
+  return (data[1] << 8) | data[0];
+}
+
+static unsigned int ExifGet32(const unsigned char* data, bool isMotorola)
+{
+  if (isMotorola)
+    return (ExifGet16(data, true) << 16) | ExifGet16(data + 2, true);
+  return (ExifGet16(data + 2, false) << 16) | ExifGet16(data, false);
+}
+
+bool CJpegIO::GetExifThumbnail(const unsigned char* exif_data, unsigned int exif_data_size, unsigned int &offset, unsigned int &length)
+{
+  unsigned const char ExifHeader[] = "Exif\0\0";
+
+  if (exif_data_size < 6 + 8 || memcmp(exif_data, ExifHeader, 6) != 0)
+    return false;
+
+  // all offsets inside the exif data are relative to the TIFF header
+  const unsigned char* tiff = exif_data + 6;
+  const unsigned int tiff_size = exif_data_size - 6;
+
+  bool isMotorola;
+  if (tiff[0] == 'I' && tiff[1] == 'I')
+    isMotorola = false;
+  else if (tiff[0] == 'M' && tiff[1] == 'M')
+    isMotorola = true;
+  else
+    return false;
+
+  if (ExifGet16(tiff + 2, isMotorola) != 0x2A)
+    return false;
+
+  // skip over IFD0 to find IFD1, which describes the thumbnail
+  unsigned int ifd = ExifGet32(tiff + 4, isMotorola);
+  if (ifd > tiff_size - 2)
+    return false;
+  unsigned int numberOfTags = ExifGet16(tiff + ifd, isMotorola);
+  ifd += 2 + numberOfTags * 12;
+  if (ifd > tiff_size - 4)
+    return false;
+  ifd = ExifGet32(tiff + ifd, isMotorola);
+  if (ifd == 0 || ifd > tiff_size - 2)
+    return false;
+
+  unsigned int thumbOffset = 0;
+  unsigned int thumbLength = 0;
+  numberOfTags = ExifGet16(tiff + ifd, isMotorola);
+  ifd += 2;
+  for (; numberOfTags > 0 && ifd <= tiff_size - 12; numberOfTags--, ifd += 12)
+  {
+    unsigned int tagNumber = ExifGet16(tiff + ifd, isMotorola);
+    if (tagNumber == EXIF_TAG_THUMBNAIL)
+      thumbOffset = ExifGet32(tiff + ifd + 8, isMotorola);
+    else if (tagNumber == EXIF_TAG_THUMBNAIL_SIZE)
+      thumbLength = ExifGet32(tiff + ifd + 8, isMotorola);
+  }
+
+  if (!thumbOffset || !thumbLength || thumbOffset > tiff_size || thumbLength > tiff_size - thumbOffset)
+    return false;
+
+  offset = thumbOffset + 6;
+  length = thumbLength;
+  return true;
+}
+
 bool CJpegIO::LoadImageFromMemory(unsigned char* buffer, unsigned int bufSize, unsigned int width, unsigned int height)
 {
   return Read(buffer, bufSize, width, height);
@@ -27,6 +27,7 @@
 #endif
 
 #include <jpeglib.h>
+#include <vector>
 #include "iimage.h"
 
 class CJpegIO : public IImage
@@ -52,12 +53,16 @@ protected:
   static  void   jpeg_error_exit(j_common_ptr cinfo);
 
   static unsigned int   GetExifOrientation(unsigned char* exif_data, unsigned int exif_data_size);
+  static bool           GetExifThumbnail(const unsigned char* exif_data, unsigned int exif_data_size, unsigned int &offset, unsigned int &length);
+  static void           GetIdealSize(unsigned int width, unsigned int height, unsigned int maxx, unsigned int maxy, unsigned int &idealx, unsigned int &idealy);
+  bool                  ReadExifThumbnail(unsigned char* exif_data, unsigned int exif_data_size, unsigned int minx, unsigned int miny);
 
   unsigned char  *m_inputBuff;
   unsigned int   m_inputBuffSize;
   struct         jpeg_decompress_struct m_cinfo;
   std::string     m_texturePath;
   unsigned char* m_thumbnailbuffer;
+  std::vector<unsigned char> m_exifThumbnail;
 };
 
 #endif
@@ -240,6 +240,16 @@ const std::string& CLocalizeStrings::Get(uint32_t dwCode) const
   return i->second.strTranslated;
 }
 
+void CLocalizeStrings::GetCharacters(std::set<wchar_t> &characters) const
+{
+  std::wstring utf16;
+  for (ciStrings i = m_strings.begin(); i != m_strings.end(); ++i)
+  {
+    g_charsetConverter.utf8ToW(i->second.strTranslated, utf16, false);
+    characters.insert(utf16.begin(), utf16.end());
+  }
+}
+
 void CLocalizeStrings::Clear()
 {
   m_strings.clear();
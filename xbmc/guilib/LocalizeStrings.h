@@ -31,6 +31,7 @@
 #include "threads/CriticalSection.h"
 
 #include <map>
+#include <set>
 #include <string>
 #include <stdint.h>
 
@@ -57,6 +58,12 @@ public:
   bool LoadSkinStrings(const std::string& path, const std::string& language);
   void ClearSkinStrings();
   const std::string& Get(uint32_t code) const;
+
+  /*! \brief Get all the characters used by the loaded strings (including any skin strings)
+   Used to pre-render the glyphs fonts are likely to need.
+   \param characters [out] the characters used.
+   */
+  void GetCharacters(std::set<wchar_t> &characters) const;
   void Clear();
 protected:
   void Clear(uint32_t start, uint32_t end);
@@ -0,0 +1,112 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "settings/AdvancedSettings.h"
+#include "guilib/XBTF.h"
+#include "guilib/JpegIO.h"
+#include "test/TestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+/* exifthumb.jpg is a 640x480 green image with a 160x120 blue EXIF thumbnail,
+ * the thumbnail of exifthumb_broken.jpg is truncated in the middle of the scan.
+ */
+#define MAIN_WIDTH  640
+#define MAIN_HEIGHT 480
+
+/* decodes the image and tells whether it came out blue (the thumbnail) */
+static bool DecodedThumbnail(CJpegIO &jpeg)
+{
+  std::vector<unsigned char> pixels(jpeg.Width() * jpeg.Height() * 3);
+  if (!jpeg.Decode(&pixels[0], jpeg.Width() * 3, XB_FMT_RGB8))
+    return false;
+  return pixels[2] > 200 && pixels[1] < 50;
+}
+
+class TestJpegIO : public testing::Test
+{
+protected:
+  TestJpegIO()
+  {
+    m_tolerance = g_advancedSettings.m_exifThumbTolerance;
+    g_advancedSettings.m_exifThumbTolerance = 0;
+  }
+
+  ~TestJpegIO()
+  {
+    g_advancedSettings.m_exifThumbTolerance = m_tolerance;
+  }
+
+  unsigned int m_tolerance;
+};
+
+TEST_F(TestJpegIO, ExifThumbnail)
+{
+  CJpegIO jpeg;
+  ASSERT_TRUE(jpeg.Open(XBMC_REF_FILE_PATH("xbmc/guilib/test/exifthumb.jpg"), 160, 120));
+  EXPECT_EQ(MAIN_WIDTH, jpeg.originalWidth());
+  EXPECT_EQ(MAIN_HEIGHT, jpeg.originalHeight());
+  EXPECT_EQ(160, jpeg.Width());
+  EXPECT_EQ(120, jpeg.Height());
+  EXPECT_TRUE(DecodedThumbnail(jpeg));
+}
+
+TEST_F(TestJpegIO, ExifThumbnailTooSmall)
+{
+  // 3/8 of the image is the smallest scale covering 200x150
+  CJpegIO jpeg;
+  ASSERT_TRUE(jpeg.Open(XBMC_REF_FILE_PATH("xbmc/guilib/test/exifthumb.jpg"), 200, 150));
+  EXPECT_EQ(240, jpeg.Width());
+  EXPECT_EQ(180, jpeg.Height());
+  EXPECT_FALSE(DecodedThumbnail(jpeg));
+}
+
+TEST_F(TestJpegIO, ExifThumbnailTolerance)
+{
+  g_advancedSettings.m_exifThumbTolerance = 25;
+
+  CJpegIO jpeg;
+  ASSERT_TRUE(jpeg.Open(XBMC_REF_FILE_PATH("xbmc/guilib/test/exifthumb.jpg"), 200, 150));
+  EXPECT_EQ(160, jpeg.Width());
+  EXPECT_EQ(120, jpeg.Height());
+  EXPECT_TRUE(DecodedThumbnail(jpeg));
+}
+
+TEST_F(TestJpegIO, FullSize)
+{
+  CJpegIO jpeg;
+  ASSERT_TRUE(jpeg.Open(XBMC_REF_FILE_PATH("xbmc/guilib/test/exifthumb.jpg"), MAIN_WIDTH, MAIN_HEIGHT));
+  EXPECT_EQ(MAIN_WIDTH, jpeg.Width());
+  EXPECT_EQ(MAIN_HEIGHT, jpeg.Height());
+  EXPECT_FALSE(DecodedThumbnail(jpeg));
+}
+
+TEST_F(TestJpegIO, BrokenExifThumbnail)
+{
+  // the main image is decoded when the thumbnail doesn't decode completely
+  CJpegIO jpeg;
+  ASSERT_TRUE(jpeg.Open(XBMC_REF_FILE_PATH("xbmc/guilib/test/exifthumb_broken.jpg"), 160, 120));
+  EXPECT_EQ(160, jpeg.Width());
+  EXPECT_EQ(120, jpeg.Height());
+  EXPECT_FALSE(DecodedThumbnail(jpeg));
+}
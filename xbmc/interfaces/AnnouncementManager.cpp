@@ -37,6 +37,8 @@ using namespace std;
 using namespace ANNOUNCEMENT;
 
 CAnnouncementManager::CAnnouncementManager()
+  : CThread("Announce"),
+    m_running(false)
 { }
 
 CAnnouncementManager::~CAnnouncementManager()
@@ -50,8 +52,34 @@ CAnnouncementManager& CAnnouncementManager::Get()
   return s_instance;
 }
 
+void CAnnouncementManager::Start()
+{
+  CSingleLock lock (m_queueCritSection);
+  if (m_running)
+    return;
+
+  m_running = true;
+  Create();
+}
+
 void CAnnouncementManager::Deinitialize()
 {
+  {
+    CSingleLock lock (m_queueCritSection);
+    m_running = false;
+    m_queueCondition.notifyAll();
+  }
+  StopThread();
+
+  // announcers still have to learn about e.g. the application quitting
+  std::deque<CAnnounceData> announcements;
+  {
+    CSingleLock lock (m_queueCritSection);
+    announcements.swap(m_announcementQueue);
+  }
+  for (std::deque<CAnnounceData>::const_iterator it = announcements.begin(); it != announcements.end(); ++it)
+    DoAnnounce(it->flag, it->sender.c_str(), it->message.c_str(), it->data);
+
   CSingleLock lock (m_critSection);
   m_announcers.clear();
 }
@@ -91,6 +119,58 @@ void CAnnouncementManager::Announce(AnnouncementFlag flag, const char *sender, c
 {
   CLog::Log(LOGDEBUG, "CAnnouncementManager - Announcement: %s from %s", message, sender);
 
+  {
+    CSingleLock lock (m_queueCritSection);
+    if (m_running && flag != System)
+    {
+      Queue(flag, sender, message, data);
+      return;
+    }
+  }
+
+  DoAnnounce(flag, sender, message, data);
+}
+
+void CAnnouncementManager::Queue(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
+{
+  if (CanCoalesce(flag, message))
+  {
+    // only the latest state matters, drop the one still waiting
+    for (std::deque<CAnnounceData>::iterator it = m_announcementQueue.begin(); it != m_announcementQueue.end(); ++it)
+    {
+      if (it->flag == flag && it->message == message && it->sender == sender)
+      {
+        m_announcementQueue.erase(it);
+        break;
+      }
+    }
+  }
+
+  if (m_announcementQueue.size() >= MAX_QUEUED_ANNOUNCEMENTS)
+  {
+    CLog::Log(LOGWARNING, "CAnnouncementManager - Queue full, dropping %s from %s",
+              m_announcementQueue.front().message.c_str(), m_announcementQueue.front().sender.c_str());
+    m_announcementQueue.pop_front();
+  }
+
+  m_announcementQueue.push_back(CAnnounceData());
+  CAnnounceData &announcement = m_announcementQueue.back();
+  announcement.flag = flag;
+  announcement.sender = sender;
+  announcement.message = message;
+  announcement.data = data;
+
+  m_queueCondition.notifyAll();
+}
+
+bool CAnnouncementManager::CanCoalesce(AnnouncementFlag flag, const std::string &message)
+{
+  return (flag == Player && (message == "OnSeek" || message == "OnSpeedChanged")) ||
+         (flag == Application && message == "OnVolumeChanged");
+}
+
+void CAnnouncementManager::DoAnnounce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
+{
   CSingleLock lock (m_critSection);
 
   // Make a copy of announers. They may be removed or even remove themselves during execution of IAnnouncer::Announce()!
@@ -99,6 +179,25 @@ void CAnnouncementManager::Announce(AnnouncementFlag flag, const char *sender, c
     announcers[i]->Announce(flag, sender, message, data);
 }
 
+void CAnnouncementManager::Process()
+{
+  CSingleLock lock (m_queueCritSection);
+  while (m_running && !m_bStop)
+  {
+    if (m_announcementQueue.empty())
+    {
+      m_queueCondition.wait(lock, 1000);
+      continue;
+    }
+
+    CAnnounceData announcement = m_announcementQueue.front();
+    m_announcementQueue.pop_front();
+
+    CSingleExit exit(m_queueCritSection);
+    DoAnnounce(announcement.flag, announcement.sender.c_str(), announcement.message.c_str(), announcement.data);
+  }
+}
+
 void CAnnouncementManager::Announce(AnnouncementFlag flag, const char *sender, const char *message, CFileItemPtr item)
 {
   CVariant data;
@@ -18,22 +18,43 @@
  *  <http://www.gnu.org/licenses/>.
  *
  */
+#include <deque>
+#include <string>
 #include <vector>
 
 #include "IAnnouncer.h"
 #include "FileItem.h"
+#include "threads/Condition.h"
 #include "threads/CriticalSection.h"
+#include "threads/Thread.h"
 #include "utils/GlobalsHandling.h"
+#include "utils/Variant.h"
 
 namespace ANNOUNCEMENT
 {
-  class CAnnouncementManager
+  /*!
+   \brief Hands announcements to all registered announcers.
+
+   Once started, announcements are queued and delivered by a separate thread,
+   so a slow announcer never holds up the thread announcing. Repeated high
+   frequency announcements (e.g. Player.OnSeek) still waiting in the queue are
+   replaced by the newest one, and the oldest ones are dropped if the queue
+   runs full. System announcements are delivered right away on the calling
+   thread, as announcers have to act on them before e.g. suspending.
+   Announcements still queued when stopping are delivered by Deinitialize().
+   */
+  class CAnnouncementManager : private CThread
   {
   public:
     virtual ~CAnnouncementManager();
 
     static CAnnouncementManager& Get();
 
+    // announcements waiting for delivery, the oldest are dropped beyond this
+    static const unsigned int MAX_QUEUED_ANNOUNCEMENTS = 1000;
+
+    /*! \brief Start delivering announcements from a separate thread */
+    void Start();
     void Deinitialize();
 
     void AddAnnouncer(IAnnouncer *listener);
@@ -43,12 +64,33 @@ namespace ANNOUNCEMENT
     void Announce(AnnouncementFlag flag, const char *sender, const char *message, CVariant &data);
     void Announce(AnnouncementFlag flag, const char *sender, const char *message, CFileItemPtr item);
     void Announce(AnnouncementFlag flag, const char *sender, const char *message, CFileItemPtr item, CVariant &data);
+
+  protected:
+    virtual void Process();
+
   private:
     CAnnouncementManager();
     CAnnouncementManager(const CAnnouncementManager&);
     CAnnouncementManager const& operator=(CAnnouncementManager const&);
 
+    struct CAnnounceData
+    {
+      AnnouncementFlag flag;
+      std::string sender;
+      std::string message;
+      CVariant data;
+    };
+
+    void Queue(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data);
+    void DoAnnounce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data);
+    static bool CanCoalesce(AnnouncementFlag flag, const std::string &message);
+
     CCriticalSection m_critSection;
     std::vector<IAnnouncer *> m_announcers;
+
+    CCriticalSection m_queueCritSection;
+    std::deque<CAnnounceData> m_announcementQueue;
+    XbmcThreads::ConditionVariable m_queueCondition;
+    bool m_running;
   };
 }
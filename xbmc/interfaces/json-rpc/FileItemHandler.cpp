@@ -45,6 +45,9 @@
 #include "epg/Epg.h"
 #include "epg/EpgContainer.h"
 
+// shorter lists aren't worth serializing them while writing the response
+#define STREAMED_LIST_MIN_SIZE 50
+
 using namespace MUSIC_INFO;
 using namespace JSONRPC;
 using namespace XFILE;
@@ -107,7 +110,7 @@ bool CFileItemHandler::GetField(const std::string &field, const CVariant &info,
 
     if (field == "art")
     {
-      if (thumbLoader != NULL && item->GetArt().size() <= 0 && !fetchedArt &&
+      if (thumbLoader != NULL && item->GetArtCount() == 0 && !fetchedArt &&
         ((item->HasVideoInfoTag() && item->GetVideoInfoTag()->m_iDbId > -1) || (item->HasMusicInfoTag() && item->GetMusicInfoTag()->GetDatabaseId() > -1)))
       {
         thumbLoader->FillLibraryArt(*item);
@@ -223,6 +226,27 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
     end = items.Size();
   }
 
+  std::set<std::string> fields;
+  if (parameterObject.isMember("properties") && parameterObject["properties"].isArray())
+  {
+    for (CVariant::const_iterator_array field = parameterObject["properties"].begin_array(); field != parameterObject["properties"].end_array(); field++)
+      fields.insert(field->asString());
+  }
+
+  // let the items be serialized one by one while the response is written
+  // instead of holding all of them in the result at once
+  if (resultname != NULL && end - start >= STREAMED_LIST_MIN_SIZE &&
+     (!result.isMember(resultname) || result[resultname].empty()))
+  {
+    CVariant placeholder;
+    JSONRPCArrayStreamPtr stream(new CFileItemListStream(ID, allowFile, items, start, end, parameterObject, fields));
+    if (CJSONRPC::AddArrayStream(stream, placeholder))
+    {
+      result[resultname] = placeholder;
+      return;
+    }
+  }
+
   CThumbLoader *thumbLoader = NULL;
   if (end - start > 0)
   {
@@ -235,13 +259,6 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
       thumbLoader->OnLoaderStart();
   }
 
-  std::set<std::string> fields;
-  if (parameterObject.isMember("properties") && parameterObject["properties"].isArray())
-  {
-    for (CVariant::const_iterator_array field = parameterObject["properties"].begin_array(); field != parameterObject["properties"].end_array(); field++)
-      fields.insert(field->asString());
-  }
-
   for (int i = start; i < end; i++)
   {
     CFileItemPtr item = items.Get(i);
@@ -251,6 +268,50 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
   delete thumbLoader;
 }
 
+CFileItemHandler::CFileItemListStream::CFileItemListStream(const char *ID, bool allowFile, const CFileItemList &items, int start, int end, const CVariant &parameterObject, const std::set<std::string> &fields)
+  : m_ID(ID),
+    m_allowFile(allowFile),
+    m_index(0),
+    m_parameterObject(parameterObject),
+    m_fields(fields),
+    m_thumbLoader(NULL)
+{
+  m_items.reserve(end - start);
+  for (int i = start; i < end; i++)
+    m_items.push_back(items.Get(i));
+}
+
+CFileItemHandler::CFileItemListStream::~CFileItemListStream()
+{
+  delete m_thumbLoader;
+}
+
+bool CFileItemHandler::CFileItemListStream::Next(CVariant &element)
+{
+  if (m_index >= m_items.size())
+    return false;
+
+  if (m_index == 0)
+  {
+    if (m_items[0]->HasVideoInfoTag())
+      m_thumbLoader = new CVideoThumbLoader();
+    else if (m_items[0]->HasMusicInfoTag())
+      m_thumbLoader = new CMusicThumbLoader();
+
+    if (m_thumbLoader != NULL)
+      m_thumbLoader->OnLoaderStart();
+  }
+
+  CVariant result;
+  HandleFileItem(m_ID, m_allowFile, "item", m_items[m_index], m_parameterObject, m_fields, result, false, m_thumbLoader);
+  element.swap(result["item"]);
+
+  // the item isn't needed anymore once it has been serialized
+  m_items[m_index++].reset();
+
+  return true;
+}
+
 void CFileItemHandler::HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const CVariant &validFields, CVariant &result, bool append /* = true */, CThumbLoader *thumbLoader /* = NULL */)
 {
   std::set<std::string> fields;
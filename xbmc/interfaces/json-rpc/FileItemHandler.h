@@ -20,6 +20,7 @@
  */
 
 #include <set>
+#include <vector>
 
 #include "JSONRPC.h"
 #include "JSONUtils.h"
@@ -39,8 +40,29 @@ namespace JSONRPC
     static void HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const std::set<std::string> &validFields, CVariant &result, bool append = true, CThumbLoader *thumbLoader = NULL);
 
     static bool FillFileItemList(const CVariant &parameterObject, CFileItemList &list);
-  private:
     static void Sort(CFileItemList &items, const CVariant& parameterObject);
+  private:
     static bool GetField(const std::string &field, const CVariant &info, const CFileItemPtr &item, CVariant &result, bool &fetchedArt, CThumbLoader *thumbLoader = NULL);
+
+    /*!
+     \brief Serializes the items of a list one at a time while the response is written
+     */
+    class CFileItemListStream : public IJSONRPCArrayStream
+    {
+    public:
+      CFileItemListStream(const char *ID, bool allowFile, const CFileItemList &items, int start, int end, const CVariant &parameterObject, const std::set<std::string> &fields);
+      virtual ~CFileItemListStream();
+
+      virtual bool Next(CVariant &element);
+
+    private:
+      const char *m_ID;
+      bool m_allowFile;
+      std::vector<CFileItemPtr> m_items;
+      size_t m_index;
+      CVariant m_parameterObject;
+      std::set<std::string> m_fields;
+      CThumbLoader *m_thumbLoader;
+    };
   };
 }
@@ -18,7 +18,9 @@
  *
  */
 
+#include <algorithm>
 #include <string.h>
+#include <utility>
 
 #include "JSONRPC.h"
 #include "ServiceDescription.h"
@@ -27,6 +29,7 @@
 #include "interfaces/AnnouncementManager.h"
 #include "playlists/SmartPlayList.h"
 #include "settings/AdvancedSettings.h"
+#include "threads/ThreadLocal.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
@@ -38,6 +41,102 @@ using namespace std;
 
 bool CJSONRPC::m_initialized = false;
 
+// streamed result arrays added while handling a request on the current thread
+typedef struct
+{
+  std::map<std::wstring, JSONRPCArrayStreamPtr> streams;
+} StreamContext;
+
+static XbmcThreads::ThreadLocal<StreamContext> streamContext;
+
+// the placeholders of streamed arrays are wide strings which neither come
+// from parsing a request nor can be written as JSON, so no actual value of
+// the result can be mistaken for one
+static bool IsStreamPlaceholder(const CVariant &value, void *data)
+{
+  const StreamContext *context = static_cast<const StreamContext*>(data);
+  return value.isWideString() && context->streams.find(value.asWideString()) != context->streams.end();
+}
+
+CJSONRPCResponse::CJSONRPCResponse()
+  : m_compact(true),
+    m_part(0),
+    m_offset(0),
+    m_inStream(false),
+    m_firstElement(true)
+{ }
+
+bool CJSONRPCResponse::IsEmpty() const
+{
+  return m_text.empty();
+}
+
+void CJSONRPCResponse::Wrap(const std::string &prefix, const std::string &suffix)
+{
+  if (m_text.empty())
+    m_text.push_back("");
+
+  m_text.front().insert(0, prefix);
+  m_text.back().append(suffix);
+}
+
+bool CJSONRPCResponse::Read(std::string &data, size_t size)
+{
+  size_t length = data.size();
+  while (data.size() - length < size && m_part < m_text.size())
+  {
+    if (m_inStream)
+    {
+      CVariant element;
+      if (m_streams[m_part]->Next(element))
+      {
+        if (!m_firstElement)
+          data += ',';
+        m_firstElement = false;
+        data += CJSONVariantWriter::Write(element, m_compact);
+      }
+      else
+      {
+        data += ']';
+        // let go of everything belonging to the finished array
+        m_streams[m_part].reset();
+        m_inStream = false;
+        m_part++;
+        m_offset = 0;
+      }
+      continue;
+    }
+
+    std::string &text = m_text[m_part];
+    size_t count = std::min(size - (data.size() - length), text.size() - m_offset);
+    data.append(text, m_offset, count);
+    m_offset += count;
+    if (m_offset < text.size())
+      break;
+
+    std::string().swap(text);
+    if (m_part < m_streams.size())
+    {
+      data += '[';
+      m_inStream = true;
+      m_firstElement = true;
+    }
+    else
+      m_part++;
+  }
+
+  return data.size() > length;
+}
+
+std::string CJSONRPCResponse::ToString()
+{
+  std::string data;
+  while (Read(data, 64 * 1024))
+    ;
+
+  return data;
+}
+
 void CJSONRPC::Initialize()
 {
   if (m_initialized)
@@ -103,6 +202,8 @@ void CJSONRPC::Initialize()
 
   for (unsigned int index = 0; index < size; index++)
     CJSONServiceDescription::AddNotification(JSONRPC_SERVICE_NOTIFICATIONS[index]);
+
+  CJSONServiceDescription::ResolveReferences();
   
   m_initialized = true;
   CLog::Log(LOGINFO, "JSONRPC v%s: Successfully initialized", CJSONServiceDescription::GetVersion());
@@ -229,7 +330,52 @@ JSONRPC_STATUS CJSONRPC::NotifyAll(const std::string &method, ITransportLayer *t
 
 std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client)
 {
-  CVariant inputroot, outputroot, result;
+  return MethodCallStreamed(inputString, transport, client)->ToString();
+}
+
+JSONRPCResponsePtr CJSONRPC::MethodCallStreamed(const std::string &inputString, ITransportLayer *transport, IClient *client)
+{
+  JSONRPCResponsePtr response(new CJSONRPCResponse());
+  response->m_compact = g_advancedSettings.m_jsonOutputCompact;
+
+  StreamContext context;
+  StreamContext *previousContext = streamContext.get();
+  streamContext.set(&context);
+
+  CVariant outputroot;
+  bool hasResponse = HandleRequest(inputString, transport, client, outputroot);
+
+  streamContext.set(previousContext);
+
+  if (!hasResponse)
+    return response;
+
+  // leave out the placeholders of the streamed arrays, methods which failed
+  // after adding a stream don't contain its placeholder
+  std::vector<const CVariant*> placeholders;
+  CJSONVariantWriter::Write(outputroot, response->m_compact, IsStreamPlaceholder, &context, response->m_text, placeholders);
+  for (std::vector<const CVariant*>::const_iterator placeholder = placeholders.begin(); placeholder != placeholders.end(); ++placeholder)
+    response->m_streams.push_back(context.streams[(*placeholder)->asWideString()]);
+
+  return response;
+}
+
+bool CJSONRPC::AddArrayStream(const JSONRPCArrayStreamPtr &stream, CVariant &placeholder)
+{
+  StreamContext *context = streamContext.get();
+  if (context == NULL || !stream)
+    return false;
+
+  std::wstring name = StringUtils::Format(L"%u", (unsigned int)context->streams.size());
+  context->streams.insert(std::make_pair(name, stream));
+  placeholder = name;
+
+  return true;
+}
+
+bool CJSONRPC::HandleRequest(const std::string &inputString, ITransportLayer *transport, IClient *client, CVariant &outputroot)
+{
+  CVariant inputroot;
   bool hasResponse = false;
 
   if(g_advancedSettings.CanLogComponent(LOGJSONRPC))
@@ -253,7 +399,7 @@ std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer
           CVariant response;
           if (HandleMethodCall(*itr, response, transport, client))
           {
-            outputroot.append(response);
+            outputroot.append(std::move(response));
             hasResponse = true;
           }
         }
@@ -269,8 +415,7 @@ std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer
     hasResponse = true;
   }
 
-  std::string str = hasResponse ? CJSONVariantWriter::Write(outputroot, g_advancedSettings.m_jsonOutputCompact) : "";
-  return str;
+  return hasResponse;
 }
 
 bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client)
@@ -292,7 +437,7 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
     if ((errorCode = CJSONServiceDescription::CheckCall(methodName.c_str(), request["params"], transport, client, isNotification, method, params)) == OK)
       errorCode = method(methodName, transport, client, params, result);
     else
-      result = params;
+      result = std::move(params);
   }
   else
   {
@@ -300,7 +445,7 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
     errorCode = InvalidRequest;
   }
 
-  BuildResponse(request, errorCode, result, response);
+  BuildResponse(request, errorCode, std::move(result), response);
 
   return !isNotification;
 }
@@ -310,7 +455,7 @@ inline bool CJSONRPC::IsProperJSONRPC(const CVariant& inputroot)
   return inputroot.isObject() && inputroot.isMember("jsonrpc") && inputroot["jsonrpc"].isString() && inputroot["jsonrpc"] == CVariant("2.0") && inputroot.isMember("method") && inputroot["method"].isString() && (!inputroot.isMember("params") || inputroot["params"].isArray() || inputroot["params"].isObject());
 }
 
-inline void CJSONRPC::BuildResponse(const CVariant& request, JSONRPC_STATUS code, const CVariant& result, CVariant& response)
+inline void CJSONRPC::BuildResponse(const CVariant& request, JSONRPC_STATUS code, CVariant&& result, CVariant& response)
 {
   response["jsonrpc"] = "2.0";
   response["id"] = request.isObject() && request.isMember("id") ? request["id"] : CVariant();
@@ -318,7 +463,7 @@ inline void CJSONRPC::BuildResponse(const CVariant& request, JSONRPC_STATUS code
   switch (code)
   {
     case OK:
-      response["result"] = result;
+      response["result"] = std::move(result);
       break;
     case ACK:
       response["result"] = "OK";
@@ -331,7 +476,7 @@ inline void CJSONRPC::BuildResponse(const CVariant& request, JSONRPC_STATUS code
       response["error"]["code"] = InvalidParams;
       response["error"]["message"] = "Invalid params.";
       if (!result.isNull())
-        response["error"]["data"] = result;
+        response["error"]["data"] = std::move(result);
       break;
     case MethodNotFound:
       response["error"]["code"] = MethodNotFound;
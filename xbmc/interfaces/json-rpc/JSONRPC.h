@@ -21,8 +21,10 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
 #include <stdio.h>
 #include <string>
+#include <vector>
 
 #include "JSONRPCUtils.h"
 #include "JSONServiceDescription.h"
@@ -30,6 +32,82 @@
 
 namespace JSONRPC
 {
+  /*!
+   \ingroup jsonrpc
+   \brief Elements of a result array which are only serialized while the
+   response is being written.
+
+   Allows methods to return huge lists without having to build a CVariant
+   for every single element up front.
+   */
+  class IJSONRPCArrayStream
+  {
+  public:
+    virtual ~IJSONRPCArrayStream() { }
+
+    /*!
+     \brief Retrieves the next element of the array
+     \param element Filled with the next element
+     \return False once there are no more elements
+     */
+    virtual bool Next(CVariant &element) = 0;
+  };
+  typedef std::shared_ptr<IJSONRPCArrayStream> JSONRPCArrayStreamPtr;
+
+  /*!
+   \ingroup jsonrpc
+   \brief Serialized JSON-RPC response which is produced piece by piece
+
+   The response is kept as the text surrounding the streamed result arrays
+   whose elements are only serialized when that part of the response is read.
+   */
+  class CJSONRPCResponse
+  {
+  public:
+    CJSONRPCResponse();
+
+    /*!
+     \brief Whether there is no response to be sent (e.g. for notifications)
+     */
+    bool IsEmpty() const;
+
+    /*!
+     \brief Whether parts of the response are only produced while reading it
+     */
+    bool IsStreamed() const { return !m_streams.empty(); }
+
+    /*!
+     \brief Surrounds the response with the given text (e.g. for JSONP)
+     */
+    void Wrap(const std::string &prefix, const std::string &suffix);
+
+    /*!
+     \brief Appends the next part of the response to the given string
+     \param data String to append to
+     \param size Number of bytes after which to stop appending, a single
+     streamed element may exceed it
+     \return False once the whole response has been read
+     */
+    bool Read(std::string &data, size_t size);
+
+    /*!
+     \brief Reads the remaining response into a single string
+     */
+    std::string ToString();
+
+  private:
+    friend class CJSONRPC;
+
+    bool m_compact;
+    std::vector<std::string> m_text;              // text before every stream and after the last one
+    std::vector<JSONRPCArrayStreamPtr> m_streams;
+    size_t m_part;
+    size_t m_offset;
+    bool m_inStream;
+    bool m_firstElement;
+  };
+  typedef std::shared_ptr<CJSONRPCResponse> JSONRPCResponsePtr;
+
   /*!
    \ingroup jsonrpc
    \brief JSON RPC handler
@@ -63,6 +141,29 @@ namespace JSONRPC
      */
     static std::string MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client);
 
+    /*
+     \brief Handles an incoming JSON-RPC request without serializing the
+     streamed result arrays
+     \param inputString received JSON-RPC request
+     \param transport Transport protocol on which the request arrived
+     \param client Client which sent the request
+     \return JSON-RPC response to be read and sent back to the client
+
+     Works like MethodCall() but the elements of result arrays added through
+     AddArrayStream() are only serialized while the response is read.
+     */
+    static JSONRPCResponsePtr MethodCallStreamed(const std::string &inputString, ITransportLayer *transport, IClient *client);
+
+    /*
+     \brief Adds an array whose elements are serialized while the response
+     of the currently handled request is read
+     \param stream Elements of the array
+     \param placeholder Value to be put into the result in place of the array
+     \return False if streaming is not possible for the current request and
+     the elements have to be added to the result directly
+     */
+    static bool AddArrayStream(const JSONRPCArrayStreamPtr &stream, CVariant &placeholder);
+
     static JSONRPC_STATUS Introspect(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Version(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Permission(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
@@ -73,10 +174,11 @@ namespace JSONRPC
   
   private:
     static void setup();
+    static bool HandleRequest(const std::string &inputString, ITransportLayer *transport, IClient *client, CVariant &outputroot);
     static bool HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client);
     static inline bool IsProperJSONRPC(const CVariant& inputroot);
 
-    inline static void BuildResponse(const CVariant& request, JSONRPC_STATUS code, const CVariant& result, CVariant& response);
+    inline static void BuildResponse(const CVariant& request, JSONRPC_STATUS code, CVariant&& result, CVariant& response);
 
     static bool m_initialized;
   };
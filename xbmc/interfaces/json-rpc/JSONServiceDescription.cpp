@@ -98,6 +98,7 @@ JsonRpcMethodMap CJSONServiceDescription::m_methodMaps[] = {
   { "Files.GetFileDetails",                         CFileOperations::GetFileDetails },
   { "Files.PrepareDownload",                        CFileOperations::PrepareDownload },
   { "Files.Download",                               CFileOperations::Download },
+  { "Files.GetDirectoryCacheStats",                 CFileOperations::GetDirectoryCacheStats },
 
 // Music Library
   { "AudioLibrary.GetArtists",                      CAudioLibrary::GetArtists },
@@ -617,14 +618,25 @@ bool JSONSchemaTypeDefinition::Parse(const CVariant &value, bool isParameter /*
 
 JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &outputValue, CVariant &errorData)
 {
-  if (!name.empty())
-    errorData["name"] = name;
-  SchemaValueTypeToJson(type, errorData["type"]);
-  std::string errorMessage;
-
   if (referencedType != NULL && !referencedTypeSet)
     Set(referencedType);
 
+  JSONRPC_STATUS status = checkValue(value, outputValue, errorData);
+  if (status != OK)
+  {
+    // the details of the type are only needed for invalid values
+    if (!name.empty())
+      errorData["name"] = name;
+    SchemaValueTypeToJson(type, errorData["type"]);
+  }
+
+  return status;
+}
+
+JSONRPC_STATUS JSONSchemaTypeDefinition::checkValue(const CVariant &value, CVariant &outputValue, CVariant &errorData)
+{
+  std::string errorMessage;
+
   // Let's check the type of the provided parameter
   if (!IsType(value, type))
   {
@@ -886,12 +898,17 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
   if (enums.size() > 0)
   {
     bool valid = false;
-    for (std::vector<CVariant>::const_iterator enumItr = enums.begin(); enumItr != enums.end(); ++enumItr)
+    if (value.isString() && !enumStrings.empty())
+      valid = enumStrings.find(value.asString()) != enumStrings.end();
+    else
     {
-      if (*enumItr == value)
+      for (std::vector<CVariant>::const_iterator enumItr = enums.begin(); enumItr != enums.end(); ++enumItr)
       {
-        valid = true;
-        break;
+        if (*enumItr == value)
+        {
+          valid = true;
+          break;
+        }
       }
     }
 
@@ -1154,6 +1171,40 @@ void JSONSchemaTypeDefinition::Set(const JSONSchemaTypeDefinitionPtr typeDefinit
   referencedTypeSet = true;
 }
 
+void JSONSchemaTypeDefinition::Resolve(std::set<JSONSchemaTypeDefinition*> &resolved)
+{
+  if (!resolved.insert(this).second)
+    return;
+
+  if (referencedType != NULL && !referencedTypeSet)
+  {
+    referencedType->Resolve(resolved);
+    Set(referencedType);
+  }
+
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::iterator it = unionTypes.begin(); it != unionTypes.end(); ++it)
+    (*it)->Resolve(resolved);
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::iterator it = extends.begin(); it != extends.end(); ++it)
+    (*it)->Resolve(resolved);
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::iterator it = items.begin(); it != items.end(); ++it)
+    (*it)->Resolve(resolved);
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::iterator it = additionalItems.begin(); it != additionalItems.end(); ++it)
+    (*it)->Resolve(resolved);
+  for (CJsonSchemaPropertiesMap::JSONSchemaPropertiesIterator it = properties.begin(); it != properties.end(); ++it)
+    it->second->Resolve(resolved);
+  if (additionalProperties != NULL)
+    additionalProperties->Resolve(resolved);
+
+  // string enums (e.g. Input.Action or the List.Fields types) can be
+  // rather long so look them up instead of comparing every value
+  enumStrings.clear();
+  for (std::vector<CVariant>::const_iterator it = enums.begin(); it != enums.end(); ++it)
+  {
+    if (it->isString())
+      enumStrings.insert(it->asString());
+  }
+}
+
 JSONSchemaTypeDefinition::CJsonSchemaPropertiesMap::CJsonSchemaPropertiesMap() :
    m_propertiesmap(std::map<std::string, JSONSchemaTypeDefinitionPtr>())
 {
@@ -1340,7 +1391,7 @@ JSONRPC_STATUS JsonRpcMethod::checkParameter(const CVariant &requestParameters,
   if (ParameterExists(requestParameters, type->name, position))
   {
     // Get the parameter
-    CVariant parameterValue = GetParameter(requestParameters, type->name, position);
+    const CVariant &parameterValue = IsValueMember(requestParameters, type->name) ? requestParameters[type->name] : requestParameters[position];
 
     // Evaluate the type of the parameter
     JSONRPC_STATUS status = type->Check(parameterValue, outputParameters[type->name], errorData["stack"]);
@@ -1366,6 +1417,19 @@ JSONRPC_STATUS JsonRpcMethod::checkParameter(const CVariant &requestParameters,
   return OK;
 }
 
+void CJSONServiceDescription::ResolveReferences()
+{
+  std::set<JSONSchemaTypeDefinition*> resolved;
+  for (map<string, JSONSchemaTypeDefinitionPtr>::iterator it = m_types.begin(); it != m_types.end(); ++it)
+    it->second->Resolve(resolved);
+
+  for (CJsonRpcMethodMap::JsonRpcMethodIterator it = m_actionMap.begin(); it != m_actionMap.end(); ++it)
+  {
+    for (std::vector<JSONSchemaTypeDefinitionPtr>::const_iterator parameter = it->second.parameters.begin(); parameter != it->second.parameters.end(); ++parameter)
+      (*parameter)->Resolve(resolved);
+  }
+}
+
 void CJSONServiceDescription::Cleanup()
 {
   // reset all of the static data
@@ -23,6 +23,7 @@
 #include <vector>
 #include <limits>
 #include <memory>
+#include <set>
 
 #include "JSONUtils.h"
 
@@ -50,6 +51,12 @@ namespace JSONRPC
     JSONRPC_STATUS Check(const CVariant &value, CVariant &outputValue, CVariant &errorData);
     void Print(bool isParameter, bool isGlobal, bool printDefault, bool printDescriptions, CVariant &output) const;
     void Set(const JSONSchemaTypeDefinitionPtr typeDefinition);
+    /*!
+     \brief Sets the referenced types of this type and all the types it
+     consists of and builds the lookups used by Check()
+     \param resolved Types which have already been resolved
+     */
+    void Resolve(std::set<JSONSchemaTypeDefinition*> &resolved);
     
     std::string missingReference;
 
@@ -157,6 +164,12 @@ namespace JSONRPC
      */
     std::vector<CVariant> enums;
 
+    /*!
+     \brief Lookup of the string values in "enums"
+     (filled by Resolve())
+     */
+    std::set<std::string> enumStrings;
+
     /*!
      \brief List of possible values in an array
      */
@@ -221,6 +234,9 @@ namespace JSONRPC
      \brief Type definition for additional properties
      */
     JSONSchemaTypeDefinitionPtr additionalProperties;
+
+  private:
+    JSONRPC_STATUS checkValue(const CVariant &value, CVariant &outputValue, CVariant &errorData);
   };
 
   /*! 
@@ -392,6 +408,16 @@ namespace JSONRPC
     
     static JSONSchemaTypeDefinitionPtr GetType(const std::string &identification);
 
+    /*!
+     \brief Resolves the references between all the defined types and
+     prepares them for checking the parameters of method calls
+
+     Must be called once all types and methods have been added. Afterwards
+     the definitions aren't changed anymore by CheckCall() which may then
+     be used from several threads at the same time.
+     */
+    static void ResolveReferences();
+
     static void Cleanup();
 
   private:
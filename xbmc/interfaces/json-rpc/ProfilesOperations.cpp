@@ -35,31 +35,20 @@ JSONRPC_STATUS CProfilesOperations::GetProfiles(const std::string &method, ITran
     const CProfile *profile = CProfilesManager::Get().GetProfile(i);
     CFileItemPtr item(new CFileItem(profile->getName()));
     item->SetArt("thumb", profile->getThumb());
+
+    // picked up by HandleFileItemList() if "lockmode" is requested
+    LockType locktype = LOCK_MODE_UNKNOWN;
+    if (i == 0)
+      locktype = CProfilesManager::Get().GetMasterProfile().getLockMode();
+    else
+      locktype = profile->getLockMode();
+    item->SetProperty("lockmode", locktype);
+
     listItems.Add(item);
   }
 
   HandleFileItemList("profileid", false, "profiles", listItems, parameterObject, result);
 
-  for (CVariant::const_iterator_array propertyiter = parameterObject["properties"].begin_array(); propertyiter != parameterObject["properties"].end_array(); ++propertyiter)
-  {
-    if (propertyiter->isString() &&
-        propertyiter->asString() == "lockmode")
-    {
-      for (CVariant::iterator_array profileiter = result["profiles"].begin_array(); profileiter != result["profiles"].end_array(); ++profileiter)
-      {
-        std::string profilename = (*profileiter)["label"].asString();
-        int index = CProfilesManager::Get().GetProfileIndex(profilename);
-        const CProfile *profile = CProfilesManager::Get().GetProfile(index);
-        LockType locktype = LOCK_MODE_UNKNOWN;
-        if (index == 0)
-          locktype = CProfilesManager::Get().GetMasterProfile().getLockMode();
-        else
-          locktype = profile->getLockMode();
-        (*profileiter)["lockmode"] = locktype;
-      }
-      break;
-    }
-  }
   return OK;
 }
 
@@ -25,6 +25,7 @@
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 #include "video/VideoDatabase.h"
+#include "video/VideoThumbLoader.h"
 
 using namespace JSONRPC;
 
@@ -860,20 +861,53 @@ JSONRPC_STATUS CVideoLibrary::GetAdditionalMovieDetails(const CVariant &paramete
   if (!videodatabase.Open())
     return InternalError;
 
-  bool additionalInfo = false;
+  int details = VideoDbDetailsNone;
+  bool art = false;
   for (CVariant::const_iterator_array itr = parameterObject["properties"].begin_array(); itr != parameterObject["properties"].end_array(); itr++)
   {
     std::string fieldValue = itr->asString();
-    if (fieldValue == "cast" || fieldValue == "showlink" || fieldValue == "tag" || fieldValue == "streamdetails")
-      additionalInfo = true;
+    if (fieldValue == "cast")
+      details |= VideoDbDetailsCast;
+    else if (fieldValue == "showlink")
+      details |= VideoDbDetailsShowLink;
+    else if (fieldValue == "tag")
+      details |= VideoDbDetailsTag;
+    else if (fieldValue == "streamdetails")
+      details |= VideoDbDetailsStream;
+    else if (fieldValue == "art" || fieldValue == "thumbnail" || fieldValue == "fanart")
+      art = true;
   }
 
-  if (additionalInfo)
+  // only load the details of the movies that are returned
+  int start = 0, end = items.Size();
+  if (limit && (details != VideoDbDetailsNone || art))
   {
-    for (int index = 0; index < items.Size(); index++)
+    Sort(items, parameterObject);
+    CVariant limits;
+    HandleLimits(parameterObject, limits, items.Size(), start, end);
+  }
+
+  if (details != VideoDbDetailsNone)
+    videodatabase.GetDetailsForMovies(items, details, start, end);
+
+  if (art)
+  {
+    std::vector<int> movieIds;
+    for (int index = start; index < end; index++)
     {
-      if (additionalInfo)
-        videodatabase.GetMovieInfo("", *(items[index]->GetVideoInfoTag()), items[index]->GetVideoInfoTag()->m_iDbId);
+      if (items[index]->GetArtCount() == 0)
+        movieIds.push_back(items[index]->GetVideoInfoTag()->m_iDbId);
+    }
+
+    std::map<int, std::map<std::string, std::string> > movieArt;
+    if (videodatabase.GetArtForItems(movieIds, MediaTypeMovie, movieArt))
+    {
+      for (int index = start; index < end; index++)
+      {
+        std::map<int, std::map<std::string, std::string> >::const_iterator it = movieArt.find(items[index]->GetVideoInfoTag()->m_iDbId);
+        if (it != movieArt.end())
+          CVideoThumbLoader::SetArt(*items[index], it->second);
+      }
     }
   }
 
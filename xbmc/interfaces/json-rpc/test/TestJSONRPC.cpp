@@ -0,0 +1,128 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "interfaces/json-rpc/FileItemHandler.h"
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "interfaces/json-rpc/JSONServiceDescription.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+using namespace JSONRPC;
+
+// enough items to have the list streamed
+#define TEST_ITEMS 100
+
+class CTestTransport : public ITransportLayer
+{
+public:
+  virtual bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) { return false; }
+  virtual bool Download(const char *path, CVariant &result) { return false; }
+  virtual int GetCapabilities() { return Response; }
+};
+
+class CTestClient : public IClient
+{
+public:
+  virtual int GetPermissionFlags() { return OPERATION_PERMISSION_ALL; }
+  virtual int GetAnnouncementFlags() { return 0; }
+  virtual bool SetAnnouncementFlags(int flags) { return false; }
+};
+
+class CTestItems : public CFileItemHandler
+{
+public:
+  static JSONRPC_STATUS GetItems(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+  {
+    CFileItemList items;
+    for (int i = 0; i < TEST_ITEMS; i++)
+    {
+      CFileItemPtr item(new CFileItem(StringUtils::Format("Item %i", i)));
+      item->SetPath(StringUtils::Format("special://temp/item%i", i));
+      items.Add(item);
+    }
+
+    // a label equal to the placeholder of the streamed list
+    items[TEST_ITEMS / 2]->SetLabel("0");
+
+    CVariant parameters;
+    parameters["properties"].push_back("file");
+    HandleFileItemList(NULL, true, "items", items, parameters, result);
+    return OK;
+  }
+};
+
+class TestJSONRPC : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    ASSERT_TRUE(CJSONServiceDescription::AddMethod("\"Test.GetItems\": { \"type\": \"method\", \"description\": \"Test\","
+                                                   " \"transport\": \"Response\", \"permission\": \"ReadData\","
+                                                   " \"params\": [], \"returns\": { \"type\": \"object\" } }", CTestItems::GetItems));
+  }
+
+  virtual void TearDown()
+  {
+    CJSONServiceDescription::Cleanup();
+  }
+
+  CTestTransport m_transport;
+  CTestClient m_client;
+};
+
+TEST_F(TestJSONRPC, StreamedResponse)
+{
+  JSONRPCResponsePtr response = CJSONRPC::MethodCallStreamed("{ \"jsonrpc\": \"2.0\", \"method\": \"Test.GetItems\", \"id\": 1 }", &m_transport, &m_client);
+  ASSERT_TRUE(response != NULL);
+  EXPECT_TRUE(response->IsStreamed());
+
+  // the list is only serialized while the response is read
+  std::string streamed;
+  while (response->Read(streamed, 1024))
+    ;
+
+  // handling the method without a request being handled has the list
+  // serialized into the result right away
+  CVariant buffered;
+  buffered["jsonrpc"] = "2.0";
+  buffered["id"] = 1;
+  ASSERT_EQ(OK, CTestItems::GetItems("test.getitems", &m_transport, &m_client, CVariant(), buffered["result"]));
+  ASSERT_EQ((unsigned int)TEST_ITEMS, buffered["result"]["items"].size());
+
+  CVariant parsed = CJSONVariantParser::Parse((const unsigned char *)streamed.c_str(), streamed.size());
+  EXPECT_STREQ(CJSONVariantWriter::Write(buffered, true).c_str(), CJSONVariantWriter::Write(parsed, true).c_str());
+  EXPECT_STREQ("0", parsed["result"]["items"][TEST_ITEMS / 2]["label"].asString().c_str());
+}
+
+TEST_F(TestJSONRPC, MethodCall)
+{
+  std::string output = CJSONRPC::MethodCall("{ \"jsonrpc\": \"2.0\", \"method\": \"Test.GetItems\", \"id\": 1 }", &m_transport, &m_client);
+
+  CVariant parsed = CJSONVariantParser::Parse((const unsigned char *)output.c_str(), output.size());
+  ASSERT_TRUE(parsed["result"]["items"].isArray());
+  EXPECT_EQ((unsigned int)TEST_ITEMS, parsed["result"]["items"].size());
+  EXPECT_STREQ("Item 0", parsed["result"]["items"][0]["label"].asString().c_str());
+  EXPECT_STREQ("special://temp/item99", parsed["result"]["items"][TEST_ITEMS - 1]["file"].asString().c_str());
+}
@@ -0,0 +1,127 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+
+#include "interfaces/json-rpc/JSONServiceDescription.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+using namespace JSONRPC;
+
+#define TEST_PROPERTIES 60
+
+class TestJSONServiceDescription : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    // modelled after Player.GetProperties
+    std::string properties;
+    for (int i = 0; i < TEST_PROPERTIES; i++)
+      properties += StringUtils::Format("%s\"property%d\"", i > 0 ? ", " : "", i);
+
+    ASSERT_TRUE(CJSONServiceDescription::AddType("\"Test.Property.Name\": { \"type\": \"string\", \"enum\": [ " + properties + " ] }"));
+    ASSERT_TRUE(CJSONServiceDescription::AddType("\"Test.Property\": { \"type\": \"array\", \"uniqueItems\": true, \"items\": { \"$ref\": \"Test.Property.Name\" } }"));
+    ASSERT_TRUE(CJSONServiceDescription::AddType("\"Test.Parameters\": { \"type\": \"object\", \"additionalProperties\": false, \"properties\": {"
+                                                 " \"playerid\": { \"type\": \"integer\", \"minimum\": 0, \"maximum\": 2, \"required\": true },"
+                                                 " \"properties\": { \"$ref\": \"Test.Property\", \"required\": true },"
+                                                 " \"limit\": { \"type\": \"integer\", \"default\": 10 } } }"));
+
+    CJSONServiceDescription::ResolveReferences();
+    m_type = CJSONServiceDescription::GetType("Test.Parameters");
+    ASSERT_TRUE(m_type != NULL);
+  }
+
+  virtual void TearDown()
+  {
+    m_type.reset();
+    CJSONServiceDescription::Cleanup();
+  }
+
+  static CVariant Parameters(int playerid, int properties)
+  {
+    CVariant parameters(CVariant::VariantTypeObject);
+    parameters["playerid"] = playerid;
+    parameters["properties"] = CVariant(CVariant::VariantTypeArray);
+    for (int i = 0; i < properties; i++)
+      parameters["properties"].push_back(StringUtils::Format("property%d", TEST_PROPERTIES - 1 - i));
+    return parameters;
+  }
+
+  JSONSchemaTypeDefinitionPtr m_type;
+};
+
+TEST_F(TestJSONServiceDescription, ValidParameters)
+{
+  CVariant output, error;
+  EXPECT_EQ(OK, m_type->Check(Parameters(1, 10), output, error));
+  EXPECT_EQ(1, output["playerid"].asInteger());
+  EXPECT_EQ(10u, output["properties"].size());
+  EXPECT_STREQ("property59", output["properties"][0].asString().c_str());
+  // optional properties get their default value
+  EXPECT_EQ(10, output["limit"].asInteger());
+}
+
+TEST_F(TestJSONServiceDescription, InvalidParameters)
+{
+  CVariant output, error;
+  CVariant parameters = Parameters(3, 1);
+  EXPECT_EQ(InvalidParams, m_type->Check(parameters, output, error));
+  EXPECT_STREQ("playerid", error["property"]["name"].asString().c_str());
+
+  output.clear();
+  error.clear();
+  parameters = Parameters(0, 1);
+  parameters["properties"].push_back("unknown");
+  EXPECT_EQ(InvalidParams, m_type->Check(parameters, output, error));
+  EXPECT_STREQ("properties", error["property"]["name"].asString().c_str());
+
+  output.clear();
+  error.clear();
+  parameters = Parameters(0, 2);
+  parameters["properties"].push_back("property59");
+  EXPECT_EQ(InvalidParams, m_type->Check(parameters, output, error));
+
+  output.clear();
+  error.clear();
+  parameters = Parameters(0, 1);
+  parameters["unknown"] = true;
+  EXPECT_EQ(InvalidParams, m_type->Check(parameters, output, error));
+}
+
+TEST_F(TestJSONServiceDescription, CheckThroughput)
+{
+  const int iterations = 20000;
+  CVariant parameters = Parameters(1, 20);
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < iterations; i++)
+  {
+    CVariant output, error;
+    ASSERT_EQ(OK, m_type->Check(parameters, output, error));
+  }
+  unsigned int duration = XbmcThreads::SystemClockMillis() - start;
+
+  RecordProperty("ChecksPerSecond", (int)(iterations * 1000LL / std::max(duration, 1u)));
+}
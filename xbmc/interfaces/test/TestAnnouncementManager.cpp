@@ -0,0 +1,152 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "interfaces/AnnouncementManager.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "threads/test/TestHelpers.h"
+#include "utils/StringUtils.h"
+
+#include "gtest/gtest.h"
+
+using namespace ANNOUNCEMENT;
+
+class CTestAnnouncer : public IAnnouncer
+{
+public:
+  CTestAnnouncer() : m_release(true) {}
+
+  virtual void Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
+  {
+    std::string msg(message);
+    if (msg == "Block")
+    {
+      // holds up the delivery of everything queued behind it
+      m_blocked.Set();
+      m_release.Wait();
+      return;
+    }
+    if (msg == "Done")
+    {
+      m_done.Set();
+      return;
+    }
+
+    CSingleLock lock(m_critSection);
+    m_messages.push_back(msg);
+    m_data.push_back(data);
+  }
+
+  CCriticalSection m_critSection;
+  std::vector<std::string> m_messages;
+  std::vector<CVariant> m_data;
+
+  CEvent m_blocked;
+  CEvent m_release;
+  CEvent m_done;
+};
+
+class CReleaser : public IRunnable
+{
+public:
+  explicit CReleaser(CEvent &release) : m_release(release) {}
+
+  void Run()
+  {
+    // give Deinitialize() the chance to stop while the announcer is blocked
+    SleepMillis(100);
+    m_release.Set();
+  }
+
+private:
+  CEvent &m_release;
+};
+
+class TestAnnouncementManager : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    CAnnouncementManager::Get().Start();
+    CAnnouncementManager::Get().AddAnnouncer(&m_announcer);
+
+    CAnnouncementManager::Get().Announce(Other, "test", "Block");
+    ASSERT_TRUE(m_announcer.m_blocked.WaitMSec(5000));
+  }
+
+  virtual void TearDown()
+  {
+    m_announcer.m_release.Set();
+    CAnnouncementManager::Get().Deinitialize();
+  }
+
+  CTestAnnouncer m_announcer;
+};
+
+TEST_F(TestAnnouncementManager, Coalesce)
+{
+  for (int i = 0; i < 3; i++)
+  {
+    CVariant data(i);
+    CAnnouncementManager::Get().Announce(Player, "test", "OnSeek", data);
+  }
+  CAnnouncementManager::Get().Announce(Player, "test", "OnPlay");
+  CAnnouncementManager::Get().Announce(Other, "test", "Done");
+
+  m_announcer.m_release.Set();
+  ASSERT_TRUE(m_announcer.m_done.WaitMSec(5000));
+
+  // only the latest seek is left
+  ASSERT_EQ(2U, m_announcer.m_messages.size());
+  EXPECT_STREQ("OnSeek", m_announcer.m_messages[0].c_str());
+  EXPECT_EQ(2, m_announcer.m_data[0].asInteger());
+  EXPECT_STREQ("OnPlay", m_announcer.m_messages[1].c_str());
+}
+
+TEST_F(TestAnnouncementManager, QueueBound)
+{
+  const unsigned int count = CAnnouncementManager::MAX_QUEUED_ANNOUNCEMENTS + 10;
+  for (unsigned int i = 0; i < count; i++)
+    CAnnouncementManager::Get().Announce(Other, "test", StringUtils::Format("%u", i).c_str());
+  CAnnouncementManager::Get().Announce(Other, "test", "Done");
+
+  m_announcer.m_release.Set();
+  ASSERT_TRUE(m_announcer.m_done.WaitMSec(5000));
+
+  // the oldest announcements made room for the newer ones
+  ASSERT_EQ(CAnnouncementManager::MAX_QUEUED_ANNOUNCEMENTS - 1, m_announcer.m_messages.size());
+  EXPECT_STREQ(StringUtils::Format("%u", count - CAnnouncementManager::MAX_QUEUED_ANNOUNCEMENTS + 1).c_str(), m_announcer.m_messages.front().c_str());
+  EXPECT_STREQ(StringUtils::Format("%u", count - 1).c_str(), m_announcer.m_messages.back().c_str());
+}
+
+TEST_F(TestAnnouncementManager, DeinitializeDeliversQueued)
+{
+  CAnnouncementManager::Get().Announce(Other, "test", "A");
+  CAnnouncementManager::Get().Announce(Other, "test", "B");
+
+  CReleaser releaser(m_announcer.m_release);
+  thread waitThread(releaser);
+  CAnnouncementManager::Get().Deinitialize();
+  EXPECT_TRUE(waitThread.timed_join(MILLIS(5000)));
+
+  ASSERT_EQ(2U, m_announcer.m_messages.size());
+  EXPECT_STREQ("A", m_announcer.m_messages[0].c_str());
+  EXPECT_STREQ("B", m_announcer.m_messages[1].c_str());
+}
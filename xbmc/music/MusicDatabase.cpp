@@ -1607,26 +1607,29 @@ int CMusicDatabase::AddPath(const std::string& strPath1)
     if (it != m_pathCache.end())
       return it->second;
 
-    strSQL=PrepareSQL( "select * from path where strPath='%s'", strPath.c_str());
-    m_pDS->query(strSQL.c_str());
-    if (m_pDS->num_rows() == 0)
-    {
-      m_pDS->close();
-      // doesnt exists, add it
-      strSQL=PrepareSQL("insert into path (idPath, strPath) values( NULL, '%s' )", strPath.c_str());
-      m_pDS->exec(strSQL.c_str());
+    strSQL = "select idPath from path where strPath=?";
+    dbiplus::StatementPtr stmt = PrepareStatement(strSQL);
+    if (!stmt)
+      return -1;
 
-      int idPath = (int)m_pDS->lastinsertid();
-      m_pathCache.insert(pair<std::string, int>(strPath, idPath));
-      return idPath;
-    }
+    stmt->bind(1, strPath);
+    int idPath;
+    if (stmt->step())
+      idPath = stmt->get_int(0);
     else
     {
-      int idPath = m_pDS->fv("idPath").get_asInt();
-      m_pathCache.insert(pair<std::string, int>(strPath, idPath));
-      m_pDS->close();
-      return idPath;
+      // doesnt exists, add it
+      strSQL = "insert into path (idPath, strPath) values( NULL, ? )";
+      stmt = PrepareStatement(strSQL);
+      if (!stmt)
+        return -1;
+
+      stmt->bind(1, strPath);
+      stmt->step();
+      idPath = (int)stmt->lastinsertid();
     }
+    m_pathCache.insert(pair<std::string, int>(strPath, idPath));
+    return idPath;
   }
   catch (...)
   {
@@ -3577,6 +3580,33 @@ bool CMusicDatabase::GetSongsByWhere(const std::string &baseDir, const Filter &f
     strSQL = PrepareSQL(strSQL, !filter.fields.empty() && filter.fields.compare("*") != 0 ? filter.fields.c_str() : "songview.*") + strSQLExtra;
 
     CLog::Log(LOGDEBUG, "%s query = %s", __FUNCTION__, strSQL.c_str());
+
+    // without sorting the rows are used in the order they come, so read them
+    // straight from the cursor instead of copying the whole result set first
+    if (sortDescription.sortBy == SortByNone)
+    {
+      dbiplus::StatementPtr stmt = PrepareStatement(strSQL, false);
+      if (!stmt)
+        return false;
+
+      int count = 0;
+      while (stmt->step())
+      {
+        CFileItemPtr item(new CFileItem);
+        GetFileItemFromDataset(stmt->get_sql_record(), item.get(), musicUrl);
+        // HACK for sorting by database returned order
+        item->m_iprogramCount = ++count;
+        items.Add(item);
+      }
+
+      // store the total value of items as a property
+      if (count > 0)
+        items.SetProperty("total", total < count ? count : total);
+
+      CLog::Log(LOGDEBUG, "%s(%s) - took %d ms", __FUNCTION__, filter.where.c_str(), XbmcThreads::SystemClockMillis() - time);
+      return true;
+    }
+
     // run query
     if (!m_pDS->query(strSQL.c_str()))
       return false;
@@ -4437,6 +4467,31 @@ bool CMusicDatabase::GetPathHash(const std::string &path, std::string &hash)
   return false;
 }
 
+bool CMusicDatabase::GetPathHashes(std::map<std::string, std::string> &hashes)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    hashes.clear();
+    if (!m_pDS->query("select strPath, strHash from path")) return false;
+    while (!m_pDS->eof())
+    {
+      hashes[m_pDS->fv(0).get_asString()] = m_pDS->fv(1).get_asString();
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+
+  return false;
+}
+
 bool CMusicDatabase::RemoveSongsFromPath(const std::string &path1, MAPSONGS& songs, bool exact)
 {
   // We need to remove all songs from this path, as their tags are going
@@ -4613,7 +4668,9 @@ bool CMusicDatabase::CommitTransaction()
 {
   if (CDatabase::CommitTransaction())
   { // number of items in the db has likely changed, so reset the infomanager cache
-    g_infoManager.SetLibraryBool(LIBRARY_HAS_MUSIC, GetSongsCount() > 0);
+    // (batched writers reset it themselves once they are done)
+    if (!InBatch())
+      g_infoManager.SetLibraryBool(LIBRARY_HAS_MUSIC, GetSongsCount() > 0);
     return true;
   }
   return false;
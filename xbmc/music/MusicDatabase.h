@@ -276,6 +276,8 @@ public:
   bool GetPaths(std::set<std::string> &paths);
   bool SetPathHash(const std::string &path, const std::string &hash);
   bool GetPathHash(const std::string &path, std::string &hash);
+  /*! \brief Get the hashes of all paths in the database, keyed by path */
+  bool GetPathHashes(std::map<std::string, std::string> &hashes);
   bool GetAlbumPath(int idAlbum, std::string &path);
   bool GetArtistPath(int idArtist, std::string &path);
 
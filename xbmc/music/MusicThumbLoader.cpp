@@ -67,7 +67,7 @@ bool CMusicThumbLoader::LoadItemCached(CFileItem* pItem)
   if (pItem->m_bIsShareOrDrive)
     return false;
 
-  if (pItem->HasMusicInfoTag() && pItem->GetArt().empty())
+  if (pItem->HasMusicInfoTag() && pItem->GetArtCount() == 0)
   {
     if (FillLibraryArt(*pItem))
       return true;
@@ -76,7 +76,7 @@ bool CMusicThumbLoader::LoadItemCached(CFileItem* pItem)
       return false; // No fallback
   }
 
-  if (pItem->HasVideoInfoTag() && pItem->GetArt().empty())
+  if (pItem->HasVideoInfoTag() && pItem->GetArtCount() == 0)
   { // music video
     CVideoThumbLoader loader;
     if (loader.LoadItemCached(pItem))
@@ -234,7 +234,7 @@ bool CMusicThumbLoader::FillLibraryArt(CFileItem &item)
     }
     m_musicDatabase->Close();
   }
-  return !item.GetArt().empty();
+  return item.GetArtCount() > 0;
 }
 
 bool CMusicThumbLoader::GetEmbeddedThumb(const std::string &path, EmbeddedArt &art)
@@ -53,6 +53,7 @@
 #include "addons/AddonManager.h"
 #include "addons/Scraper.h"
 #include "CueDocument.h"
+#include "threads/SingleLock.h"
 
 #include <algorithm>
 
@@ -63,6 +64,35 @@ using namespace MUSICDATABASEDIRECTORY;
 using namespace MUSIC_GRABBER;
 using namespace ADDON;
 
+// number of scanned directories that may wait for the database writer
+#define MAX_SCANNED_DIRECTORIES 32
+
+namespace MUSIC_INFO
+{
+class CMusicScanWorker : public IRunnable
+{
+public:
+  CMusicScanWorker(CMusicInfoScanner &scanner) : m_scanner(scanner), m_thread(this, "MusicScanWorker")
+  {
+    m_thread.Create();
+  }
+
+  virtual ~CMusicScanWorker()
+  {
+    m_thread.StopThread();
+  }
+
+  virtual void Run()
+  {
+    m_scanner.ScanWorker();
+  }
+
+private:
+  CMusicInfoScanner &m_scanner;
+  CThread m_thread;
+};
+}
+
 CMusicInfoScanner::CMusicInfoScanner() : CThread("MusicInfoScanner"), m_fileCountReader(this, "MusicFileCounter")
 {
   m_bRunning = false;
@@ -72,6 +102,8 @@ CMusicInfoScanner::CMusicInfoScanner() : CThread("MusicInfoScanner"), m_fileCoun
   m_currentItem=0;
   m_itemCount=0;
   m_flags = 0;
+  m_busyWorkers = 0;
+  m_scanStart = 0;
 }
 
 CMusicInfoScanner::~CMusicInfoScanner()
@@ -129,27 +161,7 @@ void CMusicInfoScanner::Process()
       m_bCanInterrupt = false;
       m_needsCleanup = false;
 
-      bool commit = true;
-      for (std::set<std::string>::const_iterator it = m_pathsToScan.begin(); it != m_pathsToScan.end(); ++it)
-      {
-        if (!CDirectory::Exists(*it) && !m_bClean)
-        {
-          /*
-           * Note that this will skip scanning (if m_bClean is disabled) if the directory really
-           * doesn't exist. Since the music scanner is fed with a list of existing paths from the DB
-           * and cleans out all songs under that path as its first step before re-adding files, if 
-           * the entire source is offline we totally empty the music database in one go.
-           */
-          CLog::Log(LOGWARNING, "%s directory '%s' does not exist - skipping scan.", __FUNCTION__, it->c_str());
-          m_seenPaths.insert(*it);
-          continue;
-        }
-        else if (!DoScan(*it))
-        {
-          commit = false;
-          break;
-        }
-      }
+      bool commit = DoScan();
 
       if (commit)
       {
@@ -426,38 +438,158 @@ static std::string Prettify(const std::string& strDirectory)
   return CURL::Decode(url.GetWithoutUserDetails());
 }
 
-bool CMusicInfoScanner::DoScan(const std::string& strDirectory)
+bool CMusicInfoScanner::DoScan()
 {
-  if (m_handle)
-    m_handle->SetText(Prettify(strDirectory));
+  std::vector<std::string> paths;
+  for (std::set<std::string>::const_iterator it = m_pathsToScan.begin(); it != m_pathsToScan.end(); ++it)
+  {
+    if (!CDirectory::Exists(*it) && !m_bClean)
+    {
+      /*
+       * Note that this will skip scanning (if m_bClean is disabled) if the directory really
+       * doesn't exist. Since the music scanner is fed with a list of existing paths from the DB
+       * and cleans out all songs under that path as its first step before re-adding files, if 
+       * the entire source is offline we totally empty the music database in one go.
+       */
+      CLog::Log(LOGWARNING, "%s directory '%s' does not exist - skipping scan.", __FUNCTION__, it->c_str());
+      m_seenPaths.insert(*it);
+      continue;
+    }
+    paths.push_back(*it);
+  }
+
+  // the workers only compare against the hashes, so read them all up front
+  // rather than giving every worker its own database connection
+  m_musicDatabase.GetPathHashes(m_pathHashes);
+
+  CSingleLock lock(m_scanSection);
+  m_pendingDirs.assign(paths.begin(), paths.end());
+  m_scannedDirs.clear();
+  m_busyWorkers = 0;
+
+  int threads = std::max(1, g_advancedSettings.m_iMusicLibraryScanThreads);
+  CLog::Log(LOGDEBUG, "%s - Scanning with %i threads, committing every %i albums", __FUNCTION__,
+            threads, g_advancedSettings.m_iMusicLibraryScanBatchSize);
+
+  std::vector<CMusicScanWorker*> workers;
+  for (int i = 0; i < threads; i++)
+    workers.push_back(new CMusicScanWorker(*this));
+
+  m_scanStart = XbmcThreads::SystemClockMillis();
+  m_musicDatabase.BeginBatch(g_advancedSettings.m_iMusicLibraryScanBatchSize);
+  while (!m_bStop)
+  {
+    if (m_scannedDirs.empty())
+    {
+      if (m_pendingDirs.empty() && m_busyWorkers == 0)
+        break;
+
+      // commit what we have while the workers are busy (e.g. on a slow share),
+      // so the library stays readable during long scans
+      if (!m_writerCondition.wait(lock, 500) && m_scannedDirs.empty())
+      {
+        CSingleExit exit(m_scanSection);
+        m_musicDatabase.FlushBatch();
+      }
+      continue;
+    }
+
+    ScannedDirectoryPtr directory = m_scannedDirs.front();
+    m_scannedDirs.pop_front();
+    m_workerCondition.notifyAll();
+
+    CSingleExit exit(m_scanSection);
+    AddDirectory(*directory);
+  }
+  m_workerCondition.notifyAll();
+  lock.Leave();
+
+  for (std::vector<CMusicScanWorker*>::iterator it = workers.begin(); it != workers.end(); ++it)
+    delete *it;
 
-  std::set<std::string>::const_iterator it = m_seenPaths.find(strDirectory);
-  if (it != m_seenPaths.end())
-    return true;
+  m_musicDatabase.EndBatch();
 
-  m_seenPaths.insert(strDirectory);
+  m_pendingDirs.clear();
+  m_scannedDirs.clear();
+  m_pathHashes.clear();
 
+  return !m_bStop;
+}
+
+void CMusicInfoScanner::ScanWorker()
+{
+  CSingleLock lock(m_scanSection);
+  while (!m_bStop)
+  {
+    if (m_pendingDirs.empty())
+    {
+      if (m_busyWorkers == 0)
+        break;
+      m_workerCondition.wait(lock, 100);
+      continue;
+    }
+
+    std::string strDirectory = m_pendingDirs.front();
+    m_pendingDirs.pop_front();
+    if (!m_seenPaths.insert(strDirectory).second)
+      continue;
+
+    m_busyWorkers++;
+    ScannedDirectoryPtr directory;
+    {
+      CSingleExit exit(m_scanSection);
+      directory = ScanDirectory(strDirectory);
+    }
+
+    if (directory)
+    {
+      // queue the subfolders in front so we walk the tree depth first, like a recursive scan
+      for (int i = directory->items.Size() - 1; i >= 0; --i)
+      {
+        CFileItemPtr pItem = directory->items[i];
+        if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList())
+          m_pendingDirs.push_front(pItem->GetPath());
+      }
+
+      while (!m_bStop && m_scannedDirs.size() >= MAX_SCANNED_DIRECTORIES)
+        m_workerCondition.wait(lock, 100);
+      m_scannedDirs.push_back(directory);
+    }
+    m_busyWorkers--;
+
+    m_workerCondition.notifyAll();
+    m_writerCondition.notifyAll();
+  }
+  m_workerCondition.notifyAll();
+  m_writerCondition.notifyAll();
+}
+
+CMusicInfoScanner::ScannedDirectoryPtr CMusicInfoScanner::ScanDirectory(const std::string& strDirectory)
+{
   // Discard all excluded files defined by m_musicExcludeRegExps
   vector<string> regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
   if (CUtil::ExcludeFileOrFolder(strDirectory, regexps))
-    return true;
+    return ScannedDirectoryPtr();
+
+  ScannedDirectoryPtr directory(new ScannedDirectory);
+  directory->path = strDirectory;
 
   // load subfolder
-  CFileItemList items;
+  CFileItemList &items = directory->items;
   CDirectory::GetDirectory(strDirectory, items, g_advancedSettings.m_musicExtensions + "|.jpg|.tbn|.lrc|.cdg");
 
   // sort and get the path hash.  Note that we don't filter .cue sheet items here as we want
   // to detect changes in the .cue sheet as well.  The .cue sheet items only need filtering
   // if we have a changed hash.
   items.Sort(SortByLabel, SortOrderAscending);
-  std::string hash;
-  GetPathHash(items, hash);
+  GetPathHash(items, directory->hash);
+  directory->files = CountFiles(items, false);  // false for non-recursive
 
   // check whether we need to rescan or not
-  std::string dbHash;
-  if ((m_flags & SCAN_RESCAN) || !m_musicDatabase.GetPathHash(strDirectory, dbHash) || dbHash != hash)
+  std::map<std::string, std::string>::const_iterator dbHash = m_pathHashes.find(strDirectory);
+  if ((m_flags & SCAN_RESCAN) || dbHash == m_pathHashes.end() || dbHash->second != directory->hash)
   { // path has changed - rescan
-    if (dbHash.empty())
+    if (dbHash == m_pathHashes.end() || dbHash->second.empty())
       CLog::Log(LOGDEBUG, "%s Scanning dir '%s' as not in the database", __FUNCTION__, strDirectory.c_str());
     else
       CLog::Log(LOGDEBUG, "%s Rescanning dir '%s' due to change", __FUNCTION__, strDirectory.c_str());
@@ -466,49 +598,46 @@ bool CMusicInfoScanner::DoScan(const std::string& strDirectory)
     items.FilterCueItems();
     items.Sort(SortByLabel, SortOrderAscending);
 
-    // and then scan in the new information
-    if (RetrieveMusicInfo(strDirectory, items) > 0)
-    {
-      if (m_handle)
-        OnDirectoryScanned(strDirectory);
-    }
-
-    // save information about this folder
-    m_musicDatabase.SetPathHash(strDirectory, hash);
+    // and then read the tags, the database is updated by AddDirectory
+    directory->changed = true;
+    ScanTags(items, directory->scannedItems);
   }
   else
   { // path is the same - no need to rescan
     CLog::Log(LOGDEBUG, "%s Skipping dir '%s' due to no change", __FUNCTION__, strDirectory.c_str());
-    m_currentItem += CountFiles(items, false);  // false for non-recursive
-
-    // updated the dialog with our progress
-    if (m_handle)
-    {
-      if (m_itemCount>0)
-        m_handle->SetPercentage(m_currentItem/(float)m_itemCount*100);
-      OnDirectoryScanned(strDirectory);
-    }
   }
 
-  // now scan the subfolders
-  for (int i = 0; i < items.Size(); ++i)
-  {
-    CFileItemPtr pItem = items[i];
+  return directory;
+}
 
-    if (m_bStop)
-      break;
-    // if we have a directory item (non-playlist) we then recurse into that folder
-    if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList())
+void CMusicInfoScanner::AddDirectory(ScannedDirectory& directory)
+{
+  if (directory.changed)
+  {
+    // scan in the new information
+    if (RetrieveMusicInfo(directory.path, directory.items, directory.scannedItems) > 0)
     {
-      std::string strPath=pItem->GetPath();
-      if (!DoScan(strPath))
-      {
-        m_bStop = true;
-      }
+      if (m_handle)
+        OnDirectoryScanned(directory.path);
     }
+
+    // save information about this folder
+    m_musicDatabase.SetPathHash(directory.path, directory.hash);
   }
+  else if (m_handle)
+    OnDirectoryScanned(directory.path);
 
-  return !m_bStop;
+  m_currentItem += directory.files;
+
+  // updated the dialog with our progress
+  if (m_handle)
+  {
+    unsigned int elapsed = XbmcThreads::SystemClockMillis() - m_scanStart;
+    int rate = elapsed > 0 ? (int)((int64_t)m_currentItem * 1000 / elapsed) : 0;
+    m_handle->SetText(StringUtils::Format(g_localizeStrings.Get(506).c_str(), Prettify(directory.path).c_str(), rate));
+    if (m_itemCount>0)
+      m_handle->SetPercentage(m_currentItem/(float)m_itemCount*100);
+  }
 }
 
 INFO_RET CMusicInfoScanner::ScanTags(const CFileItemList& items, CFileItemList& scannedItems)
@@ -528,8 +657,6 @@ INFO_RET CMusicInfoScanner::ScanTags(const CFileItemList& items, CFileItemList&
     if (pItem->m_bIsFolder || pItem->IsPlayList() || pItem->IsPicture() || pItem->IsLyrics())
       continue;
 
-    m_currentItem++;
-
     CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
     if (!tag.Loaded())
     {
@@ -538,9 +665,6 @@ INFO_RET CMusicInfoScanner::ScanTags(const CFileItemList& items, CFileItemList&
         pLoader->Load(pItem->GetPath(), tag);
     }
 
-    if (m_handle && m_itemCount>0)
-      m_handle->SetPercentage(m_currentItem / (float)m_itemCount * 100);
-
     if (!tag.Loaded() && !pItem->HasCueDocument())
     {
       CLog::Log(LOGDEBUG, "%s - No tag found for: %s", __FUNCTION__, pItem->GetPath().c_str());
@@ -734,7 +858,7 @@ void CMusicInfoScanner::FileItemsToAlbums(CFileItemList& items, VECALBUMS& album
   }
 }
 
-int CMusicInfoScanner::RetrieveMusicInfo(const std::string& strDirectory, CFileItemList& items)
+int CMusicInfoScanner::RetrieveMusicInfo(const std::string& strDirectory, const CFileItemList& items, CFileItemList& scannedItems)
 {
   MAPSONGS songsMap;
 
@@ -742,8 +866,7 @@ int CMusicInfoScanner::RetrieveMusicInfo(const std::string& strDirectory, CFileI
   if (m_musicDatabase.RemoveSongsFromPath(strDirectory, songsMap))
     m_needsCleanup = true;
 
-  CFileItemList scannedItems;
-  if (ScanTags(items, scannedItems) == INFO_CANCELLED || scannedItems.Size() == 0)
+  if (m_bStop || scannedItems.Size() == 0)
     return 0;
 
   VECALBUMS albums;
@@ -791,6 +914,9 @@ int CMusicInfoScanner::RetrieveMusicInfo(const std::string& strDirectory, CFileI
       if (!albumScraper || !artistScraper)
         continue;
 
+      // don't keep the database locked while waiting for the scrapers
+      m_musicDatabase.FlushBatch();
+
       INFO_RET albumScrapeStatus = INFO_NOT_FOUND;
       if (!m_musicDatabase.HasAlbumBeenScraped(album->idAlbum))
         albumScrapeStatus = UpdateDatabaseAlbumInfo(*album, albumScraper, false);
@@ -1485,15 +1611,16 @@ void CMusicInfoScanner::Run()
 // Recurse through all folders we scan and count files
 int CMusicInfoScanner::CountFilesRecursively(const std::string& strPath)
 {
-  // load subfolder
-  CFileItemList items;
-  CDirectory::GetDirectory(strPath, items, g_advancedSettings.m_musicExtensions, DIR_FLAG_NO_FILE_DIRS);
+  // load subfolder, counting doesn't need a copy of the listing
+  CDirectory::CDirectoryPtr items;
+  if (!CDirectory::GetDirectory(strPath, items, g_advancedSettings.m_musicExtensions, DIR_FLAG_NO_FILE_DIRS))
+    return 0;
 
   if (m_bStop)
     return 0;
 
   // true for recursive counting
-  int count = CountFiles(items, true);
+  int count = CountFiles(*items, true);
   return count;
 }
 
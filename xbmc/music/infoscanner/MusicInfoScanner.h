@@ -18,10 +18,16 @@
  *  <http://www.gnu.org/licenses/>.
  *
  */
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
 #include "threads/Thread.h"
 #include "music/MusicDatabase.h"
 #include "MusicAlbumInfo.h"
 #include "MusicInfoScraper.h"
+#include "FileItem.h"
+
+#include <deque>
+#include <vector>
 
 class CAlbum;
 class CArtist;
@@ -41,8 +47,12 @@ enum INFO_RET
   INFO_ADDED 
 };
 
+class CMusicScanWorker;
+
 class CMusicInfoScanner : CThread, public IRunnable
 {
+  friend class CMusicScanWorker;
+
 public:
   /*! \brief Flags for controlling the scanning process
    */
@@ -168,14 +178,30 @@ public:
 protected:
   virtual void Process();
 
-  /*! \brief Scan in the ID3/Ogg/FLAC tags for a bunch of FileItems
-   Given a list of FileItems, scan in the tags for those FileItems
-   and populate a new FileItemList with the files that were successfully scanned.
-   Any files which couldn't be scanned (no/bad tags) are discarded in the process.
-   \param items [in] list of FileItems to scan
-   \param scannedItems [in] list to populate with the scannedItems
+  /*! \brief A directory that has been listed, hashed and had its tags read by a scan worker
    */
-  int RetrieveMusicInfo(const std::string& strDirectory, CFileItemList& items);
+  struct ScannedDirectory
+  {
+    ScannedDirectory() : changed(false), files(0) {}
+
+    std::string path;
+    std::string hash;
+    bool changed;               ///< whether the hash differs from the one in the database
+    int files;                  ///< number of audio files, for progress
+    CFileItemList items;        ///< directory listing (with .cue items filtered if changed)
+    CFileItemList scannedItems; ///< items with tags, only filled if changed
+  };
+  typedef std::shared_ptr<ScannedDirectory> ScannedDirectoryPtr;
+
+  /*! \brief Add the songs of a directory to the database
+   Replaces the songs in the database for the given directory with the tagged items,
+   and scrapes the new albums online if requested.
+   \param strDirectory [in] the directory being added
+   \param items [in] listing of the directory
+   \param scannedItems [in] items of the directory with their tags loaded, see ScanTags
+   \return number of songs added
+   */
+  int RetrieveMusicInfo(const std::string& strDirectory, const CFileItemList& items, CFileItemList& scannedItems);
 
   /*! \brief Scan in the ID3/Ogg/FLAC tags for a bunch of FileItems
     Given a list of FileItems, scan in the tags for those FileItems
@@ -188,7 +214,28 @@ protected:
   int GetPathHash(const CFileItemList &items, std::string &hash);
   void GetAlbumArtwork(long id, const CAlbum &artist);
 
-  bool DoScan(const std::string& strDirectory);
+  /*! \brief Scan the paths in m_pathsToScan and all their subfolders
+   Directory listing, hashing and tag reading are done by a number of worker threads,
+   which hand the results via a bounded queue to this thread. It is the only one
+   writing to the database and groups the per album transactions in batches.
+   \return false if the scan was stopped, true otherwise
+   */
+  bool DoScan();
+
+  /*! \brief Worker loop, takes directories from m_pendingDirs until there are none left
+   */
+  void ScanWorker();
+
+  /*! \brief List, hash and (if needed) read the tags of a single directory
+   Called from the scan workers, so may only access the database through m_pathHashes.
+   \param strDirectory [in] the directory to scan
+   \return the scanned directory or an empty pointer if it is excluded
+   */
+  ScannedDirectoryPtr ScanDirectory(const std::string& strDirectory);
+
+  /*! \brief Store a directory scanned by a worker in the database
+   */
+  void AddDirectory(ScannedDirectory& directory);
 
   virtual void Run();
   int CountFiles(const CFileItemList& items, bool recursive);
@@ -222,5 +269,15 @@ protected:
   std::set<std::string> m_seenPaths;
   int m_flags;
   CThread m_fileCountReader;
+
+  // state shared with the scan workers, protected by m_scanSection
+  CCriticalSection m_scanSection;
+  XbmcThreads::ConditionVariable m_workerCondition; ///< signalled when there are directories to scan or room for results
+  XbmcThreads::ConditionVariable m_writerCondition; ///< signalled when there are results or the workers are done
+  std::deque<std::string> m_pendingDirs;
+  std::deque<ScannedDirectoryPtr> m_scannedDirs;
+  std::map<std::string, std::string> m_pathHashes; ///< read only while scanning
+  unsigned int m_busyWorkers;
+  unsigned int m_scanStart;
 };
 }
@@ -19,7 +19,11 @@
  */
 
 #include "DNSNameCache.h"
+#include "threads/Event.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/Job.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 
@@ -29,15 +33,67 @@
 
 CDNSNameCache g_DNSCache;
 
-CCriticalSection CDNSNameCache::m_critical;
+class CDNSNameCache::CPendingLookup
+{
+public:
+  CPendingLookup()
+    : m_done(true, false),
+      m_resolved(false)
+  { }
+
+  CEvent m_done;
+  std::string m_strIpAddress;
+  bool m_resolved;
+};
+
+class CDNSNameCache::CLookupJob : public CJob
+{
+public:
+  CLookupJob(CDNSNameCache *cache, const std::string &strHostName, const PendingLookupPtr &pending)
+    : m_cache(cache),
+      m_strHostName(strHostName),
+      m_pending(pending)
+  { }
+
+  virtual const char *GetType() const { return "dnslookup"; }
 
-CDNSNameCache::CDNSNameCache(void)
+  virtual bool DoWork()
+  {
+    m_cache->Complete(m_strHostName, m_pending);
+    return true;
+  }
+
+private:
+  CDNSNameCache *m_cache;
+  std::string m_strHostName;
+  PendingLookupPtr m_pending;
+};
+
+CDNSNameCache::CDNSNameCache(ResolveFunc resolve /* = Resolve */, unsigned int ttl /* = DNS_CACHE_TTL */, unsigned int negativeTtl /* = DNS_CACHE_NEGATIVE_TTL */)
+  : m_resolve(resolve),
+    m_ttl(ttl),
+    m_negativeTtl(negativeTtl)
 {}
 
 CDNSNameCache::~CDNSNameCache(void)
 {}
 
 bool CDNSNameCache::Lookup(const std::string& strHostName, std::string& strIpAddress)
+{
+  return g_DNSCache.LookupName(strHostName, strIpAddress, XbmcThreads::EndTime::InfiniteValue);
+}
+
+bool CDNSNameCache::Lookup(const std::string& strHostName, std::string& strIpAddress, unsigned int timeout)
+{
+  return g_DNSCache.LookupName(strHostName, strIpAddress, timeout);
+}
+
+void CDNSNameCache::Add(const std::string &strHostName, const std::string &strIpAddress)
+{
+  g_DNSCache.AddName(strHostName, strIpAddress);
+}
+
+bool CDNSNameCache::LookupName(const std::string& strHostName, std::string& strIpAddress, unsigned int timeout)
 {
   if (strHostName.empty() && strIpAddress.empty())
     return false;
@@ -52,81 +108,145 @@ bool CDNSNameCache::Lookup(const std::string& strHostName, std::string& strIpAdd
     return true;
   }
 
-  // check if there's a custom entry or if it's already cached
-  if(g_DNSCache.GetCached(strHostName, strIpAddress))
-    return true;
-
-#ifndef TARGET_WINDOWS
-  // perform netbios lookup (win32 is handling this via gethostbyname)
-  char nmb_ip[100];
-  char line[200];
-
-  std::string cmd = "nmblookup " + strHostName;
-  FILE* fp = popen(cmd.c_str(), "r");
-  if (fp)
+  PendingLookupPtr pending;
+  bool lookup = false;
   {
-    while (fgets(line, sizeof line, fp))
+    CSingleLock lock(m_critical);
+    // check if there's a custom entry or if it's already cached
+    bool resolved;
+    if (GetCached(strHostName, strIpAddress, resolved))
+      return resolved;
+
+    // someone else might already be looking up the same name
+    std::unordered_map<std::string, PendingLookupPtr>::const_iterator pendingLookup = m_pending.find(strHostName);
+    if (pendingLookup != m_pending.end())
+      pending = pendingLookup->second;
+    else
     {
-      if (sscanf(line, "%99s *<00>\n", nmb_ip))
-      {
-        if (inet_addr(nmb_ip) != INADDR_NONE)
-          strIpAddress = nmb_ip;
-      }
+      pending = std::make_shared<CPendingLookup>();
+      m_pending.insert(std::make_pair(strHostName, pending));
+      lookup = true;
     }
-    pclose(fp);
   }
 
-  if (!strIpAddress.empty())
+  if (lookup)
   {
-    g_DNSCache.Add(strHostName, strIpAddress);
-    return true;
+    // only lookups which may give up waiting have to run in the background
+    if (timeout == XbmcThreads::EndTime::InfiniteValue)
+      Complete(strHostName, pending);
+    else
+      CJobManager::GetInstance().AddJob(new CLookupJob(this, strHostName, pending), NULL, CJob::PRIORITY_HIGH);
   }
-#endif
 
-  // perform dns lookup
-  struct hostent *host = gethostbyname(strHostName.c_str());
-  if (host && host->h_addr_list[0])
+  if (timeout == XbmcThreads::EndTime::InfiniteValue)
+    pending->m_done.Wait();
+  else if (!pending->m_done.WaitMSec(timeout))
   {
-    strIpAddress = StringUtils::Format("%d.%d.%d.%d",
-                                       (unsigned char)host->h_addr_list[0][0],
-                                       (unsigned char)host->h_addr_list[0][1],
-                                       (unsigned char)host->h_addr_list[0][2],
-                                       (unsigned char)host->h_addr_list[0][3]);
-    g_DNSCache.Add(strHostName, strIpAddress);
-    return true;
+    CLog::Log(LOGDEBUG, "CDNSNameCache: lookup of '%s' didn't finish within %u ms, continuing in the background", strHostName.c_str(), timeout);
+    return false;
   }
 
-  CLog::Log(LOGERROR, "Unable to lookup host: '%s'", strHostName.c_str());
-  return false;
+  strIpAddress = pending->m_strIpAddress;
+  return pending->m_resolved;
 }
 
-bool CDNSNameCache::GetCached(const std::string& strHostName, std::string& strIpAddress)
+void CDNSNameCache::AddName(const std::string &strHostName, const std::string &strIpAddress)
 {
+  CDNSName dnsName;
+  dnsName.m_strIpAddress = strIpAddress;
+  dnsName.m_resolved = XbmcThreads::SystemClockMillis();
+  dnsName.m_permanent = true;
+
   CSingleLock lock(m_critical);
+  m_names[strHostName] = dnsName;
+}
 
-  // loop through all DNSname entries and see if strHostName is cached
-  for (int i = 0; i < (int)g_DNSCache.m_vecDNSNames.size(); ++i)
+bool CDNSNameCache::GetCached(const std::string& strHostName, std::string& strIpAddress, bool& resolved)
+{
+  std::unordered_map<std::string, CDNSName>::iterator dnsName = m_names.find(strHostName);
+  if (dnsName == m_names.end())
+    return false;
+
+  // drop expired entries, unresolvable names are retried sooner
+  const CDNSName& name = dnsName->second;
+  if (!name.m_permanent &&
+      XbmcThreads::SystemClockMillis() - name.m_resolved >= (name.m_strIpAddress.empty() ? m_negativeTtl : m_ttl))
   {
-    CDNSName& DNSname = g_DNSCache.m_vecDNSNames[i];
-    if ( DNSname.m_strHostName == strHostName )
+    m_names.erase(dnsName);
+    return false;
+  }
+
+  strIpAddress = name.m_strIpAddress;
+  resolved = !name.m_strIpAddress.empty();
+  return true;
+}
+
+void CDNSNameCache::Complete(const std::string& strHostName, const PendingLookupPtr& pending)
+{
+  pending->m_resolved = m_resolve(strHostName, pending->m_strIpAddress) && !pending->m_strIpAddress.empty();
+  if (!pending->m_resolved)
+  {
+    CLog::Log(LOGERROR, "Unable to lookup host: '%s'", strHostName.c_str());
+    pending->m_strIpAddress.clear();
+  }
+
+  {
+    CSingleLock lock(m_critical);
+    // don't replace a custom entry added in the meantime
+    std::unordered_map<std::string, CDNSName>::const_iterator dnsName = m_names.find(strHostName);
+    if (dnsName == m_names.end() || !dnsName->second.m_permanent)
     {
-      strIpAddress = DNSname.m_strIpAddress;
-      return true;
+      CDNSName name;
+      name.m_strIpAddress = pending->m_strIpAddress;
+      name.m_resolved = XbmcThreads::SystemClockMillis();
+      name.m_permanent = false;
+      m_names[strHostName] = name;
     }
+    m_pending.erase(strHostName);
   }
 
-  // not cached
-  return false;
+  // the cache must not be touched anymore once the waiting lookups continue
+  pending->m_done.Set();
 }
 
-void CDNSNameCache::Add(const std::string &strHostName, const std::string &strIpAddress)
+bool CDNSNameCache::Resolve(const std::string& strHostName, std::string& strIpAddress)
 {
-  CDNSName dnsName;
+#ifndef TARGET_WINDOWS
+  // perform netbios lookup (win32 is handling this via getaddrinfo)
+  char nmb_ip[100];
+  char line[200];
 
-  dnsName.m_strHostName = strHostName;
-  dnsName.m_strIpAddress  = strIpAddress;
+  std::string cmd = "nmblookup " + strHostName;
+  FILE* fp = popen(cmd.c_str(), "r");
+  if (fp)
+  {
+    while (fgets(line, sizeof line, fp))
+    {
+      if (sscanf(line, "%99s *<00>\n", nmb_ip))
+      {
+        if (inet_addr(nmb_ip) != INADDR_NONE)
+          strIpAddress = nmb_ip;
+      }
+    }
+    pclose(fp);
+  }
 
-  CSingleLock lock(m_critical);
-  g_DNSCache.m_vecDNSNames.push_back(dnsName);
-}
+  if (!strIpAddress.empty())
+    return true;
+#endif
+
+  // perform dns lookup, unlike gethostbyname getaddrinfo is safe to be
+  // used by several lookups at the same time
+  struct addrinfo hints;
+  struct addrinfo *result = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
 
+  if (getaddrinfo(strHostName.c_str(), NULL, &hints, &result) != 0 || result == NULL)
+    return false;
+
+  const unsigned char *addr = (const unsigned char*)&((struct sockaddr_in*)result->ai_addr)->sin_addr;
+  strIpAddress = StringUtils::Format("%d.%d.%d.%d", addr[0], addr[1], addr[2], addr[3]);
+  freeaddrinfo(result);
+  return true;
+}
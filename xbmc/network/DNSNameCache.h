@@ -20,27 +20,79 @@
  *
  */
 
-#include <vector>
+#include <memory>
 #include <string>
+#include <unordered_map>
 
-class CCriticalSection;
+#include "threads/CriticalSection.h"
 
+/*!
+ \brief Cache of resolved host names.
+
+ Resolved names are kept for DNS_CACHE_TTL milliseconds and names which
+ could not be resolved for DNS_CACHE_NEGATIVE_TTL milliseconds. Names added
+ through Add() (e.g. from advancedsettings.xml) never expire. Concurrent
+ lookups of the same name share a single query, and lookups with a timeout
+ leave slow queries running in the background so that their result is
+ cached for later lookups.
+ */
 class CDNSNameCache
 {
 public:
-  class CDNSName
-  {
-  public:
-    std::string m_strHostName;
-    std::string m_strIpAddress;
-  };
-  CDNSNameCache(void);
+  /*!
+   \brief Resolves the given host name.
+   \param strHostName the host name to resolve
+   \param strIpAddress the resolved ip address
+   \return true if the host name was resolved, false otherwise
+   */
+  typedef bool (*ResolveFunc)(const std::string& strHostName, std::string& strIpAddress);
+
+  CDNSNameCache(ResolveFunc resolve = Resolve, unsigned int ttl = DNS_CACHE_TTL, unsigned int negativeTtl = DNS_CACHE_NEGATIVE_TTL);
   virtual ~CDNSNameCache(void);
+
   static bool Lookup(const std::string& strHostName, std::string& strIpAddress);
+  /*!
+   \brief Looks up the given host name without waiting longer than the given time.
+   \param strHostName the host name to look up
+   \param strIpAddress the ip address of the host
+   \param timeout time (in milliseconds) to wait for the result, 0 doesn't wait for names which aren't cached
+   \return true if the host name has been resolved in time, false otherwise
+
+   Names which aren't cached are always queried, if the query doesn't finish in
+   time it continues in the background and its result is cached for later lookups.
+   */
+  static bool Lookup(const std::string& strHostName, std::string& strIpAddress, unsigned int timeout);
   static void Add(const std::string& strHostName, const std::string& strIpAddress);
 
+  bool LookupName(const std::string& strHostName, std::string& strIpAddress, unsigned int timeout);
+  void AddName(const std::string& strHostName, const std::string& strIpAddress);
+
+  static const unsigned int DNS_CACHE_TTL = 10 * 60 * 1000;
+  static const unsigned int DNS_CACHE_NEGATIVE_TTL = 5 * 1000;
+
 protected:
-  static bool GetCached(const std::string& strHostName, std::string& strIpAddress);
-  static CCriticalSection m_critical;
-  std::vector<CDNSName> m_vecDNSNames;
+  class CDNSName
+  {
+  public:
+    std::string m_strIpAddress; // empty if the name couldn't be resolved
+    unsigned int m_resolved;
+    bool m_permanent;
+  };
+
+  class CPendingLookup;
+  class CLookupJob;
+  typedef std::shared_ptr<CPendingLookup> PendingLookupPtr;
+
+  static bool Resolve(const std::string& strHostName, std::string& strIpAddress);
+
+  bool GetCached(const std::string& strHostName, std::string& strIpAddress, bool& resolved);
+  void Complete(const std::string& strHostName, const PendingLookupPtr& pending);
+
+  ResolveFunc m_resolve;
+  unsigned int m_ttl;
+  unsigned int m_negativeTtl;
+
+  CCriticalSection m_critical;
+  std::unordered_map<std::string, CDNSName> m_names;
+  std::unordered_map<std::string, PendingLookupPtr> m_pending;
 };
@@ -425,6 +425,8 @@ bool CEventClient::OnPacketBUTTON(CEventPacket *packet)
                              (flags & PTB_NO_REPEAT)             ? false : true,
                              (flags & PTB_USE_AMOUNT)            ? true : false );
 
+    state.m_iReceiveTime = packet->ReceiveTime();
+
     /* correct non active events so they work with rest of code */
     if(!active)
     {
@@ -489,6 +491,7 @@ bool CEventClient::OnPacketBUTTON(CEventPacket *packet)
       m_currentButton.m_bRepeat    = (flags & PTB_NO_REPEAT)  ? false : true;
       m_currentButton.m_bAxis      = (flags & PTB_AXIS)       ? true : false;
       m_currentButton.m_iNextRepeat = 0;
+      m_currentButton.m_iReceiveTime = packet->ReceiveTime();
       m_currentButton.SetActive();
       m_currentButton.Load();
     }
@@ -646,7 +649,7 @@ bool CEventClient::OnPacketACTION(CEventPacket *packet)
   case AT_BUTTON:
     {
       CSingleLock lock(m_critSection);
-      m_actionQueue.push(CEventAction(actionString.c_str(), actionType));
+      m_actionQueue.push(CEventAction(actionString.c_str(), actionType, packet->ReceiveTime()));
     }
     break;
 
@@ -727,10 +730,11 @@ void CEventClient::FreePacketQueues()
   m_seqPackets.clear();
 }
 
-unsigned int CEventClient::GetButtonCode(string& joystickName, bool& isAxis, float& amount)
+unsigned int CEventClient::GetButtonCode(string& joystickName, bool& isAxis, float& amount, int64_t& receiveTime)
 {
   CSingleLock lock(m_critSection);
   unsigned int bcode = 0;
+  receiveTime = 0;
 
   if ( m_currentButton.Active() )
   {
@@ -746,6 +750,12 @@ unsigned int CEventClient::GetButtonCode(string& joystickName, bool& isAxis, flo
       if ( ! CheckButtonRepeat(m_currentButton.m_iNextRepeat) )
         bcode = 0;
     }
+
+    if ( bcode )
+    {
+      receiveTime = m_currentButton.m_iReceiveTime;
+      m_currentButton.m_iReceiveTime = 0;
+    }
     return bcode;
   }
 
@@ -768,12 +778,16 @@ unsigned int CEventClient::GetButtonCode(string& joystickName, bool& isAxis, flo
       bool skip = !it->Axis() && !CheckButtonRepeat(it->m_iNextRepeat);
 
       repeat.push_back(*it);
+      repeat.back().m_iReceiveTime = 0;
       if(skip)
       {
         bcode = 0;
         continue;
       }
     }
+
+    if (bcode)
+      receiveTime = it->m_iReceiveTime;
   }
 
   m_buttonQueue.erase(m_buttonQueue.begin(), it);
@@ -794,6 +808,12 @@ bool CEventClient::GetMousePos(float& x, float& y)
   return false;
 }
 
+bool CEventClient::HasPendingInput()
+{
+  CSingleLock lock(m_critSection);
+  return !m_actionQueue.empty() || m_currentButton.Active() || !m_buttonQueue.empty() || m_bMouseMoved;
+}
+
 bool CEventClient::CheckButtonRepeat(unsigned int &next)
 {
   unsigned int now = XbmcThreads::SystemClockMillis();
@@ -42,15 +42,18 @@ namespace EVENTCLIENT
     CEventAction()
     {
       actionType = 0;
+      receiveTime = 0;
     }
-    CEventAction(const char* action, unsigned char type):
+    CEventAction(const char* action, unsigned char type, int64_t receivedAt = 0):
       actionName(action)
     {
       actionType = type;
+      receiveTime = receivedAt;
     }
 
     std::string    actionName;
     unsigned char  actionType;
+    int64_t        receiveTime; // host counter value of the packet's receipt
   };
 
   class CEventButtonState
@@ -66,6 +69,7 @@ namespace EVENTCLIENT
       m_bAxis      = false;
       m_iControllerNumber = 0;
       m_iNextRepeat = 0;
+      m_iReceiveTime = 0;
     }
 
     CEventButtonState(unsigned int iKeyCode,
@@ -86,6 +90,7 @@ namespace EVENTCLIENT
       m_bAxis      = isAxis;
       m_iControllerNumber = 0;
       m_iNextRepeat = 0;
+      m_iReceiveTime = 0;
       Load();
     }
 
@@ -112,6 +117,7 @@ namespace EVENTCLIENT
     bool              m_bActive;
     bool              m_bAxis;
     unsigned int      m_iNextRepeat;
+    int64_t           m_iReceiveTime; // host counter value of the packet's receipt (0 once reported)
   };
 
 
@@ -187,12 +193,15 @@ namespace EVENTCLIENT
     // deallocate all packets in the queues
     void FreePacketQueues();
 
-    // return event states
-    unsigned int GetButtonCode(std::string& strMapName, bool& isAxis, float& amount);
+    // return event states (receiveTime is set for the first report of a button press)
+    unsigned int GetButtonCode(std::string& strMapName, bool& isAxis, float& amount, int64_t& receiveTime);
 
     // update mouse position
     bool GetMousePos(float& x, float& y);
 
+    // return true if there are actions, buttons or mouse movements left to report
+    bool HasPendingInput();
+
   protected:
     bool ProcessPacket(EVENTPACKET::CEventPacket *packet);
 
@@ -24,10 +24,55 @@
 
 #include "EventPacket.h"
 #include "Socket.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
 #include "utils/log.h"
 
+#include <new>
+#include <vector>
+
 using namespace EVENTPACKET;
 
+// maximum number of unused packets kept for reuse
+#define PACKET_POOL_SIZE 64
+
+class CEventPacketPool
+{
+public:
+  ~CEventPacketPool()
+  {
+    for (std::vector<void*>::iterator it = m_packets.begin(); it != m_packets.end(); ++it)
+      ::operator delete(*it);
+  }
+
+  void* Get()
+  {
+    CSingleLock lock(m_critSection);
+    if (m_packets.empty())
+      return NULL;
+
+    void* packet = m_packets.back();
+    m_packets.pop_back();
+    return packet;
+  }
+
+  bool Put(void* packet)
+  {
+    CSingleLock lock(m_critSection);
+    if (m_packets.size() >= PACKET_POOL_SIZE)
+      return false;
+
+    m_packets.push_back(packet);
+    return true;
+  }
+
+private:
+  CCriticalSection   m_critSection;
+  std::vector<void*> m_packets;
+};
+
+static CEventPacketPool g_packetPool;
+
 /************************************************************************/
 /* CEventPacket                                                         */
 /************************************************************************/
@@ -83,22 +128,35 @@ bool CEventPacket::Parse(int datasize, const void *data)
     // forward past reserved bytes
     buf += 10;
 
-    if (m_pPayload)
-    {
-      free(m_pPayload);
-      m_pPayload = NULL;
-    }
+    FreePayload();
 
-    m_pPayload = malloc(m_iPayloadSize);
-    if (!m_pPayload)
-    {
-      CLog::Log(LOGERROR, "ES: Out of memory");
-      return false;
-    }
+    // the payload size has been checked against the packet size above
+    m_pPayload = m_payload;
     memcpy(m_pPayload, buf, (size_t)m_iPayloadSize);
   }
   m_bValid = true;
   return true;
 }
 
+void* CEventPacket::operator new(size_t size)
+{
+  if (size == sizeof(CEventPacket))
+  {
+    void* packet = g_packetPool.Get();
+    if (packet)
+      return packet;
+  }
+
+  return ::operator new(size);
+}
+
+void CEventPacket::operator delete(void* ptr, size_t size)
+{
+  if (ptr == NULL)
+    return;
+
+  if (size != sizeof(CEventPacket) || !g_packetPool.Put(ptr))
+    ::operator delete(ptr);
+}
+
 #endif // HAS_EVENT_SERVER
@@ -21,6 +21,7 @@
  *
  */
 
+#include <stdint.h>
 #include <stdlib.h>
 
 namespace EVENTPACKET
@@ -217,6 +218,7 @@ namespace EVENTPACKET
       m_cMajVer = '0';
       m_cMinVer = '0';
       m_eType = PT_LAST;
+      m_iReceiveTime = 0;
     }
 
     CEventPacket(int datasize, const void* data)
@@ -230,11 +232,17 @@ namespace EVENTPACKET
       m_cMajVer = '0';
       m_cMinVer = '0';
       m_eType = PT_LAST;
+      m_iReceiveTime = 0;
 
       Parse(datasize, data);
     }
 
-    virtual      ~CEventPacket() { free(m_pPayload); }
+    virtual      ~CEventPacket() { FreePayload(); }
+
+    // packets are allocated for every datagram so they are recycled
+    static void* operator new(size_t size);
+    static void  operator delete(void* ptr, size_t size);
+
     virtual bool Parse(int datasize, const void *data);
     bool         IsValid() const { return m_bValid; }
     PacketType   Type() const { return m_eType; }
@@ -245,12 +253,23 @@ namespace EVENTPACKET
     unsigned int ClientToken() const { return m_iClientToken; }
     void         SetPayload(unsigned int psize, void *payload)
     {
-      free(m_pPayload);
+      FreePayload();
       m_pPayload = payload;
       m_iPayloadSize = psize;
     }
+    // host counter value of the moment the packet has been received
+    int64_t      ReceiveTime() const { return m_iReceiveTime; }
+    void         SetReceiveTime(int64_t receiveTime) { m_iReceiveTime = receiveTime; }
 
   protected:
+    void         FreePayload()
+    {
+      // the payload of a single packet is stored in the packet itself
+      if (m_pPayload != m_payload)
+        free(m_pPayload);
+      m_pPayload = NULL;
+    }
+
     bool           m_bValid;
     unsigned int   m_iSeq;
     unsigned int   m_iTotalPackets;
@@ -261,6 +280,8 @@ namespace EVENTPACKET
     unsigned char  m_cMajVer;
     unsigned char  m_cMinVer;
     PacketType     m_eType;
+    int64_t        m_iReceiveTime;
+    unsigned char  m_payload[PACKET_SIZE - HEADER_SIZE];
   };
 
 }
@@ -35,6 +35,8 @@
 #include "Zeroconf.h"
 #include "guilib/GUIAudioManager.h"
 #include "input/Key.h"
+#include "threads/SystemClock.h"
+#include "utils/TimeUtils.h"
 #include <map>
 #include <queue>
 #include <cassert>
@@ -45,6 +47,11 @@ using namespace EVENTCLIENT;
 using namespace SOCKETS;
 using namespace std;
 
+// maximum number of datagrams read at once
+#define ES_BATCH_SIZE 32
+// interval in ms at which timed out clients are removed
+#define ES_REFRESH_INTERVAL 1000
+
 /************************************************************************/
 /* CEventServer                                                         */
 /************************************************************************/
@@ -56,6 +63,9 @@ CEventServer::CEventServer() : CThread("EventServer")
   m_bStop         = false;
   m_bRunning      = false;
   m_bRefreshSettings = false;
+  m_iLatencyCount = 0;
+  m_iLatencyTotal = 0;
+  m_iLatencyMax   = 0;
 
   // default timeout in ms for receiving a single packet
   m_iListenTimeout = 1000;
@@ -132,6 +142,8 @@ void CEventServer::Cleanup()
     m_clients.erase(iter);
     iter =  m_clients.begin();
   }
+  m_updatedClients.clear();
+  m_activeClients.clear();
 }
 
 int CEventServer::GetNumberOfClients()
@@ -154,7 +166,6 @@ void CEventServer::Run()
 {
   CAddress any_addr;
   CSocketListener listener;
-  int packetSize = 0;
 
   CLog::Log(LOGNOTICE, "ES: Starting UDP Event server on %s:%d", any_addr.Address(), m_iPort);
 
@@ -167,7 +178,7 @@ void CEventServer::Run()
     CLog::Log(LOGERROR, "ES: Could not create socket, aborting!");
     return;
   }
-  m_pPacketBuffer = (unsigned char *)malloc(PACKET_SIZE);
+  m_pPacketBuffer = (unsigned char *)malloc(PACKET_SIZE * ES_BATCH_SIZE);
 
   if (!m_pPacketBuffer)
   {
@@ -175,6 +186,11 @@ void CEventServer::Run()
     return;
   }
 
+  // every datagram of a batch is read into its own part of the buffer
+  vector<UDPDatagram> datagrams(ES_BATCH_SIZE);
+  for (int i = 0; i < ES_BATCH_SIZE; i++)
+    datagrams[i].buffer = m_pPacketBuffer + i * PACKET_SIZE;
+
   // bind to IP and start listening on port
   int port_range = CSettings::Get().GetInt("services.esportrange");
   if (port_range < 1 || port_range > 100)
@@ -201,18 +217,19 @@ void CEventServer::Run()
 
   m_bRunning = true;
 
+  XbmcThreads::EndTime refreshTimer(ES_REFRESH_INTERVAL);
   while (!m_bStop)
   {
     try
     {
-      // start listening until we timeout
-      if (listener.Listen(m_iListenTimeout))
+      // start listening until we timeout or the clients need to be refreshed
+      if (listener.Listen(min(m_iListenTimeout, (int)refreshTimer.MillisLeft())))
       {
-        CAddress addr;
-        if ((packetSize = m_pSocket->Read(addr, PACKET_SIZE, (void *)m_pPacketBuffer)) > -1)
-        {
-          ProcessPacket(addr, packetSize);
-        }
+        // read all datagrams which have arrived so far
+        int packets = m_pSocket->Read(&datagrams[0], ES_BATCH_SIZE, PACKET_SIZE);
+        int64_t receiveTime = CurrentHostCounter();
+        for (int i = 0; i < packets; i++)
+          ProcessPacket(datagrams[i], receiveTime);
       }
     }
     catch (...)
@@ -225,21 +242,34 @@ void CEventServer::Run()
     ProcessEvents();
 
     // refresh client list
-    RefreshClients();
+    if (refreshTimer.IsTimePast())
+    {
+      RefreshClients();
+      refreshTimer.Set(ES_REFRESH_INTERVAL);
+    }
 
     // broadcast
     // BroadcastBeacon();
   }
 
+  unsigned int latencyCount;
+  float latencyAverage, latencyMax;
+  GetLatency(latencyCount, latencyAverage, latencyMax);
+  if (latencyCount > 0)
+    CLog::Log(LOGDEBUG, "ES: Dispatched %u events with an average latency of %.3f ms (maximum %.3f ms)",
+              latencyCount, latencyAverage, latencyMax);
+
   CLog::Log(LOGNOTICE, "ES: UDP Event server stopped");
   m_bRunning = false;
   Cleanup();
 }
 
-void CEventServer::ProcessPacket(CAddress& addr, int pSize)
+void CEventServer::ProcessPacket(UDPDatagram& datagram, int64_t receiveTime)
 {
+  CAddress& addr = datagram.addr;
+
   // check packet validity
-  CEventPacket* packet = new CEventPacket(pSize, m_pPacketBuffer);
+  CEventPacket* packet = new CEventPacket(datagram.size, datagram.buffer);
   if(packet == NULL)
   {
     CLog::Log(LOGERROR, "ES: Out of memory, cannot accept packet");
@@ -284,7 +314,9 @@ void CEventServer::ProcessPacket(CAddress& addr, int pSize)
 
     m_clients[clientToken] = client;
   }
+  packet->SetReceiveTime(receiveTime);
   m_clients[clientToken]->AddPacket(packet);
+  m_updatedClients.insert(clientToken);
 }
 
 void CEventServer::RefreshClients()
@@ -299,6 +331,8 @@ void CEventServer::RefreshClients()
       CLog::Log(LOGNOTICE, "ES: Client %s from %s timed out", iter->second->Name().c_str(),
                 iter->second->Address().Address());
       delete iter->second;
+      m_updatedClients.erase(iter->first);
+      m_activeClients.erase(iter->first);
       m_clients.erase(iter);
       iter = m_clients.begin();
     }
@@ -317,47 +351,72 @@ void CEventServer::RefreshClients()
 void CEventServer::ProcessEvents()
 {
   CSingleLock lock(m_critSection);
-  map<unsigned long, CEventClient*>::iterator iter = m_clients.begin();
 
-  while (iter != m_clients.end())
+  // only clients which have received packets have anything to process
+  for (set<unsigned long>::const_iterator token = m_updatedClients.begin(); token != m_updatedClients.end(); ++token)
   {
+    map<unsigned long, CEventClient*>::iterator iter = m_clients.find(*token);
+    if (iter == m_clients.end())
+      continue;
+
     iter->second->ProcessEvents();
-    ++iter;
+    if (iter->second->HasPendingInput())
+      m_activeClients.insert(*token);
   }
+  m_updatedClients.clear();
 }
 
 bool CEventServer::ExecuteNextAction()
+{
+  CEventAction actionEvent;
+  if (!GetNextAction(actionEvent))
+    return false;
+
+  switch(actionEvent.actionType)
+  {
+  case AT_EXEC_BUILTIN:
+    CBuiltins::Execute(actionEvent.actionName);
+    break;
+
+  case AT_BUTTON:
+    {
+      int actionID;
+      CButtonTranslator::TranslateActionString(actionEvent.actionName.c_str(), actionID);
+      CAction action(actionID, 1.0f, 0.0f, actionEvent.actionName);
+      g_audioManager.PlayActionSound(action);
+      g_application.OnAction(action);
+    }
+    break;
+  }
+  return true;
+}
+
+bool CEventServer::GetNextAction(CEventAction &action)
 {
   CSingleLock lock(m_critSection);
 
-  CEventAction actionEvent;
-  map<unsigned long, CEventClient*>::iterator iter = m_clients.begin();
+  set<unsigned long>::iterator token = m_activeClients.begin();
 
-  while (iter != m_clients.end())
+  while (token != m_activeClients.end())
   {
-    if (iter->second->GetNextAction(actionEvent))
+    map<unsigned long, CEventClient*>::iterator iter = m_clients.find(*token);
+    if (iter == m_clients.end())
     {
-      // Leave critical section before processing action
-      lock.Leave();
-      switch(actionEvent.actionType)
-      {
-      case AT_EXEC_BUILTIN:
-        CBuiltins::Execute(actionEvent.actionName);
-        break;
-
-      case AT_BUTTON:
-        {
-          int actionID;
-          CButtonTranslator::TranslateActionString(actionEvent.actionName.c_str(), actionID);
-          CAction action(actionID, 1.0f, 0.0f, actionEvent.actionName);
-          g_audioManager.PlayActionSound(action);
-          g_application.OnAction(action);
-        }
-        break;
-      }
+      m_activeClients.erase(token++);
+      continue;
+    }
+
+    if (iter->second->GetNextAction(action))
+    {
+      RecordLatency(action.receiveTime);
       return true;
     }
-    ++iter;
+
+    // forget about clients without any input left to report
+    if (!iter->second->HasPendingInput())
+      m_activeClients.erase(token++);
+    else
+      ++token;
   }
 
   return false;
@@ -366,15 +425,30 @@ bool CEventServer::ExecuteNextAction()
 unsigned int CEventServer::GetButtonCode(std::string& strMapName, bool& isAxis, float& fAmount)
 {
   CSingleLock lock(m_critSection);
-  map<unsigned long, CEventClient*>::iterator iter = m_clients.begin();
+  set<unsigned long>::iterator token = m_activeClients.begin();
   unsigned int bcode = 0;
 
-  while (iter != m_clients.end())
+  while (token != m_activeClients.end())
   {
-    bcode = iter->second->GetButtonCode(strMapName, isAxis, fAmount);
+    map<unsigned long, CEventClient*>::iterator iter = m_clients.find(*token);
+    if (iter == m_clients.end())
+    {
+      m_activeClients.erase(token++);
+      continue;
+    }
+
+    int64_t receiveTime;
+    bcode = iter->second->GetButtonCode(strMapName, isAxis, fAmount, receiveTime);
     if (bcode)
+    {
+      RecordLatency(receiveTime);
       return bcode;
-    ++iter;
+    }
+
+    if (!iter->second->HasPendingInput())
+      m_activeClients.erase(token++);
+    else
+      ++token;
   }
   return bcode;
 }
@@ -382,15 +456,49 @@ unsigned int CEventServer::GetButtonCode(std::string& strMapName, bool& isAxis,
 bool CEventServer::GetMousePos(float &x, float &y)
 {
   CSingleLock lock(m_critSection);
-  map<unsigned long, CEventClient*>::iterator iter = m_clients.begin();
+  set<unsigned long>::iterator token = m_activeClients.begin();
 
-  while (iter != m_clients.end())
+  while (token != m_activeClients.end())
   {
+    map<unsigned long, CEventClient*>::iterator iter = m_clients.find(*token);
+    if (iter == m_clients.end())
+    {
+      m_activeClients.erase(token++);
+      continue;
+    }
+
     if (iter->second->GetMousePos(x, y))
       return true;
-    ++iter;
+
+    if (!iter->second->HasPendingInput())
+      m_activeClients.erase(token++);
+    else
+      ++token;
   }
   return false;
 }
 
+void CEventServer::GetLatency(unsigned int &count, float &averageMs, float &maxMs)
+{
+  CSingleLock lock(m_critSection);
+  float frequency = (float)CurrentHostFrequency() / 1000.0f;
+
+  count = m_iLatencyCount;
+  averageMs = m_iLatencyCount > 0 ? (float)m_iLatencyTotal / m_iLatencyCount / frequency : 0.0f;
+  maxMs = (float)m_iLatencyMax / frequency;
+}
+
+void CEventServer::RecordLatency(int64_t receiveTime)
+{
+  // repeated buttons don't have a receive time
+  if (receiveTime <= 0)
+    return;
+
+  int64_t latency = CurrentHostCounter() - receiveTime;
+  m_iLatencyCount++;
+  m_iLatencyTotal += latency;
+  if (latency > m_iLatencyMax)
+    m_iLatencyMax = latency;
+}
+
 #endif // HAS_EVENT_SERVER
@@ -29,6 +29,7 @@
 
 #include <map>
 #include <queue>
+#include <set>
 #include <vector>
 
 namespace EVENTSERVER
@@ -68,15 +69,23 @@ namespace EVENTSERVER
     bool GetMousePos(float &x, float &y);
     int GetNumberOfClients();
 
+    // get the number of dispatched actions and button presses and the time
+    // between the receipt of their packets and their dispatch
+    void GetLatency(unsigned int &count, float &averageMs, float &maxMs);
+
   protected:
     CEventServer();
     void Cleanup();
     void Run();
-    void ProcessPacket(SOCKETS::CAddress& addr, int packetSize);
+    void ProcessPacket(SOCKETS::UDPDatagram& datagram, int64_t receiveTime);
     void ProcessEvents();
+    bool GetNextAction(EVENTCLIENT::CEventAction &action);
     void RefreshClients();
+    void RecordLatency(int64_t receiveTime);
 
     std::map<unsigned long, EVENTCLIENT::CEventClient*>  m_clients;
+    std::set<unsigned long> m_updatedClients; // clients which have received packets
+    std::set<unsigned long> m_activeClients;  // clients with input left to report
     static CEventServer* m_pInstance;
     SOCKETS::CUDPSocket* m_pSocket;
     int              m_iPort;
@@ -86,6 +95,9 @@ namespace EVENTSERVER
     bool             m_bRunning;
     CCriticalSection m_critSection;
     bool             m_bRefreshSettings;
+    unsigned int     m_iLatencyCount;
+    int64_t          m_iLatencyTotal;
+    int64_t          m_iLatencyMax;
   };
 
 }
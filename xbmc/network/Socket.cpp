@@ -130,6 +130,59 @@ int CPosixUDPSocket::Read(CAddress& addr, const int buffersize, void *buffer)
                        (struct sockaddr*)&addr.saddr, &addr.size);
 }
 
+int CPosixUDPSocket::Read(UDPDatagram* datagrams, const int count, const int buffersize)
+{
+  if (count <= 0)
+    return 0;
+
+#if defined(TARGET_LINUX) && defined(MSG_WAITFORONE)
+  // receive all pending datagrams with a single system call
+  std::vector<struct mmsghdr> messages(count);
+  std::vector<struct iovec> iovecs(count);
+  for (int i = 0; i < count; i++)
+  {
+    iovecs[i].iov_base = datagrams[i].buffer;
+    iovecs[i].iov_len = (size_t)buffersize;
+    memset(&messages[i], 0, sizeof(messages[i]));
+    messages[i].msg_hdr.msg_iov = &iovecs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+    messages[i].msg_hdr.msg_name = &datagrams[i].addr.saddr;
+    messages[i].msg_hdr.msg_namelen = sizeof(datagrams[i].addr.saddr);
+  }
+
+  int received = recvmmsg(m_iSock, &messages[0], (unsigned int)count, MSG_DONTWAIT, NULL);
+  if (received < 0)
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+
+  for (int i = 0; i < received; i++)
+  {
+    datagrams[i].addr.size = messages[i].msg_hdr.msg_namelen;
+    datagrams[i].size = (int)messages[i].msg_len;
+  }
+  return received;
+#elif defined(MSG_DONTWAIT)
+  int received = 0;
+  while (received < count)
+  {
+    datagrams[received].addr.size = sizeof(datagrams[received].addr.saddr);
+    int size = (int)recvfrom(m_iSock, (char*)datagrams[received].buffer, (size_t)buffersize, MSG_DONTWAIT,
+                             (struct sockaddr*)&datagrams[received].addr.saddr, &datagrams[received].addr.size);
+    if (size < 0)
+    {
+      if (received == 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        return -1;
+      break;
+    }
+    datagrams[received++].size = size;
+  }
+  return received;
+#else
+  // without non-blocking reads only the datagram signalled by select can be read
+  datagrams[0].size = Read(datagrams[0].addr, buffersize, datagrams[0].buffer);
+  return datagrams[0].size < 0 ? -1 : 1;
+#endif
+}
+
 int CPosixUDPSocket::SendTo(const CAddress& addr, const int buffersize,
                           const void *buffer)
 {
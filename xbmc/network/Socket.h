@@ -127,6 +127,16 @@ namespace SOCKETS
     int        m_iPort;
   };
 
+  /**********************************************************************/
+  /* Datagram received as part of a batch                               */
+  /**********************************************************************/
+  typedef struct UDPDatagram
+  {
+    CAddress       addr;
+    void*          buffer;
+    int            size;
+  } UDPDatagram;
+
   /**********************************************************************/
   /* Base class for UDP socket implementations                          */
   /**********************************************************************/
@@ -143,6 +153,9 @@ namespace SOCKETS
 
     // read datagrams, return no. of bytes read or -1 or error
     virtual int  Read(CAddress& addr, const int buffersize, void *buffer) = 0;
+    // read up to count datagrams into the buffers of the given datagrams
+    // without blocking, return no. of datagrams read or -1 on error
+    virtual int  Read(UDPDatagram* datagrams, const int count, const int buffersize) = 0;
     virtual bool Broadcast(const CAddress& addr, const int datasize,
                            const void* data) = 0;
   };
@@ -165,6 +178,7 @@ namespace SOCKETS
     bool Listen(int timeout);
     int  SendTo(const CAddress& addr, const int datasize, const void* data);
     int  Read(CAddress& addr, const int buffersize, void *buffer);
+    int  Read(UDPDatagram* datagrams, const int count, const int buffersize);
     bool Broadcast(const CAddress& addr, const int datasize, const void* data)
     {
       // TODO
@@ -19,11 +19,19 @@
  */
 
 #include "TCPServer.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
+#include <algorithm>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#ifdef TARGET_LINUX
+#include <sys/epoll.h>
+#endif
+#ifndef TARGET_WINDOWS
+#include <fcntl.h>
+#endif
 
 #include "settings/AdvancedSettings.h"
 #include "interfaces/json-rpc/JSONRPC.h"
@@ -31,6 +39,7 @@
 #include "utils/log.h"
 #include "utils/Variant.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "websocket/WebSocketManager.h"
 #include "Network.h"
 
@@ -55,7 +64,73 @@ using namespace JSONRPC;
 using namespace ANNOUNCEMENT;
 //using namespace std; On VS2010, bind conflicts with std::bind
 
-#define RECEIVEBUFFER 1024
+#define RECEIVEBUFFER 4096
+#define MAX_EVENTS    64
+// reading from a client pauses while this many of its requests wait for a worker
+#define MAX_QUEUED_REQUESTS 16
+// clients not reading their responses and announcements are dropped once this much output is queued
+#define MAX_PENDING_OUTPUT (32 * 1024 * 1024)
+// streamed responses are produced in chunks of this size as the client reads them
+#define RESPONSE_CHUNK_SIZE (64 * 1024)
+// clients not reading any of a streamed response for this long are dropped
+#define STALLED_CLIENT_TIMEOUT 60000
+
+#ifdef TARGET_LINUX
+// edge triggered, so EPOLLOUT only fires once a full socket buffer has room again
+#define CLIENT_EVENTS (EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET)
+#endif
+
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+static bool SetNonBlocking(SOCKET socket)
+{
+#ifdef TARGET_WINDOWS
+  u_long nonblocking = 1;
+  return ioctlsocket(socket, FIONBIO, &nonblocking) == 0;
+#else
+  int flags = fcntl(socket, F_GETFL, 0);
+  return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static bool WouldBlock()
+{
+#ifdef TARGET_WINDOWS
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+namespace JSONRPC
+{
+  class CTCPServerWorker : public IRunnable
+  {
+  public:
+    CTCPServerWorker(CTCPServer &server) : m_server(server), m_thread(this, "TCPServerWorker")
+    {
+      m_thread.Create();
+    }
+
+    virtual ~CTCPServerWorker()
+    {
+      m_thread.StopThread();
+    }
+
+    virtual void Run()
+    {
+      m_server.ProcessRequests();
+    }
+
+  private:
+    CTCPServer &m_server;
+    CThread m_thread;
+  };
+}
 
 CTCPServer *CTCPServer::ServerInstance = NULL;
 
@@ -99,18 +174,60 @@ CTCPServer::CTCPServer(int port, bool nonlocal) : CThread("TCPServer")
   m_port = port;
   m_nonlocal = nonlocal;
   m_sdpd = NULL;
+#ifdef TARGET_LINUX
+  m_epoll = -1;
+#endif
+  m_stopWorkers = false;
 }
 
 void CTCPServer::Process()
 {
   m_bStop = false;
 
+  StartWorkers();
+
   while (!m_bStop)
   {
+#ifdef TARGET_LINUX
+    struct epoll_event events[MAX_EVENTS];
+    int res = epoll_wait(m_epoll, events, MAX_EVENTS, 1000);
+    if (res < 0 && errno != EINTR)
+    {
+      CLog::Log(LOGERROR, "JSONRPC Server: epoll_wait failed: %d", errno);
+      Sleep(1000);
+      Initialize();
+      continue;
+    }
+
+    for (int i = 0; i < res; i++)
+    {
+      SOCKET socket = events[i].data.fd;
+      if (std::find(m_servers.begin(), m_servers.end(), socket) != m_servers.end())
+      {
+        if (!AcceptConnection(socket))
+          break;
+        continue;
+      }
+
+      ClientMap::iterator it = m_connections.find(socket);
+      if (it == m_connections.end())
+        continue;
+
+      bool close = (events[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+      if (!close && (events[i].events & (EPOLLIN | EPOLLRDHUP)))
+        close = !HandleInput(it);
+      if (!close && (events[i].events & EPOLLOUT))
+        close = !it->second->FlushOutput();
+
+      if (close)
+        RemoveConnection(it);
+    }
+#else
     SOCKET          max_fd = 0;
-    fd_set          rfds;
+    fd_set          rfds, wfds;
     struct timeval  to     = {1, 0};
     FD_ZERO(&rfds);
+    FD_ZERO(&wfds);
 
     for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
     {
@@ -119,14 +236,17 @@ void CTCPServer::Process()
         max_fd = *it;
     }
 
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    for (ClientMap::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
     {
-      FD_SET(m_connections[i]->m_socket, &rfds);
-      if ((intptr_t)m_connections[i]->m_socket > (intptr_t)max_fd)
-        max_fd = m_connections[i]->m_socket;
+      if (!IsInputPaused(it->second))
+        FD_SET(it->first, &rfds);
+      if (it->second->HasPendingOutput())
+        FD_SET(it->first, &wfds);
+      if ((intptr_t)it->first > (intptr_t)max_fd)
+        max_fd = it->first;
     }
 
-    int res = select((intptr_t)max_fd+1, &rfds, NULL, NULL, &to);
+    int res = select((intptr_t)max_fd+1, &rfds, &wfds, NULL, &to);
     if (res < 0)
     {
       CLog::Log(LOGERROR, "JSONRPC Server: Select failed");
@@ -135,84 +255,264 @@ void CTCPServer::Process()
     }
     else if (res > 0)
     {
-      for (int i = m_connections.size() - 1; i >= 0; i--)
+      for (ClientMap::iterator it = m_connections.begin(); it != m_connections.end(); )
       {
-        int socket = m_connections[i]->m_socket;
-        if (FD_ISSET(socket, &rfds))
-        {
-          char buffer[RECEIVEBUFFER] = {};
-          int  nread = 0;
-          nread = recv(socket, (char*)&buffer, RECEIVEBUFFER, 0);
-          bool close = false;
-          if (nread > 0)
-          {
-            std::string response;
-            if (m_connections[i]->IsNew())
-            {
-              CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
-
-              if (response.size() > 0)
-                m_connections[i]->Send(response.c_str(), response.size());
-
-              if (websocket != NULL)
-              {
-                // Replace the CTCPClient with a CWebSocketClient
-                CWebSocketClient *websocketClient = new CWebSocketClient(websocket, *(m_connections[i]));
-                delete m_connections[i];
-                m_connections.erase(m_connections.begin() + i);
-                m_connections.insert(m_connections.begin() + i, websocketClient);
-              }
-            }
-
-            if (response.size() <= 0)
-              m_connections[i]->PushBuffer(this, buffer, nread);
-
-            close = m_connections[i]->Closing();
-          }
-          else
-            close = true;
-
-          if (close)
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
-            m_connections[i]->Disconnect();
-            delete m_connections[i];
-            m_connections.erase(m_connections.begin() + i);
-          }
-        }
+        bool close = false;
+        if (FD_ISSET(it->first, &rfds))
+          close = !HandleInput(it);
+        if (!close && FD_ISSET(it->first, &wfds))
+          close = !it->second->FlushOutput();
+
+        if (close)
+          RemoveConnection(it++);
+        else
+          ++it;
       }
 
       for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
       {
-        if (FD_ISSET(*it, &rfds))
-        {
-          CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
-          CTCPClient *newconnection = new CTCPClient();
-          newconnection->m_socket = accept(*it, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
-
-          if (newconnection->m_socket == INVALID_SOCKET)
-          {
-            CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", errno);
-            if (EBADF == errno)
-            {
-              Sleep(1000);
-              Initialize();
-              break;
-            }
-          }
-          else
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
-            m_connections.push_back(newconnection);
-          }
-        }
+        if (FD_ISSET(*it, &rfds) && !AcceptConnection(*it))
+          break;
       }
     }
+#endif
   }
 
+  StopWorkers();
   Deinitialize();
 }
 
+bool CTCPServer::AcceptConnection(SOCKET server)
+{
+  CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
+  CTCPClientPtr newconnection(new CTCPClient());
+  newconnection->m_socket = accept(server, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
+
+  if (newconnection->m_socket == INVALID_SOCKET)
+  {
+    CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", errno);
+    if (EBADF == errno)
+    {
+      Sleep(1000);
+      Initialize();
+      return false;
+    }
+    return true;
+  }
+
+  if (!SetNonBlocking(newconnection->m_socket))
+  {
+    CLog::Log(LOGERROR, "JSONRPC Server: Failed to make new connection non-blocking");
+    newconnection->Disconnect();
+    return true;
+  }
+
+#ifdef TARGET_LINUX
+  struct epoll_event event = {};
+  event.events = CLIENT_EVENTS;
+  event.data.fd = newconnection->m_socket;
+  if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, newconnection->m_socket, &event) < 0)
+  {
+    CLog::Log(LOGERROR, "JSONRPC Server: Failed to watch new connection: %d", errno);
+    newconnection->Disconnect();
+    return true;
+  }
+#endif
+
+  CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
+  CSingleLock lock(m_connectionSection);
+  m_connections.insert(std::make_pair(newconnection->m_socket, newconnection));
+  return true;
+}
+
+bool CTCPServer::HandleInput(ClientMap::iterator it)
+{
+  char buffer[RECEIVEBUFFER];
+  while (true)
+  {
+    // the rest stays in the socket until the workers caught up with the client
+    if (IsInputPaused(it->second))
+      return true;
+
+    int nread = recv(it->first, buffer, RECEIVEBUFFER, 0);
+    if (nread == 0)
+      return false;
+    if (nread < 0)
+      return WouldBlock();
+
+    CTCPClientPtr client = it->second;
+    std::string response;
+    if (client->IsNew())
+    {
+      CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
+
+      if (response.size() > 0)
+        client->Send(response.c_str(), response.size());
+
+      if (websocket != NULL)
+      {
+        // Replace the CTCPClient with a CWebSocketClient
+        client.reset(new CWebSocketClient(websocket, *client));
+        CSingleLock lock(m_connectionSection);
+        it->second = client;
+      }
+    }
+
+    if (response.size() <= 0)
+      client->PushBuffer(this, buffer, nread);
+
+    QueueRequests(client);
+
+    if (client->Closing())
+      return false;
+  }
+}
+
+void CTCPServer::RemoveConnection(ClientMap::iterator it)
+{
+  CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
+#ifdef TARGET_LINUX
+  epoll_ctl(m_epoll, EPOLL_CTL_DEL, it->first, NULL);
+#endif
+  it->second->Disconnect();
+
+  CSingleLock lock(m_connectionSection);
+  m_connections.erase(it);
+}
+
+void CTCPServer::QueueRequests(const CTCPClientPtr &client)
+{
+  if (client->m_received.empty())
+    return;
+
+  CSingleLock lock(m_requestSection);
+  client->m_requests.insert(client->m_requests.end(), client->m_received.begin(), client->m_received.end());
+  client->m_received.clear();
+  if (client->m_requests.size() >= MAX_QUEUED_REQUESTS)
+    client->m_inputPaused = true;
+
+  if (!client->m_queued)
+  {
+    client->m_queued = true;
+    m_pendingClients.push_back(client);
+    m_requestCondition.notify();
+  }
+}
+
+void CTCPServer::ProcessRequests()
+{
+  CSingleLock lock(m_requestSection);
+  while (!m_stopWorkers)
+  {
+    if (m_pendingClients.empty())
+    {
+      m_requestCondition.wait(lock, 1000);
+      continue;
+    }
+
+    // a client is only queued once, so no other worker can take its next request
+    // before this one is answered
+    CTCPClientPtr client = m_pendingClients.front();
+    m_pendingClients.pop_front();
+    std::string request = client->m_requests.front();
+    client->m_requests.pop_front();
+
+    bool resumeInput = client->m_inputPaused && client->m_requests.size() < MAX_QUEUED_REQUESTS;
+    if (resumeInput)
+      client->m_inputPaused = false;
+
+    {
+      CSingleExit exit(m_requestSection);
+      if (resumeInput)
+        ResumeInput(client);
+      SendResponse(client, CJSONRPC::MethodCallStreamed(request, this, client.get()));
+    }
+
+    if (client->m_requests.empty())
+      client->m_queued = false;
+    else
+      m_pendingClients.push_back(client);
+  }
+}
+
+bool CTCPServer::IsInputPaused(const CTCPClientPtr &client)
+{
+  CSingleLock lock(m_requestSection);
+  return client->m_inputPaused;
+}
+
+void CTCPServer::ResumeInput(const CTCPClientPtr &client)
+{
+#ifdef TARGET_LINUX
+  // re-arming the edge triggered events reports the data left in the socket again
+  CSingleLock lock(client->m_critSection);
+  if (client->m_socket == INVALID_SOCKET)
+    return;
+
+  struct epoll_event event = {};
+  event.events = CLIENT_EVENTS;
+  event.data.fd = client->m_socket;
+  epoll_ctl(m_epoll, EPOLL_CTL_MOD, client->m_socket, &event);
+#endif
+  // select() watches the client again once its timeout expires
+}
+
+void CTCPServer::SendResponse(const CTCPClientPtr &client, const JSONRPCResponsePtr &response)
+{
+  if (!response->IsStreamed() || !client->CanStreamResponses())
+  {
+    std::string data = response->ToString();
+    if (!data.empty())
+      client->Send(data.c_str(), data.size());
+    return;
+  }
+
+  // only produce the next part of the response once the client has read the previous one
+  std::string chunk;
+  while (!m_stopWorkers && response->Read(chunk, RESPONSE_CHUNK_SIZE))
+  {
+    client->Send(chunk.c_str(), chunk.size());
+    chunk.clear();
+
+    XbmcThreads::EndTime stalled(STALLED_CLIENT_TIMEOUT);
+    while (!client->WaitForOutput(RESPONSE_CHUNK_SIZE, 1000))
+    {
+      if (m_stopWorkers || client->HasFailed())
+        return;
+
+      if (stalled.IsTimePast())
+      {
+        CLog::Log(LOGWARNING, "JSONRPC Server: Client is not reading its response, disconnecting");
+        client->Shutdown();
+        return;
+      }
+    }
+  }
+}
+
+void CTCPServer::StartWorkers()
+{
+  m_stopWorkers = false;
+  for (unsigned int i = 0; i < g_advancedSettings.m_jsonTcpWorkers; i++)
+    m_workers.push_back(new CTCPServerWorker(*this));
+}
+
+void CTCPServer::StopWorkers()
+{
+  {
+    CSingleLock lock(m_requestSection);
+    m_stopWorkers = true;
+    m_requestCondition.notifyAll();
+  }
+
+  for (std::vector<CTCPServerWorker*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+    delete *it;
+  m_workers.clear();
+
+  CSingleLock lock(m_requestSection);
+  m_pendingClients.clear();
+}
+
 bool CTCPServer::PrepareDownload(const char *path, CVariant &details, std::string &protocol)
 {
   return false;
@@ -232,15 +532,14 @@ void CTCPServer::Announce(AnnouncementFlag flag, const char *sender, const char
 {
   std::string str = IJSONRPCAnnouncer::AnnouncementToJSONRPC(flag, sender, message, data, g_advancedSettings.m_jsonOutputCompact);
 
-  for (unsigned int i = 0; i < m_connections.size(); i++)
+  // sending only queues the output if a client is slow, so this never blocks on one
+  CSingleLock connectionLock(m_connectionSection);
+  for (ClientMap::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
   {
-    {
-      CSingleLock lock (m_connections[i]->m_critSection);
-      if ((m_connections[i]->GetAnnouncementFlags() & flag) == 0)
-        continue;
-    }
+    if ((it->second->GetAnnouncementFlags() & flag) == 0)
+      continue;
 
-    m_connections[i]->Send(str.c_str(), str.size());
+    it->second->Send(str.c_str(), str.size());
   }
 }
 
@@ -253,6 +552,27 @@ bool CTCPServer::Initialize()
   started |= InitializeBlue();
   started |= InitializeTCP();
 
+#ifdef TARGET_LINUX
+  if (started)
+  {
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0)
+    {
+      CLog::Log(LOGERROR, "JSONRPC Server: Failed to create epoll instance: %d", errno);
+      Deinitialize();
+      return false;
+    }
+
+    for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+    {
+      struct epoll_event event = {};
+      event.events = EPOLLIN;
+      event.data.fd = *it;
+      epoll_ctl(m_epoll, EPOLL_CTL_ADD, *it, &event);
+    }
+  }
+#endif
+
   if (started)
   {
     CAnnouncementManager::Get().AddAnnouncer(this);
@@ -458,19 +778,25 @@ bool CTCPServer::InitializeTCP()
 
 void CTCPServer::Deinitialize()
 {
-  for (unsigned int i = 0; i < m_connections.size(); i++)
   {
-    m_connections[i]->Disconnect();
-    delete m_connections[i];
-  }
+    CSingleLock lock(m_connectionSection);
+    for (ClientMap::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+      it->second->Disconnect();
 
-  m_connections.clear();
+    m_connections.clear();
+  }
 
   for (unsigned int i = 0; i < m_servers.size(); i++)
     closesocket(m_servers[i]);
 
   m_servers.clear();
 
+#ifdef TARGET_LINUX
+  if (m_epoll >= 0)
+    close(m_epoll);
+  m_epoll = -1;
+#endif
+
 #ifdef HAVE_LIBBLUETOOTH
   if (m_sdpd)
     sdp_close((sdp_session_t*)m_sdpd);
@@ -485,10 +811,14 @@ CTCPServer::CTCPClient::CTCPClient()
   m_new = true;
   m_announcementflags = ANNOUNCE_ALL;
   m_socket = INVALID_SOCKET;
-  m_beginBrackets = 0;
-  m_endBrackets = 0;
+  m_queued = false;
+  m_inputPaused = false;
+  m_depth = 0;
+  m_inString = false;
+  m_escaped = false;
   m_beginChar = 0;
   m_endChar = 0;
+  m_failed = false;
 
   m_addrlen = sizeof(m_cliaddr);
 }
@@ -511,70 +841,155 @@ int CTCPServer::CTCPClient::GetPermissionFlags()
 
 int CTCPServer::CTCPClient::GetAnnouncementFlags()
 {
+  CSingleLock lock (m_critSection);
   return m_announcementflags;
 }
 
 bool CTCPServer::CTCPClient::SetAnnouncementFlags(int flags)
 {
+  CSingleLock lock (m_critSection);
   m_announcementflags = flags;
   return true;
 }
 
 void CTCPServer::CTCPClient::Send(const char *data, unsigned int size)
 {
-  unsigned int sent = 0;
-  do
+  CSingleLock lock (m_critSection);
+  if (m_socket == INVALID_SOCKET)
+    return;
+
+  m_output.append(data, size);
+  if (m_output.size() > MAX_PENDING_OUTPUT)
   {
-    CSingleLock lock (m_critSection);
-    sent += send(m_socket, data + sent, size - sent, 0);
-  } while (sent < size);
+    CLog::Log(LOGWARNING, "JSONRPC Server: Client is not reading its output, disconnecting");
+    Shutdown();
+    return;
+  }
+
+  FlushOutput();
+}
+
+bool CTCPServer::CTCPClient::FlushOutput()
+{
+  CSingleLock lock (m_critSection);
+  size_t sent = 0;
+  while (sent < m_output.size() && m_socket != INVALID_SOCKET)
+  {
+    int res = send(m_socket, m_output.c_str() + sent, m_output.size() - sent, SEND_FLAGS);
+    if (res > 0)
+      sent += res;
+    else if (res < 0 && WouldBlock())
+      break;
+    else
+    {
+      m_output.clear();
+      m_failed = true;
+      m_outputCondition.notifyAll();
+      return false;
+    }
+  }
+  m_output.erase(0, sent);
+  if (sent > 0)
+    m_outputCondition.notifyAll();
+  return true;
+}
+
+bool CTCPServer::CTCPClient::HasPendingOutput()
+{
+  CSingleLock lock (m_critSection);
+  return !m_output.empty();
+}
+
+bool CTCPServer::CTCPClient::WaitForOutput(size_t size, unsigned int timeout)
+{
+  CSingleLock lock (m_critSection);
+  XbmcThreads::EndTime endTime(timeout);
+  while (m_output.size() > size && !m_failed && m_socket != INVALID_SOCKET && !endTime.IsTimePast())
+    m_outputCondition.wait(lock, endTime.MillisLeft());
+
+  return m_output.size() <= size && !m_failed && m_socket != INVALID_SOCKET;
+}
+
+bool CTCPServer::CTCPClient::HasFailed()
+{
+  CSingleLock lock (m_critSection);
+  return m_failed || m_socket == INVALID_SOCKET;
+}
+
+void CTCPServer::CTCPClient::Shutdown()
+{
+  CSingleLock lock (m_critSection);
+  // the server thread notices and drops the connection
+  m_output.clear();
+  m_failed = true;
+  if (m_socket != INVALID_SOCKET)
+    shutdown(m_socket, SHUT_RDWR);
+  m_outputCondition.notifyAll();
 }
 
 void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
 {
   m_new = false;
 
+  // only the characters relevant to the request boundaries are looked at, the
+  // data itself is copied in one go once a request is complete or the buffer ends
+  int start = 0;
   for (int i = 0; i < length; i++)
   {
     char c = buffer[i];
 
-    if (m_beginChar == 0 && c == '{')
+    if (m_beginChar == 0)
     {
-      m_beginChar = '{';
-      m_endChar = '}';
+      if (c == '{')
+      {
+        m_beginChar = '{';
+        m_endChar = '}';
+      }
+      else if (c == '[')
+      {
+        m_beginChar = '[';
+        m_endChar = ']';
+      }
+      else
+        continue;
+      start = i;
     }
-    else if (m_beginChar == 0 && c == '[')
+
+    if (m_inString)
     {
-      m_beginChar = '[';
-      m_endChar = ']';
+      if (m_escaped)
+        m_escaped = false;
+      else if (c == '\\')
+        m_escaped = true;
+      else if (c == '"')
+        m_inString = false;
     }
-
-    if (m_beginChar != 0)
+    else if (c == '"')
+      m_inString = true;
+    else if (c == m_beginChar)
+      m_depth++;
+    else if (c == m_endChar && --m_depth == 0)
     {
-      m_buffer.push_back(c);
-      if (c == m_beginChar)
-        m_beginBrackets++;
-      else if (c == m_endChar)
-        m_endBrackets++;
-      if (m_beginBrackets > 0 && m_endBrackets > 0 && m_beginBrackets == m_endBrackets)
-      {
-        std::string line = CJSONRPC::MethodCall(m_buffer, host, this);
-        Send(line.c_str(), line.size());
-        m_beginChar = m_beginBrackets = m_endBrackets = 0;
-        m_buffer.clear();
-      }
+      m_buffer.append(buffer + start, i + 1 - start);
+      m_received.push_back(m_buffer);
+      m_beginChar = m_endChar = 0;
+      m_buffer.clear();
     }
   }
+
+  if (m_beginChar != 0)
+    m_buffer.append(buffer + start, length - start);
 }
 
 void CTCPServer::CTCPClient::Disconnect()
 {
-  if (m_socket > 0)
+  CSingleLock lock (m_critSection);
+  if (m_socket != INVALID_SOCKET)
   {
-    CSingleLock lock (m_critSection);
     shutdown(m_socket, SHUT_RDWR);
     closesocket(m_socket);
     m_socket = INVALID_SOCKET;
+    m_outputCondition.notifyAll();
   }
 }
 
@@ -585,11 +1000,18 @@ void CTCPServer::CTCPClient::Copy(const CTCPClient& client)
   m_cliaddr           = client.m_cliaddr;
   m_addrlen           = client.m_addrlen;
   m_announcementflags = client.m_announcementflags;
-  m_beginBrackets     = client.m_beginBrackets;
-  m_endBrackets       = client.m_endBrackets;
+  m_received          = client.m_received;
+  m_requests          = client.m_requests;
+  m_queued            = client.m_queued;
+  m_inputPaused       = client.m_inputPaused;
+  m_depth             = client.m_depth;
+  m_inString          = client.m_inString;
+  m_escaped           = client.m_escaped;
   m_beginChar         = client.m_beginChar;
   m_endChar           = client.m_endChar;
   m_buffer            = client.m_buffer;
+  m_output            = client.m_output;
+  m_failed            = client.m_failed;
 }
 
 CTCPServer::CWebSocketClient::CWebSocketClient(CWebSocket *websocket)
@@ -625,6 +1047,8 @@ CTCPServer::CWebSocketClient& CTCPServer::CWebSocketClient::operator=(const CWeb
 
 void CTCPServer::CWebSocketClient::Send(const char *data, unsigned int size)
 {
+  // responses are sent from the workers, the websocket state is shared with the server thread
+  CSingleLock lock (m_critSection);
   const CWebSocketMessage *msg = m_websocket->Send(WebSocketTextFrame, data, size);
   if (msg == NULL || !msg->IsComplete())
     return;
@@ -636,6 +1060,7 @@ void CTCPServer::CWebSocketClient::Send(const char *data, unsigned int size)
 
 void CTCPServer::CWebSocketClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
 {
+  CSingleLock lock (m_critSection);
   bool send;
   const CWebSocketMessage *msg = NULL;
   size_t len = length;
@@ -666,7 +1091,8 @@ void CTCPServer::CWebSocketClient::PushBuffer(CTCPServer *host, const char *buff
 
 void CTCPServer::CWebSocketClient::Disconnect()
 {
-  if (m_socket > 0)
+  CSingleLock lock (m_critSection);
+  if (m_socket != INVALID_SOCKET)
   {
     if (m_websocket->GetState() != WebSocketStateClosed && m_websocket->GetState() != WebSocketStateNotConnected)
     {
@@ -19,6 +19,9 @@
  *
  */
 
+#include <deque>
+#include <map>
+#include <memory>
 #include <vector>
 #include <sys/socket.h>
 
@@ -26,12 +29,25 @@
 #include "interfaces/json-rpc/IClient.h"
 #include "interfaces/json-rpc/IJSONRPCAnnouncer.h"
 #include "interfaces/json-rpc/ITransportLayer.h"
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "threads/Condition.h"
 #include "threads/CriticalSection.h"
 #include "threads/Thread.h"
 #include "websocket/WebSocket.h"
 
 namespace JSONRPC
 {
+  class CTCPServerWorker;
+
+  /*!
+   \brief JSON-RPC server for raw TCP, bluetooth and websocket clients.
+
+   A single thread waits for socket events (epoll on linux, select elsewhere),
+   reads the requests and writes queued output without ever blocking on a
+   client. The method calls are run by a pool of worker threads, requests of
+   the same client are handled one after the other so its responses keep
+   their order.
+   */
   class CTCPServer : public ITransportLayer, public JSONRPC::IJSONRPCAnnouncer, public CThread
   {
   public:
@@ -47,6 +63,8 @@ namespace JSONRPC
   protected:
     void Process();
   private:
+    friend class CTCPServerWorker;
+
     CTCPServer(int port, bool nonlocal);
     bool Initialize();
     bool InitializeBlue();
@@ -67,26 +85,53 @@ namespace JSONRPC
       virtual int  GetAnnouncementFlags();
       virtual bool SetAnnouncementFlags(int flags);
 
+      /*! \brief Queue data for the client and send as much of it as possible without blocking */
       virtual void Send(const char *data, unsigned int size);
+      /*! \brief Split received data into requests, complete ones are added to m_received */
       virtual void PushBuffer(CTCPServer *host, const char *buffer, int length);
       virtual void Disconnect();
 
       virtual bool IsNew() const { return m_new; }
       virtual bool Closing() const { return false; }
 
+      /*! \brief Whether responses may be sent in several parts as they are produced */
+      virtual bool CanStreamResponses() const { return true; }
+
+      /*! \brief Send queued output until the socket would block
+       \return false if the connection failed
+       */
+      bool FlushOutput();
+      bool HasPendingOutput();
+      /*! \brief Wait until no more than size bytes of output are queued
+       \return false if the connection failed or the output wasn't sent in time
+       */
+      bool WaitForOutput(size_t size, unsigned int timeout);
+      bool HasFailed();
+      /*! \brief Drop the queued output and let the server thread close the connection */
+      void Shutdown();
+
       SOCKET           m_socket;
       sockaddr_storage m_cliaddr;
       socklen_t        m_addrlen;
       CCriticalSection m_critSection;
 
+      std::vector<std::string> m_received; ///< complete requests not yet queued, only used by the server thread
+      std::deque<std::string> m_requests;  ///< requests waiting for a worker, protected by the server's m_requestSection
+      bool m_queued;                       ///< whether the client is in the server's m_pendingClients or being handled by a worker
+      bool m_inputPaused;                  ///< whether reading stopped as too many requests are queued, protected by m_requestSection
+
     protected:
       void Copy(const CTCPClient& client);
     private:
       bool m_new;
       int m_announcementflags;
-      int m_beginBrackets, m_endBrackets;
+      int m_depth;
+      bool m_inString, m_escaped;
       char m_beginChar, m_endChar;
       std::string m_buffer;
+      std::string m_output;
+      bool m_failed;
+      XbmcThreads::ConditionVariable m_outputCondition;
     };
 
     class CWebSocketClient : public CTCPClient
@@ -102,6 +147,9 @@ namespace JSONRPC
       virtual void PushBuffer(CTCPServer *host, const char *buffer, int length);
       virtual void Disconnect();
 
+      // every Send() is a separate websocket message
+      virtual bool CanStreamResponses() const { return false; }
+
       virtual bool IsNew() const { return m_websocket == NULL; }
       virtual bool Closing() const { return m_websocket != NULL && m_websocket->GetState() == WebSocketStateClosed; }
 
@@ -109,11 +157,40 @@ namespace JSONRPC
       CWebSocket *m_websocket;
     };
 
-    std::vector<CTCPClient*> m_connections;
+    typedef std::shared_ptr<CTCPClient> CTCPClientPtr;
+    typedef std::map<SOCKET, CTCPClientPtr> ClientMap;
+
+    bool AcceptConnection(SOCKET server);
+    /*! \brief Read everything available from a client and queue its complete requests
+     \return false if the connection should be closed
+     */
+    bool HandleInput(ClientMap::iterator it);
+    void RemoveConnection(ClientMap::iterator it);
+
+    void QueueRequests(const CTCPClientPtr &client);
+    bool IsInputPaused(const CTCPClientPtr &client);
+    /*! \brief Have the server thread read from a client again after pausing it */
+    void ResumeInput(const CTCPClientPtr &client);
+    void ProcessRequests();
+    void SendResponse(const CTCPClientPtr &client, const JSONRPCResponsePtr &response);
+    void StartWorkers();
+    void StopWorkers();
+
+    ClientMap m_connections;
+    CCriticalSection m_connectionSection; ///< protects m_connections against announcements from other threads
     std::vector<SOCKET> m_servers;
     int m_port;
     bool m_nonlocal;
     void* m_sdpd;
+#ifdef TARGET_LINUX
+    int m_epoll;
+#endif
+
+    std::deque<CTCPClientPtr> m_pendingClients; ///< clients with requests waiting for a worker
+    CCriticalSection m_requestSection;
+    XbmcThreads::ConditionVariable m_requestCondition;
+    std::vector<CTCPServerWorker*> m_workers;
+    bool m_stopWorkers;
 
     static CTCPServer *ServerInstance;
   };
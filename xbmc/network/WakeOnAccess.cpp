@@ -35,6 +35,7 @@
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "settings/MediaSourceSettings.h"
+#include "threads/SystemClock.h"
 #include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/XMLUtils.h"
@@ -60,10 +61,10 @@ static int GetTotalSeconds(const CDateTimeSpan& ts)
   return ts.GetSeconds() + minutes * 60;
 }
 
-static unsigned long HostToIP(const std::string& host)
+static unsigned long HostToIP(const std::string& host, unsigned int timeout = XbmcThreads::EndTime::InfiniteValue)
 {
   std::string ip;
-  CDNSNameCache::Lookup(host, ip);
+  CDNSNameCache::Lookup(host, ip, timeout);
   return inet_addr(ip.c_str());
 }
 
@@ -242,7 +243,8 @@ public:
   }
   virtual bool SuccessWaiting () const
   {
-    unsigned long address = ntohl(HostToIP(m_host));
+    // polled by the progress dialog, so don't wait for the lookup
+    unsigned long address = ntohl(HostToIP(m_host, 0));
     bool online = g_application.getNetwork().HasInterfaceForIP(address);
 
     if (!online) // setup endtime so we dont return true until network is consistently connected
@@ -27,15 +27,21 @@
 #ifdef HAS_WEB_SERVER
 #include <memory>
 #include <algorithm>
+#ifdef TARGET_POSIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
 
 #include "URL.h"
 #include "Util.h"
 #include "XBDateTime.h"
 #include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
 #include "settings/Settings.h"
 #include "threads/SingleLock.h"
 #include "utils/Base64.h"
+#include "utils/CPUInfo.h"
 #include "utils/log.h"
 #include "utils/Mime.h"
 #include "utils/StringUtils.h"
@@ -57,6 +63,15 @@
 
 #define HEADER_NEWLINE        "\r\n"
 
+// mhd can only send files of up to 4GB from a file descriptor on 32bit platforms before 0.9.46
+#if (MHD_VERSION >= 0x00094600)
+#define MHD_CREATE_RESPONSE_FROM_FD(size, fd, offset) MHD_create_response_from_fd_at_offset64(size, fd, offset)
+#define MHD_FD_RESPONSE_MAX_SIZE UINT64_MAX
+#elif (MHD_VERSION >= 0x00090200)
+#define MHD_CREATE_RESPONSE_FROM_FD(size, fd, offset) MHD_create_response_from_fd_at_offset(static_cast<size_t>(size), fd, static_cast<off_t>(offset))
+#define MHD_FD_RESPONSE_MAX_SIZE SIZE_MAX
+#endif
+
 using namespace std;
 
 typedef struct ConnectionHandler
@@ -261,6 +276,22 @@ int CWebServer::AnswerToConnection(void *cls, struct MHD_Connection *connection,
                 cacheable = false;
             }
 
+            // handle If-None-Match (but only if the response is cacheable)
+            string etag;
+            bool hasETag = handler->GetETag(etag);
+            string ifNoneMatch = GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_NONE_MATCH);
+            if (cacheable && hasETag && MatchesETag(ifNoneMatch, etag))
+            {
+              struct MHD_Response *response = MHD_create_response_from_data(0, NULL, MHD_NO, MHD_NO);
+              if (response == NULL)
+              {
+                CLog::Log(LOGERROR, "CWebServer: failed to create a HTTP 304 response");
+                return MHD_NO;
+              }
+
+              return FinalizeRequest(handler, MHD_HTTP_NOT_MODIFIED, response);
+            }
+
             CDateTime lastModified;
             if (handler->GetLastModifiedDate(lastModified) && lastModified.IsValid())
             {
@@ -270,8 +301,9 @@ int CWebServer::AnswerToConnection(void *cls, struct MHD_Connection *connection,
 
               CDateTime ifModifiedSinceDate;
               CDateTime ifUnmodifiedSinceDate;
-              // handle If-Modified-Since (but only if the response is cacheable)
-              if (cacheable &&
+              // handle If-Modified-Since (but only if the response is cacheable
+              // and If-None-Match, which takes precedence, hasn't been provided)
+              if (cacheable && ifNoneMatch.empty() &&
                 ifModifiedSinceDate.SetFromRFC1123DateTime(ifModifiedSince) &&
                 lastModified.GetAsUTCDateTime() <= ifModifiedSinceDate)
               {
@@ -291,10 +323,16 @@ int CWebServer::AnswerToConnection(void *cls, struct MHD_Connection *connection,
             }
 
             // handle If-Range header but only if the Range header is present
-            if (ranged && lastModified.IsValid())
+            if (ranged && (lastModified.IsValid() || hasETag))
             {
               string ifRange = GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_RANGE);
-              if (!ifRange.empty() && lastModified.IsValid())
+              // If-Range either contains an entity tag (which must match exactly) or a date
+              if (StringUtils::StartsWith(ifRange, "\"") || StringUtils::StartsWith(ifRange, "W/"))
+              {
+                if (!hasETag || ifRange.compare(etag) != 0)
+                  ranges.Clear();
+              }
+              else if (!ifRange.empty() && lastModified.IsValid())
               {
                 CDateTime ifRangeDate;
                 ifRangeDate.SetFromRFC1123DateTime(ifRange);
@@ -468,6 +506,10 @@ int CWebServer::HandleRequest(IHTTPRequestHandler *handler)
       ret = CreateMemoryDownloadResponse(handler, response);
       break;
 
+    case HTTPStreamDownload:
+      ret = CreateStreamDownloadResponse(handler, response);
+      break;
+
     case HTTPError:
       ret = CreateErrorResponse(request.connection, responseDetails.status, request.method, response);
       break;
@@ -505,6 +547,11 @@ int CWebServer::FinalizeRequest(IHTTPRequestHandler *handler, int responseStatus
   if (handler->GetLastModifiedDate(lastModified) && lastModified.IsValid())
     handler->AddResponseHeader(MHD_HTTP_HEADER_LAST_MODIFIED, lastModified.GetAsRFC1123DateTime());
 
+  // if the request handler has set an entity tag and it hasn't been set as a header, add it
+  std::string etag;
+  if (handler->CanBeCached() && handler->GetETag(etag))
+    handler->AddResponseHeader(MHD_HTTP_HEADER_ETAG, etag);
+
   // check if the request handler has set Cache-Control and add it if not
   if (!handler->HasResponseHeader(MHD_HTTP_HEADER_CACHE_CONTROL))
   {
@@ -818,18 +865,26 @@ int CWebServer::CreateFileDownloadResponse(IHTTPRequestHandler *handler, struct
     // set the initial write position
     context->ranges.GetFirstPosition(context->writePosition);
 
-    // create the response object
-    response = MHD_create_response_from_callback(totalLength, 2048,
-                                                  &CWebServer::ContentReaderCallback,
-                                                  context.get(),
-                                                  &CWebServer::ContentReaderFreeCallback);
+    // a local file without multipart boundaries can be sent by mhd itself (using sendfile() where possible)
+    response = NULL;
+    if (context->rangeCountTotal == 1)
+      response = CreateFileDescriptorResponse(filePath, context->writePosition, totalLength);
+
     if (response == NULL)
     {
-      CLog::Log(LOGERROR, "CWebServer: failed to create a HTTP response for %s to be filled from %s", request.url.c_str(), filePath.c_str());
-      return MHD_NO;
+      // create the response object
+      response = MHD_create_response_from_callback(totalLength, 2048,
+                                                    &CWebServer::ContentReaderCallback,
+                                                    context.get(),
+                                                    &CWebServer::ContentReaderFreeCallback);
+      if (response == NULL)
+      {
+        CLog::Log(LOGERROR, "CWebServer: failed to create a HTTP response for %s to be filled from %s", request.url.c_str(), filePath.c_str());
+        return MHD_NO;
+      }
+
+      context.release(); // ownership was passed to mhd
     }
-        
-    context.release(); // ownership was passed to mhd
 
     // add Content-Range header
     if (ranged)
@@ -854,6 +909,72 @@ int CWebServer::CreateFileDownloadResponse(IHTTPRequestHandler *handler, struct
   return MHD_YES;
 }
 
+struct MHD_Response* CWebServer::CreateFileDescriptorResponse(const std::string &filePath, uint64_t offset, uint64_t length)
+{
+#if defined(TARGET_POSIX) && defined(MHD_CREATE_RESPONSE_FROM_FD)
+  if (length == 0 || length > MHD_FD_RESPONSE_MAX_SIZE)
+    return NULL;
+
+  // only plain local files (not in an archive or on a network share) can be used
+  std::string localPath = CSpecialProtocol::TranslatePath(filePath);
+  if (!CURL(localPath).GetProtocol().empty())
+    return NULL;
+
+  int fd = open(localPath.c_str(), O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  struct stat statBuffer;
+  if (fstat(fd, &statBuffer) != 0 || !S_ISREG(statBuffer.st_mode) ||
+      static_cast<uint64_t>(statBuffer.st_size) < offset + length)
+  {
+    close(fd);
+    return NULL;
+  }
+
+  // mhd takes over the file descriptor and closes it when the response is destroyed
+  struct MHD_Response *response = MHD_CREATE_RESPONSE_FROM_FD(length, fd, offset);
+  if (response == NULL)
+    close(fd);
+
+  return response;
+#else
+  return NULL;
+#endif
+}
+
+int CWebServer::CreateStreamDownloadResponse(IHTTPRequestHandler *handler, struct MHD_Response *&response)
+{
+  if (handler == NULL)
+    return MHD_NO;
+
+  const HTTPRequest &request = handler->GetRequest();
+  std::unique_ptr<IHTTPResponseStream> stream(handler->GetResponseStream());
+  if (stream.get() == NULL)
+  {
+    CLog::Log(LOGERROR, "CWebServer: no response stream for %s", request.url.c_str());
+    return MHD_NO;
+  }
+
+  if (request.method == HEAD)
+    return CreateMemoryDownloadResponse(request.connection, NULL, 0, false, false, response);
+
+  // the length is unknown so the response is sent in chunks (or until the connection is closed for HTTP/1.0)
+  response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, 32 * 1024,
+                                                &CWebServer::StreamReaderCallback,
+                                                stream.get(),
+                                                &CWebServer::StreamReaderFreeCallback);
+  if (response == NULL)
+  {
+    CLog::Log(LOGERROR, "CWebServer: failed to create a HTTP response for %s to be filled from a stream", request.url.c_str());
+    return MHD_NO;
+  }
+
+  stream.release(); // ownership was passed to mhd
+
+  return MHD_YES;
+}
+
 int CWebServer::CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method, struct MHD_Response *&response)
 {
   size_t payloadSize = 0;
@@ -1035,6 +1156,40 @@ void CWebServer::ContentReaderFreeCallback(void *cls)
 #endif
 }
 
+#if (MHD_VERSION >= 0x00090200)
+ssize_t CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, size_t max)
+#elif (MHD_VERSION >= 0x00040001)
+int CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, int max)
+#else   //libmicrohttpd < 0.4.0
+int CWebServer::StreamReaderCallback(void *cls, size_t pos, char *buf, int max)
+#endif
+{
+  IHTTPResponseStream *stream = (IHTTPResponseStream *)cls;
+  if (stream == NULL || max <= 0)
+    return -1;
+
+  // 0 would make mhd call us again later, the end of the stream is signalled with -1
+  ssize_t res = stream->Read(buf, static_cast<size_t>(max));
+  if (res <= 0)
+    return -1;
+
+#ifdef WEBSERVER_DEBUG
+  CLog::Log(LOGDEBUG, "webserver [OUT] streamed %d bytes from %" PRIu64, (int)res, (uint64_t)pos);
+#endif
+
+  return res;
+}
+
+void CWebServer::StreamReaderFreeCallback(void *cls)
+{
+  IHTTPResponseStream *stream = (IHTTPResponseStream *)cls;
+  delete stream;
+
+#ifdef WEBSERVER_DEBUG
+  CLog::Log(LOGDEBUG, "webserver [OUT] done");
+#endif
+}
+
 struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, int port)
 {
   unsigned int timeout = 60 * 60 * 24;
@@ -1058,7 +1213,8 @@ struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, int port)
                           this,
 
 #if (MHD_VERSION >= 0x00040002) && (MHD_VERSION < 0x00090B01)
-                          MHD_OPTION_THREAD_POOL_SIZE, 4,
+                          // requests mostly wait for (network) file access so use more threads than cores
+                          MHD_OPTION_THREAD_POOL_SIZE, static_cast<unsigned int>(std::max(4, g_cpuInfo.getCPUCount() * 2)),
 #endif
                           MHD_OPTION_CONNECTION_LIMIT, 512,
                           MHD_OPTION_CONNECTION_TIMEOUT, timeout,
@@ -1236,6 +1392,30 @@ bool CWebServer::GetRequestedRanges(struct MHD_Connection *connection, uint64_t
   return ranges.Parse(GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_RANGE), totalLength);
 }
 
+bool CWebServer::MatchesETag(const std::string &ifNoneMatch, const std::string &etag)
+{
+  if (ifNoneMatch.empty() || etag.empty())
+    return false;
+
+  std::string trimmed = ifNoneMatch;
+  if (StringUtils::Trim(trimmed) == "*")
+    return true;
+
+  // If-None-Match uses the weak comparison so the W/ prefixes can be ignored
+  std::string strongETag = StringUtils::StartsWith(etag, "W/") ? etag.substr(2) : etag;
+  std::vector<std::string> etags = StringUtils::Split(ifNoneMatch, ",");
+  for (std::vector<std::string>::iterator it = etags.begin(); it != etags.end(); ++it)
+  {
+    std::string tag = StringUtils::Trim(*it);
+    if (StringUtils::StartsWith(tag, "W/"))
+      tag.erase(0, 2);
+    if (tag == strongETag)
+      return true;
+  }
+
+  return false;
+}
+
 std::string CWebServer::CreateMimeTypeFromExtension(const char *ext)
 {
   if (strcmp(ext, ".kar") == 0)
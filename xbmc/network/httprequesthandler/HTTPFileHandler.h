@@ -34,6 +34,7 @@ public:
   virtual bool CanHandleRanges() const { return m_canHandleRanges; }
   virtual bool CanBeCached() const { return m_canBeCached; }
   virtual bool GetLastModifiedDate(CDateTime &lastModified) const;
+  virtual bool GetETag(std::string &etag) const;
 
   virtual std::string GetRedirectUrl() const { return m_url; }
   virtual std::string GetResponseFile() const { return m_url; }
@@ -47,6 +48,7 @@ protected:
   void SetCanHandleRanges(bool canHandleRanges) { m_canHandleRanges = canHandleRanges; }
   void SetCanBeCached(bool canBeCached) { m_canBeCached = canBeCached; }
   void SetLastModifiedDate(CDateTime lastModified) { m_lastModified = lastModified; }
+  void SetETag(const std::string &etag) { m_etag = etag; }
 
 private:
   std::string m_url;
@@ -55,5 +57,6 @@ private:
   bool m_canBeCached;
 
   CDateTime m_lastModified;
+  std::string m_etag;
 
 };
@@ -21,6 +21,7 @@
 #include <map>
 
 #include "HTTPImageTransformationHandler.h"
+#include "ImageTransformationCache.h"
 #include "TextureCacheJob.h"
 #include "URL.h"
 #include "filesystem/ImageFile.h"
@@ -37,7 +38,7 @@ static const std::string ImageBasePath = "/image/";
 CHTTPImageTransformationHandler::CHTTPImageTransformationHandler()
   : m_url(),
     m_lastModified(),
-    m_buffer(NULL),
+    m_image(),
     m_responseData()
 { }
 
@@ -45,7 +46,7 @@ CHTTPImageTransformationHandler::CHTTPImageTransformationHandler(const HTTPReque
   : IHTTPRequestHandler(request),
     m_url(),
     m_lastModified(),
-    m_buffer(NULL),
+    m_image(),
     m_responseData()
 {
   m_url = m_request.url.substr(ImageBasePath.size());
@@ -96,8 +97,6 @@ CHTTPImageTransformationHandler::CHTTPImageTransformationHandler(const HTTPReque
 CHTTPImageTransformationHandler::~CHTTPImageTransformationHandler()
 {
   m_responseData.clear();
-  delete m_buffer;
-  m_buffer = NULL;
 }
 
 bool CHTTPImageTransformationHandler::CanHandleRequest(const HTTPRequest &request)
@@ -148,9 +147,9 @@ int CHTTPImageTransformationHandler::HandleRequest()
     imagePath += StringUtils::Join(urlOptions, "&");
   }
 
-  // resize the image into the local buffer
-  size_t bufferSize;
-  if (!CTextureCacheJob::ResizeTexture(imagePath, m_buffer, bufferSize))
+  // get the resized image from the cache (or resize it now)
+  m_image = CImageTransformationCache::Get().GetTransformedImage(imagePath, m_response.contentType, m_lastModified, CTextureCacheJob::ResizeTexture);
+  if (m_image == NULL)
   {
     m_response.status = MHD_HTTP_INTERNAL_SERVER_ERROR;
     m_response.type = HTTPError;
@@ -159,17 +158,17 @@ int CHTTPImageTransformationHandler::HandleRequest()
   }
 
   // store the size of the image
-  m_response.totalLength = bufferSize;
+  m_response.totalLength = m_image->size();
 
   // nothing else to do if the request is not ranged
   if (!GetRequestedRanges(m_response.totalLength))
   {
-    m_responseData.push_back(CHttpResponseRange(m_buffer, 0, m_response.totalLength - 1));
+    m_responseData.push_back(CHttpResponseRange(m_image->c_str(), 0, m_response.totalLength - 1));
     return MHD_YES;
   }
 
   for (HttpRanges::const_iterator range = m_request.ranges.Begin(); range != m_request.ranges.End(); ++range)
-    m_responseData.push_back(CHttpResponseRange(m_buffer + range->GetFirstPosition(), range->GetFirstPosition(), range->GetLastPosition()));
+    m_responseData.push_back(CHttpResponseRange(m_image->c_str() + range->GetFirstPosition(), range->GetFirstPosition(), range->GetLastPosition()));
 
   return MHD_YES;
 }
@@ -19,7 +19,7 @@
  *
  */
 
-#include <stdint.h>
+#include <memory>
 #include <string>
 
 #include "XBDateTime.h"
@@ -52,6 +52,6 @@ private:
   std::string m_url;
   CDateTime m_lastModified;
 
-  uint8_t* m_buffer;
+  std::shared_ptr<const std::string> m_image;
   HttpResponseRanges m_responseData;
 };
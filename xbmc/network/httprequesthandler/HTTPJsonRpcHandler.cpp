@@ -18,6 +18,8 @@
  *
  */
 
+#include <algorithm>
+
 #include "HTTPJsonRpcHandler.h"
 #include "interfaces/json-rpc/JSONRPC.h"
 #include "interfaces/json-rpc/JSONServiceDescription.h"
@@ -80,10 +82,26 @@ int CHTTPJsonRpcHandler::HandleRequest()
 
   if (isRequest)
   {
-    m_responseData = JSONRPC::CJSONRPC::MethodCall(m_requestData, m_request.webserver, &client);
+    JSONRPC::JSONRPCResponsePtr response = JSONRPC::CJSONRPC::MethodCallStreamed(m_requestData, m_request.webserver, &client);
 
     if (!jsonpCallback.empty())
-      m_responseData = jsonpCallback + "(" + m_responseData + ");";
+      response->Wrap(jsonpCallback + "(", ");");
+
+    // large results are only serialized while they are being sent
+    if (response->IsStreamed())
+    {
+      m_requestData.clear();
+      m_streamedResponse = response;
+
+      m_response.type = HTTPStreamDownload;
+      m_response.status = MHD_HTTP_OK;
+      m_response.contentType = "application/json";
+      m_response.totalLength = 0;
+
+      return MHD_YES;
+    }
+
+    m_responseData = response->ToString();
   }
   else if (jsonpCallback.empty())
   {
@@ -120,6 +138,17 @@ HttpResponseRanges CHTTPJsonRpcHandler::GetResponseData() const
   return ranges;
 }
 
+IHTTPResponseStream* CHTTPJsonRpcHandler::GetResponseStream()
+{
+  if (!m_streamedResponse)
+    return NULL;
+
+  IHTTPResponseStream *stream = new CResponseStream(m_streamedResponse);
+  m_streamedResponse.reset();
+
+  return stream;
+}
+
 #if (MHD_VERSION >= 0x00040001)
 bool CHTTPJsonRpcHandler::appendPostData(const char *data, size_t size)
 #else
@@ -137,6 +166,29 @@ bool CHTTPJsonRpcHandler::appendPostData(const char *data, unsigned int size)
   return true;
 }
 
+CHTTPJsonRpcHandler::CResponseStream::CResponseStream(const JSONRPC::JSONRPCResponsePtr &response)
+  : m_response(response),
+    m_offset(0)
+{ }
+
+ssize_t CHTTPJsonRpcHandler::CResponseStream::Read(char *buffer, size_t size)
+{
+  if (m_offset >= m_data.size())
+  {
+    m_data.clear();
+    m_offset = 0;
+    if (!m_response->Read(m_data, size))
+      return 0;
+  }
+
+  // a single streamed element may be bigger than the buffer
+  size_t count = std::min(size, m_data.size() - m_offset);
+  memcpy(buffer, m_data.c_str() + m_offset, count);
+  m_offset += count;
+
+  return count;
+}
+
 int CHTTPJsonRpcHandler::CHTTPClient::GetPermissionFlags()
 {
   return JSONRPC::OPERATION_PERMISSION_ALL;
@@ -22,6 +22,7 @@
 #include <string>
 
 #include "interfaces/json-rpc/IClient.h"
+#include "interfaces/json-rpc/JSONRPC.h"
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
 
 class CHTTPJsonRpcHandler : public IHTTPRequestHandler
@@ -36,6 +37,7 @@ public:
   virtual int HandleRequest();
 
   virtual HttpResponseRanges GetResponseData() const;
+  virtual IHTTPResponseStream* GetResponseStream();
 
   virtual int GetPriority() const { return 2; }
 
@@ -54,6 +56,20 @@ private:
   std::string m_requestData;
   std::string m_responseData;
   CHttpResponseRange m_responseRange;
+  JSONRPC::JSONRPCResponsePtr m_streamedResponse;
+
+  class CResponseStream : public IHTTPResponseStream
+  {
+  public:
+    explicit CResponseStream(const JSONRPC::JSONRPCResponsePtr &response);
+
+    virtual ssize_t Read(char *buffer, size_t size);
+
+  private:
+    JSONRPC::JSONRPCResponsePtr m_response;
+    std::string m_data;
+    size_t m_offset;
+  };
 
   class CHTTPClient : public JSONRPC::IClient
   {
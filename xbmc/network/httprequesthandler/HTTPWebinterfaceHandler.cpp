@@ -18,17 +18,44 @@
  *
  */
 
+#include <list>
+#include <map>
+
+#include <zlib.h>
+
 #include "HTTPWebinterfaceHandler.h"
 #include "addons/AddonManager.h"
 #include "filesystem/Directory.h"
 #include "filesystem/File.h"
+#include "network/WebServer.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 
 #define DEFAULT_PAGE        "index.html"
 
+// only reasonably small files are compressed and kept in memory
+#define COMPRESS_MAX_FILE_SIZE    (2 * 1024 * 1024)
+#define COMPRESS_CACHE_MAX_SIZE   (8 * 1024 * 1024)
+
+typedef struct CompressedFile
+{
+  std::string etag;
+  std::shared_ptr<const std::string> data;
+  std::list<std::string>::iterator usage;
+} CompressedFile;
+
+static CCriticalSection s_compressedFilesSection;
+static std::map<std::string, CompressedFile> s_compressedFiles;
+static std::list<std::string> s_compressedFilesUsage; // most recently used first
+static size_t s_compressedFilesSize = 0;
+
 CHTTPWebinterfaceHandler::CHTTPWebinterfaceHandler(const HTTPRequest &request)
-  : CHTTPFileHandler(request)
+  : CHTTPFileHandler(request),
+    m_compressed(false),
+    m_compressedData()
 {
   // resolve the URL into a file path and a HTTP response status
   std::string file;
@@ -36,6 +63,43 @@ CHTTPWebinterfaceHandler::CHTTPWebinterfaceHandler(const HTTPRequest &request)
 
   // set the file and the HTTP response status
   SetFile(file, responseStatus);
+
+  PrepareResponse(request);
+}
+
+CHTTPWebinterfaceHandler::CHTTPWebinterfaceHandler(const HTTPRequest &request, const std::string &file, int responseStatus)
+  : CHTTPFileHandler(request),
+    m_compressed(false),
+    m_compressedData()
+{
+  SetFile(file, responseStatus);
+
+  PrepareResponse(request);
+}
+
+void CHTTPWebinterfaceHandler::PrepareResponse(const HTTPRequest &request)
+{
+  // static files of the web interface are sent compressed if the client supports it
+  if (CanBeCompressed(request))
+  {
+    std::string etag;
+    GetETag(etag);
+    m_compressedData = GetCompressedFile(GetResponseFile(), etag);
+    // otherwise the uncompressed file is sent as usual
+    if (m_compressedData != NULL)
+    {
+      m_compressed = true;
+
+      // compressed files can't be sent partially and need their own entity tag
+      SetCanHandleRanges(false);
+      if (!etag.empty())
+        SetETag(etag.substr(0, etag.size() - 1) + "-gzip\"");
+    }
+  }
+
+  // caches must keep the compressed and the uncompressed response apart
+  if (m_response.type == HTTPFileDownload)
+    AddResponseHeader(MHD_HTTP_HEADER_VARY, "Accept-Encoding");
 }
 
 bool CHTTPWebinterfaceHandler::CanHandleRequest(const HTTPRequest &request)
@@ -43,6 +107,27 @@ bool CHTTPWebinterfaceHandler::CanHandleRequest(const HTTPRequest &request)
   return true;
 }
 
+int CHTTPWebinterfaceHandler::HandleRequest()
+{
+  if (!m_compressed)
+    return CHTTPFileHandler::HandleRequest();
+
+  m_response.type = HTTPMemoryDownloadNoFreeCopy;
+  m_response.totalLength = m_compressedData->size();
+  AddResponseHeader(MHD_HTTP_HEADER_CONTENT_ENCODING, "gzip");
+
+  return MHD_YES;
+}
+
+HttpResponseRanges CHTTPWebinterfaceHandler::GetResponseData() const
+{
+  HttpResponseRanges ranges;
+  if (m_compressedData != NULL)
+    ranges.push_back(CHttpResponseRange(m_compressedData->c_str(), m_compressedData->size()));
+
+  return ranges;
+}
+
 int CHTTPWebinterfaceHandler::ResolveUrl(const std::string &url, std::string &path)
 {
   ADDON::AddonPtr dummyAddon;
@@ -118,3 +203,109 @@ int CHTTPWebinterfaceHandler::ResolveUrl(const std::string &url, std::string &pa
 
   return MHD_HTTP_OK;
 }
+
+bool CHTTPWebinterfaceHandler::CanBeCompressed(const HTTPRequest &request) const
+{
+  if (request.method != GET || m_response.type != HTTPFileDownload)
+    return false;
+
+  // only text based content profits from compression
+  const std::string &contentType = m_response.contentType;
+  if (!StringUtils::StartsWith(contentType, "text/") &&
+      contentType != "application/javascript" && contentType != "application/x-javascript" &&
+      contentType != "application/json" && contentType != "application/xml" &&
+      contentType != "image/svg+xml")
+    return false;
+
+  // ranges refer to the uncompressed file
+  if (!CWebServer::GetRequestHeaderValue(request.connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_RANGE).empty())
+    return false;
+
+  std::string acceptEncoding = CWebServer::GetRequestHeaderValue(request.connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_ACCEPT_ENCODING);
+  StringUtils::ToLower(acceptEncoding);
+  if (acceptEncoding.find("gzip") == std::string::npos)
+    return false;
+
+  struct __stat64 statBuffer;
+  if (XFILE::CFile::Stat(GetResponseFile(), &statBuffer) != 0 ||
+      statBuffer.st_size <= 0 || statBuffer.st_size > COMPRESS_MAX_FILE_SIZE)
+    return false;
+
+  return true;
+}
+
+std::shared_ptr<const std::string> CHTTPWebinterfaceHandler::GetCompressedFile(const std::string &file, const std::string &etag)
+{
+  {
+    CSingleLock lock(s_compressedFilesSection);
+    std::map<std::string, CompressedFile>::const_iterator it = s_compressedFiles.find(file);
+    if (it != s_compressedFiles.end() && it->second.etag == etag)
+    {
+      s_compressedFilesUsage.splice(s_compressedFilesUsage.begin(), s_compressedFilesUsage, it->second.usage);
+      return it->second.data;
+    }
+  }
+
+  // compress the file without holding the lock
+  std::string compressed;
+  if (!Compress(file, compressed))
+    return std::shared_ptr<const std::string>();
+
+  std::shared_ptr<const std::string> data = std::make_shared<const std::string>(compressed);
+  if (data->size() > COMPRESS_CACHE_MAX_SIZE)
+    return data;
+
+  CSingleLock lock(s_compressedFilesSection);
+  std::map<std::string, CompressedFile>::iterator it = s_compressedFiles.find(file);
+  if (it != s_compressedFiles.end())
+  {
+    s_compressedFilesSize -= it->second.data->size();
+    s_compressedFilesUsage.erase(it->second.usage);
+    s_compressedFiles.erase(it);
+  }
+
+  // make room for the new file by dropping the least recently used ones
+  while (!s_compressedFilesUsage.empty() && s_compressedFilesSize + data->size() > COMPRESS_CACHE_MAX_SIZE)
+  {
+    it = s_compressedFiles.find(s_compressedFilesUsage.back());
+    s_compressedFilesSize -= it->second.data->size();
+    s_compressedFiles.erase(it);
+    s_compressedFilesUsage.pop_back();
+  }
+
+  s_compressedFilesUsage.push_front(file);
+  CompressedFile compressedFile = { etag, data, s_compressedFilesUsage.begin() };
+  s_compressedFiles.insert(std::make_pair(file, compressedFile));
+  s_compressedFilesSize += data->size();
+
+  return data;
+}
+
+bool CHTTPWebinterfaceHandler::Compress(const std::string &file, std::string &compressed)
+{
+  XFILE::auto_buffer buffer;
+  if (XFILE::CFile().LoadFile(file, buffer) <= 0)
+    return false;
+
+  z_stream stream = { };
+  // 15 + 16 tells zlib to write a gzip header and trailer
+  if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+
+  compressed.resize(deflateBound(&stream, buffer.size()));
+  stream.next_in = reinterpret_cast<Bytef*>(buffer.get());
+  stream.avail_in = buffer.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+  stream.avail_out = compressed.size();
+
+  int result = deflate(&stream, Z_FINISH);
+  deflateEnd(&stream);
+  if (result != Z_STREAM_END)
+  {
+    CLog::Log(LOGWARNING, "CHTTPWebinterfaceHandler: failed to compress %s", file.c_str());
+    return false;
+  }
+
+  compressed.resize(stream.total_out);
+  return true;
+}
@@ -19,6 +19,7 @@
  *
  */
 
+#include <memory>
 #include <string>
 
 #include "addons/IAddon.h"
@@ -32,10 +33,27 @@ public:
   
   virtual IHTTPRequestHandler* Create(const HTTPRequest &request) { return new CHTTPWebinterfaceHandler(request); }
   virtual bool CanHandleRequest(const HTTPRequest &request);
+
+  virtual int HandleRequest();
+  virtual HttpResponseRanges GetResponseData() const;
   
   static int ResolveUrl(const std::string &url, std::string &path);
   static int ResolveUrl(const std::string &url, std::string &path, ADDON::AddonPtr &addon);
 
 protected:
   explicit CHTTPWebinterfaceHandler(const HTTPRequest &request);
+  /*!
+   * \brief Serves the given file which has already been resolved from the URL.
+   */
+  CHTTPWebinterfaceHandler(const HTTPRequest &request, const std::string &file, int responseStatus);
+
+private:
+  void PrepareResponse(const HTTPRequest &request);
+  bool CanBeCompressed(const HTTPRequest &request) const;
+
+  static std::shared_ptr<const std::string> GetCompressedFile(const std::string &file, const std::string &etag);
+  static bool Compress(const std::string &file, std::string &compressed);
+
+  bool m_compressed;
+  std::shared_ptr<const std::string> m_compressedData;
 };
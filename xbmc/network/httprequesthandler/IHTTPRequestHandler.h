@@ -62,7 +62,9 @@ typedef enum HTTPResponseType
   HTTPMemoryDownloadFreeNoCopy,
   // creates a HTTP response from a buffer by copying followed by freeing the buffer
   // the buffer must have been malloc'ed and not new'ed
-  HTTPMemoryDownloadFreeCopy
+  HTTPMemoryDownloadFreeCopy,
+  // creates a HTTP response of unknown length with the content read from a stream
+  HTTPStreamDownload
 } HTTPResponseType;
 
 typedef struct HTTPRequest
@@ -83,6 +85,25 @@ typedef struct HTTPResponseDetails {
   uint64_t totalLength;
 } HTTPResponseDetails;
 
+/*!
+ * \brief Content of a HTTP response which is only produced while it is sent.
+ */
+class IHTTPResponseStream
+{
+public:
+  virtual ~IHTTPResponseStream() { }
+
+  /*!
+   * \brief Fills the given buffer with the next part of the response.
+   *
+   * \param buffer Buffer to fill
+   * \param size Size of the buffer
+   * \return Number of bytes written to the buffer, 0 at the end of the response
+   * or a negative value if an error occurred.
+   */
+  virtual ssize_t Read(char *buffer, size_t size) = 0;
+};
+
 class IHTTPRequestHandler
 {
 public:
@@ -146,6 +167,13 @@ public:
   * \details This is only used if the response can be cached.
   */
   virtual bool GetLastModifiedDate(CDateTime &lastModified) const { return false; }
+
+  /*!
+  * \brief Returns the entity tag (including the quotes) of the response data.
+  *
+  * \details This is only used if the response can be cached.
+  */
+  virtual bool GetETag(std::string &etag) const { return false; }
  
   /*!
    * \brief Returns the ranges with raw data belonging to the response.
@@ -168,6 +196,14 @@ public:
   */
   virtual std::string GetResponseFile() const { return ""; }
 
+  /*!
+  * \brief Returns the stream providing the content of the response.
+  *
+  * \details This is only used if the response type is HTTPStreamDownload.
+  * The caller takes over ownership of the returned stream.
+  */
+  virtual IHTTPResponseStream* GetResponseStream() { return NULL; }
+
   /*!
   * \brief Returns the HTTP request handled by the HTTP request handler.
   */
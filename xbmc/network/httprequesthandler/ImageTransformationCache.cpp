@@ -0,0 +1,255 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ImageTransformationCache.h"
+#include "FileItem.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#define IMAGE_TRANSFORMATION_CACHE_PATH     "special://temp/imagetransformations/"
+#define IMAGE_TRANSFORMATION_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+using namespace XFILE;
+
+class CImageTransformationCache::CPendingTransformation
+{
+public:
+  CPendingTransformation()
+    : m_done(true, false),
+      m_data()
+  { }
+
+  CEvent m_done;
+  std::shared_ptr<const std::string> m_data;
+};
+
+CImageTransformationCache::CImageTransformationCache(const std::string &cachePath, uint64_t maxSize)
+  : m_cachePath(cachePath),
+    m_maxSize(maxSize),
+    m_size(0),
+    m_nextFile(0),
+    m_hits(0),
+    m_misses(0)
+{
+  // the index isn't persisted so anything left over from a previous run is useless
+  CFileItemList items;
+  if (CDirectory::GetDirectory(m_cachePath, items, "", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE))
+  {
+    for (int i = 0; i < items.Size(); i++)
+    {
+      if (!items[i]->m_bIsFolder)
+        CFile::Delete(items[i]->GetPath());
+    }
+  }
+  else
+    CDirectory::Create(m_cachePath);
+}
+
+CImageTransformationCache::~CImageTransformationCache()
+{ }
+
+CImageTransformationCache& CImageTransformationCache::Get()
+{
+  static CImageTransformationCache sImageTransformationCache(IMAGE_TRANSFORMATION_CACHE_PATH, IMAGE_TRANSFORMATION_CACHE_MAX_SIZE);
+  return sImageTransformationCache;
+}
+
+void CImageTransformationCache::Deinitialize()
+{
+  std::vector<std::string> removedFiles;
+  {
+    CSingleLock lock(m_critical);
+    while (!m_images.empty())
+      Remove(m_images.begin(), removedFiles);
+  }
+
+  for (std::vector<std::string>::const_iterator file = removedFiles.begin(); file != removedFiles.end(); ++file)
+    CFile::Delete(*file);
+}
+
+std::shared_ptr<const std::string> CImageTransformationCache::GetTransformedImage(const std::string &image, const std::string &format,
+                                                                                  const CDateTime &lastModified, TransformFunc transform)
+{
+  if (image.empty() || transform == NULL)
+    return std::shared_ptr<const std::string>();
+
+  const std::string key = format + "|" + image;
+  std::vector<std::string> removedFiles;
+
+  std::string cachedFile;
+  size_t cachedSize = 0;
+  {
+    CSingleLock lock(m_critical);
+    std::map<std::string, CachedImage>::iterator cachedImage = m_images.find(key);
+    if (cachedImage != m_images.end())
+    {
+      if (lastModified.IsValid() && cachedImage->second.lastModified == lastModified)
+      {
+        m_usage.splice(m_usage.begin(), m_usage, cachedImage->second.usage);
+        cachedFile = cachedImage->second.file;
+        cachedSize = cachedImage->second.size;
+      }
+      else // the original image has changed or its modification date is unknown
+        Remove(cachedImage, removedFiles);
+    }
+  }
+
+  if (!cachedFile.empty())
+  {
+    // read the cached image from disk
+    auto_buffer buffer;
+    if (CFile().LoadFile(cachedFile, buffer) == static_cast<ssize_t>(cachedSize))
+    {
+      CSingleLock lock(m_critical);
+      m_hits++;
+
+      return std::make_shared<const std::string>(buffer.get(), buffer.size());
+    }
+
+    // the cached image is broken (or has just been removed)
+    CSingleLock lock(m_critical);
+    std::map<std::string, CachedImage>::iterator cachedImage = m_images.find(key);
+    if (cachedImage != m_images.end() && cachedImage->second.file == cachedFile)
+      Remove(cachedImage, removedFiles);
+  }
+
+  PendingTransformationPtr pending;
+  bool transformImage = false;
+  {
+    CSingleLock lock(m_critical);
+    // someone else might already be transforming the same image
+    std::map<std::string, PendingTransformationPtr>::const_iterator pendingTransformation = m_pending.find(key);
+    if (pendingTransformation != m_pending.end())
+    {
+      pending = pendingTransformation->second;
+      m_hits++;
+    }
+    else
+    {
+      pending = std::make_shared<CPendingTransformation>();
+      m_pending.insert(std::make_pair(key, pending));
+      m_misses++;
+      transformImage = true;
+    }
+  }
+
+  if (transformImage)
+  {
+    uint8_t *result = NULL;
+    size_t resultSize = 0;
+    if (transform(image, result, resultSize) && result != NULL && resultSize > 0)
+      pending->m_data = std::make_shared<const std::string>(reinterpret_cast<const char*>(result), resultSize);
+    delete[] result;
+
+    // write the transformed image to disk before making it available
+    std::string file;
+    if (pending->m_data != NULL && lastModified.IsValid() && !Write(*pending->m_data, file))
+      CLog::Log(LOGWARNING, "CImageTransformationCache: failed to cache transformed image %s", image.c_str());
+
+    CSingleLock lock(m_critical);
+    if (!file.empty())
+      Add(key, file, pending->m_data->size(), lastModified, removedFiles);
+    m_pending.erase(key);
+    pending->m_done.Set();
+  }
+
+  for (std::vector<std::string>::const_iterator file = removedFiles.begin(); file != removedFiles.end(); ++file)
+    CFile::Delete(*file);
+
+  pending->m_done.Wait();
+  return pending->m_data;
+}
+
+uint64_t CImageTransformationCache::GetHits() const
+{
+  CSingleLock lock(m_critical);
+  return m_hits;
+}
+
+uint64_t CImageTransformationCache::GetMisses() const
+{
+  CSingleLock lock(m_critical);
+  return m_misses;
+}
+
+uint64_t CImageTransformationCache::GetSize() const
+{
+  CSingleLock lock(m_critical);
+  return m_size;
+}
+
+bool CImageTransformationCache::Write(const std::string &data, std::string &file)
+{
+  if (data.size() > m_maxSize)
+    return false;
+
+  unsigned int fileNumber;
+  {
+    CSingleLock lock(m_critical);
+    fileNumber = m_nextFile++;
+  }
+
+  std::string path = URIUtils::AddFileToFolder(m_cachePath, StringUtils::Format("%08x.img", fileNumber));
+  CFile cacheFile;
+  if (!cacheFile.OpenForWrite(path, true))
+    return false;
+
+  bool success = cacheFile.Write(data.c_str(), data.size()) == static_cast<ssize_t>(data.size());
+  cacheFile.Close();
+  if (!success)
+  {
+    CFile::Delete(path);
+    return false;
+  }
+
+  file = path;
+  return true;
+}
+
+void CImageTransformationCache::Add(const std::string &key, const std::string &file, size_t size, const CDateTime &lastModified, std::vector<std::string> &removedFiles)
+{
+  // replace any older version of the same image
+  Remove(m_images.find(key), removedFiles);
+
+  // make room for the new image by removing the least recently used ones
+  while (!m_usage.empty() && m_size + size > m_maxSize)
+    Remove(m_images.find(m_usage.back()), removedFiles);
+
+  m_usage.push_front(key);
+  CachedImage cachedImage = { file, size, lastModified, m_usage.begin() };
+  m_images.insert(std::make_pair(key, cachedImage));
+  m_size += size;
+}
+
+void CImageTransformationCache::Remove(std::map<std::string, CachedImage>::iterator image, std::vector<std::string> &removedFiles)
+{
+  if (image == m_images.end())
+    return;
+
+  removedFiles.push_back(image->second.file);
+  m_size -= image->second.size;
+  m_usage.erase(image->second.usage);
+  m_images.erase(image);
+}
@@ -0,0 +1,110 @@
+#pragma once
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <list>
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "XBDateTime.h"
+#include "threads/CriticalSection.h"
+
+/*!
+ \brief Cache of transformed (e.g. resized) images served by the web server.
+
+ The transformed images are stored on disk while an in-memory index keeps
+ track of them in least recently used order. The total size of the stored
+ images is limited and the least recently used ones are removed first.
+ Concurrent requests for the same transformation only run it once.
+ Images without a valid modification date are never cached as there is no
+ way to tell whether the cached transformation is still up to date.
+ */
+class CImageTransformationCache
+{
+public:
+  /*!
+   \brief Transforms the given image (including its transformation options).
+   \param image path of the image including the transformation options
+   \param result the transformed image (allocated with new[])
+   \param result_size size of the transformed image
+   \return true if the image was transformed, false otherwise
+   */
+  typedef bool (*TransformFunc)(const std::string &image, uint8_t* &result, size_t &result_size);
+
+  CImageTransformationCache(const std::string &cachePath, uint64_t maxSize);
+  ~CImageTransformationCache();
+
+  static CImageTransformationCache& Get();
+
+  /*!
+   \brief Removes all cached images from disk.
+   */
+  void Deinitialize();
+
+  /*!
+   \brief Returns the transformed image either from the cache or by transforming it.
+   \param image path of the image including the transformation options
+   \param format format (MIME type) of the transformed image
+   \param lastModified last modification of the original image, the transformed image isn't cached if it is invalid
+   \param transform function to transform the image if it isn't cached
+   \return the transformed image or an empty pointer if the transformation failed
+   */
+  std::shared_ptr<const std::string> GetTransformedImage(const std::string &image, const std::string &format,
+                                                         const CDateTime &lastModified, TransformFunc transform);
+
+  uint64_t GetHits() const;
+  uint64_t GetMisses() const;
+  uint64_t GetSize() const;
+
+private:
+  CImageTransformationCache(const CImageTransformationCache&);
+  CImageTransformationCache& operator=(const CImageTransformationCache&);
+
+  typedef struct CachedImage
+  {
+    std::string file;
+    size_t size;
+    CDateTime lastModified;
+    std::list<std::string>::iterator usage;
+  } CachedImage;
+
+  class CPendingTransformation;
+  typedef std::shared_ptr<CPendingTransformation> PendingTransformationPtr;
+
+  bool Write(const std::string &data, std::string &file);
+  void Add(const std::string &key, const std::string &file, size_t size, const CDateTime &lastModified, std::vector<std::string> &removedFiles);
+  void Remove(std::map<std::string, CachedImage>::iterator image, std::vector<std::string> &removedFiles);
+
+  std::string m_cachePath;
+  uint64_t m_maxSize;
+
+  CCriticalSection m_critical;
+  std::map<std::string, CachedImage> m_images;
+  std::list<std::string> m_usage; // most recently used first
+  std::map<std::string, PendingTransformationPtr> m_pending;
+  uint64_t m_size;
+  unsigned int m_nextFile;
+
+  uint64_t m_hits;
+  uint64_t m_misses;
+};
@@ -0,0 +1,183 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <vector>
+
+#include "network/DNSNameCache.h"
+#include "threads/Atomics.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+
+#include "gtest/gtest.h"
+
+#define TEST_HOST           "testhost"
+#define TEST_IP             "192.168.1.10"
+#define TEST_UNKNOWN_HOST   "unknownhost"
+
+static volatile long s_lookups = 0;
+
+static bool Resolve(const std::string &strHostName, std::string &strIpAddress)
+{
+  AtomicIncrement(&s_lookups);
+  // give concurrent lookups some time to pile up
+  XbmcThreads::ThreadSleep(100);
+
+  if (strHostName != TEST_HOST)
+    return false;
+
+  strIpAddress = TEST_IP;
+  return true;
+}
+
+class LookupName : public IRunnable
+{
+public:
+  LookupName(CDNSNameCache &cache)
+    : m_cache(cache),
+      m_resolved(false)
+  { }
+
+  virtual void Run()
+  {
+    m_resolved = m_cache.LookupName(TEST_HOST, m_strIpAddress, XbmcThreads::EndTime::InfiniteValue);
+  }
+
+  CDNSNameCache &m_cache;
+  std::string m_strIpAddress;
+  bool m_resolved;
+};
+
+class TestDNSNameCache : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    s_lookups = 0;
+  }
+};
+
+TEST_F(TestDNSNameCache, IpAddress)
+{
+  CDNSNameCache cache(Resolve);
+
+  std::string ip;
+  EXPECT_TRUE(cache.LookupName("10.0.0.1", ip, XbmcThreads::EndTime::InfiniteValue));
+  EXPECT_STREQ("10.0.0.1", ip.c_str());
+  EXPECT_EQ(0, s_lookups);
+}
+
+TEST_F(TestDNSNameCache, Cached)
+{
+  CDNSNameCache cache(Resolve);
+
+  std::string ip;
+  EXPECT_TRUE(cache.LookupName(TEST_HOST, ip, XbmcThreads::EndTime::InfiniteValue));
+  EXPECT_STREQ(TEST_IP, ip.c_str());
+  EXPECT_TRUE(cache.LookupName(TEST_HOST, ip, XbmcThreads::EndTime::InfiniteValue));
+  EXPECT_STREQ(TEST_IP, ip.c_str());
+  EXPECT_EQ(1, s_lookups);
+}
+
+TEST_F(TestDNSNameCache, Expired)
+{
+  CDNSNameCache cache(Resolve, 50, 50);
+
+  std::string ip;
+  EXPECT_TRUE(cache.LookupName(TEST_HOST, ip, XbmcThreads::EndTime::InfiniteValue));
+  XbmcThreads::ThreadSleep(100);
+  EXPECT_TRUE(cache.LookupName(TEST_HOST, ip, XbmcThreads::EndTime::InfiniteValue));
+  EXPECT_STREQ(TEST_IP, ip.c_str());
+  EXPECT_EQ(2, s_lookups);
+}
+
+TEST_F(TestDNSNameCache, NegativeCaching)
+{
+  CDNSNameCache cache(Resolve, CDNSNameCache::DNS_CACHE_TTL, 200);
+
+  std::string ip;
+  EXPECT_FALSE(cache.LookupName(TEST_UNKNOWN_HOST, ip, XbmcThreads::EndTime::InfiniteValue));
+  EXPECT_FALSE(cache.LookupName(TEST_UNKNOWN_HOST, ip, XbmcThreads::EndTime::InfiniteValue));
+  EXPECT_TRUE(ip.empty());
+  EXPECT_EQ(1, s_lookups);
+
+  // unresolvable names are retried once their entry has expired
+  XbmcThreads::ThreadSleep(250);
+  EXPECT_FALSE(cache.LookupName(TEST_UNKNOWN_HOST, ip, XbmcThreads::EndTime::InfiniteValue));
+  EXPECT_EQ(2, s_lookups);
+}
+
+TEST_F(TestDNSNameCache, CustomEntry)
+{
+  CDNSNameCache cache(Resolve, 0, 0);
+  cache.AddName(TEST_HOST, "10.0.0.2");
+
+  std::string ip;
+  EXPECT_TRUE(cache.LookupName(TEST_HOST, ip, XbmcThreads::EndTime::InfiniteValue));
+  EXPECT_STREQ("10.0.0.2", ip.c_str());
+  EXPECT_EQ(0, s_lookups);
+}
+
+TEST_F(TestDNSNameCache, Timeout)
+{
+  CDNSNameCache cache(Resolve);
+
+  // the lookup continues in the background after giving up waiting
+  std::string ip;
+  EXPECT_FALSE(cache.LookupName(TEST_HOST, ip, 0));
+  EXPECT_TRUE(cache.LookupName(TEST_HOST, ip, 10000));
+  EXPECT_STREQ(TEST_IP, ip.c_str());
+  EXPECT_EQ(1, s_lookups);
+}
+
+TEST_F(TestDNSNameCache, DefaultResolver)
+{
+  CDNSNameCache cache;
+
+  std::string ip;
+  EXPECT_TRUE(cache.LookupName("localhost", ip, XbmcThreads::EndTime::InfiniteValue));
+  EXPECT_STREQ("127.0.0.1", ip.c_str());
+}
+
+TEST_F(TestDNSNameCache, ConcurrentLookups)
+{
+  CDNSNameCache cache(Resolve);
+
+  const int lookups = 4;
+  std::vector<LookupName*> runnables;
+  std::vector<CThread*> threads;
+  for (int i = 0; i < lookups; i++)
+  {
+    runnables.push_back(new LookupName(cache));
+    threads.push_back(new CThread(runnables.back(), "TestDNSNameCache"));
+    threads.back()->Create();
+  }
+
+  for (int i = 0; i < lookups; i++)
+  {
+    EXPECT_TRUE(threads[i]->WaitForThreadExit(10000));
+    EXPECT_TRUE(runnables[i]->m_resolved);
+    EXPECT_STREQ(TEST_IP, runnables[i]->m_strIpAddress.c_str());
+    delete threads[i];
+    delete runnables[i];
+  }
+
+  // all lookups have been served by a single query
+  EXPECT_EQ(1, s_lookups);
+}
@@ -0,0 +1,203 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#ifdef HAS_EVENT_SERVER
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "network/EventPacket.h"
+#include "network/EventServer.h"
+#include "network/Socket.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
+
+using namespace EVENTCLIENT;
+using namespace EVENTPACKET;
+using namespace EVENTSERVER;
+using namespace SOCKETS;
+
+#define EVENTSERVER_PORT        29777
+#define EVENTSERVER_TIMEOUT     10000
+
+#define TEST_CLIENTS            4
+// more packets than are read at once and than are kept for reuse
+#define TEST_PACKETS            25
+
+// feeds datagrams read from its socket to the event server without running its thread
+class CTestEventServer : public CEventServer
+{
+public:
+  CTestEventServer()
+  {
+    m_iMaxClients = TEST_CLIENTS;
+  }
+
+  virtual ~CTestEventServer()
+  {
+    Cleanup();
+  }
+
+  using CEventServer::ProcessPacket;
+  using CEventServer::ProcessEvents;
+  using CEventServer::GetNextAction;
+};
+
+class TestEventServer : public testing::Test
+{
+protected:
+  TestEventServer()
+    : server(NULL)
+  { }
+
+  virtual void SetUp()
+  {
+    CAddress addr("127.0.0.1");
+    server = CSocketFactory::CreateUDPSocket();
+    ASSERT_TRUE(server->Bind(addr, EVENTSERVER_PORT, 10));
+
+    for (int i = 0; i < TEST_CLIENTS; i++)
+    {
+      CUDPSocket *client = CSocketFactory::CreateUDPSocket();
+      clients.push_back(client);
+      ASSERT_TRUE(client->Bind(addr, 0));
+    }
+  }
+
+  virtual void TearDown()
+  {
+    for (std::vector<CUDPSocket*>::iterator it = clients.begin(); it != clients.end(); ++it)
+      delete *it;
+    clients.clear();
+
+    delete server;
+    server = NULL;
+  }
+
+  // sends an action from the client with the given token
+  bool SendAction(int client, const std::string &action)
+  {
+    unsigned char packet[PACKET_SIZE];
+    memset(packet, 0, HEADER_SIZE);
+
+    // payload: action type followed by the null terminated action
+    unsigned char *payload = packet + HEADER_SIZE;
+    payload[0] = AT_EXEC_BUILTIN;
+    memcpy(payload + 1, action.c_str(), action.size() + 1);
+    uint16_t payloadSize = (uint16_t)(action.size() + 2);
+
+    memcpy(packet, HEADER_SIG, HEADER_SIG_LENGTH);
+    packet[4] = 2;
+    packet[5] = 0;
+    uint16_t type = htons(PT_ACTION);
+    memcpy(packet + 6, &type, 2);
+    uint32_t sequence = htonl(1);
+    memcpy(packet + 8, &sequence, 4);
+    memcpy(packet + 12, &sequence, 4);
+    uint16_t size = htons(payloadSize);
+    memcpy(packet + 16, &size, 2);
+    uint32_t token = htonl(client + 1);
+    memcpy(packet + 18, &token, 4);
+
+    CAddress addr("127.0.0.1");
+    addr.saddr.sin_port = htons(server->Port());
+    int length = HEADER_SIZE + payloadSize;
+    return clients[client]->SendTo(addr, length, packet) == length;
+  }
+
+  // reads batches of datagrams like CEventServer::Run() until the given number has been processed
+  int ReceivePackets(CTestEventServer &eventServer, int count)
+  {
+    std::vector<unsigned char> buffer(PACKET_SIZE * TEST_PACKETS);
+    std::vector<UDPDatagram> datagrams(TEST_PACKETS);
+    for (int i = 0; i < TEST_PACKETS; i++)
+      datagrams[i].buffer = &buffer[i * PACKET_SIZE];
+
+    CSocketListener listener;
+    listener.AddSocket(server);
+
+    int received = 0;
+    XbmcThreads::EndTime timeout(EVENTSERVER_TIMEOUT);
+    while (received < count && !timeout.IsTimePast() && listener.Listen(timeout.MillisLeft()))
+    {
+      int packets = server->Read(&datagrams[0], TEST_PACKETS, PACKET_SIZE);
+      if (packets < 0)
+        break;
+
+      int64_t receiveTime = CurrentHostCounter();
+      for (int i = 0; i < packets; i++)
+        eventServer.ProcessPacket(datagrams[i], receiveTime);
+      received += packets;
+    }
+
+    return received;
+  }
+
+  CUDPSocket *server;
+  std::vector<CUDPSocket*> clients;
+};
+
+TEST_F(TestEventServer, DispatchesBurstOfPacketsInOrder)
+{
+  // every client sends its packets interleaved with the ones of the other clients
+  for (int i = 0; i < TEST_PACKETS; i++)
+  {
+    for (int client = 0; client < TEST_CLIENTS; client++)
+      ASSERT_TRUE(SendAction(client, StringUtils::Format("%d:%d", client, i)));
+  }
+
+  CTestEventServer eventServer;
+  ASSERT_EQ(TEST_CLIENTS * TEST_PACKETS, ReceivePackets(eventServer, TEST_CLIENTS * TEST_PACKETS));
+  EXPECT_EQ(TEST_CLIENTS, eventServer.GetNumberOfClients());
+  eventServer.ProcessEvents();
+
+  // the actions of each client are dispatched in the order they have been sent
+  std::vector<int> next(TEST_CLIENTS, 0);
+  CEventAction action;
+  while (eventServer.GetNextAction(action))
+  {
+    EXPECT_EQ(AT_EXEC_BUILTIN, action.actionType);
+    std::vector<std::string> parts = StringUtils::Split(action.actionName, ":");
+    ASSERT_EQ(2, parts.size());
+    int client = atoi(parts[0].c_str());
+    ASSERT_TRUE(client >= 0 && client < TEST_CLIENTS);
+    EXPECT_EQ(next[client], atoi(parts[1].c_str()));
+    next[client]++;
+  }
+
+  for (int client = 0; client < TEST_CLIENTS; client++)
+    EXPECT_EQ(TEST_PACKETS, next[client]);
+
+  // every dispatched action has been measured
+  unsigned int count;
+  float averageMs, maxMs;
+  eventServer.GetLatency(count, averageMs, maxMs);
+  EXPECT_EQ(TEST_CLIENTS * TEST_PACKETS, (int)count);
+  EXPECT_LE(0.0f, averageMs);
+  EXPECT_LE(averageMs, maxMs);
+}
+
+#endif // HAS_EVENT_SERVER
@@ -0,0 +1,214 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+
+#include "FileItem.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "network/httprequesthandler/ImageTransformationCache.h"
+#include "threads/Atomics.h"
+#include "threads/Thread.h"
+
+#include "gtest/gtest.h"
+
+#define TEST_CACHE_PATH     "special://temp/imagetransformationcachetest/"
+#define TEST_IMAGE          "image://test.png?width=100"
+#define TEST_FORMAT         "image/png"
+#define TEST_MODIFIED       CDateTime(2015, 1, 1, 0, 0, 0)
+
+static volatile long s_transformations = 0;
+
+static bool Transform(const std::string &image, uint8_t* &result, size_t &result_size)
+{
+  AtomicIncrement(&s_transformations);
+  // give concurrent requests some time to pile up
+  XbmcThreads::ThreadSleep(100);
+
+  result_size = image.size();
+  result = new uint8_t[result_size];
+  memcpy(result, image.c_str(), result_size);
+  return true;
+}
+
+static bool TransformFailing(const std::string &image, uint8_t* &result, size_t &result_size)
+{
+  AtomicIncrement(&s_transformations);
+  return false;
+}
+
+class GetTransformedImage : public IRunnable
+{
+public:
+  GetTransformedImage(CImageTransformationCache &cache)
+    : m_cache(cache)
+  { }
+
+  virtual void Run()
+  {
+    m_image = m_cache.GetTransformedImage(TEST_IMAGE, TEST_FORMAT, TEST_MODIFIED, Transform);
+  }
+
+  CImageTransformationCache &m_cache;
+  std::shared_ptr<const std::string> m_image;
+};
+
+class TestImageTransformationCache : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    s_transformations = 0;
+  }
+
+  virtual void TearDown()
+  {
+    // the cache only removes its files when deinitialized
+    CFileItemList items;
+    XFILE::CDirectory::GetDirectory(TEST_CACHE_PATH, items, "", XFILE::DIR_FLAG_NO_FILE_DIRS | XFILE::DIR_FLAG_BYPASS_CACHE);
+    for (int i = 0; i < items.Size(); i++)
+      XFILE::CFile::Delete(items[i]->GetPath());
+    XFILE::CDirectory::Remove(TEST_CACHE_PATH);
+  }
+};
+
+TEST_F(TestImageTransformationCache, HitAndMiss)
+{
+  CImageTransformationCache cache(TEST_CACHE_PATH, 1024);
+
+  std::shared_ptr<const std::string> image = cache.GetTransformedImage(TEST_IMAGE, TEST_FORMAT, TEST_MODIFIED, Transform);
+  ASSERT_TRUE(image != NULL);
+  EXPECT_STREQ(TEST_IMAGE, image->c_str());
+  EXPECT_EQ(0u, cache.GetHits());
+  EXPECT_EQ(1u, cache.GetMisses());
+
+  image = cache.GetTransformedImage(TEST_IMAGE, TEST_FORMAT, TEST_MODIFIED, Transform);
+  ASSERT_TRUE(image != NULL);
+  EXPECT_STREQ(TEST_IMAGE, image->c_str());
+  EXPECT_EQ(1u, cache.GetHits());
+  EXPECT_EQ(1u, cache.GetMisses());
+  EXPECT_EQ(1, s_transformations);
+
+  // a different format is a different transformation
+  image = cache.GetTransformedImage(TEST_IMAGE, "image/jpeg", TEST_MODIFIED, Transform);
+  ASSERT_TRUE(image != NULL);
+  EXPECT_EQ(2u, cache.GetMisses());
+  EXPECT_EQ(2, s_transformations);
+}
+
+TEST_F(TestImageTransformationCache, ModifiedImage)
+{
+  CImageTransformationCache cache(TEST_CACHE_PATH, 1024);
+
+  ASSERT_TRUE(cache.GetTransformedImage(TEST_IMAGE, TEST_FORMAT, CDateTime(2015, 1, 1, 0, 0, 0), Transform) != NULL);
+  ASSERT_TRUE(cache.GetTransformedImage(TEST_IMAGE, TEST_FORMAT, CDateTime(2015, 1, 2, 0, 0, 0), Transform) != NULL);
+  EXPECT_EQ(0u, cache.GetHits());
+  EXPECT_EQ(2u, cache.GetMisses());
+  EXPECT_EQ(strlen(TEST_IMAGE), cache.GetSize());
+}
+
+TEST_F(TestImageTransformationCache, UnknownModification)
+{
+  CImageTransformationCache cache(TEST_CACHE_PATH, 1024);
+
+  // without a modification date a cached image might be outdated
+  ASSERT_TRUE(cache.GetTransformedImage(TEST_IMAGE, TEST_FORMAT, CDateTime(), Transform) != NULL);
+  ASSERT_TRUE(cache.GetTransformedImage(TEST_IMAGE, TEST_FORMAT, CDateTime(), Transform) != NULL);
+  EXPECT_EQ(0u, cache.GetHits());
+  EXPECT_EQ(2u, cache.GetMisses());
+  EXPECT_EQ(0u, cache.GetSize());
+  EXPECT_EQ(2, s_transformations);
+}
+
+TEST_F(TestImageTransformationCache, Deinitialize)
+{
+  CImageTransformationCache cache(TEST_CACHE_PATH, 1024);
+
+  ASSERT_TRUE(cache.GetTransformedImage(TEST_IMAGE, TEST_FORMAT, TEST_MODIFIED, Transform) != NULL);
+  EXPECT_EQ(strlen(TEST_IMAGE), cache.GetSize());
+
+  cache.Deinitialize();
+  EXPECT_EQ(0u, cache.GetSize());
+
+  CFileItemList items;
+  ASSERT_TRUE(XFILE::CDirectory::GetDirectory(TEST_CACHE_PATH, items, "", XFILE::DIR_FLAG_NO_FILE_DIRS | XFILE::DIR_FLAG_BYPASS_CACHE));
+  EXPECT_EQ(0, items.Size());
+}
+
+TEST_F(TestImageTransformationCache, FailedTransformation)
+{
+  CImageTransformationCache cache(TEST_CACHE_PATH, 1024);
+
+  EXPECT_TRUE(cache.GetTransformedImage(TEST_IMAGE, TEST_FORMAT, TEST_MODIFIED, TransformFailing) == NULL);
+  EXPECT_TRUE(cache.GetTransformedImage(TEST_IMAGE, TEST_FORMAT, TEST_MODIFIED, TransformFailing) == NULL);
+  EXPECT_EQ(2, s_transformations);
+  EXPECT_EQ(0u, cache.GetSize());
+}
+
+TEST_F(TestImageTransformationCache, LeastRecentlyUsed)
+{
+  // only two images fit into the cache
+  const std::string image1 = "image://1.png?width=100";
+  const std::string image2 = "image://2.png?width=100";
+  const std::string image3 = "image://3.png?width=100";
+  CImageTransformationCache cache(TEST_CACHE_PATH, image1.size() * 2);
+
+  ASSERT_TRUE(cache.GetTransformedImage(image1, TEST_FORMAT, TEST_MODIFIED, Transform) != NULL);
+  ASSERT_TRUE(cache.GetTransformedImage(image2, TEST_FORMAT, TEST_MODIFIED, Transform) != NULL);
+  // use the first image so that the second one is the least recently used
+  ASSERT_TRUE(cache.GetTransformedImage(image1, TEST_FORMAT, TEST_MODIFIED, Transform) != NULL);
+  ASSERT_TRUE(cache.GetTransformedImage(image3, TEST_FORMAT, TEST_MODIFIED, Transform) != NULL);
+  EXPECT_EQ(image1.size() * 2, cache.GetSize());
+  EXPECT_EQ(3, s_transformations);
+
+  ASSERT_TRUE(cache.GetTransformedImage(image1, TEST_FORMAT, TEST_MODIFIED, Transform) != NULL);
+  EXPECT_EQ(3, s_transformations);
+  ASSERT_TRUE(cache.GetTransformedImage(image2, TEST_FORMAT, TEST_MODIFIED, Transform) != NULL);
+  EXPECT_EQ(4, s_transformations);
+}
+
+TEST_F(TestImageTransformationCache, ConcurrentRequests)
+{
+  CImageTransformationCache cache(TEST_CACHE_PATH, 1024);
+
+  const int requests = 4;
+  std::vector<GetTransformedImage*> runnables;
+  std::vector<CThread*> threads;
+  for (int i = 0; i < requests; i++)
+  {
+    runnables.push_back(new GetTransformedImage(cache));
+    threads.push_back(new CThread(runnables.back(), "TestImageTransformationCache"));
+    threads.back()->Create();
+  }
+
+  for (int i = 0; i < requests; i++)
+  {
+    EXPECT_TRUE(threads[i]->WaitForThreadExit(10000));
+    ASSERT_TRUE(runnables[i]->m_image != NULL);
+    EXPECT_STREQ(TEST_IMAGE, runnables[i]->m_image->c_str());
+    delete threads[i];
+    delete runnables[i];
+  }
+
+  // all requests have been served by a single transformation
+  EXPECT_EQ(1, s_transformations);
+  EXPECT_EQ(1u, cache.GetMisses());
+  EXPECT_EQ((uint64_t)requests - 1, cache.GetHits());
+}
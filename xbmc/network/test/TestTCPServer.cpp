@@ -0,0 +1,234 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <gtest/gtest.h>
+#include "system.h"
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "network/TCPServer.h"
+#include "threads/SystemClock.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+#define TCPSERVER_PORT          23457
+#define TCPSERVER_TIMEOUT       10000
+
+// hundreds of clients at once, each holding a connection while the others are served
+#define TEST_CLIENTS            300
+#define TEST_REQUESTS           50
+
+class TestTCPServer : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    JSONRPC::CJSONRPC::Initialize();
+    ASSERT_TRUE(JSONRPC::CTCPServer::StartServer(TCPSERVER_PORT, false));
+  }
+
+  virtual void TearDown()
+  {
+    JSONRPC::CTCPServer::StopServer(true);
+    JSONRPC::CJSONRPC::Cleanup();
+  }
+
+  static int Connect()
+  {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+      return -1;
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TCPSERVER_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  static bool SendAll(int fd, const std::string &data)
+  {
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+      ssize_t res = send(fd, data.c_str() + sent, data.size() - sent, 0);
+      if (res <= 0)
+        return false;
+      sent += res;
+    }
+    return true;
+  }
+
+  static std::string Ping(int id)
+  {
+    return StringUtils::Format("{ \"jsonrpc\": \"2.0\", \"method\": \"JSONRPC.Ping\", \"id\": %d }", id);
+  }
+
+  /* reads until count complete responses arrived and returns them in order */
+  static bool ReadResponses(int fd, size_t count, std::vector<CVariant> &responses, unsigned int timeout = TCPSERVER_TIMEOUT)
+  {
+    std::string buffer;
+    int depth = 0;
+    bool inString = false, escaped = false;
+    size_t start = 0, pos = 0;
+    unsigned int end = XbmcThreads::SystemClockMillis() + timeout;
+
+    while (responses.size() < count)
+    {
+      int left = (int)(end - XbmcThreads::SystemClockMillis());
+      struct pollfd pfd = { fd, POLLIN, 0 };
+      if (left <= 0 || poll(&pfd, 1, left) <= 0)
+        return false;
+
+      char data[4096];
+      ssize_t res = recv(fd, data, sizeof(data), 0);
+      if (res <= 0)
+        return false;
+      buffer.append(data, res);
+
+      for (; pos < buffer.size(); pos++)
+      {
+        char c = buffer[pos];
+        if (inString)
+        {
+          if (escaped)
+            escaped = false;
+          else if (c == '\\')
+            escaped = true;
+          else if (c == '"')
+            inString = false;
+        }
+        else if (c == '"')
+          inString = true;
+        else if (c == '{')
+        {
+          if (depth++ == 0)
+            start = pos;
+        }
+        else if (c == '}' && --depth == 0)
+          responses.push_back(CJSONVariantParser::Parse((const unsigned char*)buffer.c_str() + start, pos + 1 - start));
+      }
+    }
+    return true;
+  }
+};
+
+TEST_F(TestTCPServer, ManyClients)
+{
+  std::vector<int> clients;
+  for (int i = 0; i < TEST_CLIENTS; i++)
+  {
+    int fd = Connect();
+    ASSERT_GE(fd, 0) << "connection " << i << " failed: " << strerror(errno);
+    clients.push_back(fd);
+  }
+
+  for (size_t i = 0; i < clients.size(); i++)
+    EXPECT_TRUE(SendAll(clients[i], Ping(i)));
+
+  for (size_t i = 0; i < clients.size(); i++)
+  {
+    std::vector<CVariant> responses;
+    ASSERT_TRUE(ReadResponses(clients[i], 1, responses)) << "no response for client " << i;
+    EXPECT_EQ((int64_t)i, responses[0]["id"].asInteger());
+    EXPECT_STREQ("pong", responses[0]["result"].asString().c_str());
+  }
+
+  for (size_t i = 0; i < clients.size(); i++)
+    close(clients[i]);
+}
+
+TEST_F(TestTCPServer, ResponsesKeepOrder)
+{
+  int fd = Connect();
+  ASSERT_GE(fd, 0);
+
+  // several requests per packet and requests split over packets, with braces in strings
+  std::string data;
+  for (int i = 0; i < TEST_REQUESTS; i++)
+    data += StringUtils::Format("{ \"jsonrpc\": \"2.0\", \"method\": \"JSONRPC.Ping\", \"params\": { \"x\": \"}{\\\"\" }, \"id\": %d }", i);
+  for (size_t pos = 0; pos < data.size(); pos += 37)
+  {
+    ASSERT_TRUE(SendAll(fd, data.substr(pos, 37)));
+    usleep(100);
+  }
+
+  std::vector<CVariant> responses;
+  ASSERT_TRUE(ReadResponses(fd, TEST_REQUESTS, responses));
+  for (int i = 0; i < TEST_REQUESTS; i++)
+    EXPECT_EQ(i, responses[i]["id"].asInteger());
+
+  close(fd);
+}
+
+TEST_F(TestTCPServer, ManyQueuedRequests)
+{
+  int fd = Connect();
+  ASSERT_GE(fd, 0);
+
+  // far more requests than are queued per client, reading from it pauses and resumes
+  const int requests = TEST_REQUESTS * 20;
+  std::string data;
+  for (int i = 0; i < requests; i++)
+    data += Ping(i);
+  ASSERT_TRUE(SendAll(fd, data));
+
+  std::vector<CVariant> responses;
+  ASSERT_TRUE(ReadResponses(fd, requests, responses));
+  for (int i = 0; i < requests; i++)
+    EXPECT_EQ(i, responses[i]["id"].asInteger());
+
+  close(fd);
+}
+
+TEST_F(TestTCPServer, StalledClientDoesNotBlockOthers)
+{
+  // keeps requesting the api description without ever reading it
+  int stalled = Connect();
+  ASSERT_GE(stalled, 0);
+  std::string introspect = "{ \"jsonrpc\": \"2.0\", \"method\": \"JSONRPC.Introspect\", \"id\": 1 }";
+  for (int i = 0; i < TEST_REQUESTS; i++)
+    ASSERT_TRUE(SendAll(stalled, introspect));
+
+  int fd = Connect();
+  ASSERT_GE(fd, 0);
+  for (int i = 0; i < TEST_REQUESTS; i++)
+  {
+    std::vector<CVariant> responses;
+    ASSERT_TRUE(SendAll(fd, Ping(i)));
+    ASSERT_TRUE(ReadResponses(fd, 1, responses, 1000));
+    EXPECT_EQ(i, responses[0]["id"].asInteger());
+  }
+
+  close(fd);
+  close(stalled);
+}
@@ -0,0 +1,111 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "network/upnp/UPnPDidlCache.h"
+#include "video/VideoInfoTag.h"
+#include "FileItem.h"
+
+#include "gtest/gtest.h"
+
+using namespace UPNP;
+
+TEST(TestUPnPDidlCache, GetSet)
+{
+  CUPnPDidlCache cache(1024);
+
+  std::string didl;
+  EXPECT_FALSE(cache.Get("movie1", "stamp", didl));
+
+  cache.Set("movie1", "stamp", "movie", 1, "<item>1</item>");
+  EXPECT_TRUE(cache.Get("movie1", "stamp", didl));
+  EXPECT_STREQ("<item>1</item>", didl.c_str());
+  EXPECT_EQ(std::string("movie1").size() + didl.size(), cache.GetSize());
+
+  // a newer fragment replaces the old one
+  cache.Set("movie1", "stamp", "movie", 1, "<item>one</item>");
+  EXPECT_TRUE(cache.Get("movie1", "stamp", didl));
+  EXPECT_STREQ("<item>one</item>", didl.c_str());
+  EXPECT_EQ(std::string("movie1").size() + didl.size(), cache.GetSize());
+}
+
+TEST(TestUPnPDidlCache, StampChanged)
+{
+  CUPnPDidlCache cache(1024);
+
+  CFileItem item("Movie 1");
+  item.GetVideoInfoTag()->m_playCount = 0;
+  std::string stamp = CUPnPDidlCache::GetStamp(item);
+  cache.Set("movie1", stamp, "movie", 1, "<item>1</item>");
+
+  // watching the movie changes its stamp, so the fragment is outdated
+  item.GetVideoInfoTag()->m_playCount = 1;
+  std::string watched = CUPnPDidlCache::GetStamp(item);
+  EXPECT_NE(stamp, watched);
+
+  std::string didl;
+  EXPECT_FALSE(cache.Get("movie1", watched, didl));
+  // and it's gone for good
+  EXPECT_FALSE(cache.Get("movie1", stamp, didl));
+  EXPECT_EQ(0u, cache.GetSize());
+}
+
+TEST(TestUPnPDidlCache, Invalidate)
+{
+  CUPnPDidlCache cache(1024);
+  cache.Set("movie1", "stamp", "movie", 1, "<item>1</item>");
+  cache.Set("movie2", "stamp", "movie", 2, "<item>2</item>");
+  cache.Set("episode1", "stamp", "episode", 1, "<item>1</item>");
+
+  std::string didl;
+  cache.Invalidate("movie", 1);
+  EXPECT_FALSE(cache.Get("movie1", "stamp", didl));
+  EXPECT_TRUE(cache.Get("movie2", "stamp", didl));
+  EXPECT_TRUE(cache.Get("episode1", "stamp", didl));
+
+  cache.Invalidate("episode");
+  EXPECT_TRUE(cache.Get("movie2", "stamp", didl));
+  EXPECT_FALSE(cache.Get("episode1", "stamp", didl));
+}
+
+TEST(TestUPnPDidlCache, LeastRecentlyUsedFirst)
+{
+  // room for three fragments of 10 bytes each
+  CUPnPDidlCache cache(30);
+  cache.Set("key1", "stamp", "movie", 1, "didl01");
+  cache.Set("key2", "stamp", "movie", 2, "didl02");
+  cache.Set("key3", "stamp", "movie", 3, "didl03");
+  EXPECT_EQ(30u, cache.GetSize());
+
+  // using the oldest one makes the second the least recently used
+  std::string didl;
+  EXPECT_TRUE(cache.Get("key1", "stamp", didl));
+
+  cache.Set("key4", "stamp", "movie", 4, "didl04");
+  EXPECT_EQ(30u, cache.GetSize());
+  EXPECT_TRUE(cache.Get("key1", "stamp", didl));
+  EXPECT_FALSE(cache.Get("key2", "stamp", didl));
+  EXPECT_TRUE(cache.Get("key3", "stamp", didl));
+  EXPECT_TRUE(cache.Get("key4", "stamp", didl));
+
+  // fragments larger than the whole cache aren't stored
+  cache.Set("key5", "stamp", "movie", 5, std::string(64, 'x'));
+  EXPECT_FALSE(cache.Get("key5", "stamp", didl));
+  EXPECT_EQ(30u, cache.GetSize());
+}
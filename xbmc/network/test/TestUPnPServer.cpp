@@ -0,0 +1,165 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#ifdef HAS_UPNP
+#include "network/upnp/UPnPServer.h"
+#include "DatabaseManager.h"
+#include "dbwrappers/Database.h"
+#include "dbwrappers/dataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "video/VideoDatabase.h"
+#include "video/VideoInfoTag.h"
+
+#include <Platinum/Source/Platinum/Platinum.h>
+
+#include "gtest/gtest.h"
+
+#define TEST_MOVIES 30
+
+using namespace UPNP;
+
+class CTestUPnPVideoDatabase : public CVideoDatabase
+{
+public:
+  void Delete()
+  {
+    std::string file;
+    if (m_pDB.get())
+      file = URIUtils::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase());
+    Close();
+    if (!file.empty())
+      XFILE::CFile::Delete(file);
+  }
+};
+
+class TestUPnPServer : public testing::Test
+{
+protected:
+  /* sets up a video library in the temp folder that is used instead of the one of the profile */
+  static void SetUpTestCase()
+  {
+    m_settings = g_advancedSettings.m_databaseVideo;
+    g_advancedSettings.m_databaseVideo.Reset();
+    g_advancedSettings.m_databaseVideo.type = "sqlite3";
+    g_advancedSettings.m_databaseVideo.host = CSpecialProtocol::TranslatePath("special://temp/");
+    g_advancedSettings.m_databaseVideo.name = "TestUPnPVideos";
+
+    CTestUPnPVideoDatabase db;
+    CDatabaseManager::Get().UpdateDatabase(db, &g_advancedSettings.m_databaseVideo);
+    if (!db.Open())
+      return;
+
+    for (int i = 1; i <= TEST_MOVIES; i++)
+    {
+      CVideoInfoTag movie;
+      movie.m_strTitle = StringUtils::Format("Movie %02i", i);
+      std::map<std::string, std::string> art;
+      if (db.SetDetailsForMovie(StringUtils::Format("/movies/Movie %02i.mkv", i), movie, art) < 0)
+        return;
+    }
+    m_populated = true;
+  }
+
+  static void TearDownTestCase()
+  {
+    CTestUPnPVideoDatabase db;
+    if (db.Open())
+      db.Delete();
+    g_advancedSettings.m_databaseVideo = m_settings;
+  }
+
+  virtual void SetUp()
+  {
+    ASSERT_TRUE(m_populated);
+  }
+
+  /* browses the children of the container like a client would */
+  static void Browse(const char *container, NPT_UInt32 start, NPT_UInt32 count, NPT_String &result, NPT_String &returned, NPT_String &total)
+  {
+    CUPnPServer server("TestUPnPServer");
+    ASSERT_TRUE(NPT_SUCCEEDED(server.SetupServices()));
+
+    PLT_Service *service = NULL;
+    ASSERT_TRUE(NPT_SUCCEEDED(server.FindServiceByType("urn:schemas-upnp-org:service:ContentDirectory:1", service)));
+    PLT_ActionDesc *browse = service->FindActionDesc("Browse");
+    ASSERT_TRUE(browse != NULL);
+
+    PLT_ActionReference action(new PLT_Action(*browse));
+    NPT_HttpRequest request("http://127.0.0.1/", NPT_HTTP_METHOD_POST);
+    PLT_HttpRequestContext context(request);
+    ASSERT_TRUE(NPT_SUCCEEDED(server.OnBrowseDirectChildren(action, container, "*", start, count, "", context)));
+
+    action->GetArgumentValue("Result", result);
+    action->GetArgumentValue("NumberReturned", returned);
+    action->GetArgumentValue("TotalMatches", total);
+  }
+
+  static DatabaseSettings m_settings;
+  static bool m_populated;
+};
+
+DatabaseSettings TestUPnPServer::m_settings;
+bool TestUPnPServer::m_populated = false;
+
+TEST_F(TestUPnPServer, BrowsePage)
+{
+  NPT_String result, returned, total;
+  Browse("videodb://movies/titles/", 10, 5, result, returned, total);
+
+  // only the requested page, but the total of the whole container
+  EXPECT_STREQ("5", returned.GetChars());
+  EXPECT_STREQ("30", total.GetChars());
+  for (int i = 1; i <= TEST_MOVIES; i++)
+  {
+    std::string title = StringUtils::Format("Movie %02i", i);
+    EXPECT_EQ(i >= 11 && i <= 15, result.Find(title.c_str()) >= 0) << title;
+  }
+}
+
+TEST_F(TestUPnPServer, BrowseLastPage)
+{
+  NPT_String result, returned, total;
+  Browse("videodb://movies/titles/", 25, 10, result, returned, total);
+
+  EXPECT_STREQ("5", returned.GetChars());
+  EXPECT_STREQ("30", total.GetChars());
+  EXPECT_GE(result.Find("Movie 30"), 0);
+}
+
+TEST_F(TestUPnPServer, BrowseWithRules)
+{
+  // only "Movie 10" to "Movie 19" match the rules of the container
+  NPT_String result, returned, total;
+  Browse("videodb://movies/titles/?xsp=%7B%22rules%22%3A%7B%22and%22%3A%5B%7B%22field%22%3A%22title%22%2C%22operator%22%3A%22contains%22%2C%22value%22%3A%5B%22Movie%201%22%5D%7D%5D%7D%2C%22type%22%3A%22movies%22%7D",
+         5, 10, result, returned, total);
+
+  EXPECT_STREQ("5", returned.GetChars());
+  EXPECT_STREQ("10", total.GetChars());
+  EXPECT_LT(result.Find("Movie 09"), 0);
+  EXPECT_LT(result.Find("Movie 20"), 0);
+}
+
+#endif
@@ -21,6 +21,11 @@
 #include <errno.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <vector>
+
+#include <zlib.h>
+
 #include <gtest/gtest.h>
 #include "system.h"
 #include "URL.h"
@@ -28,8 +33,11 @@
 #include "filesystem/File.h"
 #include "interfaces/json-rpc/JSONRPC.h"
 #include "network/WebServer.h"
+#include "network/httprequesthandler/HTTPWebinterfaceHandler.h"
+#include "settings/AdvancedSettings.h"
 #include "settings/MediaSourceSettings.h"
 #include "test/TestUtils.h"
+#include "threads/SingleLock.h"
 #include "utils/JSONVariantParser.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
@@ -46,13 +54,115 @@ using namespace XFILE;
 #define TEST_FILES_HTML         TEST_FILES_DATA ".html"
 #define TEST_FILES_RANGES       TEST_FILES_DATA "-ranges.txt"
 
+#define TEST_URL_WEBINTERFACE   "webinterface/"
+#define TEST_URL_DOWNLOAD       "download/"
+
+#define TEST_DOWNLOAD_SIZE      (5 * 1024 * 1024)
+#define TEST_DOWNLOAD_RANGES    4
+#define TEST_DOWNLOAD_SOURCE    "special://temp/webserver-download-source.bin"
+#define TEST_DOWNLOAD_TARGET    "special://temp/webserver-download-target.bin"
+
+// serves the test files like files of the web interface
+class CTestWebinterfaceHandler : public CHTTPWebinterfaceHandler
+{
+public:
+  explicit CTestWebinterfaceHandler(const std::string &sourcePath)
+    : m_sourcePath(sourcePath)
+  { }
+
+  virtual IHTTPRequestHandler* Create(const HTTPRequest &request)
+  {
+    std::string file = URIUtils::AddFileToFolder(m_sourcePath, request.url.substr(strlen("/" TEST_URL_WEBINTERFACE)));
+    return new CTestWebinterfaceHandler(request, file, CFile::Exists(file) ? MHD_HTTP_OK : MHD_HTTP_NOT_FOUND);
+  }
+  virtual bool CanHandleRequest(const HTTPRequest &request) { return request.url.find("/" TEST_URL_WEBINTERFACE) == 0; }
+  virtual int GetPriority() const { return 10; }
+
+protected:
+  CTestWebinterfaceHandler(const HTTPRequest &request, const std::string &file, int responseStatus)
+    : CHTTPWebinterfaceHandler(request, file, responseStatus)
+  { }
+
+  std::string m_sourcePath;
+};
+
+// serves a single file to CCurlFile::Download() and remembers the ranges it was asked for
+class CTestDownloadHandler : public CHTTPFileHandler
+{
+public:
+  enum RangeMode
+  {
+    RangesServed,
+    RangesIgnored,
+    RangesFailed
+  };
+
+  CTestDownloadHandler()
+    : m_mode(RangesServed)
+  { }
+
+  virtual IHTTPRequestHandler* Create(const HTTPRequest &request)
+  {
+    std::string range = CWebServer::GetRequestHeaderValue(request.connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_RANGE);
+
+    CSingleLock lock(m_section);
+    if (!range.empty())
+      m_ranges.push_back(range);
+
+    CTestDownloadHandler *handler = new CTestDownloadHandler(request);
+    // every range but the first one fails, the fallback to a single request starts at 0 as well
+    if (m_mode == RangesFailed && !range.empty() && !StringUtils::StartsWith(range, "bytes=0-"))
+      handler->SetFile(m_file, MHD_HTTP_INTERNAL_SERVER_ERROR);
+    else
+    {
+      handler->SetFile(m_file, MHD_HTTP_OK);
+      // the web server only honours the ranges of responses that can be cached,
+      // so the file is sent as a whole while ranges are still advertised
+      if (m_mode == RangesIgnored)
+        handler->SetCanBeCached(false);
+    }
+
+    return handler;
+  }
+  virtual bool CanHandleRequest(const HTTPRequest &request) { return request.url.find("/" TEST_URL_DOWNLOAD) == 0; }
+  virtual int GetPriority() const { return 10; }
+
+  void Setup(const std::string &file, RangeMode mode)
+  {
+    CSingleLock lock(m_section);
+    m_file = file;
+    m_mode = mode;
+    m_ranges.clear();
+  }
+
+  std::vector<std::string> GetRanges() const
+  {
+    CSingleLock lock(m_section);
+    return m_ranges;
+  }
+
+protected:
+  explicit CTestDownloadHandler(const HTTPRequest &request)
+    : CHTTPFileHandler(request),
+      m_mode(RangesServed)
+  { }
+
+  std::string m_file;
+  RangeMode m_mode;
+  std::vector<std::string> m_ranges;
+  CCriticalSection m_section;
+};
+
 class TestWebServer : public testing::Test
 {
 protected:
   TestWebServer()
     : webserver(),
       baseUrl(StringUtils::Format("http://" WEBSERVER_HOST ":%d", WEBSERVER_PORT)),
-      sourcePath(XBMC_REF_FILE_PATH("xbmc/network/test/data/webserver/"))
+      sourcePath(XBMC_REF_FILE_PATH("xbmc/network/test/data/webserver/")),
+      webinterfaceHandler(sourcePath),
+      downloadHandler(),
+      parallelRanges(g_advancedSettings.m_curlParallelRanges)
   { }
   virtual ~TestWebServer() { }
 
@@ -61,6 +171,8 @@ protected:
   {
     SetupMediaSources();
 
+    CWebServer::RegisterRequestHandler(&webinterfaceHandler);
+    CWebServer::RegisterRequestHandler(&downloadHandler);
     webserver.Start(WEBSERVER_PORT, "", "");
   }
 
@@ -69,7 +181,13 @@ protected:
     if (webserver.IsStarted())
       webserver.Stop();
 
+    CWebServer::UnregisterRequestHandler(&webinterfaceHandler);
+    CWebServer::UnregisterRequestHandler(&downloadHandler);
     TearDownMediaSources();
+
+    g_advancedSettings.m_curlParallelRanges = parallelRanges;
+    CFile::Delete(TEST_DOWNLOAD_SOURCE);
+    CFile::Delete(TEST_DOWNLOAD_TARGET);
   }
 
   void SetupMediaSources()
@@ -329,9 +447,59 @@ protected:
     return StringUtils::Format("bytes=%u-%u", start, end);
   }
 
+  // writes a file large enough for a parallel ranged download and serves it in the given mode
+  bool SetupDownload(CTestDownloadHandler::RangeMode mode, std::string &content)
+  {
+    // a prime period moves every byte that ends up at the wrong position out of place
+    content.resize(TEST_DOWNLOAD_SIZE);
+    for (size_t i = 0; i < content.size(); i++)
+      content[i] = static_cast<char>(i % 251);
+
+    CFile file;
+    if (!file.OpenForWrite(TEST_DOWNLOAD_SOURCE, true) ||
+        file.Write(content.c_str(), content.size()) != static_cast<ssize_t>(content.size()))
+      return false;
+    file.Close();
+
+    g_advancedSettings.m_curlParallelRanges = TEST_DOWNLOAD_RANGES;
+    downloadHandler.Setup(TEST_DOWNLOAD_SOURCE, mode);
+    return true;
+  }
+
+  bool Download(std::string &content)
+  {
+    CCurlFile curl;
+    if (!curl.Download(GetUrl(TEST_URL_DOWNLOAD "file.bin"), TEST_DOWNLOAD_TARGET))
+      return false;
+
+    XFILE::auto_buffer buffer;
+    CFile file;
+    if (file.LoadFile(TEST_DOWNLOAD_TARGET, buffer) <= 0)
+      return false;
+
+    content.assign(buffer.get(), buffer.size());
+    return true;
+  }
+
+  // checks that the download asked for each of its parallel ranges
+  void CheckDownloadRanges()
+  {
+    const std::vector<std::string> ranges = downloadHandler.GetRanges();
+    const unsigned int chunk = TEST_DOWNLOAD_SIZE / TEST_DOWNLOAD_RANGES;
+    for (unsigned int i = 0; i < TEST_DOWNLOAD_RANGES; i++)
+    {
+      const unsigned int end = (i == TEST_DOWNLOAD_RANGES - 1 ? TEST_DOWNLOAD_SIZE : chunk * (i + 1)) - 1;
+      const std::string range = GenerateRangeHeaderValue(chunk * i, end);
+      EXPECT_TRUE(std::find(ranges.begin(), ranges.end(), range) != ranges.end()) << "missing range " << range;
+    }
+  }
+
   CWebServer webserver;
   std::string baseUrl;
   std::string sourcePath;
+  CTestWebinterfaceHandler webinterfaceHandler;
+  CTestDownloadHandler downloadHandler;
+  int parallelRanges;
 };
 
 TEST_F(TestWebServer, IsStarted)
@@ -772,4 +940,152 @@ TEST_F(TestWebServer, CanGetCachedRangedFileWithNewerIfRange)
   curl.SetRequestHeader(MHD_HTTP_HEADER_IF_RANGE, lastModifiedNewer.GetAsRFC1123DateTime());
   ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
   CheckRangesTestFileResponse(curl, result, ranges);
-}
\ No newline at end of file
+}
+
+TEST_F(TestWebServer, CanGetFileWithETag)
+{
+  // get the file and its entity tag
+  std::string result;
+  CCurlFile curl;
+  curl.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "");
+  ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
+  EXPECT_STREQ(TEST_FILES_DATA_RANGES, result.c_str());
+  CheckRangesTestFileResponse(curl);
+
+  std::string etag = curl.GetHttpHeader().GetValue(MHD_HTTP_HEADER_ETAG);
+  ASSERT_FALSE(etag.empty());
+  EXPECT_TRUE(StringUtils::StartsWith(etag, "\""));
+  EXPECT_TRUE(StringUtils::EndsWith(etag, "\""));
+}
+
+TEST_F(TestWebServer, CanGetCachedFileWithMatchingIfNoneMatch)
+{
+  // get the entity tag of the file
+  std::string result;
+  CCurlFile curl_etag;
+  curl_etag.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "");
+  ASSERT_TRUE(curl_etag.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
+  std::string etag = curl_etag.GetHttpHeader().GetValue(MHD_HTTP_HEADER_ETAG);
+  ASSERT_FALSE(etag.empty());
+
+  // get the file with the matching If-None-Match value
+  result.clear();
+  CCurlFile curl;
+  curl.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "");
+  curl.SetRequestHeader(MHD_HTTP_HEADER_IF_NONE_MATCH, "\"unknown\", " + etag);
+  ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
+  ASSERT_TRUE(result.empty());
+  CheckRangesTestFileResponse(curl, MHD_HTTP_NOT_MODIFIED, true);
+}
+
+TEST_F(TestWebServer, CanGetCachedFileWithDifferentIfNoneMatch)
+{
+  // get the file with a different If-None-Match value (which takes precedence over If-Modified-Since)
+  CDateTime lastModified;
+  ASSERT_TRUE(GetLastModifiedOfTestFile(TEST_FILES_RANGES, lastModified));
+
+  std::string result;
+  CCurlFile curl;
+  curl.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "");
+  curl.SetRequestHeader(MHD_HTTP_HEADER_IF_NONE_MATCH, "\"unknown\"");
+  curl.SetRequestHeader(MHD_HTTP_HEADER_IF_MODIFIED_SINCE, lastModified.GetAsRFC1123DateTime());
+  ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
+  EXPECT_STREQ(TEST_FILES_DATA_RANGES, result.c_str());
+  CheckRangesTestFileResponse(curl);
+}
+
+TEST_F(TestWebServer, CanGetCachedRangedFileWithDifferentETagIfRange)
+{
+  // get the whole file (but ranged) with an If-Range value that doesn't match the entity tag
+  std::string result;
+  CCurlFile curl;
+  curl.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "bytes=0-5");
+  curl.SetRequestHeader(MHD_HTTP_HEADER_IF_RANGE, "\"unknown\"");
+  ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
+  EXPECT_STREQ(TEST_FILES_DATA_RANGES, result.c_str());
+  CheckRangesTestFileResponse(curl);
+}
+
+TEST_F(TestWebServer, CanGetCompressedFile)
+{
+  std::string result;
+  CCurlFile curl;
+  curl.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "");
+  curl.SetRequestHeader(MHD_HTTP_HEADER_ACCEPT_ENCODING, "gzip, deflate");
+  ASSERT_TRUE(curl.Get(GetUrl(TEST_URL_WEBINTERFACE TEST_FILES_HTML), result));
+
+  const CHttpHeader& httpHeader = curl.GetHttpHeader();
+  EXPECT_STREQ("gzip", httpHeader.GetValue(MHD_HTTP_HEADER_CONTENT_ENCODING).c_str());
+  EXPECT_STREQ("Accept-Encoding", httpHeader.GetValue(MHD_HTTP_HEADER_VARY).c_str());
+  EXPECT_STREQ("none", httpHeader.GetValue(MHD_HTTP_HEADER_ACCEPT_RANGES).c_str());
+  EXPECT_TRUE(StringUtils::EndsWith(httpHeader.GetValue(MHD_HTTP_HEADER_ETAG), "-gzip\""));
+
+  // the body is the gzip compressed file
+  char data[256];
+  z_stream stream = { };
+  ASSERT_EQ(Z_OK, inflateInit2(&stream, 15 + 16));
+  stream.next_in = reinterpret_cast<Bytef*>(&result[0]);
+  stream.avail_in = result.size();
+  stream.next_out = reinterpret_cast<Bytef*>(data);
+  stream.avail_out = sizeof(data);
+  EXPECT_EQ(Z_STREAM_END, inflate(&stream, Z_FINISH));
+  inflateEnd(&stream);
+  EXPECT_STREQ(TEST_FILES_DATA, std::string(data, stream.total_out).c_str());
+}
+
+TEST_F(TestWebServer, CanGetUncompressedFile)
+{
+  // without gzip in Accept-Encoding the file is sent as is
+  std::string result;
+  CCurlFile curl;
+  curl.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "");
+  curl.SetRequestHeader(MHD_HTTP_HEADER_ACCEPT_ENCODING, "identity");
+  ASSERT_TRUE(curl.Get(GetUrl(TEST_URL_WEBINTERFACE TEST_FILES_HTML), result));
+  EXPECT_STREQ(TEST_FILES_DATA, result.c_str());
+
+  const CHttpHeader& httpHeader = curl.GetHttpHeader();
+  EXPECT_TRUE(httpHeader.GetValue(MHD_HTTP_HEADER_CONTENT_ENCODING).empty());
+  EXPECT_STREQ("Accept-Encoding", httpHeader.GetValue(MHD_HTTP_HEADER_VARY).c_str());
+  EXPECT_STREQ("bytes", httpHeader.GetValue(MHD_HTTP_HEADER_ACCEPT_RANGES).c_str());
+  std::string etag = httpHeader.GetValue(MHD_HTTP_HEADER_ETAG);
+  ASSERT_FALSE(etag.empty());
+  EXPECT_FALSE(StringUtils::EndsWith(etag, "-gzip\""));
+}
+
+TEST_F(TestWebServer, CanDownloadFileInParallelRanges)
+{
+  std::string content;
+  ASSERT_TRUE(SetupDownload(CTestDownloadHandler::RangesServed, content));
+
+  std::string result;
+  ASSERT_TRUE(Download(result));
+  ASSERT_EQ(content.size(), result.size());
+  EXPECT_TRUE(content == result);
+  CheckDownloadRanges();
+}
+
+TEST_F(TestWebServer, CanDownloadFileIgnoringRanges)
+{
+  std::string content;
+  ASSERT_TRUE(SetupDownload(CTestDownloadHandler::RangesIgnored, content));
+
+  // the whole file answering each range fails the ranged download and the file is fetched at once
+  std::string result;
+  ASSERT_TRUE(Download(result));
+  ASSERT_EQ(content.size(), result.size());
+  EXPECT_TRUE(content == result);
+  CheckDownloadRanges();
+}
+
+TEST_F(TestWebServer, CanDownloadFileWithFailingRange)
+{
+  std::string content;
+  ASSERT_TRUE(SetupDownload(CTestDownloadHandler::RangesFailed, content));
+
+  // the failed ranges are fetched again by a single request
+  std::string result;
+  ASSERT_TRUE(Download(result));
+  ASSERT_EQ(content.size(), result.size());
+  EXPECT_TRUE(content == result);
+  CheckDownloadRanges();
+}
@@ -0,0 +1,138 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "UPnPDidlCache.h"
+#include "FileItem.h"
+#include "music/tags/MusicInfoTag.h"
+#include "threads/SingleLock.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+#include "video/VideoInfoTag.h"
+
+namespace UPNP
+{
+
+CUPnPDidlCache::CUPnPDidlCache(size_t maxSize)
+  : m_maxSize(maxSize),
+    m_size(0)
+{ }
+
+CUPnPDidlCache::~CUPnPDidlCache()
+{ }
+
+std::string CUPnPDidlCache::GetStamp(const CFileItem &item)
+{
+  std::string stamp = StringUtils::Format("%s|%s|%" PRId64, item.GetLabel().c_str(),
+                                          item.m_dateTime.GetAsDBDateTime().c_str(), item.m_dwSize);
+
+  if (item.HasVideoInfoTag())
+  {
+    const CVideoInfoTag &tag = *item.GetVideoInfoTag();
+    stamp += StringUtils::Format("|%d|%s|%f|%d|%d", tag.m_playCount, tag.m_lastPlayed.GetAsDBDateTime().c_str(),
+                                 tag.m_resumePoint.timeInSeconds,
+                                 (int)item.GetProperty("totalepisodes").asInteger(),
+                                 (int)item.GetProperty("watchedepisodes").asInteger());
+  }
+  else if (item.HasMusicInfoTag())
+  {
+    const MUSIC_INFO::CMusicInfoTag &tag = *item.GetMusicInfoTag();
+    stamp += StringUtils::Format("|%d|%s|%c", tag.GetPlayCount(), tag.GetLastPlayed().GetAsDBDateTime().c_str(),
+                                 tag.GetRating());
+  }
+
+  return stamp;
+}
+
+bool CUPnPDidlCache::Get(const std::string &key, const std::string &stamp, std::string &didl)
+{
+  CSingleLock lock(m_critical);
+  std::map<std::string, Fragment>::iterator fragment = m_fragments.find(key);
+  if (fragment == m_fragments.end())
+    return false;
+
+  // the item has changed since its fragment was generated
+  if (fragment->second.stamp != stamp)
+  {
+    Remove(fragment);
+    return false;
+  }
+
+  m_usage.splice(m_usage.begin(), m_usage, fragment->second.usage);
+  didl = fragment->second.didl;
+  return true;
+}
+
+void CUPnPDidlCache::Set(const std::string &key, const std::string &stamp, const std::string &mediaType, int dbId, const std::string &didl)
+{
+  const size_t size = key.size() + didl.size();
+  if (size > m_maxSize)
+    return;
+
+  CSingleLock lock(m_critical);
+  // replace any older fragment of the same item
+  Remove(m_fragments.find(key));
+
+  // make room for the new fragment by removing the least recently used ones
+  while (!m_usage.empty() && m_size + size > m_maxSize)
+    Remove(m_fragments.find(m_usage.back()));
+
+  m_usage.push_front(key);
+  Fragment fragment = { stamp, mediaType, dbId, didl, m_usage.begin() };
+  m_fragments.insert(std::make_pair(key, fragment));
+  m_size += size;
+}
+
+void CUPnPDidlCache::Invalidate(const std::string &mediaType, int dbId /* = -1 */)
+{
+  CSingleLock lock(m_critical);
+  for (std::map<std::string, Fragment>::iterator fragment = m_fragments.begin(); fragment != m_fragments.end(); )
+  {
+    if (fragment->second.mediaType == mediaType && (dbId < 0 || fragment->second.dbId == dbId))
+      Remove(fragment++);
+    else
+      ++fragment;
+  }
+}
+
+void CUPnPDidlCache::Clear()
+{
+  CSingleLock lock(m_critical);
+  m_fragments.clear();
+  m_usage.clear();
+  m_size = 0;
+}
+
+size_t CUPnPDidlCache::GetSize() const
+{
+  CSingleLock lock(m_critical);
+  return m_size;
+}
+
+void CUPnPDidlCache::Remove(std::map<std::string, Fragment>::iterator fragment)
+{
+  if (fragment == m_fragments.end())
+    return;
+
+  m_size -= fragment->first.size() + fragment->second.didl.size();
+  m_usage.erase(fragment->second.usage);
+  m_fragments.erase(fragment);
+}
+
+}
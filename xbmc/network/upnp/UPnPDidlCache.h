@@ -0,0 +1,108 @@
+#pragma once
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "threads/CriticalSection.h"
+
+class CFileItem;
+
+namespace UPNP
+{
+
+/*!
+ \brief Cache of the DIDL-Lite fragments generated by the media server.
+
+ Every fragment describes a single item as seen by a specific client and is
+ stored together with the database id of the item and a stamp of its state.
+ A fragment is only used as long as the stamp of the browsed item matches
+ and can be dropped by database id when the library reports a change. The
+ total size of the fragments is limited and the least recently used ones
+ are removed first.
+ */
+class CUPnPDidlCache
+{
+public:
+  CUPnPDidlCache(size_t maxSize);
+  ~CUPnPDidlCache();
+
+  /*!
+   \brief Returns the stamp describing the state of the given item.
+   The stamp covers everything that can change without the item being
+   reloaded from the library (playcount, resume point, last played etc.).
+   */
+  static std::string GetStamp(const CFileItem &item);
+
+  /*!
+   \brief Looks up the fragment stored for the given key.
+   \param key identifies the item, its parent, the filter and the client
+   \param stamp stamp of the item as returned by GetStamp()
+   \param didl the cached fragment
+   \return true if a fragment with a matching stamp was found, false otherwise
+   */
+  bool Get(const std::string &key, const std::string &stamp, std::string &didl);
+
+  /*!
+   \brief Stores the fragment for the given key.
+   \param key identifies the item, its parent, the filter and the client
+   \param stamp stamp of the item as returned by GetStamp()
+   \param mediaType media type of the item in the library (if any)
+   \param dbId id of the item in the library or -1
+   \param didl the fragment to store
+   */
+  void Set(const std::string &key, const std::string &stamp, const std::string &mediaType, int dbId, const std::string &didl);
+
+  /*!
+   \brief Removes all fragments of the given library item.
+   \param mediaType media type of the item
+   \param dbId id of the item or -1 to remove all items of the media type
+   */
+  void Invalidate(const std::string &mediaType, int dbId = -1);
+  void Clear();
+
+  size_t GetSize() const;
+
+private:
+  CUPnPDidlCache(const CUPnPDidlCache&);
+  CUPnPDidlCache& operator=(const CUPnPDidlCache&);
+
+  typedef struct Fragment
+  {
+    std::string stamp;
+    std::string mediaType;
+    int dbId;
+    std::string didl;
+    std::list<std::string>::iterator usage;
+  } Fragment;
+
+  void Remove(std::map<std::string, Fragment>::iterator fragment);
+
+  size_t m_maxSize;
+
+  CCriticalSection m_critical;
+  std::map<std::string, Fragment> m_fragments;
+  std::list<std::string> m_usage; // most recently used first
+  size_t m_size;
+};
+
+}
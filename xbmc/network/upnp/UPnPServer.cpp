@@ -28,13 +28,19 @@
 #include "music/MusicThumbLoader.h"
 #include "interfaces/AnnouncementManager.h"
 #include "filesystem/Directory.h"
+#include "filesystem/LibraryDirectory.h"
 #include "filesystem/MusicDatabaseDirectory.h"
+#include "filesystem/SmartPlaylistDirectory.h"
 #include "filesystem/SpecialProtocol.h"
 #include "filesystem/VideoDatabaseDirectory.h"
 #include "guilib/WindowIDs.h"
 #include "music/tags/MusicInfoTag.h"
+#include "playlists/SmartPlayList.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/md5.h"
 #include "utils/StringUtils.h"
@@ -48,6 +54,13 @@
 
 NPT_SET_LOCAL_LOGGER("xbmc.upnp.server")
 
+// maximum size of the cached DIDL-Lite fragments
+#define UPNP_DIDL_CACHE_SIZE  (16 * 1024 * 1024)
+// number of jobs helping to build the uncached items of a response
+#define UPNP_BUILD_JOBS       3
+// minimum number of uncached items per job
+#define UPNP_BUILD_JOB_ITEMS  8
+
 using namespace std;
 using namespace ANNOUNCEMENT;
 using namespace XFILE;
@@ -64,12 +77,122 @@ const char* audio_containers[] = { "musicdb://genres/", "musicdb://artists/", "m
 const char* video_containers[] = { "library://video/movies/titles.xml/", "library://video/tvshows/titles.xml/",
                                    "videodb://recentlyaddedmovies/", "videodb://recentlyaddedepisodes/"  };
 
+/*----------------------------------------------------------------------
+|   CUPnPServer::CBuildQueue
+|
+|   Builds the DIDL-Lite fragments of the items of a response. The items
+|   are handed out one by one to the thread handling the request and to
+|   any jobs helping it, each using its own thumb loader.
++---------------------------------------------------------------------*/
+class CUPnPServer::CBuildQueue
+{
+public:
+    CBuildQueue(CUPnPServer*                  server,
+                const std::string&            path,
+                const char*                   filter,
+                const PLT_HttpRequestContext& context,
+                const char*                   parent_id) :
+        m_Server(server),
+        m_Path(path),
+        m_Filter(filter?filter:""),
+        m_Context(context),
+        m_ParentId(parent_id?parent_id:""),
+        m_HasParentId(parent_id != NULL),
+        m_Next(0),
+        m_Done(0),
+        m_Finished(true, false)
+    {
+    }
+
+    void Add(const CFileItemPtr& item) {
+        m_Items.push_back(item);
+        m_Didl.push_back(NPT_String());
+    }
+
+    NPT_Cardinal GetCount() const { return m_Items.size(); }
+    const NPT_String& GetDidl(NPT_Cardinal index) const { return m_Didl[index]; }
+
+    void Process() {
+        NPT_Reference<CThumbLoader> thumb_loader;
+        bool thumb_loader_started = false;
+
+        for (;;) {
+            NPT_Cardinal index;
+            { CSingleLock lock(m_Section);
+              if (m_Next >= m_Items.size())
+                  break;
+              index = m_Next++;
+            }
+
+            if (!thumb_loader_started) {
+                thumb_loader = GetThumbLoader(m_Path);
+                if (!thumb_loader.IsNull())
+                    thumb_loader->OnLoaderStart();
+                thumb_loader_started = true;
+            }
+
+            NPT_String didl;
+            PLT_MediaObjectReference object(m_Server->Build(m_Items[index], true, m_Context, thumb_loader,
+                                                            m_HasParentId?m_ParentId.c_str():NULL));
+            if (!object.IsNull() && NPT_FAILED(PLT_Didl::ToDidl(*object.AsPointer(), m_Filter.c_str(), didl)))
+                didl = "";
+
+            CSingleLock lock(m_Section);
+            m_Didl[index] = didl;
+            if (++m_Done == m_Items.size())
+                m_Finished.Set();
+        }
+
+        if (!thumb_loader.IsNull())
+            thumb_loader->OnLoaderFinish();
+    }
+
+    void Wait() {
+        { CSingleLock lock(m_Section);
+          if (m_Done == m_Items.size())
+              return;
+        }
+        m_Finished.Wait();
+    }
+
+private:
+    CUPnPServer*                  m_Server;
+    std::string                   m_Path;
+    std::string                   m_Filter;
+    const PLT_HttpRequestContext& m_Context;
+    std::string                   m_ParentId;
+    bool                          m_HasParentId;
+
+    CCriticalSection              m_Section;
+    std::vector<CFileItemPtr>     m_Items;
+    std::vector<NPT_String>       m_Didl;
+    NPT_Cardinal                  m_Next;
+    NPT_Cardinal                  m_Done;
+    CEvent                        m_Finished;
+};
+
+class CUPnPServer::CBuildJob : public CJob
+{
+public:
+    CBuildJob(const std::shared_ptr<CBuildQueue>& queue) : m_Queue(queue) {}
+
+    virtual const char* GetType() const { return "upnpbuild"; }
+    virtual bool DoWork() {
+        m_Queue->Process();
+        return true;
+    }
+
+private:
+    std::shared_ptr<CBuildQueue> m_Queue;
+};
+
 /*----------------------------------------------------------------------
 |   CUPnPServer::CUPnPServer
 +---------------------------------------------------------------------*/
 CUPnPServer::CUPnPServer(const char* friendly_name, const char* uuid /*= NULL*/, int port /*= 0*/) :
     PLT_MediaConnect(friendly_name, false, uuid, port),
     PLT_FileMediaConnectDelegate("/", "/"),
+    m_DidlCache(UPNP_DIDL_CACHE_SIZE),
     m_scanning(g_application.IsMusicScanning() || g_application.IsVideoScanning())
 {
 }
@@ -134,6 +257,10 @@ CUPnPServer::OnScanCompleted(int type)
     }
     else
         return;
+
+    // a scan or clean may have changed anything in the library
+    m_DidlCache.Clear();
+
     m_scanning = false;
     PropagateUpdates();
 }
@@ -440,6 +567,14 @@ CUPnPServer::Announce(AnnouncementFlag flag, const char *sender, const char *mes
             item_type = data["type"].asString();
         }
 
+        // drop the cached didl of the item, episodes and seasons also
+        // contain details of their tvshow
+        m_DidlCache.Invalidate(item_type, item_id);
+        if (item_type == MediaTypeTvShow) {
+            m_DidlCache.Invalidate(MediaTypeSeason);
+            m_DidlCache.Invalidate(MediaTypeEpisode);
+        }
+
         // we always update 'recently added' nodes along with the specific container,
         // as we don't differentiate 'updates' from 'adds' in RPC interface
         if (flag == VideoLibrary) {
@@ -642,6 +777,27 @@ CUPnPServer::OnBrowseDirectChildren(PLT_ActionReference&          action,
         return NPT_FAILURE;
     }
 
+    // Don't pass parent_id if action is Search not BrowseDirectChildren, as
+    // we want the engine to determine the best parent id, not necessarily the one
+    // passed
+    NPT_String action_name = action->GetActionDesc().GetName();
+    const char* response_parent_id = (action_name.Compare("Search", true)==0)?NULL:parent_id.GetChars();
+
+    // let the database do the paging of large library containers instead
+    // of retrieving all of their items for every page
+    if (GetPagedItems((const char*)parent_id, starting_index, requested_count, items)) {
+        return BuildResponse(
+            action,
+            items,
+            filter,
+            starting_index,
+            requested_count,
+            sort_criteria,
+            context,
+            response_parent_id,
+            true);
+    }
+
     items.SetPath(std::string(parent_id));
 
     // guard against loading while saving to the same cache file
@@ -705,10 +861,6 @@ CUPnPServer::OnBrowseDirectChildren(PLT_ActionReference&          action,
       }
     }
 
-    // Don't pass parent_id if action is Search not BrowseDirectChildren, as
-    // we want the engine to determine the best parent id, not necessarily the one
-    // passed
-    NPT_String action_name = action->GetActionDesc().GetName();
     return BuildResponse(
         action,
         items,
@@ -717,7 +869,93 @@ CUPnPServer::OnBrowseDirectChildren(PLT_ActionReference&          action,
         requested_count,
         sort_criteria,
         context,
-        (action_name.Compare("Search", true)==0)?NULL:parent_id.GetChars());
+        response_parent_id);
+}
+
+/*----------------------------------------------------------------------
+|   CUPnPServer::GetPagedItems
+|
+|   Retrieves only the requested page of library containers whose items
+|   come straight from the database. Returns false for everything else.
++---------------------------------------------------------------------*/
+bool
+CUPnPServer::GetPagedItems(const std::string& path,
+                           NPT_UInt32         starting_index,
+                           NPT_UInt32         requested_count,
+                           CFileItemList&     items)
+{
+    NPT_UInt32 max_count = (requested_count == 0)?m_MaxReturnedItems:min((unsigned long)requested_count, (unsigned long)m_MaxReturnedItems);
+
+    std::string db_path = path;
+    if (StringUtils::StartsWith(path, "library://")) {
+        CLibraryDirectory library;
+        CSmartPlaylist playlist;
+        // filter nodes are paged with their rules, order and limit applied
+        // by the database, just like CLibraryDirectory lists them
+        if (library.GetFilterPlaylist(CURL(path), playlist)) {
+            if (!CSmartPlaylistDirectory::GetDirectoryRange(playlist, starting_index, starting_index + max_count, items)) {
+                items.Clear();
+                return false;
+            }
+            items.SetPath(path);
+            return true;
+        }
+        if (!library.GetFolderPath(CURL(path), db_path))
+            return false;
+    }
+
+    // options hold rules (xsp) and filters the node would apply on top of
+    // the plain database listing
+    if (!CURL(db_path).GetOptions().empty())
+        return false;
+
+    bool paged = false;
+    if (URIUtils::IsVideoDb(db_path)) {
+        VIDEODATABASEDIRECTORY::NODE_TYPE type = CVideoDatabaseDirectory::GetDirectoryChildType(db_path);
+        VIDEODATABASEDIRECTORY::CQueryParams params;
+        CVideoDatabaseDirectory::GetQueryParams(db_path, params);
+
+        // all episodes of a tvshow also contain its linked movies
+        paged = type == VIDEODATABASEDIRECTORY::NODE_TYPE_TITLE_MOVIES ||
+                type == VIDEODATABASEDIRECTORY::NODE_TYPE_TITLE_TVSHOWS ||
+                type == VIDEODATABASEDIRECTORY::NODE_TYPE_TITLE_MUSICVIDEOS ||
+               (type == VIDEODATABASEDIRECTORY::NODE_TYPE_EPISODES && params.GetSeason() >= 0);
+    }
+    else if (URIUtils::IsMusicDb(db_path)) {
+        MUSICDATABASEDIRECTORY::NODE_TYPE type = CMusicDatabaseDirectory::GetDirectoryChildType(db_path);
+
+        // artists and albums below other nodes come with an "all" item
+        paged = type == MUSICDATABASEDIRECTORY::NODE_TYPE_SONG ||
+              ((type == MUSICDATABASEDIRECTORY::NODE_TYPE_ARTIST || type == MUSICDATABASEDIRECTORY::NODE_TYPE_ALBUM) &&
+               CMusicDatabaseDirectory::GetDirectoryType(db_path) == MUSICDATABASEDIRECTORY::NODE_TYPE_OVERVIEW);
+    }
+    if (!paged)
+        return false;
+
+    // use the same sorting as the unpaged directory would have
+    items.SetPath(db_path);
+    SortDescription sorting = GetDefaultSort(items);
+    sorting.limitStart = starting_index;
+    sorting.limitEnd = starting_index + max_count;
+
+    bool success = false;
+    if (URIUtils::IsVideoDb(db_path)) {
+        CVideoDatabase db;
+        success = db.Open() && db.GetItems(db_path, items, CDatabase::Filter(), sorting);
+    }
+    else {
+        CMusicDatabase db;
+        success = db.Open() && db.GetItems(db_path, items, CDatabase::Filter(), sorting);
+    }
+
+    if (!success) {
+        CLog::Log(LOGWARNING, "UPnP: failed to retrieve items %u to %u of %s", starting_index, sorting.limitEnd, path.c_str());
+        items.Clear();
+        return false;
+    }
+
+    items.SetPath(path);
+    return true;
 }
 
 /*----------------------------------------------------------------------
@@ -731,7 +969,8 @@ CUPnPServer::BuildResponse(PLT_ActionReference&          action,
                            NPT_UInt32                    requested_count,
                            const char*                   sort_criteria,
                            const PLT_HttpRequestContext& context,
-                           const char*                   parent_id /* = NULL */)
+                           const char*                   parent_id /* = NULL */,
+                           bool                          paged /* = false */)
 {
     NPT_COMPILER_UNUSED(sort_criteria);
 
@@ -740,24 +979,6 @@ CUPnPServer::BuildResponse(PLT_ActionReference&          action,
         starting_index,
         requested_count);
 
-    // we will reuse this ThumbLoader for all items
-    NPT_Reference<CThumbLoader> thumb_loader;
-
-    if (URIUtils::IsVideoDb(items.GetPath()) ||
-        StringUtils::StartsWithNoCase(items.GetPath(), "library://video/") ||
-        StringUtils::StartsWithNoCase(items.GetPath(), "special://profile/playlists/video/")) {
-
-        thumb_loader = NPT_Reference<CThumbLoader>(new CVideoThumbLoader());
-    }
-    else if (URIUtils::IsMusicDb(items.GetPath()) ||
-        StringUtils::StartsWithNoCase(items.GetPath(), "special://profile/playlists/music/")) {
-
-        thumb_loader = NPT_Reference<CThumbLoader>(new CMusicThumbLoader());
-    }
-    if (!thumb_loader.IsNull()) {
-        thumb_loader->OnLoaderStart();
-    }
-
     // this isn't pretty but needed to properly hide the addons node from clients
     if (StringUtils::StartsWith(items.GetPath(), "library")) {
         for (int i=0; i<items.Size(); i++) {
@@ -770,35 +991,78 @@ CUPnPServer::BuildResponse(PLT_ActionReference&          action,
     // won't return more than UPNP_MAX_RETURNED_ITEMS items at a time to keep things smooth
     // 0 requested means as many as possible
     NPT_UInt32 max_count  = (requested_count == 0)?m_MaxReturnedItems:min((unsigned long)requested_count, (unsigned long)m_MaxReturnedItems);
-    NPT_UInt32 stop_index = min((unsigned long)(starting_index + max_count), (unsigned long)items.Size()); // don't return more than we can
 
-    NPT_Cardinal count = 0;
+    // paged items only contain the requested page, the database told us
+    // how many there are in total
+    NPT_UInt32   start_index = starting_index;
     NPT_Cardinal total = items.Size();
-    NPT_String didl = didl_header;
-    PLT_MediaObjectReference object;
-    for (unsigned long i=starting_index; i<stop_index; ++i) {
-        object = Build(items[i], true, context, thumb_loader, parent_id);
-        if (object.IsNull()) {
-            // don't tell the client this item ever existed
-            --total;
-            continue;
+    if (paged) {
+        start_index = 0;
+        total = max((unsigned long)items.GetProperty("total").asInteger(), (unsigned long)(starting_index + items.Size()));
+    }
+    NPT_UInt32 stop_index = min((unsigned long)(start_index + max_count), (unsigned long)items.Size()); // don't return more than we can
+
+    // look up the cached didl of the items and queue the others
+    std::vector<std::string> fragments(stop_index > start_index ? stop_index - start_index : 0);
+    std::vector<std::string> keys(fragments.size());
+    std::vector<std::string> stamps(fragments.size());
+    std::vector<NPT_Cardinal> queued(fragments.size());
+    std::shared_ptr<CBuildQueue> queue(new CBuildQueue(this, items.GetPath(), filter, context, parent_id));
+    for (unsigned long i=start_index; i<stop_index; ++i) {
+        const unsigned long index = i - start_index;
+        keys[index] = GetDidlCacheKey(*items[i], filter, context, parent_id);
+        stamps[index] = CUPnPDidlCache::GetStamp(*items[i]);
+        if (!m_DidlCache.Get(keys[index], stamps[index], fragments[index])) {
+            queued[index] = queue->GetCount();
+            queue->Add(items[i]);
         }
+    }
+
+    // build the uncached items with the help of some jobs for large pages
+    if (queue->GetCount() > 0) {
+        NPT_Cardinal jobs = min((NPT_Cardinal)UPNP_BUILD_JOBS, (queue->GetCount() - 1) / UPNP_BUILD_JOB_ITEMS);
+        for (NPT_Cardinal i = 0; i < jobs; ++i)
+            CJobManager::GetInstance().AddJob(new CBuildJob(queue), NULL, CJob::PRIORITY_NORMAL);
 
-        NPT_String tmp;
-        NPT_CHECK(PLT_Didl::ToDidl(*object.AsPointer(), filter, tmp));
+        queue->Process();
+        queue->Wait();
+    }
+
+    NPT_Cardinal count = 0;
+    NPT_String didl = didl_header;
+    for (unsigned long i=start_index; i<stop_index; ++i) {
+        const unsigned long index = i - start_index;
+        if (fragments[index].empty()) {
+            const NPT_String& tmp = queue->GetDidl(queued[index]);
+            if (tmp.IsEmpty()) {
+                // don't tell the client this item ever existed
+                --total;
+                continue;
+            }
+            fragments[index] = (const char*)tmp;
+
+            CFileItemPtr item = items[i];
+            if (item->HasVideoInfoTag())
+                m_DidlCache.Set(keys[index], stamps[index], item->GetVideoInfoTag()->m_type, item->GetVideoInfoTag()->m_iDbId, fragments[index]);
+            else if (item->HasMusicInfoTag())
+                m_DidlCache.Set(keys[index], stamps[index], item->GetMusicInfoTag()->GetType(), item->GetMusicInfoTag()->GetDatabaseId(), fragments[index]);
+            else
+                m_DidlCache.Set(keys[index], stamps[index], "", -1, fragments[index]);
+        }
 
         // Neptunes string growing is dead slow for small additions
-        if (didl.GetCapacity() < tmp.GetLength() + didl.GetLength()) {
-            didl.Reserve((tmp.GetLength() + didl.GetLength())*2);
+        if (didl.GetCapacity() < fragments[index].size() + didl.GetLength()) {
+            didl.Reserve((fragments[index].size() + didl.GetLength())*2);
         }
-        didl += tmp;
+        didl.Append(fragments[index].c_str(), fragments[index].size());
         ++count;
     }
 
     didl += didl_footer;
 
-    CLog::Log(LOGDEBUG, "Returning UPnP response with %d items out of %d total matches",
+    CLog::Log(LOGDEBUG, "Returning UPnP response with %d items (%d built) out of %d total matches",
         count,
+        queue->GetCount(),
         total);
 
     NPT_CHECK(action->SetArgumentValue("Result", didl));
@@ -808,6 +1072,47 @@ CUPnPServer::BuildResponse(PLT_ActionReference&          action,
     return NPT_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+|   CUPnPServer::GetDidlCacheKey
+|
+|   The didl of an item also depends on the client (quirks, mime types)
+|   and the interface it connected to (resource uris).
++---------------------------------------------------------------------*/
+std::string
+CUPnPServer::GetDidlCacheKey(const CFileItem&              item,
+                             const char*                   filter,
+                             const PLT_HttpRequestContext& context,
+                             const char*                   parent_id)
+{
+    const NPT_String* user_agent = context.GetRequest().GetHeaders().GetHeaderValue(NPT_HTTP_HEADER_USER_AGENT);
+    return StringUtils::Format("%s|%s|%s|%s|%s",
+                               item.GetPath().c_str(),
+                               parent_id ? parent_id : "",
+                               filter ? filter : "",
+                               (const char*)context.GetLocalAddress().ToString(),
+                               user_agent ? (const char*)*user_agent : "");
+}
+
+/*----------------------------------------------------------------------
+|   CUPnPServer::GetThumbLoader
++---------------------------------------------------------------------*/
+NPT_Reference<CThumbLoader>
+CUPnPServer::GetThumbLoader(const std::string& path)
+{
+    if (URIUtils::IsVideoDb(path) ||
+        StringUtils::StartsWithNoCase(path, "library://video/") ||
+        StringUtils::StartsWithNoCase(path, "special://profile/playlists/video/")) {
+
+        return NPT_Reference<CThumbLoader>(new CVideoThumbLoader());
+    }
+    else if (URIUtils::IsMusicDb(path) ||
+        StringUtils::StartsWithNoCase(path, "special://profile/playlists/music/")) {
+
+        return NPT_Reference<CThumbLoader>(new CMusicThumbLoader());
+    }
+    return NPT_Reference<CThumbLoader>();
+}
+
 /*----------------------------------------------------------------------
 |   FindSubCriteria
 +---------------------------------------------------------------------*/
@@ -1296,13 +1601,21 @@ CUPnPServer::SortItems(CFileItemList& items, const char* sort_criteria)
 void
 CUPnPServer::DefaultSortItems(CFileItemList& items)
 {
+  SortDescription sorting = GetDefaultSort(items);
+  items.Sort(sorting.sortBy, sorting.sortOrder, sorting.sortAttributes);
+}
+
+SortDescription
+CUPnPServer::GetDefaultSort(const CFileItemList& items)
+{
+  SortDescription sorting;
   CGUIViewState* viewState = CGUIViewState::GetViewState(items.IsVideoDb() ? WINDOW_VIDEO_NAV : -1, items);
   if (viewState)
   {
-    SortDescription sorting = viewState->GetSortMethod();
-    items.Sort(sorting.sortBy, sorting.sortOrder, sorting.sortAttributes);
+    sorting = viewState->GetSortMethod();
     delete viewState;
   }
+  return sorting;
 }
 
 NPT_Result
@@ -22,6 +22,7 @@
 
 #include "interfaces/IAnnouncer.h"
 #include "FileItem.h"
+#include "UPnPDidlCache.h"
 
 class CThumbLoader;
 class PLT_MediaObject;
@@ -119,11 +120,22 @@ private:
                                    NPT_UInt32                    requested_count,
                                    const char*                   sort_criteria,
                                    const PLT_HttpRequestContext& context,
-                                   const char*                   parent_id /* = NULL */);
+                                   const char*                   parent_id /* = NULL */,
+                                   bool                          paged = false);
+    bool             GetPagedItems(const std::string& path,
+                                   NPT_UInt32         starting_index,
+                                   NPT_UInt32         requested_count,
+                                   CFileItemList&     items);
 
     // class methods
     static bool SortItems(CFileItemList& items, const char* sort_criteria);
     static void DefaultSortItems(CFileItemList& items);
+    static SortDescription GetDefaultSort(const CFileItemList& items);
+    static NPT_Reference<CThumbLoader> GetThumbLoader(const std::string& path);
+    static std::string GetDidlCacheKey(const CFileItem&             item,
+                                       const char*                   filter,
+                                       const PLT_HttpRequestContext& context,
+                                       const char*                   parent_id);
     static NPT_String GetParentFolder(NPT_String file_path) {
         int index = file_path.ReverseFind("\\");
         if (index == -1) return "";
@@ -131,7 +143,11 @@ private:
         return file_path.Left(index);
     }
 
+    class CBuildQueue;
+    class CBuildJob;
+
     NPT_Mutex                       m_CacheMutex;
+    CUPnPDidlCache                  m_DidlCache;
 
     NPT_Mutex                       m_FileMutex;
     NPT_Map<NPT_String, NPT_String> m_FileMap;
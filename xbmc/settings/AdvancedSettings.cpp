@@ -253,6 +253,7 @@ void CAdvancedSettings::Initialize()
 
   m_fanartRes = 1080;
   m_imageRes = 720;
+  m_exifThumbTolerance = 0;
   m_useDDSFanart = false;
 
   m_sambaclienttimeout = 10;
@@ -270,6 +271,8 @@ void CAdvancedSettings::Initialize()
   m_bMusicLibraryAllItemsOnBottom = false;
   m_bMusicLibraryAlbumsSortByArtistThenYear = false;
   m_bMusicLibraryCleanOnUpdate = false;
+  m_iMusicLibraryScanThreads = 4;
+  m_iMusicLibraryScanBatchSize = 100;
   m_iMusicLibraryRecentlyAddedItems = 25;
   m_strMusicLibraryAlbumFormat = "";
   m_strMusicLibraryAlbumFormatRight = "";
@@ -325,6 +328,8 @@ void CAdvancedSettings::Initialize()
   m_curlretries = 2;
   m_curlDisableIPV6 = false;      //Certain hardware/OS combinations have trouble
                                   //with ipv6.
+  m_curlDisableHTTP2 = false;
+  m_curlParallelRanges = 4;       //Ranged requests used by CCurlFile::Download
 
   m_startFullScreen = false;
   m_showExitButton = true;
@@ -368,14 +373,19 @@ void CAdvancedSettings::Initialize()
   m_iPVRNumericChannelSwitchTimeout = 1000;
 
   m_cacheMemBufferSize = 1024 * 1024 * 20;
+  m_cacheMapped = false;
+  m_cacheMappedPersist = false;
   m_networkBufferMode = 0; // Default (buffer all internet streams/filesystems)
   // the following setting determines the readRate of a player data
   // as multiply of the default data read rate
   m_readBufferFactor = 1.0f;
   m_addonPackageFolderSize = 200;
+  m_directoryCacheSize = 16 * 1024; // 16 MB
+  m_persistentDirectoryCache = false;
 
   m_jsonOutputCompact = true;
   m_jsonTcpPort = 9090;
+  m_jsonTcpWorkers = 4;
 
   m_enableMultimediaKeys = false;
 
@@ -750,6 +760,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetBoolean(pElement, "allitemsonbottom", m_bMusicLibraryAllItemsOnBottom);
     XMLUtils::GetBoolean(pElement, "albumssortbyartistthenyear", m_bMusicLibraryAlbumsSortByArtistThenYear);
     XMLUtils::GetBoolean(pElement, "cleanonupdate", m_bMusicLibraryCleanOnUpdate);
+    XMLUtils::GetInt(pElement, "scanthreads", m_iMusicLibraryScanThreads, 1, 16);
+    XMLUtils::GetInt(pElement, "scanbatchsize", m_iMusicLibraryScanBatchSize, 1, 10000);
     XMLUtils::GetString(pElement, "albumformat", m_strMusicLibraryAlbumFormat);
     XMLUtils::GetString(pElement, "albumformatright", m_strMusicLibraryAlbumFormatRight);
     XMLUtils::GetString(pElement, "itemseparator", m_musicItemSeparator);
@@ -798,7 +810,11 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetInt(pElement, "curllowspeedtime", m_curllowspeedtime, 1, 1000);
     XMLUtils::GetInt(pElement, "curlretries", m_curlretries, 0, 10);
     XMLUtils::GetBoolean(pElement,"disableipv6", m_curlDisableIPV6);
+    XMLUtils::GetBoolean(pElement,"disablehttp2", m_curlDisableHTTP2);
+    XMLUtils::GetInt(pElement, "curlparallelranges", m_curlParallelRanges, 1, 16);
     XMLUtils::GetUInt(pElement, "cachemembuffersize", m_cacheMemBufferSize);
+    XMLUtils::GetBoolean(pElement, "mappedcache", m_cacheMapped);
+    XMLUtils::GetBoolean(pElement, "mappedcachepersist", m_cacheMappedPersist);
     XMLUtils::GetUInt(pElement, "buffermode", m_networkBufferMode, 0, 3);
     XMLUtils::GetFloat(pElement, "readbufferfactor", m_readBufferFactor);
   }
@@ -808,6 +824,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   {
     XMLUtils::GetBoolean(pElement, "compactoutput", m_jsonOutputCompact);
     XMLUtils::GetUInt(pElement, "tcpport", m_jsonTcpPort);
+    XMLUtils::GetUInt(pElement, "tcpworkers", m_jsonTcpWorkers, 1, 32);
   }
 
   pElement = pRootElement->FirstChildElement("samba");
@@ -874,6 +891,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   XMLUtils::GetFloat(pRootElement,"sleepbeforeflip", m_sleepBeforeFlip, 0.0f, 1.0f);
   XMLUtils::GetBoolean(pRootElement,"virtualshares", m_bVirtualShares);
   XMLUtils::GetUInt(pRootElement, "packagefoldersize", m_addonPackageFolderSize);
+  XMLUtils::GetUInt(pRootElement, "directorycachesize", m_directoryCacheSize);
+  XMLUtils::GetBoolean(pRootElement, "persistentdirectorycache", m_persistentDirectoryCache);
 
   //Tuxbox
   pElement = pRootElement->FirstChildElement("tuxbox");
@@ -1033,6 +1052,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   XMLUtils::GetFloat(pRootElement, "controllerdeadzone", m_controllerDeadzone, 0.0f, 1.0f);
   XMLUtils::GetUInt(pRootElement, "fanartres", m_fanartRes, 0, 1080);
   XMLUtils::GetUInt(pRootElement, "imageres", m_imageRes, 0, 1080);
+  XMLUtils::GetUInt(pRootElement, "exifthumbtolerance", m_exifThumbTolerance, 0, 50);
 #if !defined(TARGET_RASPBERRY_PI)
   XMLUtils::GetBoolean(pRootElement, "useddsfanart", m_useDDSFanart);
 #endif
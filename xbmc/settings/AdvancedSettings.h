@@ -248,6 +248,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
      Used for actual thumbs (eg bookmark thumbs, picture thumbs) rather than cover art which uses m_imageRes instead
      */
     unsigned int GetThumbSize() const { return m_imageRes / 2; };
+    unsigned int m_exifThumbTolerance; ///< \brief percentage an EXIF thumbnail may be smaller than the size needed and still be used instead of the image
     bool m_useDDSFanart;
 
     int m_sambaclienttimeout;
@@ -266,6 +267,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_bMusicLibraryAllItemsOnBottom;
     bool m_bMusicLibraryAlbumsSortByArtistThenYear;
     bool m_bMusicLibraryCleanOnUpdate;
+    int m_iMusicLibraryScanThreads;
+    int m_iMusicLibraryScanBatchSize;
     std::string m_strMusicLibraryAlbumFormat;
     std::string m_strMusicLibraryAlbumFormatRight;
     bool m_prioritiseAPEv2tags;
@@ -324,6 +327,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_curllowspeedtime;
     int m_curlretries;
     bool m_curlDisableIPV6;
+    bool m_curlDisableHTTP2;
+    int m_curlParallelRanges;
 
     bool m_fullScreen;
     bool m_startFullScreen;
@@ -376,13 +381,18 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int  m_guiAlgorithmDirtyRegions;
     int  m_guiDirtyRegionNoFlipTimeout;
     unsigned int m_addonPackageFolderSize;
+    unsigned int m_directoryCacheSize; ///< \brief memory budget of the directory cache in KB
+    bool m_persistentDirectoryCache;   ///< \brief keep listings of network shares on disk between sessions
 
     unsigned int m_cacheMemBufferSize;
+    bool m_cacheMapped;
+    bool m_cacheMappedPersist;
     unsigned int m_networkBufferMode;
     float m_readBufferFactor;
 
     bool m_jsonOutputCompact;
     unsigned int m_jsonTcpPort;
+    unsigned int m_jsonTcpWorkers;
 
     bool m_enableMultimediaKeys;
     std::vector<std::string> m_settingsFiles;
@@ -0,0 +1,80 @@
+/*
+ *      Copyright (C) 2015 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "TextureCache.h"
+#include "TextureCacheJob.h"
+#include "threads/Thread.h"
+
+#include "gtest/gtest.h"
+
+#define TEST_CONTENT "0123456789abcdef0123456789abcdef-test"
+
+class GetCachedContent : public IRunnable
+{
+public:
+  GetCachedContent() : m_cached(true) { }
+
+  virtual void Run()
+  {
+    CTextureDetails details;
+    m_cached = CTextureCache::Get().GetCachedContent(TEST_CONTENT, details);
+  }
+
+  bool m_cached;
+};
+
+TEST(TestTextureCache, ContentWaitsForCachingJob)
+{
+  CTextureDetails details;
+  // the content isn't cached, so we're expected to cache it
+  ASSERT_FALSE(CTextureCache::Get().GetCachedContent(TEST_CONTENT, details));
+
+  GetCachedContent runnable;
+  CThread thread(&runnable, "TestTextureCache");
+  thread.Create();
+  EXPECT_FALSE(thread.WaitForThreadExit(100));
+
+  // once we're done the waiting job continues right away
+  CTextureCache::Get().ReleaseContent(TEST_CONTENT);
+  EXPECT_TRUE(thread.WaitForThreadExit(500));
+  EXPECT_FALSE(runnable.m_cached);
+
+  // it is now responsible for caching the content
+  CTextureCache::Get().ReleaseContent(TEST_CONTENT);
+}
+
+TEST(TestTextureCache, CancelledJobReleasesContent)
+{
+  CTextureCacheJob *job = new CTextureCacheJob("/path/to/image/file.jpg");
+  ASSERT_FALSE(CTextureCache::Get().GetCachedContent(TEST_CONTENT, job->m_details));
+  job->m_details.contentHash = TEST_CONTENT;
+  job->m_cachingContent = true;
+
+  // a cancelled job is deleted without OnJobComplete()
+  delete job;
+
+  GetCachedContent runnable;
+  CThread thread(&runnable, "TestTextureCache");
+  thread.Create();
+  EXPECT_TRUE(thread.WaitForThreadExit(500));
+  EXPECT_FALSE(runnable.m_cached);
+
+  CTextureCache::Get().ReleaseContent(TEST_CONTENT);
+}
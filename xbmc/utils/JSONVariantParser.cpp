@@ -64,7 +64,7 @@ CVariant CJSONVariantParser::Parse(const unsigned char *json, unsigned int lengt
 
   parser.push_buffer(json, length);
 
-  return callback.GetOutput();
+  return std::move(callback.GetOutput());
 }
 
 int CJSONVariantParser::ParseNull(void * ctx)
@@ -130,7 +130,7 @@ int CJSONVariantParser::ParseMapKey(void * ctx, const unsigned char * stringVal,
 {
   CJSONVariantParser *parser = (CJSONVariantParser *)ctx;
 
-  parser->m_key = std::string((const char *)stringVal, 0, stringLen);
+  parser->m_key.assign((const char *)stringVal, stringLen);
 
   return 1;
 }
@@ -164,28 +164,31 @@ int CJSONVariantParser::ParseArrayEnd(void * ctx)
 
 void CJSONVariantParser::PushObject(CVariant variant)
 {
+  PARSE_STATUS status = ParseVariable;
+  if (variant.isObject())
+    status = ParseObject;
+  else if (variant.isArray())
+    status = ParseArray;
+
+  // move the value into its place in the parsed tree instead of copying it
   if (m_status == ParseObject)
   {
-    (*m_parse[m_parse.size() - 1])[m_key] = variant;
-    m_parse.push_back(&(*m_parse[m_parse.size() - 1])[m_key]);
+    CVariant &value = (*m_parse[m_parse.size() - 1])[m_key];
+    value = std::move(variant);
+    m_parse.push_back(&value);
   }
   else if (m_status == ParseArray)
   {
     CVariant *temp = m_parse[m_parse.size() - 1];
-    temp->push_back(variant);
+    temp->push_back(std::move(variant));
     m_parse.push_back(&(*temp)[temp->size() - 1]);
   }
   else if (m_parse.size() == 0)
   {
-    m_parse.push_back(new CVariant(variant));
+    m_parse.push_back(new CVariant(std::move(variant)));
   }
 
-  if (variant.isObject())
-    m_status = ParseObject;
-  else if (variant.isArray())
-    m_status = ParseArray;
-  else
-    m_status = ParseVariable;
+  m_status = status;
 }
 
 void CJSONVariantParser::PopObject()
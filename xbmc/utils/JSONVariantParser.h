@@ -19,6 +19,8 @@
  *
  */
 
+#include <utility>
+
 #include "Variant.h"
 
 #include <yajl/yajl_parse.h>
@@ -35,7 +37,7 @@ public:
 class CSimpleParseCallback : public IParseCallback
 {
 public:
-  virtual void onParsed(CVariant *variant) { m_parsed = *variant; }
+  virtual void onParsed(CVariant *variant) { m_parsed = std::move(*variant); }
   CVariant &GetOutput() { return m_parsed; }
 
 private:
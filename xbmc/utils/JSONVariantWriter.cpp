@@ -24,9 +24,31 @@
 
 using namespace std;
 
+static void AppendBuffer(yajl_gen g, string &output)
+{
+  const unsigned char * buffer;
+  size_t length;
+  yajl_gen_get_buf(g, &buffer, &length);
+  output.append((const char *)buffer, length);
+  yajl_gen_clear(g);
+}
+
 string CJSONVariantWriter::Write(const CVariant &value, bool compact)
 {
-  string output;
+  vector<string> parts;
+  vector<const CVariant*> splitValues;
+  if (!Write(value, compact, NULL, NULL, parts, splitValues))
+    return "";
+
+  return std::move(parts.front());
+}
+
+bool CJSONVariantWriter::Write(const CVariant &value, bool compact, SplitFunc split, void *data, vector<string> &parts, vector<const CVariant*> &splitValues)
+{
+  parts.assign(1, "");
+  splitValues.clear();
+
+  SplitContext context = { split, data, &parts, &splitValues };
 
   yajl_gen g = yajl_gen_alloc(NULL);
   yajl_gen_config(g, yajl_gen_beautify, compact ? 0 : 1);
@@ -51,13 +73,13 @@ string CJSONVariantWriter::Write(const CVariant &value, bool compact)
   }
 #endif // TARGET_WINDOWS
 
-  if (InternalWrite(g, value))
+  bool success = InternalWrite(g, value, split != NULL ? &context : NULL);
+  if (success)
+    AppendBuffer(g, parts.back());
+  else
   {
-    const unsigned char * buffer;
-
-    size_t length;
-    yajl_gen_get_buf(g, &buffer, &length);
-    output = string((const char *)buffer, length);
+    parts.assign(1, "");
+    splitValues.clear();
   }
 
   // Re-set locale to what it was before using yajl
@@ -72,11 +94,34 @@ string CJSONVariantWriter::Write(const CVariant &value, bool compact)
   yajl_gen_clear(g);
   yajl_gen_free(g);
 
-  return output;
+  return success;
 }
 
-bool CJSONVariantWriter::InternalWrite(yajl_gen g, const CVariant &value)
+bool CJSONVariantWriter::Split(yajl_gen g, const CVariant &value, SplitContext *split)
 {
+  // everything written so far goes in front of the left out value
+  AppendBuffer(g, split->parts->back());
+
+  // write null in its place to have the generator add the separator and
+  // indentation of the value and carry on as if it had been written
+  if (yajl_gen_null(g) != yajl_gen_status_ok)
+    return false;
+
+  string null;
+  AppendBuffer(g, null);
+  size_t pos = null.rfind("null");
+  split->parts->back().append(null, 0, pos);
+  split->parts->push_back(null.substr(pos + 4));
+  split->values->push_back(&value);
+
+  return true;
+}
+
+bool CJSONVariantWriter::InternalWrite(yajl_gen g, const CVariant &value, SplitContext *split)
+{
+  if (split != NULL && split->func(value, split->data))
+    return Split(g, value, split);
+
   bool success = false;
 
   switch (value.type())
@@ -100,7 +145,7 @@ bool CJSONVariantWriter::InternalWrite(yajl_gen g, const CVariant &value)
     success = yajl_gen_status_ok == yajl_gen_array_open(g);
 
     for (CVariant::const_iterator_array itr = value.begin_array(); itr != value.end_array() && success; ++itr)
-      success &= InternalWrite(g, *itr);
+      success &= InternalWrite(g, *itr, split);
 
     if (success)
       success = yajl_gen_status_ok == yajl_gen_array_close(g);
@@ -113,7 +158,7 @@ bool CJSONVariantWriter::InternalWrite(yajl_gen g, const CVariant &value)
     {
       success &= yajl_gen_status_ok == yajl_gen_string(g, (const unsigned char*)itr->first.c_str(), (size_t)itr->first.length());
       if (success)
-        success &= InternalWrite(g, itr->second);
+        success &= InternalWrite(g, itr->second, split);
     }
 
     if (success)
@@ -19,6 +19,8 @@
  *
  */
 
+#include <vector>
+
 #include "Variant.h"
 #include <yajl/yajl_gen.h>
 
@@ -26,6 +28,38 @@ class CJSONVariantWriter
 {
 public:
   static std::string Write(const CVariant &value, bool compact);
+
+  /*!
+   \brief Decides whether a value is left out of the output
+   \param value Value about to be written
+   \param data Data passed to Write()
+   \return True if the value should be left out
+   */
+  typedef bool (*SplitFunc)(const CVariant &value, void *data);
+
+  /*!
+   \brief Serializes the given value with the values picked by the given
+   function left out, e.g. to have them written by someone else
+   \param value Value to serialize
+   \param compact Whether to leave out whitespace
+   \param split Called for every value to be written
+   \param data Passed on to split
+   \param parts Filled with the output in front of every left out value and
+   the output after the last one
+   \param splitValues Filled with the left out values in the order of the output
+   \return False if the value couldn't be serialized
+   */
+  static bool Write(const CVariant &value, bool compact, SplitFunc split, void *data, std::vector<std::string> &parts, std::vector<const CVariant*> &splitValues);
+
 private:
-  static bool InternalWrite(yajl_gen g, const CVariant &value);
+  typedef struct
+  {
+    SplitFunc func;
+    void *data;
+    std::vector<std::string> *parts;
+    std::vector<const CVariant*> *values;
+  } SplitContext;
+
+  static bool InternalWrite(yajl_gen g, const CVariant &value, SplitContext *split);
+  static bool Split(yajl_gen g, const CVariant &value, SplitContext *split);
 };
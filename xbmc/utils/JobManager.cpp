@@ -239,7 +239,7 @@ unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORI
   CWorkItem work(job, m_jobCounter, priority, callback);
   m_jobQueue[priority].push_back(work);
 
-  StartWorkers(priority);
+  StartWorkers(work);
   return work.m_id;
 }
 
@@ -264,12 +264,32 @@ void CJobManager::CancelJob(unsigned int jobID)
     it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
 }
 
-void CJobManager::StartWorkers(CJob::PRIORITY priority)
+bool CJobManager::CanStart(const CWorkItem &work, bool &allowance) const
+{
+  unsigned int processing = 0;
+  unsigned int allowanceUsed = 0;
+  const std::string type = work.m_job->GetType();
+  for (Processing::const_iterator it = m_processing.begin(); it != m_processing.end(); ++it)
+  {
+    if (!it->m_allowance)
+      processing++;
+    else if (type == it->m_job->GetType())
+      allowanceUsed++;
+  }
+
+  // jobs with an allowance don't take the workers of other jobs while they have their own
+  std::map<std::string, unsigned int>::const_iterator it = m_allowances.find(type);
+  allowance = it != m_allowances.end() && allowanceUsed < it->second;
+  return allowance || processing < GetMaxWorkers(work.m_priority);
+}
+
+void CJobManager::StartWorkers(const CWorkItem &work)
 {
   CSingleLock lock(m_section);
 
   // check how many free threads we have
-  if (m_processing.size() >= GetMaxWorkers(priority))
+  bool allowance;
+  if (!CanStart(work, allowance))
     return;
 
   // do we have any sleeping threads?
@@ -292,11 +312,21 @@ CJob *CJobManager::PopJob()
     if (priority == CJob::PRIORITY_LOW_PAUSABLE && m_pauseJobs)
       continue;
 
-    if (m_jobQueue[priority].size() && m_processing.size() < GetMaxWorkers(CJob::PRIORITY(priority)))
+    // jobs behind one that has to wait may still run on the allowance of their type
+    for (JobQueue::iterator it = m_jobQueue[priority].begin(); it != m_jobQueue[priority].end(); ++it)
     {
+      bool allowance;
+      if (!CanStart(*it, allowance))
+      {
+        if (m_allowances.empty())
+          break;
+        continue;
+      }
+
       // pop the job off the queue
-      CWorkItem job = m_jobQueue[priority].front();
-      m_jobQueue[priority].pop_front();
+      CWorkItem job = *it;
+      job.m_allowance = allowance;
+      m_jobQueue[priority].erase(it);
 
       // add to the processing vector
       m_processing.push_back(job);
@@ -350,6 +380,15 @@ int CJobManager::IsProcessing(const std::string &type) const
   return jobsMatched;
 }
 
+void CJobManager::SetWorkerAllowance(const std::string &type, unsigned int workers)
+{
+  CSingleLock lock(m_section);
+  if (workers > 0)
+    m_allowances[type] = workers;
+  else
+    m_allowances.erase(type);
+}
+
 CJob *CJobManager::GetNextJob(const CJobWorker *worker)
 {
   CSingleLock lock(m_section);
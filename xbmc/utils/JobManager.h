@@ -19,6 +19,7 @@
  *
  */
 
+#include <map>
 #include <queue>
 #include <vector>
 #include <string>
@@ -183,6 +184,7 @@ class CJobManager
       m_id = id;
       m_callback = callback;
       m_priority = priority;
+      m_allowance = false;
     }
     bool operator==(unsigned int jobID) const
     {
@@ -205,6 +207,7 @@ class CJobManager
     unsigned int  m_id;
     IJobCallback *m_callback;
     CJob::PRIORITY m_priority;
+    bool          m_allowance; ///< runs on the worker allowance of its type
   };
 
 public:
@@ -274,6 +277,15 @@ public:
    */
   bool IsProcessing(const CJob::PRIORITY &priority) const;
 
+  /*!
+   \brief Give jobs of a specific type workers of their own
+   Jobs of the type first run on these workers and only compete with other jobs
+   for the workers of their priority once all of them are busy.
+   \param type Job type the workers are reserved for
+   \param workers number of workers, 0 to remove the allowance
+   */
+  void SetWorkerAllowance(const std::string &type, unsigned int workers);
+
 protected:
   friend class CJobWorker;
   friend class CJob;
@@ -317,7 +329,13 @@ private:
    */
   CJob *PopJob();
 
-  void StartWorkers(CJob::PRIORITY priority);
+  /*! \brief Whether the work item may start now
+   \param work the work item to check
+   \param allowance set to true if it runs on the worker allowance of its type
+   */
+  bool CanStart(const CWorkItem &work, bool &allowance) const;
+
+  void StartWorkers(const CWorkItem &work);
   void RemoveWorker(const CJobWorker *worker);
   static unsigned int GetMaxWorkers(CJob::PRIORITY priority);
 
@@ -331,6 +349,7 @@ private:
   bool       m_pauseJobs;
   Processing m_processing;
   Workers    m_workers;
+  std::map<std::string, unsigned int> m_allowances;
 
   CCriticalSection m_section;
   CEvent           m_jobEvent;
@@ -19,15 +19,19 @@
  */
 
 #include "SortUtils.h"
+#include "LangInfo.h"
 #include "URL.h"
 #include "Util.h"
 #include "XBDateTime.h"
 #include "settings/AdvancedSettings.h"
+#include "threads/Thread.h"
 #include "utils/CharsetConverter.h"
+#include "utils/CPUInfo.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
 #include <algorithm>
+#include <locale>
 
 using namespace std;
 
@@ -505,6 +509,283 @@ bool SorterIndirectIgnoreFoldersDescending(const SortItemPtr &left, const SortIt
   return SorterIgnoreFoldersDescending(*left, *right);
 }
 
+/* Collation keys for sorting large lists.
+
+   Comparing two items with the sorters above means several map lookups, two
+   wide string copies and a locale collate call per character. For large lists
+   we instead extract the sort label, the special sort and the folder flag of
+   every item into columns once, and encode every label as a sequence of
+   integers that compare in the same order as StringUtils::AlphaNumericCompare:
+   every character becomes its rank in the collation order of the current
+   locale (after lowering A-Z), every run of up to 15 digits becomes a marker
+   followed by its numeric value. Sorting is then done on an index array.
+
+   If a list can't be represented exactly (characters outside the BMP, digits
+   that don't collate as a single block, items with and without FieldFolder)
+   the caller falls back to the sorters above.
+ */
+#define SORT_KEYS_MIN_ITEMS     256    // below this building the keys isn't worth it
+#define SORT_PARALLEL_MIN_ITEMS 20000  // below this a single thread is fast enough
+#define SORT_MAX_THREADS        4
+#define SORT_NUMBER_DIGITS      15     // see StringUtils::AlphaNumericCompare
+
+class CSortKeys
+{
+public:
+  CSortKeys(size_t size, bool handleFolder, bool descending)
+    : m_handleFolder(handleFolder), m_descending(descending),
+      m_hasFolder(0), m_ranks(0x10000, 0)
+  {
+    m_groups.reserve(size);
+    m_folders.reserve(size);
+    m_labelOffsets.reserve(size + 1);
+    m_labelOffsets.push_back(0);
+  }
+
+  /*! \brief Add the item with the given sort label, returns false if it can't be represented */
+  bool Add(const SortItem &item, const std::wstring &label)
+  {
+    SortItem::const_iterator it;
+    uint8_t group = 1;
+    if ((it = item.find(FieldSortSpecial)) != item.end())
+    {
+      int64_t special = it->second.asInteger();
+      if (special < 0)
+        return false;
+      if (special == SortSpecialOnTop)
+        group = 0;
+      else if (special == SortSpecialOnBottom)
+        group = 2;
+    }
+    m_groups.push_back(group);
+
+    bool folder = false;
+    if (m_handleFolder)
+    {
+      // the sorters only compare folders if both items have the field
+      bool hasFolder = (it = item.find(FieldFolder)) != item.end();
+      if (m_groups.size() == 1)
+        m_hasFolder = hasFolder;
+      else if (m_hasFolder != hasFolder)
+        return false;
+      folder = hasFolder && it->second.asBoolean();
+    }
+    m_folders.push_back(folder);
+
+    for (std::wstring::const_iterator c = label.begin(); c != label.end(); ++c)
+    {
+      if ((uint32_t)*c > 0xFFFF)
+        return false;
+      m_ranks[Lower(*c)] = 1;
+    }
+    m_labels.append(label);
+    m_labelOffsets.push_back(m_labels.size());
+
+    return true;
+  }
+
+  /*! \brief Rank all characters used and encode the labels, returns false if that's not possible */
+  bool Encode()
+  {
+    const std::collate<wchar_t>& coll = std::use_facet< std::collate<wchar_t> >(g_langInfo.GetLocale());
+
+    std::vector<wchar_t> chars;
+    for (wchar_t c = L'0'; c <= L'9'; c++)
+      m_ranks[c] = 1;
+    for (size_t c = 0; c < m_ranks.size(); c++)
+    {
+      if (m_ranks[c])
+        chars.push_back((wchar_t)c);
+    }
+    std::stable_sort(chars.begin(), chars.end(), CCollateLess(coll));
+
+    uint32_t rank = 0;
+    for (size_t i = 0; i < chars.size(); i++)
+    {
+      if (i == 0 || coll.compare(&chars[i - 1], &chars[i - 1] + 1, &chars[i], &chars[i] + 1) != 0)
+        rank++;
+      m_ranks[chars[i]] = rank;
+    }
+
+    // numbers are compared as a whole, which only fits in the order of the
+    // characters if the digits are ranked as a block of their own
+    uint32_t digits = m_ranks[L'0'];
+    for (size_t i = 0; i < chars.size(); i++)
+    {
+      bool digit = chars[i] >= L'0' && chars[i] <= L'9';
+      if (digit && m_ranks[chars[i]] != digits + (chars[i] - L'0'))
+        return false;
+      if (!digit && m_ranks[chars[i]] >= digits && m_ranks[chars[i]] <= digits + 9)
+        return false;
+    }
+
+    m_keys.reserve(m_labels.size());
+    m_keyOffsets.reserve(m_labelOffsets.size());
+    m_keyOffsets.push_back(0);
+    for (size_t item = 0; item + 1 < m_labelOffsets.size(); item++)
+    {
+      const wchar_t *c = m_labels.c_str() + m_labelOffsets[item];
+      const wchar_t *end = m_labels.c_str() + m_labelOffsets[item + 1];
+      while (c < end)
+      {
+        if (*c >= L'0' && *c <= L'9')
+        {
+          const wchar_t *start = c;
+          uint64_t number = 0;
+          while (c < end && *c >= L'0' && *c <= L'9' && c < start + SORT_NUMBER_DIGITS)
+            number = number * 10 + (*c++ - L'0');
+          m_keys.push_back(digits);
+          m_keys.push_back((uint32_t)(number >> 32));
+          m_keys.push_back((uint32_t)number);
+        }
+        else
+          m_keys.push_back(m_ranks[Lower(*c++)]);
+      }
+      m_keyOffsets.push_back(m_keys.size());
+    }
+
+    // the labels and the rank table are no longer needed
+    std::wstring().swap(m_labels);
+    std::vector<uint32_t>().swap(m_ranks);
+    return true;
+  }
+
+  /*! \brief Whether the item at index left is sorted before the one at index right */
+  bool Less(uint32_t left, uint32_t right) const
+  {
+    if (m_groups[left] != m_groups[right])
+      return m_groups[left] < m_groups[right];
+    // both have either sort on top or sort on bottom -> leave as-is
+    if (m_groups[left] != 1)
+      return false;
+
+    if (m_handleFolder && m_folders[left] != m_folders[right])
+      return m_folders[left];
+
+    if (m_descending)
+      std::swap(left, right);
+    return std::lexicographical_compare(m_keys.begin() + m_keyOffsets[left], m_keys.begin() + m_keyOffsets[left + 1],
+                                        m_keys.begin() + m_keyOffsets[right], m_keys.begin() + m_keyOffsets[right + 1]);
+  }
+
+  size_t Size() const { return m_groups.size(); }
+
+private:
+  static wchar_t Lower(wchar_t c)
+  {
+    return (c >= L'A' && c <= L'Z') ? c + (L'a' - L'A') : c;
+  }
+
+  class CCollateLess
+  {
+  public:
+    CCollateLess(const std::collate<wchar_t> &coll) : m_coll(&coll) { }
+    bool operator()(const wchar_t &left, const wchar_t &right) const
+    {
+      return m_coll->compare(&left, &left + 1, &right, &right + 1) < 0;
+    }
+  private:
+    const std::collate<wchar_t> *m_coll;
+  };
+
+  bool m_handleFolder;
+  bool m_descending;
+  bool m_hasFolder;
+
+  std::vector<uint8_t> m_groups;      // 0 sort on top, 1 normal, 2 sort on bottom
+  std::vector<bool> m_folders;
+  std::wstring m_labels;              // all sort labels, see m_labelOffsets
+  std::vector<size_t> m_labelOffsets;
+  std::vector<uint32_t> m_ranks;      // character -> collation rank
+  std::vector<uint32_t> m_keys;       // all encoded labels, see m_keyOffsets
+  std::vector<size_t> m_keyOffsets;
+};
+
+class CSortKeysLess
+{
+public:
+  CSortKeysLess(const CSortKeys &keys) : m_keys(&keys) { }
+  bool operator()(uint32_t left, uint32_t right) const { return m_keys->Less(left, right); }
+private:
+  const CSortKeys *m_keys;
+};
+
+class CSortWorker : public IRunnable
+{
+public:
+  CSortWorker(std::vector<uint32_t>::iterator begin, std::vector<uint32_t>::iterator end, const CSortKeys &keys)
+    : m_begin(begin), m_end(end), m_keys(keys), m_thread(this, "SortWorker")
+  {
+    m_thread.Create();
+  }
+
+  virtual ~CSortWorker()
+  {
+    m_thread.StopThread();
+  }
+
+  virtual void Run()
+  {
+    std::stable_sort(m_begin, m_end, CSortKeysLess(m_keys));
+  }
+
+private:
+  std::vector<uint32_t>::iterator m_begin;
+  std::vector<uint32_t>::iterator m_end;
+  const CSortKeys &m_keys;
+  CThread m_thread;
+};
+
+/*! \brief Stable sort of the indices 0..keys.Size() - 1, in parallel for large lists */
+static void SortIndices(const CSortKeys &keys, std::vector<uint32_t> &indices)
+{
+  indices.resize(keys.Size());
+  for (size_t i = 0; i < indices.size(); i++)
+    indices[i] = i;
+
+  size_t chunks = 1;
+  if (indices.size() >= SORT_PARALLEL_MIN_ITEMS)
+    chunks = std::min(std::max(g_cpuInfo.getCPUCount(), 1), SORT_MAX_THREADS);
+
+  if (chunks == 1)
+  {
+    std::stable_sort(indices.begin(), indices.end(), CSortKeysLess(keys));
+    return;
+  }
+
+  // sort the chunks in parallel, the first one in this thread
+  std::vector<size_t> bounds;
+  for (size_t i = 0; i <= chunks; i++)
+    bounds.push_back(indices.size() * i / chunks);
+
+  std::vector<CSortWorker*> workers;
+  for (size_t i = 1; i < chunks; i++)
+    workers.push_back(new CSortWorker(indices.begin() + bounds[i], indices.begin() + bounds[i + 1], keys));
+  std::stable_sort(indices.begin(), indices.begin() + bounds[1], CSortKeysLess(keys));
+  for (std::vector<CSortWorker*>::iterator it = workers.begin(); it != workers.end(); ++it)
+    delete *it;
+
+  // and merge them, std::merge takes equal items from the first range first so this stays stable
+  std::vector<uint32_t> merged(indices.size());
+  while (bounds.size() > 2)
+  {
+    std::vector<size_t> mergedBounds;
+    for (size_t i = 0; i + 1 < bounds.size(); i += 2)
+    {
+      mergedBounds.push_back(bounds[i]);
+      if (i + 2 < bounds.size())
+        std::merge(indices.begin() + bounds[i], indices.begin() + bounds[i + 1],
+                   indices.begin() + bounds[i + 1], indices.begin() + bounds[i + 2],
+                   merged.begin() + bounds[i], CSortKeysLess(keys));
+      else
+        std::copy(indices.begin() + bounds[i], indices.begin() + bounds[i + 1], merged.begin() + bounds[i]);
+    }
+    mergedBounds.push_back(bounds.back());
+    bounds.swap(mergedBounds);
+    indices.swap(merged);
+  }
+}
+
 map<SortBy, SortUtils::SortPreparator> fillPreparators()
 {
   map<SortBy, SortUtils::SortPreparator> preparators;
@@ -647,6 +928,10 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
     {
       Fields sortingFields = GetFieldsForSorting(sortBy);
 
+      std::unique_ptr<CSortKeys> keys;
+      if (items.size() >= SORT_KEYS_MIN_ITEMS)
+        keys.reset(new CSortKeys(items.size(), !(attributes & SortAttributeIgnoreFolders), sortOrder == SortOrderDescending));
+
       // Prepare the string used for sorting and store it under FieldSort
       for (DatabaseResults::iterator item = items.begin(); item != items.end(); ++item)
       {
@@ -659,11 +944,24 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
 
         std::wstring sortLabel;
         g_charsetConverter.utf8ToW(preparator(attributes, *item), sortLabel, false);
-        item->insert(pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
+        pair<DatabaseResult::iterator, bool> sort = item->insert(pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
+        if (keys && !keys->Add(*item, sort.second ? sortLabel : sort.first->second.asWideString()))
+          keys.reset();
       }
 
       // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorter(sortOrder, attributes));
+      if (keys && keys->Encode())
+      {
+        vector<uint32_t> indices;
+        SortIndices(*keys, indices);
+
+        DatabaseResults sorted(items.size());
+        for (size_t i = 0; i < indices.size(); i++)
+          sorted[i].swap(items[indices[i]]);
+        items.swap(sorted);
+      }
+      else
+        std::stable_sort(items.begin(), items.end(), getSorter(sortOrder, attributes));
     }
   }
 
@@ -686,6 +984,10 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
     {
       Fields sortingFields = GetFieldsForSorting(sortBy);
 
+      std::unique_ptr<CSortKeys> keys;
+      if (items.size() >= SORT_KEYS_MIN_ITEMS)
+        keys.reset(new CSortKeys(items.size(), !(attributes & SortAttributeIgnoreFolders), sortOrder == SortOrderDescending));
+
       // Prepare the string used for sorting and store it under FieldSort
       for (SortItems::iterator item = items.begin(); item != items.end(); ++item)
       {
@@ -698,11 +1000,24 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
 
         std::wstring sortLabel;
         g_charsetConverter.utf8ToW(preparator(attributes, **item), sortLabel, false);
-        (*item)->insert(pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
+        pair<SortItem::iterator, bool> sort = (*item)->insert(pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
+        if (keys && !keys->Add(**item, sort.second ? sortLabel : sort.first->second.asWideString()))
+          keys.reset();
       }
 
       // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorterIndirect(sortOrder, attributes));
+      if (keys && keys->Encode())
+      {
+        vector<uint32_t> indices;
+        SortIndices(*keys, indices);
+
+        SortItems sorted(items.size());
+        for (size_t i = 0; i < indices.size(); i++)
+          sorted[i] = items[indices[i]];
+        items.swap(sorted);
+      }
+      else
+        std::stable_sort(items.begin(), items.end(), getSorterIndirect(sortOrder, attributes));
     }
   }
 
@@ -0,0 +1,221 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "StringAtom.h"
+#include "threads/Atomics.h"
+#include "threads/SharedSection.h"
+#include "threads/SingleLock.h"
+#include "utils/StringUtils.h"
+
+#include <map>
+
+namespace
+{
+struct icompare
+{
+  bool operator()(const std::string &s1, const std::string &s2) const
+  {
+    return StringUtils::CompareNoCase(s1, s2) < 0;
+  }
+};
+}
+
+/* The table is created on first use, as atoms may be created during static
+   initialization, and is never destroyed, as atoms may still be around while
+   other statics are destroyed.
+
+   An entry whose count dropped to zero is about to be removed and can't be
+   handed out again. Interning its string meanwhile replaces it in the table. */
+struct CStringAtomTable
+{
+  typedef std::map<std::string, CStringAtom::Entry*> AtomMap;
+  typedef std::map<std::string, CStringAtom::Entry*, icompare> FoldedAtomMap;
+
+  CSharedSection section;
+  AtomMap atoms;
+  FoldedAtomMap foldedAtoms;
+};
+
+static CStringAtomTable &GetTable()
+{
+  static CStringAtomTable *table = new CStringAtomTable;
+  return *table;
+}
+
+CStringAtom::CStringAtom(const std::string &str)
+  : m_entry(str.empty() ? NULL : Intern(str))
+{
+}
+
+CStringAtom::CStringAtom(Entry *entry)
+  : m_entry(entry)
+{
+  if (m_entry)
+    AtomicIncrement(&m_entry->refs);
+}
+
+CStringAtom::CStringAtom(const CStringAtom &right)
+  : m_entry(right.m_entry)
+{
+  if (m_entry)
+    AtomicIncrement(&m_entry->refs);
+}
+
+CStringAtom::~CStringAtom()
+{
+  Release(m_entry);
+}
+
+CStringAtom &CStringAtom::operator=(const CStringAtom &right)
+{
+  if (m_entry != right.m_entry)
+  {
+    if (right.m_entry)
+      AtomicIncrement(&right.m_entry->refs);
+    Release(m_entry);
+    m_entry = right.m_entry;
+  }
+  return *this;
+}
+
+CStringAtom &CStringAtom::operator=(CStringAtom &&right)
+{
+  if (this != &right)
+  {
+    Release(m_entry);
+    m_entry = right.m_entry;
+    right.m_entry = NULL;
+  }
+  return *this;
+}
+
+const std::string &CStringAtom::str() const
+{
+  return m_entry ? m_entry->str : StringUtils::Empty;
+}
+
+bool CStringAtom::Acquire(Entry *entry)
+{
+  // only take a reference while someone else holds one
+  long refs = entry->refs;
+  while (refs > 0)
+  {
+    long prev = cas(&entry->refs, refs, refs + 1);
+    if (prev == refs)
+      return true;
+    refs = prev;
+  }
+  return false;
+}
+
+void CStringAtom::Release(Entry *entry)
+{
+  if (!entry || AtomicDecrement(&entry->refs) > 0)
+    return;
+
+  // no one can take a new reference, so this is the only thread that gets here for the entry
+  {
+    CStringAtomTable &table = GetTable();
+    CExclusiveLock lock(table.section);
+    CStringAtomTable::AtomMap::iterator it = table.atoms.find(entry->str);
+    if (it != table.atoms.end() && it->second == entry)
+      table.atoms.erase(it);
+    CStringAtomTable::FoldedAtomMap::iterator folded = table.foldedAtoms.find(entry->str);
+    if (folded != table.foldedAtoms.end() && folded->second == entry)
+      table.foldedAtoms.erase(folded);
+  }
+
+  if (entry->folded != entry)
+    Release(entry->folded);
+  delete entry;
+}
+
+CStringAtom::Entry *CStringAtom::Intern(const std::string &str)
+{
+  CStringAtomTable &table = GetTable();
+  {
+    CSharedLock lock(table.section);
+    CStringAtomTable::AtomMap::const_iterator it = table.atoms.find(str);
+    if (it != table.atoms.end() && Acquire(it->second))
+      return it->second;
+  }
+
+  CExclusiveLock lock(table.section);
+  CStringAtomTable::AtomMap::iterator it = table.atoms.find(str);
+  if (it != table.atoms.end() && Acquire(it->second))
+    return it->second;
+
+  Entry *entry = new Entry;
+  entry->str = str;
+  entry->refs = 1;
+  CStringAtomTable::FoldedAtomMap::iterator folded = table.foldedAtoms.find(str);
+  if (folded != table.foldedAtoms.end() && Acquire(folded->second))
+    entry->folded = folded->second;
+  else
+  {
+    entry->folded = entry;
+    table.foldedAtoms[str] = entry;
+  }
+  table.atoms[str] = entry;
+
+  return entry;
+}
+
+bool CStringAtom::Find(const std::string &str, CStringAtom &atom)
+{
+  CStringAtomTable &table = GetTable();
+  Entry *entry;
+  {
+    CSharedLock lock(table.section);
+    CStringAtomTable::AtomMap::const_iterator it = table.atoms.find(str);
+    if (it == table.atoms.end() || !Acquire(it->second))
+      return false;
+    entry = it->second;
+  }
+
+  // releasing may remove an entry, which needs the table exclusively
+  Release(atom.m_entry);
+  atom.m_entry = entry;
+  return true;
+}
+
+bool CStringAtom::FindNoCase(const std::string &str, CStringAtom &atom)
+{
+  CStringAtomTable &table = GetTable();
+  Entry *entry;
+  {
+    CSharedLock lock(table.section);
+    CStringAtomTable::FoldedAtomMap::const_iterator it = table.foldedAtoms.find(str);
+    if (it == table.foldedAtoms.end() || !Acquire(it->second))
+      return false;
+    entry = it->second;
+  }
+
+  Release(atom.m_entry);
+  atom.m_entry = entry;
+  return true;
+}
+
+size_t CStringAtom::Count()
+{
+  CStringAtomTable &table = GetTable();
+  CSharedLock lock(table.section);
+  return table.atoms.size();
+}
@@ -0,0 +1,105 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+
+/*!
+ \brief An interned string.
+
+ All atoms of the same string share a single entry in a global table, so an
+ atom is the size of a pointer and two atoms are compared without looking at
+ the strings. Entries are reference counted and leave the table once the last
+ atom of their string is gone, so the table only holds the keys in use (list
+ item properties, art types). Atoms are not meant for values.
+ */
+class CStringAtom
+{
+public:
+  /*! \brief The atom of the empty string */
+  CStringAtom() : m_entry(NULL) { }
+
+  /*! \brief Get the atom of a string, adding it to the table if needed */
+  explicit CStringAtom(const std::string &str);
+
+  CStringAtom(const CStringAtom &right);
+  CStringAtom(CStringAtom &&right) : m_entry(right.m_entry) { right.m_entry = NULL; }
+  ~CStringAtom();
+
+  CStringAtom &operator=(const CStringAtom &right);
+  CStringAtom &operator=(CStringAtom &&right);
+
+  /*!
+   \brief Find the atom of a string without adding it to the table
+   Useful for lookups, as no item can have a key that isn't in the table.
+   \param str the string to look for
+   \param atom [out] the atom of the string
+   \return true if the string is in the table, false otherwise
+   */
+  static bool Find(const std::string &str, CStringAtom &atom);
+
+  /*!
+   \brief Find the case folded atom of a string without adding it to the table
+   \sa Find, Folded
+   */
+  static bool FindNoCase(const std::string &str, CStringAtom &atom);
+
+  const std::string &str() const;
+  const char *c_str() const { return str().c_str(); }
+  bool empty() const { return m_entry == NULL; }
+
+  /*!
+   \brief The atom shared by all strings that only differ in case
+   It is the first of those strings in the table.
+   */
+  CStringAtom Folded() const { return CStringAtom(FoldedEntry()); }
+
+  /*! \brief Case insensitive compare, cheaper than comparing Folded() atoms */
+  bool EqualsNoCase(const CStringAtom &right) const { return FoldedEntry() == right.FoldedEntry(); }
+  /*! \brief Case insensitive order, for sorted containers of atoms */
+  bool LessNoCase(const CStringAtom &right) const { return FoldedEntry() < right.FoldedEntry(); }
+
+  bool operator==(const CStringAtom &right) const { return m_entry == right.m_entry; }
+  bool operator!=(const CStringAtom &right) const { return m_entry != right.m_entry; }
+  /*! \brief Arbitrary but stable order, for sorted containers of atoms */
+  bool operator<(const CStringAtom &right) const { return m_entry < right.m_entry; }
+
+  /*! \brief Number of strings in the table */
+  static size_t Count();
+
+private:
+  friend struct CStringAtomTable;
+
+  struct Entry
+  {
+    std::string str;
+    Entry *folded;
+    volatile long refs;
+  };
+
+  explicit CStringAtom(Entry *entry);
+  Entry *FoldedEntry() const { return m_entry ? m_entry->folded : NULL; }
+
+  static Entry *Intern(const std::string &str);
+  static bool Acquire(Entry *entry);
+  static void Release(Entry *entry);
+
+  Entry *m_entry;
+};
@@ -36,6 +36,9 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
+// time (in ms) IsHostOnLAN() waits for the ip address of a host
+#define DNS_LOOKUP_TIMEOUT_LAN 100
+
 using namespace std;
 using namespace XFILE;
 
@@ -624,8 +627,11 @@ bool URIUtils::IsHostOnLAN(const std::string& host, bool offLineCheck)
   uint32_t address = ntohl(inet_addr(host.c_str()));
   if(address == INADDR_NONE)
   {
+    // this is called from the GUI thread, so don't wait for a slow lookup
+    // but have its result cached for the next time. Until then the host is
+    // treated as not being on the LAN.
     std::string ip;
-    if(CDNSNameCache::Lookup(host, ip))
+    if(CDNSNameCache::Lookup(host, ip, DNS_LOOKUP_TIMEOUT_LAN))
       address = ntohl(inet_addr(ip.c_str()));
   }
 
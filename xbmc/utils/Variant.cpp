@@ -20,7 +20,9 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <new>
 #include <sstream>
+#include <utility>
 
 #include "Variant.h"
 
@@ -149,10 +151,10 @@ CVariant::CVariant(VariantType type)
       m_data.dvalue = 0.0;
       break;
     case VariantTypeString:
-      m_data.string = new string();
+      new (&m_data.string) string();
       break;
     case VariantTypeWideString:
-      m_data.wstring = new wstring();
+      new (&m_data.wstring) wstring();
       break;
     case VariantTypeArray:
       m_data.array = new VariantArray();
@@ -161,7 +163,7 @@ CVariant::CVariant(VariantType type)
       m_data.map = new VariantMap();
       break;
     default:
-      memset(&m_data, 0, sizeof(m_data));
+      m_data.unsignedinteger = 0;
       break;
   }
 }
@@ -211,37 +213,49 @@ CVariant::CVariant(bool boolean)
 CVariant::CVariant(const char *str)
 {
   m_type = VariantTypeString;
-  m_data.string = new string(str);
+  new (&m_data.string) string(str);
 }
 
 CVariant::CVariant(const char *str, unsigned int length)
 {
   m_type = VariantTypeString;
-  m_data.string = new string(str, length);
+  new (&m_data.string) string(str, length);
 }
 
 CVariant::CVariant(const string &str)
 {
   m_type = VariantTypeString;
-  m_data.string = new string(str);
+  new (&m_data.string) string(str);
+}
+
+CVariant::CVariant(string &&str)
+{
+  m_type = VariantTypeString;
+  new (&m_data.string) string(std::move(str));
 }
 
 CVariant::CVariant(const wchar_t *str)
 {
   m_type = VariantTypeWideString;
-  m_data.wstring = new wstring(str);
+  new (&m_data.wstring) wstring(str);
 }
 
 CVariant::CVariant(const wchar_t *str, unsigned int length)
 {
   m_type = VariantTypeWideString;
-  m_data.wstring = new wstring(str, length);
+  new (&m_data.wstring) wstring(str, length);
 }
 
 CVariant::CVariant(const wstring &str)
 {
   m_type = VariantTypeWideString;
-  m_data.wstring = new wstring(str);
+  new (&m_data.wstring) wstring(str);
+}
+
+CVariant::CVariant(wstring &&str)
+{
+  m_type = VariantTypeWideString;
+  new (&m_data.wstring) wstring(std::move(str));
 }
 
 CVariant::CVariant(const std::vector<std::string> &strArray)
@@ -258,7 +272,7 @@ CVariant::CVariant(const std::map<std::string, std::string> &strMap)
   m_type = VariantTypeObject;
   m_data.map = new VariantMap;
   for (std::map<std::string, std::string>::const_iterator it = strMap.begin(); it != strMap.end(); ++it)
-    m_data.map->insert(make_pair(it->first, CVariant(it->second)));
+    m_data.map->insert(m_data.map->end(), make_pair(it->first, CVariant(it->second)));
 }
 
 CVariant::CVariant(const std::map<std::string, CVariant> &variantMap)
@@ -273,6 +287,11 @@ CVariant::CVariant(const CVariant &variant)
   *this = variant;
 }
 
+CVariant::CVariant(CVariant &&rhs) VARIANT_NOEXCEPT
+{
+  moveFrom(rhs);
+}
+
 CVariant::~CVariant()
 {
   cleanup();
@@ -281,9 +300,9 @@ CVariant::~CVariant()
 void CVariant::cleanup()
 {
   if (m_type == VariantTypeString)
-    delete m_data.string;
+    str().~string();
   else if (m_type == VariantTypeWideString)
-    delete m_data.wstring;
+    wstr().~wstring();
   else if (m_type == VariantTypeArray)
     delete m_data.array;
   else if (m_type == VariantTypeObject)
@@ -291,6 +310,49 @@ void CVariant::cleanup()
   m_type = VariantTypeNull;
 }
 
+void CVariant::moveFrom(CVariant &rhs)
+{
+  // expects this to be cleaned up already
+  m_type = rhs.m_type;
+
+  switch (m_type)
+  {
+  case VariantTypeInteger:
+    m_data.integer = rhs.m_data.integer;
+    break;
+  case VariantTypeUnsignedInteger:
+    m_data.unsignedinteger = rhs.m_data.unsignedinteger;
+    break;
+  case VariantTypeBoolean:
+    m_data.boolean = rhs.m_data.boolean;
+    break;
+  case VariantTypeDouble:
+    m_data.dvalue = rhs.m_data.dvalue;
+    break;
+  case VariantTypeString:
+    new (&m_data.string) string(std::move(rhs.str()));
+    break;
+  case VariantTypeWideString:
+    new (&m_data.wstring) wstring(std::move(rhs.wstr()));
+    break;
+  case VariantTypeArray:
+    m_data.array = rhs.m_data.array;
+    rhs.m_data.array = NULL;
+    break;
+  case VariantTypeObject:
+    m_data.map = rhs.m_data.map;
+    rhs.m_data.map = NULL;
+    break;
+  default:
+    // ConstNullVariant stays what it is (it's handed out as a non-const
+    // reference by operator[] so it may end up being moved from)
+    m_data.unsignedinteger = 0;
+    return;
+  }
+
+  rhs.cleanup();
+}
+
 bool CVariant::isInteger() const
 {
   return m_type == VariantTypeInteger;
@@ -352,9 +414,9 @@ int64_t CVariant::asInteger(int64_t fallback) const
     case VariantTypeDouble:
       return (int64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2int64(*m_data.string, fallback);
+      return str2int64(str(), fallback);
     case VariantTypeWideString:
-      return str2int64(*m_data.wstring, fallback);
+      return str2int64(wstr(), fallback);
     default:
       return fallback;
   }
@@ -373,9 +435,9 @@ uint64_t CVariant::asUnsignedInteger(uint64_t fallback) const
     case VariantTypeDouble:
       return (uint64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2uint64(*m_data.string, fallback);
+      return str2uint64(str(), fallback);
     case VariantTypeWideString:
-      return str2uint64(*m_data.wstring, fallback);
+      return str2uint64(wstr(), fallback);
     default:
       return fallback;
   }
@@ -394,9 +456,9 @@ double CVariant::asDouble(double fallback) const
     case VariantTypeUnsignedInteger:
       return (double)m_data.unsignedinteger;
     case VariantTypeString:
-      return str2double(*m_data.string, fallback);
+      return str2double(str(), fallback);
     case VariantTypeWideString:
-      return str2double(*m_data.wstring, fallback);
+      return str2double(wstr(), fallback);
     default:
       return fallback;
   }
@@ -415,9 +477,9 @@ float CVariant::asFloat(float fallback) const
     case VariantTypeUnsignedInteger:
       return (float)m_data.unsignedinteger;
     case VariantTypeString:
-      return (float)str2double(*m_data.string, fallback);
+      return (float)str2double(str(), fallback);
     case VariantTypeWideString:
-      return (float)str2double(*m_data.wstring, fallback);
+      return (float)str2double(wstr(), fallback);
     default:
       return fallback;
   }
@@ -438,11 +500,11 @@ bool CVariant::asBoolean(bool fallback) const
     case VariantTypeDouble:
       return (m_data.dvalue != 0);
     case VariantTypeString:
-      if (m_data.string->empty() || m_data.string->compare("0") == 0 || m_data.string->compare("false") == 0)
+      if (str().empty() || str().compare("0") == 0 || str().compare("false") == 0)
         return false;
       return true;
     case VariantTypeWideString:
-      if (m_data.wstring->empty() || m_data.wstring->compare(L"0") == 0 || m_data.wstring->compare(L"false") == 0)
+      if (wstr().empty() || wstr().compare(L"0") == 0 || wstr().compare(L"false") == 0)
         return false;
       return true;
     default:
@@ -457,7 +519,7 @@ std::string CVariant::asString(const std::string &fallback /* = "" */) const
   switch (m_type)
   {
     case VariantTypeString:
-      return *m_data.string;
+      return str();
     case VariantTypeBoolean:
       return m_data.boolean ? "true" : "false";
     case VariantTypeInteger:
@@ -485,7 +547,7 @@ std::wstring CVariant::asWideString(const std::wstring &fallback /* = L"" */) co
   switch (m_type)
   {
     case VariantTypeWideString:
-      return *m_data.wstring;
+      return wstr();
     case VariantTypeBoolean:
       return m_data.boolean ? L"true" : L"false";
     case VariantTypeInteger:
@@ -571,16 +633,16 @@ CVariant &CVariant::operator=(const CVariant &rhs)
     m_data.dvalue = rhs.m_data.dvalue;
     break;
   case VariantTypeString:
-    m_data.string = new string(*rhs.m_data.string);
+    new (&m_data.string) string(rhs.str());
     break;
   case VariantTypeWideString:
-    m_data.wstring = new wstring(*rhs.m_data.wstring);
+    new (&m_data.wstring) wstring(rhs.wstr());
     break;
   case VariantTypeArray:
-    m_data.array = new VariantArray(rhs.m_data.array->begin(), rhs.m_data.array->end());
+    m_data.array = new VariantArray(*rhs.m_data.array);
     break;
   case VariantTypeObject:
-    m_data.map = new VariantMap(rhs.m_data.map->begin(), rhs.m_data.map->end());
+    m_data.map = new VariantMap(*rhs.m_data.map);
     break;
   default:
     break;
@@ -589,6 +651,19 @@ CVariant &CVariant::operator=(const CVariant &rhs)
   return *this;
 }
 
+CVariant &CVariant::operator=(CVariant &&rhs) VARIANT_NOEXCEPT
+{
+  if (m_type == VariantTypeConstNull || this == &rhs)
+    return *this;
+
+  // rhs may be part of this variant
+  CVariant temp(std::move(rhs));
+  cleanup();
+  moveFrom(temp);
+
+  return *this;
+}
+
 bool CVariant::operator==(const CVariant &rhs) const
 {
   if (m_type == rhs.m_type)
@@ -604,9 +679,9 @@ bool CVariant::operator==(const CVariant &rhs) const
     case VariantTypeDouble:
       return m_data.dvalue == rhs.m_data.dvalue;
     case VariantTypeString:
-      return *m_data.string == *rhs.m_data.string;
+      return str() == rhs.str();
     case VariantTypeWideString:
-      return *m_data.wstring == *rhs.m_data.wstring;
+      return wstr() == rhs.wstr();
     case VariantTypeArray:
       return *m_data.array == *rhs.m_data.array;
     case VariantTypeObject:
@@ -631,29 +706,46 @@ void CVariant::push_back(const CVariant &variant)
     m_data.array->push_back(variant);
 }
 
+void CVariant::push_back(CVariant &&variant)
+{
+  if (m_type == VariantTypeNull)
+  {
+    m_type = VariantTypeArray;
+    m_data.array = new VariantArray;
+  }
+
+  if (m_type == VariantTypeArray)
+    m_data.array->push_back(std::move(variant));
+}
+
 void CVariant::append(const CVariant &variant)
 {
   push_back(variant);
 }
 
+void CVariant::append(CVariant &&variant)
+{
+  push_back(std::move(variant));
+}
+
 const char *CVariant::c_str() const
 {
   if (m_type == VariantTypeString)
-    return m_data.string->c_str();
+    return str().c_str();
   else
     return NULL;
 }
 
 void CVariant::swap(CVariant &rhs)
 {
-  VariantType  temp_type = m_type;
-  VariantUnion temp_data = m_data;
-
-  m_type = rhs.m_type;
-  m_data = rhs.m_data;
+  if (this == &rhs)
+    return;
 
-  rhs.m_type = temp_type;
-  rhs.m_data = temp_data;
+  CVariant temp(std::move(rhs));
+  rhs.cleanup();
+  rhs.moveFrom(*this);
+  cleanup();
+  moveFrom(temp);
 }
 
 CVariant::iterator_array CVariant::begin_array()
@@ -727,9 +819,9 @@ unsigned int CVariant::size() const
   else if (m_type == VariantTypeArray)
     return m_data.array->size();
   else if (m_type == VariantTypeString)
-    return m_data.string->size();
+    return str().size();
   else if (m_type == VariantTypeWideString)
-    return m_data.wstring->size();
+    return wstr().size();
   else
     return 0;
 }
@@ -741,9 +833,9 @@ bool CVariant::empty() const
   else if (m_type == VariantTypeArray)
     return m_data.array->empty();
   else if (m_type == VariantTypeString)
-    return m_data.string->empty();
+    return str().empty();
   else if (m_type == VariantTypeWideString)
-    return m_data.wstring->empty();
+    return wstr().empty();
   else if (m_type == VariantTypeNull)
     return true;
 
@@ -757,9 +849,9 @@ void CVariant::clear()
   else if (m_type == VariantTypeArray)
     m_data.array->clear();
   else if (m_type == VariantTypeString)
-    m_data.string->clear();
+    str().clear();
   else if (m_type == VariantTypeWideString)
-    m_data.wstring->clear();
+    wstr().clear();
 }
 
 void CVariant::erase(const std::string &key)
@@ -22,6 +22,7 @@
 #include <vector>
 #include <string>
 #include <stdint.h>
+#include <type_traits>
 #include <wchar.h>
 
 int64_t str2int64(const std::string &str, int64_t fallback = 0);
@@ -31,6 +32,14 @@ uint64_t str2uint64(const std::wstring &str, uint64_t fallback = 0);
 double str2double(const std::string &str, double fallback = 0.0);
 double str2double(const std::wstring &str, double fallback = 0.0);
 
+// Visual Studio 2013 doesn't know noexcept but moves the elements of a
+// std::vector on reallocation anyway
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define VARIANT_NOEXCEPT
+#else
+#define VARIANT_NOEXCEPT noexcept
+#endif
+
 class CVariant
 {
 public:
@@ -59,13 +68,16 @@ public:
   CVariant(const char *str);
   CVariant(const char *str, unsigned int length);
   CVariant(const std::string &str);
+  CVariant(std::string &&str);
   CVariant(const wchar_t *str);
   CVariant(const wchar_t *str, unsigned int length);
   CVariant(const std::wstring &str);
+  CVariant(std::wstring &&str);
   CVariant(const std::vector<std::string> &strArray);
   CVariant(const std::map<std::string, std::string> &strMap);
   CVariant(const std::map<std::string, CVariant> &variantMap);
   CVariant(const CVariant &variant);
+  CVariant(CVariant &&rhs) VARIANT_NOEXCEPT;
   ~CVariant();
 
   bool isInteger() const;
@@ -94,11 +106,14 @@ public:
   const CVariant &operator[](unsigned int position) const;
 
   CVariant &operator=(const CVariant &rhs);
+  CVariant &operator=(CVariant &&rhs) VARIANT_NOEXCEPT;
   bool operator==(const CVariant &rhs) const;
   bool operator!=(const CVariant &rhs) const { return !(*this == rhs); }
 
   void push_back(const CVariant &variant);
+  void push_back(CVariant &&variant);
   void append(const CVariant &variant);
+  void append(CVariant &&variant);
 
   const char *c_str() const;
 
@@ -137,14 +152,25 @@ public:
 
 private:
   void cleanup();
+  void moveFrom(CVariant &rhs);
+
+  /* strings are stored inline (so short ones don't need any allocation)
+     and have to be constructed and destroyed explicitly. The union only
+     holds raw storage for them because unrestricted unions aren't
+     supported by Visual Studio 2013. */
+  std::string &str() { return *reinterpret_cast<std::string*>(&m_data.string); }
+  const std::string &str() const { return *reinterpret_cast<const std::string*>(&m_data.string); }
+  std::wstring &wstr() { return *reinterpret_cast<std::wstring*>(&m_data.wstring); }
+  const std::wstring &wstr() const { return *reinterpret_cast<const std::wstring*>(&m_data.wstring); }
+
   union VariantUnion
   {
     int64_t integer;
     uint64_t unsignedinteger;
     bool boolean;
     double dvalue;
-    std::string *string;
-    std::wstring *wstring;
+    std::aligned_storage<sizeof(std::string), std::alignment_of<std::string>::value>::type string;
+    std::aligned_storage<sizeof(std::wstring), std::alignment_of<std::wstring>::value>::type wstring;
     VariantArray *array;
     VariantMap *map;
   };
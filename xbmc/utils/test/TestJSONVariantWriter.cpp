@@ -30,3 +30,28 @@ TEST(TestJSONVariantWriter, Write)
   str = CJSONVariantWriter::Write(variant, false);
   EXPECT_STREQ("null\n", str.c_str());
 }
+
+static bool IsWideString(const CVariant &value, void *data)
+{
+  return value.isWideString();
+}
+
+TEST(TestJSONVariantWriter, WriteSplit)
+{
+  CVariant variant;
+  variant["a"] = 1;
+  variant["b"] = std::wstring(L"b");
+  variant["c"].push_back(2);
+  variant["c"].push_back(std::wstring(L"c"));
+
+  std::vector<std::string> parts;
+  std::vector<const CVariant*> splitValues;
+  EXPECT_TRUE(CJSONVariantWriter::Write(variant, true, IsWideString, NULL, parts, splitValues));
+  ASSERT_EQ(3u, parts.size());
+  ASSERT_EQ(2u, splitValues.size());
+  EXPECT_STREQ("{\"a\":1,\"b\":", parts[0].c_str());
+  EXPECT_STREQ(",\"c\":[2,", parts[1].c_str());
+  EXPECT_STREQ("]}", parts[2].c_str());
+  EXPECT_EQ(&variant["b"], splitValues[0]);
+  EXPECT_EQ(&variant["c"][1], splitValues[1]);
+}
@@ -20,6 +20,7 @@
 
 #include "utils/JobManager.h"
 #include "settings/Settings.h"
+#include "threads/Thread.h"
 #include "utils/SystemInfo.h"
 
 #include "gtest/gtest.h"
@@ -49,6 +50,7 @@ protected:
   ~TestJobManager()
   {
     /* Always cancel jobs test completion */
+    CJobManager::GetInstance().SetWorkerAllowance("BroadcastingJob", 0);
     CJobManager::GetInstance().CancelJobs();
     CJobManager::GetInstance().Restart();
     CSettings::Get().Unload();
@@ -177,3 +179,53 @@ TEST_F(TestJobManager, IsProcessing)
 
   job->FinishAndStopBlocking();
 }
+
+TEST_F(TestJobManager, LowPriorityWorkerLimit)
+{
+  JobControlPackage package1, package2, package3;
+  BroadcastingJob *job1 (WaitForJobToStartProcessing(CJob::PRIORITY_LOW_PAUSABLE, package1));
+  BroadcastingJob *job2 (WaitForJobToStartProcessing(CJob::PRIORITY_LOW_PAUSABLE, package2));
+
+  // the third job has to wait for one of the others to finish
+  BroadcastingJob *job3 = new BroadcastingJob(package3);
+  CJobManager::GetInstance().AddJob(job3, NULL, CJob::PRIORITY_LOW_PAUSABLE);
+  XbmcThreads::ThreadSleep(100);
+  EXPECT_EQ(2, CJobManager::GetInstance().IsProcessing("BroadcastingJob"));
+
+  job1->FinishAndStopBlocking();
+  while (!package3.ready)
+    package3.jobCreatedCond.wait(package3.jobCreatedMutex);
+  EXPECT_EQ(2, CJobManager::GetInstance().IsProcessing("BroadcastingJob"));
+
+  job2->FinishAndStopBlocking();
+  job3->FinishAndStopBlocking();
+}
+
+TEST_F(TestJobManager, WorkerAllowance)
+{
+  CJobManager::GetInstance().SetWorkerAllowance("BroadcastingJob", 2);
+
+  // two jobs on the allowance, two on the low priority workers
+  JobControlPackage package1, package2, package3, package4, package5;
+  BroadcastingJob *job1 (WaitForJobToStartProcessing(CJob::PRIORITY_LOW_PAUSABLE, package1));
+  BroadcastingJob *job2 (WaitForJobToStartProcessing(CJob::PRIORITY_LOW_PAUSABLE, package2));
+  BroadcastingJob *job3 (WaitForJobToStartProcessing(CJob::PRIORITY_LOW_PAUSABLE, package3));
+  BroadcastingJob *job4 (WaitForJobToStartProcessing(CJob::PRIORITY_LOW_PAUSABLE, package4));
+  EXPECT_EQ(4, CJobManager::GetInstance().IsProcessing("BroadcastingJob"));
+
+  // the fifth job has to wait for one of the others to finish
+  BroadcastingJob *job5 = new BroadcastingJob(package5);
+  CJobManager::GetInstance().AddJob(job5, NULL, CJob::PRIORITY_LOW_PAUSABLE);
+  XbmcThreads::ThreadSleep(100);
+  EXPECT_EQ(4, CJobManager::GetInstance().IsProcessing("BroadcastingJob"));
+
+  job1->FinishAndStopBlocking();
+  while (!package5.ready)
+    package5.jobCreatedCond.wait(package5.jobCreatedMutex);
+  EXPECT_EQ(4, CJobManager::GetInstance().IsProcessing("BroadcastingJob"));
+
+  job2->FinishAndStopBlocking();
+  job3->FinishAndStopBlocking();
+  job4->FinishAndStopBlocking();
+  job5->FinishAndStopBlocking();
+}
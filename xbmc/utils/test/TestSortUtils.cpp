@@ -19,6 +19,7 @@
  */
 
 #include "utils/SortUtils.h"
+#include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
 #include "gtest/gtest.h"
@@ -131,3 +132,43 @@ TEST(TestSortUtils, GetFieldsForSorting)
   EXPECT_EQ(FieldTrackNumber, *it);
   EXPECT_EQ((unsigned int)4, fields.size());
 }
+
+TEST(TestSortUtils, Sort_LargeList)
+{
+  // enough items to use the collation keys and several threads
+  const int count = 30000;
+
+  SortItems items;
+  for (int i = 0; i < count; i++)
+  {
+    int number = (i * 7919) % count;
+    SortItemPtr item(new SortItem());
+    (*item)[FieldLabel] = StringUtils::Format("%s %i", number % 2 ? "item" : "Item", number);
+    (*item)[FieldFolder] = false;
+    (*item)[FieldId] = number;
+    if (number == 42)
+      (*item)[FieldSortSpecial] = SortSpecialOnTop;
+    else if (number == 0)
+      (*item)[FieldSortSpecial] = SortSpecialOnBottom;
+    items.push_back(item);
+  }
+
+  SortUtils::Sort(SortByLabel, SortOrderAscending, SortAttributeNone, items);
+
+  ASSERT_EQ((size_t)count, items.size());
+  EXPECT_EQ(42, (*items[0])[FieldId].asInteger());
+  EXPECT_EQ(0, (*items[count - 1])[FieldId].asInteger());
+  int previous = 0;
+  for (int i = 1; i < count - 1; i++)
+  {
+    int number = (int)(*items[i])[FieldId].asInteger();
+    EXPECT_LT(previous, number);
+    previous = number;
+  }
+
+  SortUtils::Sort(SortByLabel, SortOrderDescending, SortAttributeNone, items);
+  EXPECT_EQ(42, (*items[0])[FieldId].asInteger());
+  EXPECT_EQ(count - 1, (*items[1])[FieldId].asInteger());
+  EXPECT_EQ(1, (*items[count - 2])[FieldId].asInteger());
+  EXPECT_EQ(0, (*items[count - 1])[FieldId].asInteger());
+}
@@ -0,0 +1,95 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/StringAtom.h"
+
+#include "gtest/gtest.h"
+
+TEST(TestStringAtom, Intern)
+{
+  CStringAtom atom1("TestStringAtom.Intern");
+  CStringAtom atom2(std::string("TestStringAtom.") + "Intern");
+  CStringAtom other("TestStringAtom.Other");
+
+  EXPECT_TRUE(atom1 == atom2);
+  EXPECT_TRUE(atom1 != other);
+  EXPECT_EQ(&atom1.str(), &atom2.str());
+  EXPECT_STREQ("TestStringAtom.Intern", atom1.c_str());
+}
+
+TEST(TestStringAtom, Empty)
+{
+  CStringAtom atom;
+  EXPECT_TRUE(atom.empty());
+  EXPECT_TRUE(atom == CStringAtom(""));
+  EXPECT_FALSE(CStringAtom("TestStringAtom.Empty").empty());
+}
+
+TEST(TestStringAtom, Find)
+{
+  CStringAtom atom;
+  EXPECT_FALSE(CStringAtom::Find("TestStringAtom.Find", atom));
+  size_t count = CStringAtom::Count();
+  EXPECT_FALSE(CStringAtom::Find("TestStringAtom.Find", atom));
+  EXPECT_EQ(count, CStringAtom::Count());
+
+  CStringAtom interned("TestStringAtom.Find");
+  EXPECT_EQ(count + 1, CStringAtom::Count());
+  EXPECT_TRUE(CStringAtom::Find("TestStringAtom.Find", atom));
+  EXPECT_TRUE(atom == interned);
+  EXPECT_FALSE(CStringAtom::Find("TESTSTRINGATOM.FIND", atom));
+}
+
+TEST(TestStringAtom, Folded)
+{
+  CStringAtom lower("teststringatom.folded");
+  CStringAtom mixed("TestStringAtom.Folded");
+
+  EXPECT_TRUE(lower != mixed);
+  EXPECT_TRUE(lower.Folded() == mixed.Folded());
+  EXPECT_TRUE(lower.Folded() == lower);
+  EXPECT_STREQ("TestStringAtom.Folded", mixed.c_str());
+
+  CStringAtom folded;
+  EXPECT_TRUE(CStringAtom::FindNoCase("TESTSTRINGATOM.FOLDED", folded));
+  EXPECT_TRUE(folded == lower);
+  EXPECT_FALSE(CStringAtom::FindNoCase("TestStringAtom.NotFolded", folded));
+}
+
+TEST(TestStringAtom, Released)
+{
+  size_t count = CStringAtom::Count();
+  {
+    CStringAtom atom("TestStringAtom.Released");
+    CStringAtom copy(atom);
+    CStringAtom upper("TESTSTRINGATOM.RELEASED");
+    EXPECT_EQ(count + 2, CStringAtom::Count());
+    EXPECT_TRUE(upper.EqualsNoCase(atom));
+  }
+
+  // the strings leave the table with their last atom
+  EXPECT_EQ(count, CStringAtom::Count());
+  CStringAtom atom;
+  EXPECT_FALSE(CStringAtom::Find("TestStringAtom.Released", atom));
+  EXPECT_FALSE(CStringAtom::FindNoCase("TestStringAtom.Released", atom));
+
+  CStringAtom again("TESTSTRINGATOM.RELEASED");
+  EXPECT_TRUE(again.Folded() == again);
+}
@@ -18,6 +18,10 @@
  *
  */
 
+#include <algorithm>
+#include <utility>
+
+#include "threads/SystemClock.h"
 #include "utils/Variant.h"
 
 #include "gtest/gtest.h"
@@ -348,3 +352,92 @@ TEST(TestVariant, isMember)
   EXPECT_TRUE(a.isMember("key1"));
   EXPECT_FALSE(a.isMember("key2"));
 }
+
+TEST(TestVariant, move)
+{
+  CVariant a("a string which is too long to be stored inline");
+  const char *str = a.c_str();
+  CVariant b(std::move(a));
+
+  EXPECT_TRUE(a.isNull());
+  EXPECT_TRUE(b.isString());
+  EXPECT_EQ(str, b.c_str());
+
+  CVariant c;
+  c["key"] = "value";
+  b = std::move(c);
+  EXPECT_TRUE(c.isNull());
+  EXPECT_TRUE(b.isObject());
+  EXPECT_STREQ("value", b["key"].c_str());
+
+  // moving a member into the variant containing it
+  b = std::move(b["key"]);
+  EXPECT_TRUE(b.isString());
+  EXPECT_STREQ("value", b.c_str());
+
+  CVariant d;
+  d.push_back(std::move(b));
+  EXPECT_TRUE(b.isNull());
+  EXPECT_STREQ("value", d[0].c_str());
+}
+
+TEST(TestVariant, moveConstNull)
+{
+  CVariant a("string");
+  CVariant &null = a[0];
+  CVariant b(std::move(null));
+
+  EXPECT_EQ(CVariant::VariantTypeConstNull, CVariant::ConstNullVariant.type());
+  EXPECT_TRUE(b.isNull());
+
+  CVariant::ConstNullVariant = std::move(a);
+  EXPECT_EQ(CVariant::VariantTypeConstNull, CVariant::ConstNullVariant.type());
+  EXPECT_STREQ("string", a.c_str());
+}
+
+TEST(TestVariant, swapStrings)
+{
+  CVariant a("short"), b("a string which is too long to be stored inline");
+
+  a.swap(b);
+  EXPECT_STREQ("a string which is too long to be stored inline", a.c_str());
+  EXPECT_STREQ("short", b.c_str());
+
+  a.swap(a);
+  EXPECT_STREQ("a string which is too long to be stored inline", a.c_str());
+}
+
+TEST(TestVariant, Throughput)
+{
+  // builds, copies and moves lists modelled after the items of a library
+  // listing returned by JSON-RPC
+  const int iterations = 200;
+  const int items = 500;
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < iterations; i++)
+  {
+    CVariant list(CVariant::VariantTypeArray);
+    for (int j = 0; j < items; j++)
+    {
+      CVariant item;
+      item["label"] = "Some Movie";
+      item["movieid"] = j;
+      item["year"] = 2014;
+      item["rating"] = 7.5;
+      item["file"] = "smb://server/share/movies/Some Movie (2014)/Some Movie (2014).mkv";
+      item["genre"].push_back("Drama");
+      item["genre"].push_back("Thriller");
+      list.push_back(std::move(item));
+    }
+
+    CVariant result;
+    result["movies"] = list;
+    CVariant response;
+    response["result"] = std::move(result);
+    ASSERT_EQ((unsigned int)items, response["result"]["movies"].size());
+  }
+  unsigned int duration = XbmcThreads::SystemClockMillis() - start;
+
+  RecordProperty("ItemsPerSecond", (int)(iterations * items * 1000LL / std::max(duration, 1u)));
+}
@@ -461,12 +461,15 @@ int CVideoDatabase::GetPathId(const std::string& strPath)
 
     URIUtils::AddSlashAtEnd(strPath1);
 
-    strSQL=PrepareSQL("select idPath from path where strPath='%s'",strPath1.c_str());
-    m_pDS->query(strSQL.c_str());
-    if (!m_pDS->eof())
-      idPath = m_pDS->fv("path.idPath").get_asInt();
+    strSQL = "select idPath from path where strPath=?";
+    StatementPtr stmt = PrepareStatement(strSQL);
+    if (!stmt)
+      return -1;
+
+    stmt->bind(1, strPath1);
+    if (stmt->step())
+      idPath = stmt->get_int(0);
 
-    m_pDS->close();
     return idPath;
   }
   catch (...)
@@ -664,22 +667,22 @@ int CVideoDatabase::AddPath(const std::string& strPath, const std::string &paren
     int idParentPath = GetPathId(parentPath.empty() ? (std::string)URIUtils::GetParentPath(strPath1) : parentPath);
 
     // add the path
-    if (idParentPath < 0)
-    {
-      if (!strDateAdded.empty())
-        strSQL=PrepareSQL("insert into path (idPath, strPath, dateAdded) values (NULL, '%s', '%s')", strPath1.c_str(), strDateAdded.c_str());
-      else
-        strSQL=PrepareSQL("insert into path (idPath, strPath) values (NULL, '%s')", strPath1.c_str());
-    }
+    strSQL = "insert into path (idPath, strPath, dateAdded, idParentPath) values (NULL, ?, ?, ?)";
+    StatementPtr stmt = PrepareStatement(strSQL);
+    if (!stmt)
+      return -1;
+
+    stmt->bind(1, strPath1);
+    if (!strDateAdded.empty())
+      stmt->bind(2, strDateAdded);
     else
-    {
-      if (!strDateAdded.empty())
-        strSQL=PrepareSQL("insert into path (idPath, strPath, dateAdded, idParentPath) values (NULL, '%s', '%s', %i)", strPath1.c_str(), strDateAdded.c_str(), idParentPath);
-      else
-        strSQL=PrepareSQL("insert into path (idPath, strPath, idParentPath) values (NULL, '%s', %i)", strPath1.c_str(), idParentPath);
-    }
-    m_pDS->exec(strSQL.c_str());
-    idPath = (int)m_pDS->lastinsertid();
+      stmt->bind_null(2);
+    if (idParentPath >= 0)
+      stmt->bind(3, idParentPath);
+    else
+      stmt->bind_null(3);
+    stmt->step();
+    idPath = (int)stmt->lastinsertid();
     return idPath;
   }
   catch (...)
@@ -810,20 +813,25 @@ int CVideoDatabase::AddFile(const std::string& strFileNameAndPath)
     if (idPath < 0)
       return -1;
 
-    std::string strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
+    strSQL = "select idFile from files where strFileName=? and idPath=?";
+    StatementPtr stmt = PrepareStatement(strSQL);
+    if (!stmt)
+      return -1;
 
-    m_pDS->query(strSQL.c_str());
-    if (m_pDS->num_rows() > 0)
-    {
-      idFile = m_pDS->fv("idFile").get_asInt() ;
-      m_pDS->close();
-      return idFile;
-    }
-    m_pDS->close();
+    stmt->bind(1, strFileName);
+    stmt->bind(2, idPath);
+    if (stmt->step())
+      return stmt->get_int(0);
 
-    strSQL=PrepareSQL("insert into files (idFile, idPath, strFileName) values(NULL, %i, '%s')", idPath, strFileName.c_str());
-    m_pDS->exec(strSQL.c_str());
-    idFile = (int)m_pDS->lastinsertid();
+    strSQL = "insert into files (idFile, idPath, strFileName) values(NULL, ?, ?)";
+    stmt = PrepareStatement(strSQL);
+    if (!stmt)
+      return -1;
+
+    stmt->bind(1, idPath);
+    stmt->bind(2, strFileName);
+    stmt->step();
+    idFile = (int)stmt->lastinsertid();
     return idFile;
   }
   catch (...)
@@ -3309,6 +3317,47 @@ bool CVideoDatabase::GetStreamDetails(CFileItem& item)
   return GetStreamDetails(*item.GetVideoInfoTag());
 }
 
+/* adds the stream of a row of the streamdetails table to the details */
+static bool AddStreamDetail(CStreamDetails &details, const dbiplus::sql_record* const record)
+{
+  CStreamDetail::StreamType e = (CStreamDetail::StreamType)record->at(1).get_asInt();
+  switch (e)
+  {
+  case CStreamDetail::VIDEO:
+    {
+      CStreamDetailVideo *p = new CStreamDetailVideo();
+      p->m_strCodec = record->at(2).get_asString();
+      p->m_fAspect = record->at(3).get_asFloat();
+      p->m_iWidth = record->at(4).get_asInt();
+      p->m_iHeight = record->at(5).get_asInt();
+      p->m_iDuration = record->at(10).get_asInt();
+      p->m_strStereoMode = record->at(11).get_asString();
+      details.AddStream(p);
+      return true;
+    }
+  case CStreamDetail::AUDIO:
+    {
+      CStreamDetailAudio *p = new CStreamDetailAudio();
+      p->m_strCodec = record->at(6).get_asString();
+      if (record->at(7).get_isNull())
+        p->m_iChannels = -1;
+      else
+        p->m_iChannels = record->at(7).get_asInt();
+      p->m_strLanguage = record->at(8).get_asString();
+      details.AddStream(p);
+      return true;
+    }
+  case CStreamDetail::SUBTITLE:
+    {
+      CStreamDetailSubtitle *p = new CStreamDetailSubtitle();
+      p->m_strLanguage = record->at(9).get_asString();
+      details.AddStream(p);
+      return true;
+    }
+  }
+  return false;
+}
+
 bool CVideoDatabase::GetStreamDetails(CVideoInfoTag& tag) const
 {
   if (tag.m_iFileId < 0)
@@ -3327,45 +3376,8 @@ bool CVideoDatabase::GetStreamDetails(CVideoInfoTag& tag) const
 
     while (!pDS->eof())
     {
-      CStreamDetail::StreamType e = (CStreamDetail::StreamType)pDS->fv(1).get_asInt();
-      switch (e)
-      {
-      case CStreamDetail::VIDEO:
-        {
-          CStreamDetailVideo *p = new CStreamDetailVideo();
-          p->m_strCodec = pDS->fv(2).get_asString();
-          p->m_fAspect = pDS->fv(3).get_asFloat();
-          p->m_iWidth = pDS->fv(4).get_asInt();
-          p->m_iHeight = pDS->fv(5).get_asInt();
-          p->m_iDuration = pDS->fv(10).get_asInt();
-          p->m_strStereoMode = pDS->fv(11).get_asString();
-          details.AddStream(p);
-          retVal = true;
-          break;
-        }
-      case CStreamDetail::AUDIO:
-        {
-          CStreamDetailAudio *p = new CStreamDetailAudio();
-          p->m_strCodec = pDS->fv(6).get_asString();
-          if (pDS->fv(7).get_isNull())
-            p->m_iChannels = -1;
-          else
-            p->m_iChannels = pDS->fv(7).get_asInt();
-          p->m_strLanguage = pDS->fv(8).get_asString();
-          details.AddStream(p);
-          retVal = true;
-          break;
-        }
-      case CStreamDetail::SUBTITLE:
-        {
-          CStreamDetailSubtitle *p = new CStreamDetailSubtitle();
-          p->m_strLanguage = pDS->fv(9).get_asString();
-          details.AddStream(p);
-          retVal = true;
-          break;
-        }
-      }
-
+      if (AddStreamDetail(details, pDS->get_sql_record()))
+        retVal = true;
       pDS->next();
     }
 
@@ -3721,6 +3733,181 @@ void CVideoDatabase::GetTags(int media_id, const std::string &media_type, std::v
   }
 }
 
+// number of ids that are put into a single IN () clause by the batch loaders
+#define VIDEODB_BATCH_SIZE 500
+
+/* joins the ids of a batch into a list for an IN () clause */
+static std::string GetIdBatch(const std::vector<int> &ids, size_t batch)
+{
+  std::string list;
+  for (size_t i = batch; i < ids.size() && i < batch + VIDEODB_BATCH_SIZE; i++)
+  {
+    if (!list.empty())
+      list += ",";
+    list += StringUtils::Format("%i", ids[i]);
+  }
+  return list;
+}
+
+void CVideoDatabase::GetDetailsForMovies(CFileItemList& items, int details, int start /* = 0 */, int end /* = -1 */)
+{
+  if (end < 0 || end > items.Size())
+    end = items.Size();
+  if (start < 0 || start >= end || details == VideoDbDetailsNone)
+    return;
+
+  typedef multimap<int, CVideoInfoTag*> TagMap;
+  typedef pair<TagMap::const_iterator, TagMap::const_iterator> TagRange;
+
+  std::string sql;
+  try
+  {
+    if (NULL == m_pDB.get()) return;
+    if (NULL == m_pDS2.get()) return;
+
+    unsigned int time = XbmcThreads::SystemClockMillis();
+
+    // map the movie and file ids to the tags to fill
+    TagMap movies, files;
+    vector<int> movieIds, fileIds;
+    for (int i = start; i < end; i++)
+    {
+      if (!items[i]->HasVideoInfoTag())
+        continue;
+
+      CVideoInfoTag *tag = items[i]->GetVideoInfoTag();
+      if (tag->m_iDbId < 0 || tag->m_type != MediaTypeMovie)
+        continue;
+
+      if (movies.find(tag->m_iDbId) == movies.end())
+        movieIds.push_back(tag->m_iDbId);
+      movies.insert(make_pair(tag->m_iDbId, tag));
+      if (tag->m_iFileId >= 0)
+      {
+        if (files.find(tag->m_iFileId) == files.end())
+          fileIds.push_back(tag->m_iFileId);
+        files.insert(make_pair(tag->m_iFileId, tag));
+      }
+
+      tag->m_strPictureURL.Parse();
+      if (details & VideoDbDetailsCast)
+        tag->m_cast.clear();
+      if (details & VideoDbDetailsTag)
+        tag->m_tags.clear();
+      if (details & VideoDbDetailsShowLink)
+        tag->m_showLink.clear();
+      if (details & VideoDbDetailsStream)
+        tag->m_streamDetails.Reset();
+    }
+
+    for (size_t batch = 0; batch < movieIds.size(); batch += VIDEODB_BATCH_SIZE)
+    {
+      std::string ids = GetIdBatch(movieIds, batch);
+
+      if (details & VideoDbDetailsCast)
+      {
+        sql = PrepareSQL("SELECT actor_link.media_id,"
+                         "  actor.name,"
+                         "  actor_link.role,"
+                         "  actor_link.cast_order,"
+                         "  actor.art_urls,"
+                         "  art.url "
+                         "FROM actor_link"
+                         "  JOIN actor ON"
+                         "    actor_link.actor_id=actor.actor_id"
+                         "  LEFT JOIN art ON"
+                         "    art.media_id=actor.actor_id AND art.media_type='actor' AND art.type='thumb' "
+                         "WHERE actor_link.media_id IN (%s) AND actor_link.media_type='%s' "
+                         "ORDER BY actor_link.media_id, actor_link.cast_order", ids.c_str(), MediaTypeMovie);
+        m_pDS2->query(sql);
+        while (!m_pDS2->eof())
+        {
+          SActorInfo info;
+          info.strName = m_pDS2->fv(1).get_asString();
+          info.strRole = m_pDS2->fv(2).get_asString();
+          info.order = m_pDS2->fv(3).get_asInt();
+          info.thumbUrl.ParseString(m_pDS2->fv(4).get_asString());
+          info.thumb = m_pDS2->fv(5).get_asString();
+
+          TagRange range = movies.equal_range(m_pDS2->fv(0).get_asInt());
+          for (TagMap::const_iterator it = range.first; it != range.second; ++it)
+          {
+            vector<SActorInfo> &cast = it->second->m_cast;
+            bool found = false;
+            for (vector<SActorInfo>::const_iterator i = cast.begin(); i != cast.end() && !found; ++i)
+              found = i->strName == info.strName;
+            if (!found)
+              cast.push_back(info);
+          }
+          m_pDS2->next();
+        }
+        m_pDS2->close();
+      }
+
+      if (details & VideoDbDetailsTag)
+      {
+        sql = PrepareSQL("SELECT tag_link.media_id, tag.name FROM tag_link JOIN tag ON tag_link.tag_id = tag.tag_id "
+                         "WHERE tag_link.media_id IN (%s) AND tag_link.media_type = '%s' ORDER BY tag.tag_id", ids.c_str(), MediaTypeMovie);
+        m_pDS2->query(sql);
+        while (!m_pDS2->eof())
+        {
+          TagRange range = movies.equal_range(m_pDS2->fv(0).get_asInt());
+          for (TagMap::const_iterator it = range.first; it != range.second; ++it)
+            it->second->m_tags.push_back(m_pDS2->fv(1).get_asString());
+          m_pDS2->next();
+        }
+        m_pDS2->close();
+      }
+
+      if (details & VideoDbDetailsShowLink)
+      {
+        sql = PrepareSQL("SELECT movielinktvshow.idMovie, tvshow.c%02d FROM movielinktvshow JOIN tvshow ON tvshow.idShow = movielinktvshow.idShow "
+                         "WHERE movielinktvshow.idMovie IN (%s)", VIDEODB_ID_TV_TITLE, ids.c_str());
+        m_pDS2->query(sql);
+        while (!m_pDS2->eof())
+        {
+          TagRange range = movies.equal_range(m_pDS2->fv(0).get_asInt());
+          for (TagMap::const_iterator it = range.first; it != range.second; ++it)
+            it->second->m_showLink.push_back(m_pDS2->fv(1).get_asString());
+          m_pDS2->next();
+        }
+        m_pDS2->close();
+      }
+    }
+
+    if (details & VideoDbDetailsStream)
+    {
+      for (size_t batch = 0; batch < fileIds.size(); batch += VIDEODB_BATCH_SIZE)
+      {
+        sql = PrepareSQL("SELECT * FROM streamdetails WHERE idFile IN (%s)", GetIdBatch(fileIds, batch).c_str());
+        m_pDS2->query(sql);
+        while (!m_pDS2->eof())
+        {
+          TagRange range = files.equal_range(m_pDS2->fv(0).get_asInt());
+          for (TagMap::const_iterator it = range.first; it != range.second; ++it)
+            AddStreamDetail(it->second->m_streamDetails, m_pDS2->get_sql_record());
+          m_pDS2->next();
+        }
+        m_pDS2->close();
+      }
+
+      for (TagMap::const_iterator it = files.begin(); it != files.end(); ++it)
+      {
+        CStreamDetails &streamDetails = it->second->m_streamDetails;
+        streamDetails.DetermineBestStreams();
+        if (streamDetails.GetVideoDuration() > 0)
+          it->second->m_duration = streamDetails.GetVideoDuration();
+      }
+    }
+
+    CLog::Log(LOGDEBUG, "%s - loaded details of %u movies in %u ms", __FUNCTION__, (unsigned int)movieIds.size(), XbmcThreads::SystemClockMillis() - time);
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed (%s)", __FUNCTION__, sql.c_str());
+  }
+}
+
 /// \brief GetVideoSettings() obtains any saved video settings for the current file.
 /// \retval Returns true if the settings exist, false otherwise.
 bool CVideoDatabase::GetVideoSettings(const std::string &strFilenameAndPath, CVideoSettings &settings)
@@ -3905,6 +4092,33 @@ bool CVideoDatabase::GetArtForItem(int mediaId, const MediaType &mediaType, map<
   return false;
 }
 
+bool CVideoDatabase::GetArtForItems(const vector<int> &mediaIds, const MediaType &mediaType, map<int, map<string, string> > &art)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS2.get()) return false; // using dataset 2 as we're likely called in loops on dataset 1
+
+    for (size_t batch = 0; batch < mediaIds.size(); batch += VIDEODB_BATCH_SIZE)
+    {
+      std::string sql = PrepareSQL("SELECT media_id,type,url FROM art WHERE media_id IN (%s) AND media_type='%s'", GetIdBatch(mediaIds, batch).c_str(), mediaType.c_str());
+      m_pDS2->query(sql.c_str());
+      while (!m_pDS2->eof())
+      {
+        art[m_pDS2->fv(0).get_asInt()].insert(make_pair(m_pDS2->fv(1).get_asString(), m_pDS2->fv(2).get_asString()));
+        m_pDS2->next();
+      }
+      m_pDS2->close();
+    }
+    return !art.empty();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s(%s) failed", __FUNCTION__, mediaType.c_str());
+  }
+  return false;
+}
+
 string CVideoDatabase::GetArtForItem(int mediaId, const MediaType &mediaType, const string &artType)
 {
   std::string query = PrepareSQL("SELECT url FROM art WHERE media_id=%i AND media_type='%s' AND type='%s'", mediaId, mediaType.c_str(), artType.c_str());
@@ -6211,6 +6425,26 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
 
     strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
+    // without sorting the rows are used in the order they come, so read them
+    // straight from the cursor instead of copying the whole result set first
+    if (sortDescription.sortBy == SortByNone)
+    {
+      unsigned int time = XbmcThreads::SystemClockMillis();
+      StatementPtr stmt = PrepareStatement(strSQL, false);
+      if (!stmt)
+        return false;
+
+      int count = 0;
+      for (; stmt->step(); count++)
+        AddMovieItem(stmt->get_sql_record(), videoUrl, items);
+      CLog::Log(LOGDEBUG, "%s took %d ms for %d items query: %s", __FUNCTION__, XbmcThreads::SystemClockMillis() - time, count, strSQL.c_str());
+
+      // store the total value of items as a property
+      if (count > 0)
+        items.SetProperty("total", total < count ? count : total);
+      return true;
+    }
+
     int iRowsFound = RunQuery(strSQL);
     if (iRowsFound <= 0)
       return iRowsFound == 0;
@@ -6232,23 +6466,7 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
     for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); ++it)
     {
       unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
-
-      CVideoInfoTag movie = GetDetailsForMovie(record);
-      if (CProfilesManager::Get().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
-          g_passwordManager.bMasterUser                                   ||
-          g_passwordManager.IsDatabasePathUnlocked(movie.m_strPath, *CMediaSourceSettings::Get().GetSources("video")))
-      {
-        CFileItemPtr pItem(new CFileItem(movie));
-
-        CVideoDbUrl itemUrl = videoUrl;
-        std::string path = StringUtils::Format("%i", movie.m_iDbId);
-        itemUrl.AppendPath(path);
-        pItem->SetPath(itemUrl.ToString());
-
-        pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED,movie.m_playCount > 0);
-        items.Add(pItem);
-      }
+      AddMovieItem(data.at(targetRow), videoUrl, items);
     }
 
     // cleanup
@@ -6262,6 +6480,25 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
   return false;
 }
 
+void CVideoDatabase::AddMovieItem(const dbiplus::sql_record* const record, const CVideoDbUrl &videoUrl, CFileItemList& items)
+{
+  CVideoInfoTag movie = GetDetailsForMovie(record);
+  if (CProfilesManager::Get().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
+      g_passwordManager.bMasterUser                                   ||
+      g_passwordManager.IsDatabasePathUnlocked(movie.m_strPath, *CMediaSourceSettings::Get().GetSources("video")))
+  {
+    CFileItemPtr pItem(new CFileItem(movie));
+
+    CVideoDbUrl itemUrl = videoUrl;
+    std::string path = StringUtils::Format("%i", movie.m_iDbId);
+    itemUrl.AppendPath(path);
+    pItem->SetPath(itemUrl.ToString());
+
+    pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED,movie.m_playCount > 0);
+    items.Add(pItem);
+  }
+}
+
 bool CVideoDatabase::GetTvShowsNav(const std::string& strBaseDir, CFileItemList& items,
                                   int idGenre /* = -1 */, int idYear /* = -1 */, int idActor /* = -1 */, int idDirector /* = -1 */, int idStudio /* = -1 */, int idTag /* = -1 */,
                                   const SortDescription &sortDescription /* = SortDescription() */)
@@ -33,6 +33,7 @@ class CFileItemList;
 class CVideoSettings;
 class CGUIDialogProgress;
 class CGUIDialogProgressBarHandle;
+class CVideoDbUrl;
 
 namespace dbiplus
 {
@@ -128,6 +129,17 @@ typedef enum
   VIDEODB_CONTENT_MOVIE_SETS = 5
 } VIDEODB_CONTENT_TYPE;
 
+/*! \brief details that are stored in separate tables and are only loaded on request */
+enum VideoDbDetails
+{
+  VideoDbDetailsNone          = 0x00,
+  VideoDbDetailsCast          = 0x01,
+  VideoDbDetailsTag           = 0x02,
+  VideoDbDetailsShowLink      = 0x04,
+  VideoDbDetailsStream        = 0x08,
+  VideoDbDetailsAll           = 0xFF
+};
+
 typedef enum // this enum MUST match the offset struct further down!! and make sure to keep min and max at -1 and sizeof(offsets)
 {
   VIDEODB_ID_MIN = -1,
@@ -452,6 +464,15 @@ public:
 
   bool LoadVideoInfo(const std::string& strFilenameAndPath, CVideoInfoTag& details);
   bool GetMovieInfo(const std::string& strFilenameAndPath, CVideoInfoTag& details, int idMovie = -1);
+
+  /*! \brief Load the details of a list of movies that are stored in separate tables.
+   Each table is queried once for all movies in the range instead of once per movie.
+   \param items the movies, as retrieved by GetMoviesByWhere().
+   \param details the details to load, a combination of VideoDbDetails.
+   \param start the first item to load the details for.
+   \param end the item after the last one to load the details for, -1 for the end of the list.
+   */
+  void GetDetailsForMovies(CFileItemList& items, int details, int start = 0, int end = -1);
   bool GetTvShowInfo(const std::string& strPath, CVideoInfoTag& details, int idTvShow = -1, CFileItem* item = NULL);
   bool GetSeasonInfo(int idSeason, CVideoInfoTag& details);
   bool GetEpisodeInfo(const std::string& strFilenameAndPath, CVideoInfoTag& details, int idEpisode = -1);
@@ -752,6 +773,13 @@ public:
   void SetArtForItem(int mediaId, const MediaType &mediaType, const std::string &artType, const std::string &url);
   void SetArtForItem(int mediaId, const MediaType &mediaType, const std::map<std::string, std::string> &art);
   bool GetArtForItem(int mediaId, const MediaType &mediaType, std::map<std::string, std::string> &art);
+  /*! \brief Get the art of several items of the same type with a single query per batch of ids.
+   \param mediaIds the ids of the items.
+   \param mediaType the type of the items.
+   \param art the art of each item by id, items without art are left out.
+   \return true if any art was found, false otherwise.
+   */
+  bool GetArtForItems(const std::vector<int> &mediaIds, const MediaType &mediaType, std::map<int, std::map<std::string, std::string> > &art);
   std::string GetArtForItem(int mediaId, const MediaType &mediaType, const std::string &artType);
   bool RemoveArtForItem(int mediaId, const MediaType &mediaType, const std::string &artType);
   bool RemoveArtForItem(int mediaId, const MediaType &mediaType, const std::set<std::string> &artTypes);
@@ -825,6 +853,8 @@ protected:
   CVideoInfoTag GetDetailsByTypeAndId(VIDEODB_CONTENT_TYPE type, int id);
   CVideoInfoTag GetDetailsForMovie(std::unique_ptr<dbiplus::Dataset> &pDS, bool getDetails = false);
   CVideoInfoTag GetDetailsForMovie(const dbiplus::sql_record* const record, bool getDetails = false);
+  /*! \brief Add the movie of the given record to the list, unless it's locked for the current profile */
+  void AddMovieItem(const dbiplus::sql_record* const record, const CVideoDbUrl &videoUrl, CFileItemList& items);
   CVideoInfoTag GetDetailsForTvShow(std::unique_ptr<dbiplus::Dataset> &pDS, bool getDetails = false, CFileItem* item = NULL);
   CVideoInfoTag GetDetailsForTvShow(const dbiplus::sql_record* const record, bool getDetails = false, CFileItem* item = NULL);
   CVideoInfoTag GetDetailsForEpisode(std::unique_ptr<dbiplus::Dataset> &pDS, bool getDetails = false);
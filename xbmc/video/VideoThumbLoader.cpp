@@ -467,7 +467,7 @@ bool CVideoThumbLoader::FillLibraryArt(CFileItem &item)
     }
     m_videoDatabase->Close();
   }
-  return !item.GetArt().empty();
+  return item.GetArtCount() > 0;
 }
 
 bool CVideoThumbLoader::FillThumb(CFileItem &item)
@@ -0,0 +1,303 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "video/VideoDatabase.h"
+#include "dbwrappers/dataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "FileItem.h"
+
+#include "gtest/gtest.h"
+
+// a few batches of VIDEODB_BATCH_SIZE (500) with the last one only partly filled
+#define TEST_MOVIES 1200
+#define TEST_ACTORS 200
+#define TEST_TAGS   50
+
+// a large library for the opt-in benchmark
+#define BENCHMARK_MOVIES 50000
+
+class CTestVideoDatabase : public CVideoDatabase
+{
+public:
+  /* creates a new database in the temp folder, without the database manager */
+  bool Create(const std::string &name)
+  {
+    DatabaseSettings settings;
+    settings.type = "sqlite3";
+    settings.host = CSpecialProtocol::TranslatePath("special://temp/");
+    settings.name = name;
+    return Update(settings);
+  }
+
+  void Delete()
+  {
+    std::string file;
+    if (m_pDB.get())
+      file = URIUtils::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase());
+    Close();
+    if (!file.empty())
+      XFILE::CFile::Delete(file);
+  }
+
+  /* fills the database with movies that all have cast, tags, stream details and art */
+  bool Populate(int movies)
+  {
+    BeginTransaction();
+
+    ExecuteQuery("INSERT INTO path (idPath, strPath) VALUES (1, '/movies/')");
+    for (int i = 1; i <= TEST_ACTORS; i++)
+      ExecuteQuery(PrepareSQL("INSERT INTO actor (actor_id, name) VALUES (%i, 'Actor %i')", i, i));
+    for (int i = 1; i <= TEST_TAGS; i++)
+      ExecuteQuery(PrepareSQL("INSERT INTO tag (tag_id, name) VALUES (%i, 'Tag %i')", i, i));
+
+    dbiplus::StatementPtr file = PrepareStatement("INSERT INTO files (idFile, idPath, strFilename) VALUES (?, 1, ?)");
+    dbiplus::StatementPtr movie = PrepareStatement("INSERT INTO movie (idMovie, idFile, c00) VALUES (?, ?, ?)");
+    dbiplus::StatementPtr cast = PrepareStatement("INSERT INTO actor_link (actor_id, media_id, media_type, role, cast_order) VALUES (?, ?, 'movie', ?, ?)");
+    dbiplus::StatementPtr tag = PrepareStatement("INSERT INTO tag_link (tag_id, media_id, media_type) VALUES (?, ?, 'movie')");
+    dbiplus::StatementPtr stream = PrepareStatement("INSERT INTO streamdetails (idFile, iStreamType, strVideoCodec, strAudioCodec, iAudioChannels) VALUES (?, ?, ?, ?, ?)");
+    dbiplus::StatementPtr art = PrepareStatement("INSERT INTO art (media_id, media_type, type, url) VALUES (?, 'movie', ?, ?)");
+    if (!file || !movie || !cast || !tag || !stream || !art)
+      return false;
+
+    for (int i = 1; i <= movies; i++)
+    {
+      std::string name = StringUtils::Format("Movie %i", i);
+
+      file->bind(1, i);
+      file->bind(2, name + ".mkv");
+      file->step();
+      file->reset();
+
+      movie->bind(1, i);
+      movie->bind(2, i);
+      movie->bind(3, name);
+      movie->step();
+      movie->reset();
+
+      for (int j = 0; j < 3; j++)
+      {
+        cast->bind(1, (i + j * 7) % TEST_ACTORS + 1);
+        cast->bind(2, i);
+        cast->bind(3, StringUtils::Format("Role %i", j));
+        cast->bind(4, j);
+        cast->step();
+        cast->reset();
+      }
+
+      for (int j = 0; j < 2; j++)
+      {
+        tag->bind(1, (i + j) % TEST_TAGS + 1);
+        tag->bind(2, i);
+        tag->step();
+        tag->reset();
+      }
+
+      stream->bind(1, i);
+      stream->bind(2, (int)CStreamDetail::VIDEO);
+      stream->bind(3, std::string("h264"));
+      stream->bind_null(4);
+      stream->bind_null(5);
+      stream->step();
+      stream->reset();
+      stream->bind(1, i);
+      stream->bind(2, (int)CStreamDetail::AUDIO);
+      stream->bind_null(3);
+      stream->bind(4, std::string("dts"));
+      stream->bind(5, 6);
+      stream->step();
+      stream->reset();
+
+      art->bind(1, i);
+      art->bind(2, std::string("poster"));
+      art->bind(3, "/art/" + name + "-poster.jpg");
+      art->step();
+      art->reset();
+      art->bind(1, i);
+      art->bind(2, std::string("fanart"));
+      art->bind(3, "/art/" + name + "-fanart.jpg");
+      art->step();
+      art->reset();
+    }
+
+    return CDatabase::CommitTransaction();
+  }
+};
+
+class TestVideoDatabase : public testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    m_db = new CTestVideoDatabase;
+    if (m_db->Create("TestVideos"))
+      m_populated = m_db->Populate(TEST_MOVIES);
+  }
+
+  static void TearDownTestCase()
+  {
+    m_db->Delete();
+    delete m_db;
+    m_db = NULL;
+  }
+
+  virtual void SetUp()
+  {
+    ASSERT_TRUE(m_populated);
+  }
+
+  static CTestVideoDatabase *m_db;
+  static bool m_populated;
+};
+
+CTestVideoDatabase *TestVideoDatabase::m_db = NULL;
+bool TestVideoDatabase::m_populated = false;
+
+TEST_F(TestVideoDatabase, GetMoviesByWhereLimits)
+{
+  SortDescription sorting;
+  sorting.limitStart = 100;
+  sorting.limitEnd = 150;
+
+  CFileItemList items;
+  EXPECT_TRUE(m_db->GetMoviesByWhere("videodb://movies/titles/", CDatabase::Filter(), items, sorting));
+  EXPECT_EQ(50, items.Size());
+  EXPECT_EQ(TEST_MOVIES, items.GetProperty("total").asInteger());
+}
+
+TEST_F(TestVideoDatabase, GetDetailsForMoviesMatchesGetMovieInfo)
+{
+  CFileItemList items;
+  ASSERT_TRUE(m_db->GetMoviesByWhere("videodb://movies/titles/", CDatabase::Filter(), items));
+  ASSERT_EQ(TEST_MOVIES, items.Size());
+
+  m_db->GetDetailsForMovies(items, VideoDbDetailsAll);
+  for (int i = 0; i < items.Size(); i++)
+  {
+    const CVideoInfoTag &batched = *items[i]->GetVideoInfoTag();
+    CVideoInfoTag single;
+    ASSERT_TRUE(m_db->GetMovieInfo("", single, batched.m_iDbId));
+
+    ASSERT_EQ(single.m_cast.size(), batched.m_cast.size());
+    for (size_t j = 0; j < single.m_cast.size(); j++)
+    {
+      EXPECT_EQ(single.m_cast[j].strName, batched.m_cast[j].strName);
+      EXPECT_EQ(single.m_cast[j].strRole, batched.m_cast[j].strRole);
+      EXPECT_EQ(single.m_cast[j].order, batched.m_cast[j].order);
+    }
+    EXPECT_EQ(single.m_tags, batched.m_tags);
+    EXPECT_EQ(single.m_showLink, batched.m_showLink);
+    EXPECT_EQ(single.m_streamDetails.GetStreamCount(CStreamDetail::VIDEO), batched.m_streamDetails.GetStreamCount(CStreamDetail::VIDEO));
+    EXPECT_EQ(single.m_streamDetails.GetStreamCount(CStreamDetail::AUDIO), batched.m_streamDetails.GetStreamCount(CStreamDetail::AUDIO));
+    EXPECT_EQ(single.m_streamDetails.GetVideoCodec(), batched.m_streamDetails.GetVideoCodec());
+    EXPECT_EQ(single.m_streamDetails.GetAudioCodec(), batched.m_streamDetails.GetAudioCodec());
+    EXPECT_EQ(single.m_streamDetails.GetAudioChannels(), batched.m_streamDetails.GetAudioChannels());
+  }
+}
+
+TEST_F(TestVideoDatabase, GetDetailsForMoviesRange)
+{
+  SortDescription sorting;
+  sorting.limitEnd = 20;
+
+  CFileItemList items;
+  ASSERT_TRUE(m_db->GetMoviesByWhere("videodb://movies/titles/", CDatabase::Filter(), items, sorting));
+  ASSERT_EQ(20, items.Size());
+
+  m_db->GetDetailsForMovies(items, VideoDbDetailsCast, 5, 10);
+  for (int i = 0; i < items.Size(); i++)
+  {
+    const CVideoInfoTag &tag = *items[i]->GetVideoInfoTag();
+    EXPECT_EQ(i >= 5 && i < 10 ? 3u : 0u, tag.m_cast.size());
+    EXPECT_TRUE(tag.m_tags.empty());
+  }
+}
+
+TEST_F(TestVideoDatabase, GetArtForItems)
+{
+  std::vector<int> ids;
+  ids.push_back(1);
+  ids.push_back(TEST_MOVIES);
+  ids.push_back(TEST_MOVIES + 1);
+
+  std::map<int, std::map<std::string, std::string> > art;
+  EXPECT_TRUE(m_db->GetArtForItems(ids, MediaTypeMovie, art));
+  EXPECT_EQ(2u, art.size());
+  EXPECT_EQ("/art/Movie 1-poster.jpg", art[1]["poster"]);
+  EXPECT_EQ(StringUtils::Format("/art/Movie %i-fanart.jpg", TEST_MOVIES), art[TEST_MOVIES]["fanart"]);
+}
+
+class TestVideoDatabaseBenchmark : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    ASSERT_TRUE(m_db.Create("TestVideosBenchmark"));
+    ASSERT_TRUE(m_db.Populate(BENCHMARK_MOVIES));
+  }
+
+  virtual void TearDown()
+  {
+    m_db.Delete();
+  }
+
+  CTestVideoDatabase m_db;
+};
+
+/* Not a correctness test, records the time it takes to load a full listing of
+ * a large library with details per movie and in batches. It takes a while, run
+ * it with --gtest_also_run_disabled_tests.
+ */
+TEST_F(TestVideoDatabaseBenchmark, DISABLED_GetDetailsForMovies)
+{
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  CFileItemList items;
+  ASSERT_TRUE(m_db.GetMoviesByWhere("videodb://movies/titles/", CDatabase::Filter(), items));
+  ASSERT_EQ(BENCHMARK_MOVIES, items.Size());
+  unsigned int listing = XbmcThreads::SystemClockMillis() - start;
+
+  start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < items.Size(); i++)
+  {
+    CVideoInfoTag *tag = items[i]->GetVideoInfoTag();
+    m_db.GetMovieInfo("", *tag, tag->m_iDbId);
+    std::map<std::string, std::string> art;
+    m_db.GetArtForItem(tag->m_iDbId, MediaTypeMovie, art);
+  }
+  unsigned int single = XbmcThreads::SystemClockMillis() - start;
+
+  start = XbmcThreads::SystemClockMillis();
+  m_db.GetDetailsForMovies(items, VideoDbDetailsAll);
+  std::vector<int> ids;
+  for (int i = 0; i < items.Size(); i++)
+    ids.push_back(items[i]->GetVideoInfoTag()->m_iDbId);
+  std::map<int, std::map<std::string, std::string> > art;
+  m_db.GetArtForItems(ids, MediaTypeMovie, art);
+  unsigned int batched = XbmcThreads::SystemClockMillis() - start;
+
+  RecordProperty("Movies", BENCHMARK_MOVIES);
+  RecordProperty("ListingMs", (int)listing);
+  RecordProperty("DetailsPerMovieMs", (int)single);
+  RecordProperty("DetailsInBatchesMs", (int)batched);
+}
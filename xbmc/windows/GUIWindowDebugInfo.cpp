@@ -32,6 +32,7 @@
 #include "guilib/GUIWindowManager.h"
 #include "guilib/GUIControlProfiler.h"
 #include "GUIInfoManager.h"
+#include "network/EventServer.h"
 #include "utils/Variant.h"
 #include "utils/StringUtils.h"
 
@@ -115,6 +116,14 @@ void CGUIWindowDebugInfo::Process(unsigned int currentTime, CDirtyRegionList &di
     StringUtils::ToUpper(ucAppName);
     info = StringUtils::Format("LOG: %s%s.log\nMEM: %" PRIu64"/%" PRIu64" KB - FPS: %2.1f fps\nCPU: %s (CPU-%s %4.2f%%%s)", g_advancedSettings.m_logFolder.c_str(), lcAppName.c_str(),
                                stat.ullAvailPhys/1024, stat.ullTotalPhys/1024, g_infoManager.GetFPS(), strCores.c_str(), ucAppName.c_str(), dCPU, profiling.c_str());
+#endif
+#ifdef HAS_EVENT_SERVER
+    // time from the receipt of event client packets to the dispatch of their actions
+    unsigned int esEvents;
+    float esAverage, esMax;
+    EVENTSERVER::CEventServer::GetInstance()->GetLatency(esEvents, esAverage, esMax);
+    if (esEvents > 0)
+      info += StringUtils::Format("\nES: %u events - latency %.1f ms (max %.1f ms)", esEvents, esAverage, esMax);
 #endif
   }
 